@@ -6,35 +6,42 @@
 // Author : Shriya Shah
 
 #include "slugTest.h"
+#include "telemetry.h"
+#include "paramStore.h"
 
 double ref_input = 5;
 double cF;
 
 int main(void){
+    Param_Boot boot;
 
     // Initialize clock at 80 MHZ frequency
     Clock_set_80MHz();
 
+    // Gains, calibration and rates saved on this stand (Host Tools/slugCmd
+    // store save), the build values where there are none
+    ParamStore_Load();
+    Param_GetBoot(&boot);
+
 //    // Initialize Console
-    int BaudRate  = 115200;
-    uint32_t loggerFreq = 100; //1 KHz
-    Logger_Init(loggerFreq, BaudRate);
+//    int BaudRate  = 115200;
+//    uint32_t loggerFreq = 100; //1 KHz
+//    Logger_Init(loggerFreq, BaudRate);
+
+    // Binary telemetry, every controller tick (decode with Host Tools/telemetryDecode)
+    Logger_InitTelemetry(TELEMETRY_BAUD_RATE);
 
-    // Initialize motor
-    uint32_t pwmFreq = 20000; // 20KHz
-    Motor_Init(pwmFreq);
+    // Initialize motor, 20KHz by default
+    Motor_Init(boot.pwmFreq);
 
     // Initialize Load Cell
-    int hardwareAveraging, ADCsampleFreq;
-    hardwareAveraging = 8;
-    ADCsampleFreq = 800; //1 KHz
-    LoadCell_init(hardwareAveraging, ADCsampleFreq);
+    // uDMA blocks of 16 samples at 32 KHz, decimated to one value every 0.5 ms
+    LoadCell_initBlock(boot.adcAveraging, boot.adcFreq);
 
 
-    // Initialize controller
+    // Initialize controller, 2kHZ by default
     setGoalForce(ref_input);
-    uint32_t controllerFreq = 2000; //2kHZ
-    Controller_Init(controllerFreq);
+    Controller_Init(boot.controllerFreq);
     ControllerEnable();
 
     // Enable all interrupts and channels
@@ -45,8 +52,12 @@ int main(void){
 
 
     while(1){
-        delayMS(1);
-        // Do nothing
+        // Send the telemetry queued by the controller
+        Logger_Drain();
+        // Setpoint, gains and mode from the host (Host Tools/slugCmd)
+        SerialMonitor_Receive();
+        // Gains of a finished relay tuning
+        Tune_Background();
     }
 
 }
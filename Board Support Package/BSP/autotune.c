@@ -0,0 +1,150 @@
+// autotune.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Relay feedback auto-tuner of the force loop, see autotune.h.
+
+#include <math.h>
+#include <string.h>
+#include "autotune.h"
+
+#define AUTOTUNE_PI 3.14159265f
+
+//------------------limit()---------------------------
+//Limit a duty to +-AUTOTUNE_MAX_DUTY
+static float limit(float duty){
+    return (duty > AUTOTUNE_MAX_DUTY) ? AUTOTUNE_MAX_DUTY : ((duty < -AUTOTUNE_MAX_DUTY) ? -AUTOTUNE_MAX_DUTY : duty);
+}
+
+//------------------finish()---------------------------
+//End the run, Ku from the averaged cycles when it completed
+static void finish(Autotune_State *s, Autotune_Status status){
+    float a, h2;
+
+    if(status == AUTOTUNE_DONE){
+        s->tu = s->periodSum/(float)s->measured;
+        a = s->amplitudeSum/(float)s->measured;
+        s->oscillation = a;
+        h2 = a*a - s->hysteresis*s->hysteresis;
+        if(h2 <= 0){
+            status = AUTOTUNE_NO_OSCILLATION;
+        }else{
+            s->ku = 4.0f*s->amplitude/(AUTOTUNE_PI*sqrtf(h2));
+        }
+    }
+    s->status = status;
+    s->duty = limit(s->bias);
+}
+
+//------------------Autotune_Init()---------------------------
+//Start a relay run
+//Input: state, goal (lb), relay amplitude (percent), hysteresis (lb), force
+//       range (lb), starting bias (percent), measured cycles, time limit (s),
+//       controller frequency (Hz)
+//Output: None
+void Autotune_Init(Autotune_State *s, float goal, float amplitude, float hysteresis, float range, float bias,
+                   uint32_t cycles, float seconds, uint32_t freq){
+    memset(s, 0, sizeof(*s));
+    s->goal = goal;
+    s->amplitude = amplitude;
+    s->hysteresis = hysteresis;
+    s->range = range;
+    s->bias = bias;
+    s->duty = limit(bias);
+    s->dt = 1.0f/(float)freq;
+    s->cycles = (cycles > 0) ? cycles : 1;
+    s->maxTicks = (uint32_t)(seconds*(float)freq);
+    s->status = AUTOTUNE_RUNNING;
+}
+
+//------------------Autotune_Step()---------------------------
+//One controller tick
+//Input: state, load (lb)
+//Output: Signed duty in percent, the bias once the run is over
+float Autotune_Step(Autotune_State *s, float load){
+    float error = s->goal - load;
+    uint32_t period;
+
+    if(s->status != AUTOTUNE_RUNNING){
+        return s->duty;
+    }
+    s->tick++;
+    if(s->tick > s->maxTicks){
+        finish(s, AUTOTUNE_TIMEOUT);
+        return s->duty;
+    }
+    if(load > s->goal + s->range || (s->reached && load < s->goal - s->range)){
+        finish(s, AUTOTUNE_OVERLOAD);
+        return s->duty;
+    }
+    if(error <= 0){
+        s->reached = 1;
+    }
+    if(!s->reached && s->tick > s->maxTicks/2){
+        finish(s, AUTOTUNE_NO_OSCILLATION);   // bias + amplitude does not reach the goal
+        return s->duty;
+    }
+
+    if(load < s->loadMin) s->loadMin = load;
+    if(load > s->loadMax) s->loadMax = load;
+
+    // Relay with hysteresis, a cycle starts at every switch to high
+    if(!s->high && error > s->hysteresis){
+        s->high = 1;
+        if(s->cycle > 0){
+            // Centre the oscillation: the longer half asks for more bias its way
+            period = s->tick - s->cycleStart;
+            s->bias = limit(s->bias + AUTOTUNE_BIAS_GAIN*s->amplitude*
+                            (float)((int32_t)(2*s->highTicks) - (int32_t)period)/(float)period);
+        }
+        if(s->cycle > AUTOTUNE_SETTLE_CYCLES){
+            s->periodSum += (float)(s->tick - s->cycleStart)*s->dt;
+            s->amplitudeSum += 0.5f*(s->loadMax - s->loadMin);
+            if(++s->measured >= s->cycles){
+                finish(s, AUTOTUNE_DONE);
+                return s->duty;
+            }
+        }
+        s->cycle++;
+        s->cycleStart = s->tick;
+        s->loadMin = s->loadMax = load;
+    }else if(s->high && error < -s->hysteresis){
+        s->high = 0;
+        s->highTicks = s->tick - s->cycleStart;
+    }
+
+    s->duty = limit(s->bias + (s->high ? s->amplitude : -s->amplitude));
+    return s->duty;
+}
+
+//------------------Autotune_Compute()---------------------------
+//PID gains from the measured ultimate gain and period
+//Input: state after AUTOTUNE_DONE, rule, gains out
+//Output: 1 if computed, 0 if the run is not done or the rule unknown
+int Autotune_Compute(const Autotune_State *s, Autotune_Rule rule, Autotune_Gains *g){
+    float ti, td;
+
+    if(s->status != AUTOTUNE_DONE){
+        return 0;
+    }
+    switch(rule){
+    case AUTOTUNE_ZN_PI:
+        g->kp = 0.45f*s->ku;
+        ti = s->tu/1.2f;
+        td = 0;
+        break;
+    case AUTOTUNE_ZN_PID:
+        g->kp = 0.6f*s->ku;
+        ti = 0.5f*s->tu;
+        td = 0.125f*s->tu;
+        break;
+    case AUTOTUNE_TL_PI:
+        g->kp = s->ku/3.2f;
+        ti = 2.2f*s->tu;
+        td = 0;
+        break;
+    default:
+        return 0;
+    }
+    g->ki = g->kp/ti;
+    g->kd = g->kp*td;
+    return 1;
+}
@@ -0,0 +1,99 @@
+// autotune.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Relay feedback auto-tuner of the force loop (Astrom-Hagglund). One step
+// per controller tick:
+//   duty = bias + amplitude   while the load is below goal - hysteresis
+//   duty = bias - amplitude   once it is above goal + hysteresis
+// so the load oscillates around the goal at the ultimate period of the
+// loop. The bias starts at the duty that holds the goal, so the run is
+// started once a controller has settled there; after every cycle it moves
+// by AUTOTUNE_BIAS_GAIN*amplitude times the high to low time imbalance,
+// which centres the oscillation. A cycle runs from one switch to the high
+// duty to the next; the
+// first AUTOTUNE_SETTLE_CYCLES are dropped, then the period and the peak to
+// peak load of the next ones are averaged:
+//   Tu = mean period, a = mean half peak to peak
+//   Ku = 4*amplitude/(pi*sqrt(a^2 - hysteresis^2))
+// Bounds, the run aborts when one is broken:
+//   - time: maxTicks, or half of it without reaching the goal
+//   - force: the load above goal + range, or below goal - range once it
+//     reached the goal
+// Autotune_Compute() turns Ku and Tu into PID gains with a tuning rule.
+// Float, runs on the FPU.
+
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+#include <stdint.h>
+
+#define AUTOTUNE_SETTLE_CYCLES  2
+#define AUTOTUNE_BIAS_GAIN      0.5f    // bias correction per cycle, of the amplitude
+#define AUTOTUNE_MAX_DUTY       100.0f  // percent
+
+typedef enum {
+    AUTOTUNE_RUNNING,
+    AUTOTUNE_DONE,
+    AUTOTUNE_TIMEOUT,       // aborted, maxTicks
+    AUTOTUNE_OVERLOAD,      // aborted, load out of range
+    AUTOTUNE_NO_OSCILLATION // aborted, the goal not reached or the amplitude within the hysteresis
+} Autotune_Status;
+
+typedef enum {
+    AUTOTUNE_ZN_PI,         // Ziegler-Nichols PI:  0.45 Ku, Ti = Tu/1.2
+    AUTOTUNE_ZN_PID,        // Ziegler-Nichols PID: 0.6 Ku,  Ti = Tu/2,   Td = Tu/8
+    AUTOTUNE_TL_PI,         // Tyreus-Luyben PI:    Ku/3.2,  Ti = 2.2 Tu, less overshoot
+    NUM_AUTOTUNE_RULES
+} Autotune_Rule;
+
+typedef struct {
+    float kp;               // percent/lb
+    float ki;               // percent/(lb s)
+    float kd;               // percent/(lb/s)
+} Autotune_Gains;
+
+typedef struct {
+    // settings
+    float goal, amplitude, hysteresis, range;   // lb, percent, lb, lb
+    float dt;                                   // s
+    uint32_t cycles;                            // measured cycles
+    uint32_t maxTicks;
+    // state
+    Autotune_Status status;
+    uint32_t tick;
+    int high;               // relay output is bias + amplitude
+    int reached;            // the load got to the goal once
+    float bias;             // percent
+    float duty;             // last output, percent
+    uint32_t cycle;         // cycles started
+    uint32_t cycleStart;    // tick of the switch to high
+    uint32_t highTicks;     // high half of the current cycle
+    float loadMin, loadMax; // over the current cycle
+    // results over the measured cycles
+    float periodSum, amplitudeSum;
+    uint32_t measured;
+    float ku, tu;           // percent/lb, s
+    float oscillation;      // lb, a
+} Autotune_State;
+
+//------------------Autotune_Init()---------------------------
+//Start a relay run
+//Input: state, goal (lb), relay amplitude (percent), hysteresis (lb), force
+//       range (lb), starting bias (percent), measured cycles, time limit (s),
+//       controller frequency (Hz)
+//Output: None
+void Autotune_Init(Autotune_State *s, float goal, float amplitude, float hysteresis, float range, float bias,
+                   uint32_t cycles, float seconds, uint32_t freq);
+
+//------------------Autotune_Step()---------------------------
+//One controller tick
+//Input: state, load (lb)
+//Output: Signed duty in percent, the bias once the run is over
+float Autotune_Step(Autotune_State *s, float load);
+
+//------------------Autotune_Compute()---------------------------
+//PID gains from the measured ultimate gain and period
+//Input: state after AUTOTUNE_DONE, rule, gains out
+//Output: 1 if computed, 0 if the run is not done or the rule unknown
+int Autotune_Compute(const Autotune_State *s, Autotune_Rule rule, Autotune_Gains *g);
+
+#endif /* AUTOTUNE_H_ */
@@ -0,0 +1,54 @@
+// calib.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Load cell calibration table, see calib.h.
+
+#include <math.h>
+#include "calib.h"
+
+//------------------fixed()---------------------------
+//Round to a fixed point integer
+static int32_t fixed(double value){
+    return (int32_t)floor(value + 0.5);
+}
+
+//------------------Calib_Set()---------------------------
+//Build the table from engineering units
+//Input: table, load at the points (lb), pound per nominal ADC count,
+//       span (1/C), offset (lb/C), reference temperature (C), chip
+//       temperature scaling (C = tempGain*counts + tempOffset), tare (lb)
+//Output: None
+void Calib_Set(Calib_Table *t, const double point[CALIB_POINTS], double loadPerCount, double span, double offset,
+               double tempRef, double tempGain, double tempOffset, double tare){
+    double one = (double)(1 << CALIB_FRAC_BITS)/loadPerCount;   // table units per lb
+    int i;
+
+    for(i = 0; i < CALIB_POINTS; i++){
+        t->point[i] = fixed(point[i]*one);
+    }
+    t->span = fixed(span*tempGain*(double)(1u << CALIB_SPAN_BITS));
+    t->offset = fixed(offset*tempGain*one*(double)(1 << CALIB_OFFSET_BITS));
+    t->tempRef = fixed((tempRef - tempOffset)/tempGain);
+    t->tare = fixed(tare*one);
+}
+
+//------------------Calib_Apply()---------------------------
+//Correct one reading
+//Input: table, load cell reading (counts*2^CALIB_FRAC_BITS), chip
+//       temperature (ADC counts)
+//Output: Corrected reading, nominal counts*2^CALIB_FRAC_BITS, negative below the tare
+int32_t Calib_Apply(const Calib_Table *t, uint32_t counts, uint32_t temp){
+    uint32_t x = counts & ((1u << (CALIB_INPUT_BITS + CALIB_FRAC_BITS)) - 1);
+    uint32_t i = x >> CALIB_SHIFT;                  // segment
+    int32_t f = (int32_t)(x & ((1u << CALIB_SHIFT) - 1));
+    int32_t dT = (int32_t)temp - t->tempRef;
+    int32_t y, m;
+
+    y = t->point[i] + (int32_t)(((int64_t)(t->point[i + 1] - t->point[i])*f) >> CALIB_SHIFT);
+
+    // Span and offset drift, span first brought to 2^-16
+    m = (int32_t)(((int64_t)t->span*dT) >> (CALIB_SPAN_BITS - 16));
+    y += (int32_t)(((int64_t)y*m) >> 16);
+    y += (int32_t)(((int64_t)t->offset*dT) >> CALIB_OFFSET_BITS);
+
+    return y - t->tare;
+}
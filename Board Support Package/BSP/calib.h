@@ -0,0 +1,61 @@
+// calib.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Load cell calibration: the ADC reading is corrected by a piecewise linear
+// table, compensated for the on-die temperature and tared, then given back
+// in nominal ADC counts (FC_LOAD_PER_COUNT lb each) so every user of the
+// load cell value keeps its units:
+//   y = L(counts)                        CALIB_POINTS points, CALIB_SEGMENT apart
+//   y = y*(1 + span*dT) + offset*dT      dT = chip temperature - reference
+//   y = y - tare
+// The result is signed: below the tare point (unloading, compression) it is
+// negative, not clamped to 0.
+// The points are evenly spaced over the 12 bit range, so the segment of a
+// reading is its top bits and its position in the segment the bits below:
+// the interpolation has no search and no branch. Fixed point, counts and
+// table values carry CALIB_FRAC_BITS fraction bits (the decimator output of
+// block mode), dT is in chip temperature ADC counts. The identity table
+// (Calib_Set() with the points at their nominal load and no temperature or
+// tare terms) gives back the reading unchanged.
+// Host Tools/calFit fits the points and the temperature terms from
+// calibration logs (logger_Calibration() in slug.c).
+
+#ifndef CALIB_H_
+#define CALIB_H_
+
+#include <stdint.h>
+
+#define CALIB_INPUT_BITS        12                          // ADC resolution
+#define CALIB_FRAC_BITS         4                           // fraction bits of counts and table
+#define CALIB_SEGMENTS_LOG2     3
+#define CALIB_POINTS            ((1 << CALIB_SEGMENTS_LOG2) + 1)
+#define CALIB_SEGMENT           (1 << (CALIB_INPUT_BITS - CALIB_SEGMENTS_LOG2))   // counts between points
+#define CALIB_SHIFT             (CALIB_INPUT_BITS - CALIB_SEGMENTS_LOG2 + CALIB_FRAC_BITS)
+#define CALIB_SPAN_BITS         30                          // fraction bits of span
+#define CALIB_OFFSET_BITS       16                          // fraction bits of offset
+#define CALIB_NOMINAL(i)        ((int32_t)(i)*CALIB_SEGMENT << CALIB_FRAC_BITS)   // identity table point
+
+typedef struct {
+    int32_t point[CALIB_POINTS];    // load at counts i*CALIB_SEGMENT, counts*2^CALIB_FRAC_BITS
+    int32_t span;                   // per chip temperature count, 2^-CALIB_SPAN_BITS
+    int32_t offset;                 // counts*2^CALIB_FRAC_BITS per chip temperature count, 2^-CALIB_OFFSET_BITS
+    int32_t tempRef;                // chip temperature ADC counts
+    int32_t tare;                   // counts*2^CALIB_FRAC_BITS
+} Calib_Table;
+
+//------------------Calib_Set()---------------------------
+//Build the table from engineering units
+//Input: table, load at the points (lb), pound per nominal ADC count,
+//       span (1/C), offset (lb/C), reference temperature (C), chip
+//       temperature scaling (C = tempGain*counts + tempOffset), tare (lb)
+//Output: None
+void Calib_Set(Calib_Table *t, const double point[CALIB_POINTS], double loadPerCount, double span, double offset,
+               double tempRef, double tempGain, double tempOffset, double tare);
+
+//------------------Calib_Apply()---------------------------
+//Correct one reading
+//Input: table, load cell reading (counts*2^CALIB_FRAC_BITS), chip
+//       temperature (ADC counts)
+//Output: Corrected reading, nominal counts*2^CALIB_FRAC_BITS, negative below the tare
+int32_t Calib_Apply(const Calib_Table *t, uint32_t counts, uint32_t temp);
+
+#endif /* CALIB_H_ */
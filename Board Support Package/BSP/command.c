@@ -0,0 +1,193 @@
+// command.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Binary command protocol, see command.h for the frame format.
+// The UART interrupt only frames bytes into a queue slot, the CRC is checked
+// in the background loop, same as the telemetry framing. The queue is a lock
+// free ring (ring.h), filled in place.
+
+#include <string.h>
+#include "command.h"
+#include "telemetry.h"
+#include "ring.h"
+
+RING_DEFINE(RequestQueue, Command_Request, COMMAND_QUEUE_SIZE)
+
+typedef enum {
+    WAIT_SYNC0,
+    WAIT_SYNC1,
+    WAIT_SEQ,
+    WAIT_CODE,
+    WAIT_LENGTH,
+    WAIT_PAYLOAD,
+    WAIT_CRC0,
+    WAIT_CRC1
+} Command_State;
+
+static RequestQueue queue;              // UART ISR to background
+static Command_Request *slot;           // being framed, &overflow when the queue was full
+static Command_Request overflow;        // framed and dropped when the queue is full
+static Command_State state;
+static uint32_t received;
+static volatile uint32_t errors;
+
+//------------------Command_Init()---------------------------
+//Empty the queue, wait for a sync word and clear the error counts
+//Input: None
+//Output: None
+void Command_Init(void){
+    RequestQueue_Init(&queue);
+    state = WAIT_SYNC0;
+    errors = 0;
+}
+
+//------------------Command_Receive()---------------------------
+//Frame one received byte, called from the UART interrupt
+//Input: byte
+//Output: None
+void Command_Receive(uint8_t byte){
+    switch(state){
+    case WAIT_SYNC0:
+        if(byte == (COMMAND_SYNC & 0xFF)){
+            state = WAIT_SYNC1;
+        }
+        break;
+    case WAIT_SYNC1:
+        if(byte == (COMMAND_SYNC >> 8)){
+            slot = RequestQueue_Claim(&queue);
+            if(!slot){
+                slot = &overflow;
+            }
+            state = WAIT_SEQ;
+        }else if(byte != (COMMAND_SYNC & 0xFF)){
+            state = WAIT_SYNC0;
+        }
+        break;
+    case WAIT_SEQ:
+        slot->seq = byte;
+        state = WAIT_CODE;
+        break;
+    case WAIT_CODE:
+        slot->code = byte;
+        state = WAIT_LENGTH;
+        break;
+    case WAIT_LENGTH:
+        if(byte > COMMAND_MAX_PAYLOAD){
+            errors++;
+            state = WAIT_SYNC0;
+            break;
+        }
+        slot->length = byte;
+        received = 0;
+        state = byte ? WAIT_PAYLOAD : WAIT_CRC0;
+        break;
+    case WAIT_PAYLOAD:
+        slot->payload[received++] = byte;
+        if(received == slot->length){
+            state = WAIT_CRC0;
+        }
+        break;
+    case WAIT_CRC0:
+        slot->crc = byte;
+        state = WAIT_CRC1;
+        break;
+    case WAIT_CRC1:
+        slot->crc |= (uint16_t)byte << 8;
+        if(slot == &overflow){
+            errors++;
+        }else{
+            RequestQueue_Publish(&queue);
+        }
+        state = WAIT_SYNC0;
+        break;
+    }
+}
+
+//------------------Command_Get()---------------------------
+//Take the next queued request with a good CRC, call from the background loop
+//Input: request out
+//Output: 1 if a request was taken, 0 if none is waiting
+int Command_Get(Command_Request *request){
+    const Command_Request *r;
+    uint8_t header[3 + COMMAND_MAX_PAYLOAD];
+
+    while((r = RequestQueue_Peek(&queue)) != 0){
+        *request = *r;
+        RequestQueue_Release(&queue);
+        header[0] = request->seq;
+        header[1] = request->code;
+        header[2] = request->length;
+        memcpy(&header[3], request->payload, request->length);
+        if(Telemetry_CRC16(header, 3 + request->length) == request->crc){
+            return 1;
+        }
+        errors++;
+    }
+    return 0;
+}
+
+//------------------Command_EncodeReply()---------------------------
+//Frame the reply to a request, little endian
+//Input: request, status, payload, payload length, output buffer
+//Output: Frame length
+uint32_t Command_EncodeReply(const Command_Request *request, Command_Status status,
+                             const uint8_t *payload, uint32_t length, uint8_t *frame){
+    uint16_t crc;
+
+    if(length > COMMAND_MAX_PAYLOAD){
+        length = COMMAND_MAX_PAYLOAD;
+    }
+    frame[0] = COMMAND_REPLY_SYNC & 0xFF;
+    frame[1] = COMMAND_REPLY_SYNC >> 8;
+    frame[2] = request->seq;
+    frame[3] = request->code & ~COMMAND_NO_REPLY;
+    frame[4] = status;
+    frame[5] = length;
+    memcpy(&frame[6], payload, length);
+    crc = Telemetry_CRC16(&frame[2], 4 + length);
+    frame[6 + length] = crc;
+    frame[7 + length] = crc >> 8;
+    return COMMAND_REPLY_SIZE(length);
+}
+
+//------------------Command_Errors()---------------------------
+//Get the number of requests dropped
+//Input: None
+//Output: Dropped requests
+uint32_t Command_Errors(void){
+    return errors;
+}
+
+//------------------Command_PutFloat()---------------------------
+//Store a float32 little endian
+//Input: buffer, value
+//Output: None
+void Command_PutFloat(uint8_t *buffer, float value){
+    uint32_t u;
+
+    memcpy(&u, &value, 4);
+    Command_PutUint32(buffer, u);
+}
+
+//------------------Command_PutUint32()---------------------------
+//Store a uint32 little endian
+//Input: buffer, value
+//Output: None
+void Command_PutUint32(uint8_t *buffer, uint32_t value){
+    buffer[0] = value;
+    buffer[1] = value >> 8;
+    buffer[2] = value >> 16;
+    buffer[3] = value >> 24;
+}
+
+//------------------Command_GetFloat()---------------------------
+//Load a float32 little endian
+//Input: buffer
+//Output: Value
+float Command_GetFloat(const uint8_t *buffer){
+    uint32_t u;
+    float value;
+
+    u = buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+    memcpy(&value, &u, 4);
+    return value;
+}
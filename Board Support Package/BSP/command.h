@@ -0,0 +1,199 @@
+// command.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Binary command protocol on UART0. The UART interrupt hands every received
+// byte to Command_Receive(), a state machine that frames requests without
+// waiting and queues them; the background loop takes them with
+// Command_Get(), which checks the CRC, runs them (SerialMonitor_Receive() in
+// slug.c) and sends the reply framed by Command_EncodeReply().
+// Host Tools/slugLink.h is the host side.
+//
+// Request, host to board, little endian:
+//   offset size
+//   0      2    sync word 0xC55A (bytes 0x5A 0xC5)
+//   2      1    sequence number, echoed in the reply
+//   3      1    command (Command_Code), | COMMAND_NO_REPLY for no reply
+//   4      1    payload length n, at most COMMAND_MAX_PAYLOAD
+//   5      n    payload
+//   5+n    2    CRC-16/CCITT-FALSE of bytes 2 to 4+n
+// Reply, board to host, between the telemetry records:
+//   0      2    sync word 0xD55A (bytes 0x5A 0xD5)
+//   2      1    sequence number of the request
+//   3      1    command of the request
+//   4      1    status (Command_Status)
+//   5      1    payload length n
+//   6      n    payload
+//   6+n    2    CRC-16/CCITT-FALSE of bytes 2 to 5+n
+// A request with a bad CRC is dropped without a reply, the host times out and
+// sends it again. A request that comes while the transmitter has no room for
+// its longest reply is not run, the reply is COMMAND_BUSY and the host sends
+// it again after a pause. Values are float32, parameters are numbered from 0.
+//
+//   command       payload                 reply payload
+//   PING          -                       protocol version (uint8)
+//   PARAM_COUNT   -                       number of parameters (uint8)
+//   PARAM_NAME    id (uint8)              id, name (ASCII, no terminator)
+//   GET           id (uint8)              id, value (float32)
+//   SET           id, value (float32)     id, value now set (float32)
+//   GOAL          force, lb (float32)     -   stream with COMMAND_NO_REPLY
+//   START         -                       -   controller on
+//   STOP          -                       -   controller off, motor at 0
+//   LOGGER        1 on, 0 off (uint8)     -
+//   SELECT        controller (uint8)      -   Controller_Id
+//   PROFILE       handler, page (uint8)   handler, page, then for page 0:
+//                                         count, min, mean, max, period,
+//                                         latency max, missed (uint32 each);
+//                                         for page p > 0 latency bins
+//                                         7(p-1) to 7p-1 (uint32 each)
+//   PROFILE_RESET -                       -
+//   MONITOR       page (uint8)            page, then for page 0: ticks,
+//                                         overruns, bucket, tripped, jitter
+//                                         min, jitter max (int32), longest
+//                                         tick (uint32 each); for page p > 0
+//                                         jitter bins 7(p-1) to 7p-1
+//   LOAD          tier (uint8)            tier, CPU load in 0.01 %, runs,
+//                                         latency max, latency mean
+//                                         (uint32 each, cycles)
+//   STORE         action (uint8)          action, status, parameters loaded,
+//                                         records skipped (uint8 each),
+//                                         saves (uint32) of the parameter
+//                                         store (paramStore.h), after the
+//                                         action: INFO, SAVE, LOAD, DEFAULTS
+//                                         or ERASE (Command_StoreAction),
+//                                         1 if the gain schedule was
+//                                         loaded or saved with them (uint8)
+//   SCHEDULE      action (uint8), then    action, then
+//                 INFO: -                 goals, errors (uint8 each)
+//                 GET: i, j (uint8)       i, j, goal i, error j, kp, ki, kd
+//                                         (float32 each) of the gain schedule
+//                                         of CONTROLLER_SCHEDULED
+//                 BEGIN: goals, errors    goals, errors; the upload starts
+//                 (uint8)                 from a copy of the schedule in use
+//                 PUT: i, j, goal i,      i, j; written to the upload
+//                 error j, kp, ki, kd
+//                 COMMIT: -               -   the upload replaces the
+//                                         schedule if GainSchedule_Check()
+//                                         accepts it, OUT_OF_RANGE if not
+//                                         (Command_ScheduleAction)
+// The PROFILE commands are unknown unless the board is built with profiling
+// (profile.h), LOAD unless it runs TI-RTOS (RTOS/ForceControl_RTOS), which
+// numbers its tiers.
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+#include <stdint.h>
+
+#define COMMAND_SYNC            0xC55A
+#define COMMAND_REPLY_SYNC      0xD55A
+#define COMMAND_VERSION         1
+#define COMMAND_MAX_PAYLOAD     32
+#define COMMAND_REQUEST_SIZE(n) (7 + (n))
+#define COMMAND_REPLY_SIZE(n)   (8 + (n))
+#define COMMAND_QUEUE_SIZE      8       // requests, power of 2
+#define COMMAND_NO_REPLY        0x80
+#define COMMAND_PAGE_BINS       7       // histogram bins per PROFILE or MONITOR page
+
+typedef enum {
+    COMMAND_PING = 1,
+    COMMAND_PARAM_COUNT,
+    COMMAND_PARAM_NAME,
+    COMMAND_GET,
+    COMMAND_SET,
+    COMMAND_GOAL,
+    COMMAND_START,
+    COMMAND_STOP,
+    COMMAND_LOGGER,
+    COMMAND_SELECT,
+    COMMAND_PROFILE,
+    COMMAND_PROFILE_RESET,
+    COMMAND_MONITOR,
+    COMMAND_LOAD,
+    COMMAND_STORE,
+    COMMAND_SCHEDULE
+} Command_Code;
+
+typedef enum {
+    COMMAND_STORE_INFO = 0,     // state of the last load or save
+    COMMAND_STORE_SAVE,         // parameters to EEPROM
+    COMMAND_STORE_LOAD,         // EEPROM to the parameters
+    COMMAND_STORE_DEFAULTS,     // parameters back to the build values, EEPROM kept
+    COMMAND_STORE_ERASE         // EEPROM store erased, the next reset boots on the build values
+} Command_StoreAction;
+
+typedef enum {
+    COMMAND_SCHEDULE_INFO = 0,  // breakpoint counts of the gain schedule in use
+    COMMAND_SCHEDULE_GET,       // one entry of the gain schedule in use
+    COMMAND_SCHEDULE_BEGIN,     // start an upload with new breakpoint counts
+    COMMAND_SCHEDULE_PUT,       // one entry of the upload
+    COMMAND_SCHEDULE_COMMIT     // checked upload replaces the schedule in use
+} Command_ScheduleAction;
+
+typedef enum {
+    COMMAND_OK = 0,
+    COMMAND_UNKNOWN,            // no such command
+    COMMAND_BAD_LENGTH,         // payload too short or too long for the command
+    COMMAND_BAD_ID,             // no such parameter, controller, handler or tier
+    COMMAND_OUT_OF_RANGE,       // value outside the limits of the parameter
+    COMMAND_BUSY                // not run, no room for the reply, send it again
+} Command_Status;
+
+typedef struct {
+    uint8_t seq;
+    uint8_t code;               // COMMAND_NO_REPLY included
+    uint8_t length;
+    uint8_t payload[COMMAND_MAX_PAYLOAD];
+    uint16_t crc;               // as received
+} Command_Request;
+
+//------------------Command_Init()---------------------------
+//Empty the queue, wait for a sync word and clear the error counts
+//Input: None
+//Output: None
+void Command_Init(void);
+
+//------------------Command_Receive()---------------------------
+//Frame one received byte, called from the UART interrupt. A complete request
+//is queued, dropped when the queue is full
+//Input: byte
+//Output: None
+void Command_Receive(uint8_t byte);
+
+//------------------Command_Get()---------------------------
+//Take the next queued request with a good CRC, call from the background loop
+//Input: request out
+//Output: 1 if a request was taken, 0 if none is waiting
+int Command_Get(Command_Request *request);
+
+//------------------Command_EncodeReply()---------------------------
+//Frame the reply to a request
+//Input: request, status, payload, payload length (at most COMMAND_MAX_PAYLOAD),
+//       output buffer of COMMAND_REPLY_SIZE(length) bytes
+//Output: Frame length
+uint32_t Command_EncodeReply(const Command_Request *request, Command_Status status,
+                             const uint8_t *payload, uint32_t length, uint8_t *frame);
+
+//------------------Command_Errors()---------------------------
+//Get the number of requests dropped: bad CRC, bad length or queue full
+//Input: None
+//Output: Dropped requests
+uint32_t Command_Errors(void);
+
+//------------------Command_PutFloat()---------------------------
+//Store a float32 little endian
+//Input: buffer, value
+//Output: None
+void Command_PutFloat(uint8_t *buffer, float value);
+
+//------------------Command_PutUint32()---------------------------
+//Store a uint32 little endian
+//Input: buffer, value
+//Output: None
+void Command_PutUint32(uint8_t *buffer, uint32_t value);
+
+//------------------Command_GetFloat()---------------------------
+//Load a float32 little endian
+//Input: buffer
+//Output: Value
+float Command_GetFloat(const uint8_t *buffer);
+
+#endif /* COMMAND_H_ */
@@ -0,0 +1,78 @@
+// decimator.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// CIC decimator, see decimator.h.
+
+#include "decimator.h"
+
+#if DECIMATOR_ORDER < 1 || DECIMATOR_ORDER > 3
+#error "DECIMATOR_ORDER must be 1, 2 or 3"
+#endif
+
+#define DECIMATOR_SHIFT     (DECIMATOR_ORDER*DECIMATOR_RATE_LOG2 - DECIMATOR_FRAC_BITS)
+
+//------------------Decimator_Init()---------------------------
+//Reset the filter to the steady state of a constant input
+//Input: filter, initial ADC value
+//Output: None
+void Decimator_Init(Decimator *d, uint16_t value){
+    uint16_t block[DECIMATOR_RATE];
+    int i;
+
+    for(i = 0; i < DECIMATOR_ORDER; i++){
+        d->integrator[i] = 0;
+        d->comb[i] = 0;
+    }
+
+    // The combs settle after ORDER blocks of a constant input
+    for(i = 0; i < DECIMATOR_RATE; i++){
+        block[i] = value;
+    }
+    for(i = 0; i < DECIMATOR_ORDER; i++){
+        Decimator_Block(d, block);
+    }
+}
+
+//------------------Decimator_Block()---------------------------
+//Filter one block of DECIMATOR_RATE samples
+//Input: filter, samples
+//Output: Filtered value, ADC counts * 2^DECIMATOR_FRAC_BITS
+int32_t Decimator_Block(Decimator *d, const uint16_t *samples){
+    uint32_t i1 = d->integrator[0];
+#if DECIMATOR_ORDER > 1
+    uint32_t i2 = d->integrator[1];
+#endif
+#if DECIMATOR_ORDER > 2
+    uint32_t i3 = d->integrator[2];
+#endif
+    uint32_t y, prev;
+    int i;
+
+    // Integrators at the input rate
+    for(i = 0; i < DECIMATOR_RATE; i++){
+        i1 += samples[i];
+#if DECIMATOR_ORDER > 1
+        i2 += i1;
+#endif
+#if DECIMATOR_ORDER > 2
+        i3 += i2;
+#endif
+    }
+    d->integrator[0] = i1;
+#if DECIMATOR_ORDER > 1
+    d->integrator[1] = i2;
+#endif
+#if DECIMATOR_ORDER > 2
+    d->integrator[2] = i3;
+#endif
+    y = d->integrator[DECIMATOR_ORDER - 1];
+
+    // Combs at the output rate, differential delay 1
+    for(i = 0; i < DECIMATOR_ORDER; i++){
+        prev = d->comb[i];
+        d->comb[i] = y;
+        y -= prev;
+    }
+
+    d->out = (int32_t)((y + (1u << (DECIMATOR_SHIFT - 1))) >> DECIMATOR_SHIFT);
+    return d->out;
+}
@@ -0,0 +1,42 @@
+// decimator.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// CIC (cascaded integrator comb) decimator for blocks of raw ADC samples.
+// One block of DECIMATOR_RATE samples gives one output, so it runs once per
+// uDMA block in the ADC interrupt. Integer only: DECIMATOR_ORDER adds per
+// sample, DECIMATOR_ORDER subtractions per block.
+// The DC gain RATE^ORDER is divided out down to DECIMATOR_FRAC_BITS
+// fractional bits, so the output keeps the extra resolution of the
+// averaged samples (ADC counts * 2^DECIMATOR_FRAC_BITS).
+// Group delay is ORDER*(RATE-1)/2 input samples.
+
+#ifndef DECIMATOR_H_
+#define DECIMATOR_H_
+
+#include <stdint.h>
+
+#define DECIMATOR_RATE_LOG2     4                           // 16 samples per output
+#define DECIMATOR_RATE          (1 << DECIMATOR_RATE_LOG2)
+#define DECIMATOR_ORDER         3                           // 1 to 3
+#define DECIMATOR_FRAC_BITS     4
+
+// 12 bit samples, the integrators need 12 + ORDER*RATE_LOG2 bits; they wrap
+// in two's complement and the combs undo the wrap
+typedef struct {
+    uint32_t integrator[DECIMATOR_ORDER];
+    uint32_t comb[DECIMATOR_ORDER];         // previous comb inputs
+    int32_t out;                            // last output
+} Decimator;
+
+//------------------Decimator_Init()---------------------------
+//Reset the filter, preloaded so the first outputs already read value
+//Input: filter, initial ADC value
+//Output: None
+void Decimator_Init(Decimator *d, uint16_t value);
+
+//------------------Decimator_Block()---------------------------
+//Filter one block of DECIMATOR_RATE samples
+//Input: filter, samples
+//Output: Filtered value, ADC counts * 2^DECIMATOR_FRAC_BITS
+int32_t Decimator_Block(Decimator *d, const uint16_t *samples);
+
+#endif /* DECIMATOR_H_ */
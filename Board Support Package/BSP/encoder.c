@@ -0,0 +1,145 @@
+// encoder.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Position and velocity estimator for the incremental encoder, see encoder.h.
+
+#include "encoder.h"
+
+#define ENCODER_ONE     (1 << ENCODER_FRAC_BITS)
+
+//------------------Encoder_Init()---------------------------
+//Reset the estimator at rest
+//Input: estimator, QEI position, QEI maximum position, update rate (Hz),
+//       velocity timer rate (Hz)
+//Output: None
+void Encoder_Init(Encoder_Estimator *e, uint32_t raw, uint32_t top, uint32_t tickFreq, uint32_t velocityFreq){
+    e->top = top;
+    e->tickFreq = tickFreq;
+    e->velocityFreq = velocityFreq;
+    e->stopTicks = (uint32_t)(ENCODER_STOP_TIME*tickFreq);
+    if(e->stopTicks < 2){
+        e->stopTicks = 2;
+    }
+    e->windowTicks = (uint32_t)(ENCODER_WINDOW*tickFreq);
+    if(e->windowTicks < 1){
+        e->windowTicks = 1;
+    }
+    e->raw = raw;
+    e->count = (int32_t)raw;
+    e->tick = 0;
+    e->moves = 0;
+    e->newest = 0;
+    e->moveTick[0] = 0;
+    e->moveCount[0] = e->count;
+    e->ticksSinceEdge = e->stopTicks;
+    e->lastPeriod = e->stopTicks;
+    e->lastDirection = 1;
+    e->periodVelocity = 0;
+    e->edgeVelocity = 0;
+    e->velocity = 0;
+    e->position = e->count*ENCODER_ONE;
+}
+
+//------------------unwrap()---------------------------
+//Counts moved since the last update, the shorter way round the QEI range
+static int32_t unwrap(const Encoder_Estimator *e, uint32_t raw){
+    int32_t d = (int32_t)(raw - e->raw);
+    int32_t range = (int32_t)(e->top + 1);
+
+    if(range > 0){
+        if(d > range/2){
+            d -= range;
+        }else if(d < -(range/2)){
+            d += range;
+        }
+    }
+    return d;
+}
+
+//------------------periodMeasure()---------------------------
+//Velocity from the moves in the history, the last one just stored: back to
+//the oldest move within the window, at least the move before the last one.
+//The first move after a stop only gives a lower bound.
+static int32_t periodMeasure(const Encoder_Estimator *e){
+    uint32_t i = e->newest, j, k, span;
+
+    j = (i - 1) & (ENCODER_HISTORY - 1);
+    for(k = 2; k < e->moves; k++){
+        uint32_t older = (j - 1) & (ENCODER_HISTORY - 1);
+        if(e->moveTick[i] - e->moveTick[older] > e->windowTicks){
+            break;
+        }
+        j = older;
+    }
+    span = e->moveTick[i] - e->moveTick[j];
+    return (e->moveCount[i] - e->moveCount[j])*ENCODER_ONE*(int32_t)e->tickFreq/(int32_t)span;
+}
+
+//------------------Encoder_Update()---------------------------
+//Run one tick
+//Input: estimator, QEI position, edges latched by the velocity timer,
+//       QEI direction (+1 or -1)
+//Output: Velocity, counts/s * 2^ENCODER_FRAC_BITS
+int32_t Encoder_Update(Encoder_Estimator *e, uint32_t raw, uint32_t edges, int32_t direction){
+    int32_t d = unwrap(e, raw);
+    int32_t w, v, interp, limit;
+
+    e->raw = raw;
+    e->count += d;
+    e->tick++;
+    if(e->ticksSinceEdge < e->stopTicks){
+        e->ticksSinceEdge++;
+    }
+
+    // Period measurement
+    if(d != 0){
+        e->newest = (e->newest + 1) & (ENCODER_HISTORY - 1);
+        e->moveTick[e->newest] = e->tick;
+        e->moveCount[e->newest] = e->count;
+        if(((d > 0) ? 1 : -1) != e->lastDirection){
+            // Reversed: the edge just crossed back tells nothing of the speed,
+            // hold 0 until the next move
+            e->moves = 1;
+            e->periodVelocity = 0;
+            e->lastPeriod = e->stopTicks;
+        }else{
+            if(e->moves < ENCODER_HISTORY){
+                e->moves++;
+            }
+            e->periodVelocity = periodMeasure(e);
+            e->lastPeriod = e->ticksSinceEdge;
+        }
+        e->lastDirection = (d > 0) ? 1 : -1;
+        e->ticksSinceEdge = 0;
+    }else if(e->ticksSinceEdge >= e->stopTicks){
+        e->periodVelocity = 0;
+    }else if(e->ticksSinceEdge > e->lastPeriod){
+        // Slower than the last period, at most one count in the time waited
+        e->periodVelocity = e->lastDirection*(int32_t)(e->tickFreq*ENCODER_ONE/e->ticksSinceEdge);
+    }
+
+    // Edge counting, over the last velocity timer period
+    e->edgeVelocity = direction*(int32_t)(edges*e->velocityFreq)*ENCODER_ONE;
+
+    // Blend, weight of edge counting in 1/256
+    w = ((int32_t)edges - ENCODER_SLOW_EDGES)*256/(ENCODER_FAST_EDGES - ENCODER_SLOW_EDGES);
+    if(w < 0) w = 0;
+    if(w > 256) w = 256;
+    e->velocity = e->periodVelocity + (int32_t)(((int64_t)(e->edgeVelocity - e->periodVelocity)*w) >> 8);
+
+    // Position, moved on since the last edge by less than one count. Counting
+    // down the edge crossed into count c is at c + 1.
+    interp = (e->lastDirection < 0) ? ENCODER_ONE : 0;
+    if(e->ticksSinceEdge > 0){
+        limit = (int32_t)e->tickFreq*ENCODER_ONE;
+        v = e->velocity;
+        if(v > limit) v = limit;
+        if(v < -limit) v = -limit;
+        v = v*(int32_t)e->ticksSinceEdge/(int32_t)e->tickFreq;
+        if(v > ENCODER_ONE - 1) v = ENCODER_ONE - 1;
+        if(v < -(ENCODER_ONE - 1)) v = -(ENCODER_ONE - 1);
+        interp += v;
+    }
+    e->position = e->count*ENCODER_ONE + interp;
+
+    return e->velocity;
+}
@@ -0,0 +1,69 @@
+// encoder.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Position and velocity estimator for the incremental encoder on QEI1,
+// updated once per controller tick. Two velocity measurements are blended:
+//   - edge counting: edges the QEI velocity timer latched over its last
+//     period, accurate when many edges fall in one period
+//   - period measurement: counts moved divided by the ticks between the ticks
+//     that saw them move, accurate when edges are ticks apart. It spans as
+//     many of the last ENCODER_HISTORY moves as fit in ENCODER_WINDOW, back
+//     to the last reversal, so one tick of timing error is spread over
+//     several edges. While no edge comes the estimate decays as 1/t (it cannot
+//     be faster than one count in the time waited) and drops to 0 after
+//     ENCODER_STOP_TIME.
+// The weight of edge counting goes from 0 at ENCODER_SLOW_EDGES to 1 at
+// ENCODER_FAST_EDGES edges per velocity period. The position is the last
+// edge crossed, unwrapped, plus the motion since, less than one count; count
+// c covers the positions from c to c + 1.
+// Integer only. Velocity and unwrapped position must stay within
+// 2^(31 - ENCODER_FRAC_BITS) counts/s and counts.
+
+#ifndef ENCODER_H_
+#define ENCODER_H_
+
+#include <stdint.h>
+
+#define ENCODER_FRAC_BITS       8       // fraction bits of velocity and position
+#define ENCODER_SLOW_EDGES      2       // edges per velocity period, period measurement only
+#define ENCODER_FAST_EDGES      8       // edges per velocity period, edge counting only
+#define ENCODER_STOP_TIME       0.25    // s without an edge before the velocity is 0
+#define ENCODER_WINDOW          0.01    // s, longest span of the period measurement
+#define ENCODER_HISTORY         8       // moves kept for the period measurement, power of 2
+
+typedef struct {
+    uint32_t top;               // QEI maximum position, the count wraps after it
+    uint32_t tickFreq;          // Encoder_Update() calls per second
+    uint32_t velocityFreq;      // velocity timer periods per second
+    uint32_t stopTicks;
+    uint32_t windowTicks;
+    uint32_t raw;               // QEI position at the last update
+    int32_t count;              // unwrapped position, counts
+    uint32_t tick;              // updates since Encoder_Init()
+    uint32_t moveTick[ENCODER_HISTORY];  // tick and count of the last moves
+    int32_t moveCount[ENCODER_HISTORY];
+    uint32_t moves;             // moves since the last reversal, ENCODER_HISTORY at most
+    uint32_t newest;            // index of the last move
+    uint32_t ticksSinceEdge;    // updates since the count last moved
+    uint32_t lastPeriod;        // ticks between the last two moves
+    int32_t lastDirection;      // +1 or -1, of the last move
+    int32_t periodVelocity;     // counts/s * 2^ENCODER_FRAC_BITS
+    int32_t edgeVelocity;
+    int32_t velocity;           // blended
+    int32_t position;           // counts * 2^ENCODER_FRAC_BITS
+} Encoder_Estimator;
+
+//------------------Encoder_Init()---------------------------
+//Reset the estimator at rest
+//Input: estimator, QEI position, QEI maximum position, update rate (Hz),
+//       velocity timer rate (Hz)
+//Output: None
+void Encoder_Init(Encoder_Estimator *e, uint32_t raw, uint32_t top, uint32_t tickFreq, uint32_t velocityFreq);
+
+//------------------Encoder_Update()---------------------------
+//Run one tick
+//Input: estimator, QEI position, edges latched by the velocity timer,
+//       QEI direction (+1 or -1)
+//Output: Velocity, counts/s * 2^ENCODER_FRAC_BITS
+int32_t Encoder_Update(Encoder_Estimator *e, uint32_t raw, uint32_t edges, int32_t direction);
+
+#endif /* ENCODER_H_ */
@@ -0,0 +1,535 @@
+// forceControl.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Hardware independent force control laws called from the controller ISR.
+// This file contains the double, float32 and fixed point versions of the
+// PID and adaptive (MRAC) laws. See forceControl.h for the formats.
+
+#include <stdlib.h>
+#include <math.h>
+#include "forceControl.h"
+
+// ********************************************************
+// ****************** Fixed point helpers *****************
+// ********************************************************
+#define Q16_MAX ((int64_t)INT32_MAX)
+#define Q16_MIN (-(int64_t)INT32_MAX)
+
+//------------------satQ16()---------------------------
+//Saturate a 64 bit intermediate to an int32_t, symmetric so the result
+//can always be negated
+//Input: value
+//Output: Saturated value
+static int32_t satQ16(int64_t v){
+    if(v > Q16_MAX){
+        return INT32_MAX;
+    }
+    if(v < Q16_MIN){
+        return -INT32_MAX;
+    }
+    return (int32_t)v;
+}
+
+//------------------gainQ24()---------------------------
+//Convert a PID gain to Q8.24, gains are limited to |gain| < FC_GAIN_LIMIT
+//Input: gain
+//Output: Q8.24 gain
+static int32_t gainQ24(double gain){
+    if(gain >= FC_GAIN_LIMIT){
+        return INT32_MAX;
+    }
+    if(gain <= -FC_GAIN_LIMIT){
+        return -INT32_MAX;
+    }
+    return FC_Q24(gain);
+}
+
+//------------------gainQ31()---------------------------
+//Convert a coefficient to Q31, coefficients are limited to |coefficient| < 1
+//Input: gain
+//Output: Q31 gain
+static int32_t gainQ31(double gain){
+    if(gain >= 1.0){
+        return INT32_MAX;
+    }
+    if(gain <= -1.0){
+        return -INT32_MAX;
+    }
+    return FC_Q31(gain);
+}
+
+// ********************************************************
+// ******************* PID law ****************************
+// ********************************************************
+//------------------FC_PIDInit_F64()---------------------------
+//Reset the PID state and load the gains
+//Input: state, gains, integral error limits
+//Output: None
+void FC_PIDInit_F64(FC_PID_F64 *pid, double Kbar, double Ki, double Kd, double integralMin, double integralMax){
+    pid->Kbar = Kbar;
+    pid->Ki = Ki;
+    pid->Kd = Kd;
+    pid->integralMin = integralMin;
+    pid->integralMax = integralMax;
+    pid->lastError = 0;
+    pid->totalError = 0;
+    pid->Kp = 0;
+    pid->error = 0;
+    pid->out = 0;
+    pid->duty = 0;
+    pid->direction = 1;
+}
+
+//------------------FC_PIDSetGoal_F64()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_PIDSetGoal_F64(FC_PID_F64 *pid, double goal){
+    pid->goal = goal;
+}
+
+//------------------FC_PIDStep_F64()---------------------------
+//Run one controller tick, original double precision PID_control()
+//Input: state, load in pound (Q16.16)
+//Output: None
+void FC_PIDStep_F64(FC_PID_F64 *pid, int32_t load){
+    double measured, P, D, I, duty;
+
+    measured = load*(1.0/FC_Q16_ONE);
+    pid->error = pid->goal - measured;
+
+    pid->Kp = pid->Kbar*abs((int)pid->error);
+    P = pid->Kp*pid->error;
+
+    D = pid->Kd*(pid->error - pid->lastError);
+    pid->lastError = pid->error;
+
+    pid->totalError = pid->totalError + pid->error;
+    if(pid->totalError > pid->integralMax)
+        pid->totalError = pid->integralMax;
+    if(pid->totalError < pid->integralMin)
+        pid->totalError = pid->integralMin;
+    I = pid->Ki*pid->totalError;
+
+    pid->out = P + D + I;
+
+    // Limits
+    duty = pid->out;
+    if(duty < 0){
+        pid->direction = 0;
+        duty = -duty;
+    }else{
+        pid->direction = 1;
+    }
+    if(duty > FC_MAX_DUTY){
+        duty = FC_MAX_DUTY;
+    }
+    pid->duty = (uint32_t)duty;
+}
+
+//------------------FC_PIDInit_F32()---------------------------
+//Reset the PID state and load the gains
+//Input: state, gains, integral error limits
+//Output: None
+void FC_PIDInit_F32(FC_PID_F32 *pid, double Kbar, double Ki, double Kd, double integralMin, double integralMax){
+    pid->Kbar = (float)Kbar;
+    pid->Ki = (float)Ki;
+    pid->Kd = (float)Kd;
+    pid->integralMin = (float)integralMin;
+    pid->integralMax = (float)integralMax;
+    pid->lastError = 0;
+    pid->totalError = 0;
+    pid->Kp = 0;
+    pid->error = 0;
+    pid->out = 0;
+    pid->duty = 0;
+    pid->direction = 1;
+}
+
+//------------------FC_PIDSetGoal_F32()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_PIDSetGoal_F32(FC_PID_F32 *pid, double goal){
+    pid->goal = (float)goal;
+}
+
+//------------------FC_PIDStep_F32()---------------------------
+//Run one controller tick in single precision
+//Input: state, load in pound (Q16.16)
+//Output: None
+void FC_PIDStep_F32(FC_PID_F32 *pid, int32_t load){
+    float measured, P, D, I, duty;
+
+    measured = (float)load*(1.0f/FC_Q16_ONE);
+    pid->error = pid->goal - measured;
+
+    pid->Kp = pid->Kbar*(float)abs((int)pid->error);
+    P = pid->Kp*pid->error;
+
+    D = pid->Kd*(pid->error - pid->lastError);
+    pid->lastError = pid->error;
+
+    pid->totalError = pid->totalError + pid->error;
+    if(pid->totalError > pid->integralMax)
+        pid->totalError = pid->integralMax;
+    if(pid->totalError < pid->integralMin)
+        pid->totalError = pid->integralMin;
+    I = pid->Ki*pid->totalError;
+
+    pid->out = P + D + I;
+
+    // Limits
+    duty = pid->out;
+    if(duty < 0.0f){
+        pid->direction = 0;
+        duty = -duty;
+    }else{
+        pid->direction = 1;
+    }
+    if(duty > (float)FC_MAX_DUTY){
+        duty = (float)FC_MAX_DUTY;
+    }
+    pid->duty = (uint32_t)duty;
+}
+
+//------------------FC_PIDInit_Q()---------------------------
+//Reset the PID state and load the gains
+//Input: state, gains (|gain| < FC_GAIN_LIMIT), integral error limits
+//Output: None
+void FC_PIDInit_Q(FC_PID_Q *pid, double Kbar, double Ki, double Kd, double integralMin, double integralMax){
+    pid->Kbar = gainQ24(Kbar);
+    pid->Ki = gainQ24(Ki);
+    pid->Kd = gainQ24(Kd);
+    pid->integralMin = FC_Q16(integralMin);
+    pid->integralMax = FC_Q16(integralMax);
+    pid->lastError = 0;
+    pid->totalError = 0;
+    pid->Kp = 0;
+    pid->error = 0;
+    pid->out = 0;
+    pid->duty = 0;
+    pid->direction = 1;
+}
+
+//------------------FC_PIDSetGoal_Q()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_PIDSetGoal_Q(FC_PID_Q *pid, double goal){
+    pid->goal = FC_Q16(goal);
+}
+
+//------------------FC_PIDStep_Q()---------------------------
+//Run one controller tick in fixed point
+//Input: state, load in pound (Q16.16)
+//Output: None
+void FC_PIDStep_Q(FC_PID_Q *pid, int32_t load){
+    int32_t measured, absError, P, D, I;
+    int64_t total;
+    uint32_t duty;
+
+    measured = load;
+    pid->error = satQ16((int64_t)pid->goal - measured);
+
+    // Kp = Kbar*abs(error) with the integer truncation of abs()
+    absError = (pid->error < 0) ? -pid->error : pid->error;
+    pid->Kp = satQ16(((int64_t)pid->Kbar*(absError >> 16)) >> 8);
+    P = satQ16(((int64_t)pid->Kp*pid->error) >> 16);
+
+    D = satQ16(((int64_t)pid->Kd*((int64_t)pid->error - pid->lastError)) >> 24);
+    pid->lastError = pid->error;
+
+    total = (int64_t)pid->totalError + pid->error;
+    if(total > pid->integralMax)
+        total = pid->integralMax;
+    if(total < pid->integralMin)
+        total = pid->integralMin;
+    pid->totalError = (int32_t)total;
+    I = satQ16(((int64_t)pid->Ki*pid->totalError) >> 24);
+
+    pid->out = satQ16((int64_t)P + D + I);
+
+    // Limits
+    if(pid->out < 0){
+        pid->direction = 0;
+        duty = (uint32_t)(-(int64_t)pid->out >> 16);
+    }else{
+        pid->direction = 1;
+        duty = (uint32_t)(pid->out >> 16);
+    }
+    if(duty > FC_MAX_DUTY){
+        duty = FC_MAX_DUTY;
+    }
+    pid->duty = duty;
+}
+
+// ********************************************************
+// ***************** Adaptive law *************************
+// ********************************************************
+//------------------FC_MRACInit_F64()---------------------------
+//Reset the adaptive state and load the adaptation gains
+//Input: state, gamma_x, gamma_r, controller frequency
+//Output: None
+void FC_MRACInit_F64(FC_MRAC_F64 *mrac, double gamma_x, double gamma_r, uint32_t controllerFreq){
+    double dt = 1.0/(double)controllerFreq;
+
+    mrac->gamma_x = gamma_x;
+    mrac->gamma_r = gamma_r;
+    mrac->refStep = 1.0 - exp(-FC_MRAC_POLE*dt);
+    mrac->gammaDt_x = gamma_x*dt;
+    mrac->gammaDt_r = gamma_r*dt;
+    mrac->started = 0;
+    mrac->x_ref = 0;
+    mrac->x = 0;
+    mrac->error = 0;
+    mrac->theta_x = 0;
+    mrac->theta_r = 0;
+    mrac->out = 0;
+    mrac->duty = 0;
+    mrac->direction = 1;
+}
+
+//------------------FC_MRACSetGoal_F64()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_MRACSetGoal_F64(FC_MRAC_F64 *mrac, double goal){
+    mrac->goal = goal;
+}
+
+//------------------FC_MRACStep_F64()---------------------------
+//Run one controller tick in double precision
+//Input: state, load in pound (Q16.16)
+//Output: None
+void FC_MRACStep_F64(FC_MRAC_F64 *mrac, int32_t load){
+    double duty;
+
+    //Plant output
+    mrac->x = load*(1.0/FC_Q16_ONE);
+    if(!mrac->started){
+        mrac->x_ref = mrac->x;
+        mrac->started = 1;
+    }
+
+    //Error
+    mrac->error = mrac->x - mrac->x_ref;
+
+    //Theta integration
+    mrac->theta_x -= mrac->gammaDt_x*mrac->error*mrac->x;
+    mrac->theta_r -= mrac->gammaDt_r*mrac->error*mrac->goal;
+    if(mrac->theta_x > FC_MRAC_THETA_MAX) mrac->theta_x = FC_MRAC_THETA_MAX;
+    if(mrac->theta_x < -FC_MRAC_THETA_MAX) mrac->theta_x = -FC_MRAC_THETA_MAX;
+    if(mrac->theta_r > FC_MRAC_THETA_MAX) mrac->theta_r = FC_MRAC_THETA_MAX;
+    if(mrac->theta_r < -FC_MRAC_THETA_MAX) mrac->theta_r = -FC_MRAC_THETA_MAX;
+
+    // Calculate output
+    mrac->out = mrac->theta_x*mrac->x + mrac->theta_r*mrac->goal;
+
+    // Reference model, next tick
+    mrac->x_ref += mrac->refStep*(mrac->goal - mrac->x_ref);
+
+    // Limits
+    duty = mrac->out;
+    if(duty < 0){
+        mrac->direction = 0;
+        duty = -duty;
+    }else{
+        mrac->direction = 1;
+    }
+    if(duty > FC_MAX_DUTY){
+        duty = FC_MAX_DUTY;
+    }
+    mrac->duty = (uint32_t)duty;
+}
+
+//------------------FC_MRACInit_F32()---------------------------
+//Reset the adaptive state and load the adaptation gains
+//Input: state, gamma_x, gamma_r, controller frequency
+//Output: None
+void FC_MRACInit_F32(FC_MRAC_F32 *mrac, double gamma_x, double gamma_r, uint32_t controllerFreq){
+    double dt = 1.0/(double)controllerFreq;
+
+    mrac->gamma_x = (float)gamma_x;
+    mrac->gamma_r = (float)gamma_r;
+    mrac->refStep = (float)(1.0 - exp(-FC_MRAC_POLE*dt));
+    mrac->gammaDt_x = (float)(gamma_x*dt);
+    mrac->gammaDt_r = (float)(gamma_r*dt);
+    mrac->started = 0;
+    mrac->x_ref = 0;
+    mrac->x = 0;
+    mrac->error = 0;
+    mrac->theta_x = 0;
+    mrac->theta_r = 0;
+    mrac->carry_ref = 0;
+    mrac->carry_x = 0;
+    mrac->carry_r = 0;
+    mrac->out = 0;
+    mrac->duty = 0;
+    mrac->direction = 1;
+}
+
+//------------------sumAdd()---------------------------
+//Compensated (Kahan) sum of a float32 integrator, the carry keeps the low
+//bits of the step that fall under the resolution of the sum. Needs strict
+//float evaluation, a relaxed FP mode may fold the carry away
+static void sumAdd(float *sum, float *carry, float step){
+    float y = step - *carry;
+    float t = *sum + y;
+
+    *carry = (t - *sum) - y;
+    *sum = t;
+}
+
+//------------------FC_MRACSetGoal_F32()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_MRACSetGoal_F32(FC_MRAC_F32 *mrac, double goal){
+    mrac->goal = (float)goal;
+}
+
+//------------------FC_MRACStep_F32()---------------------------
+//Run one controller tick in single precision
+//Input: state, load in pound (Q16.16)
+//Output: None
+void FC_MRACStep_F32(FC_MRAC_F32 *mrac, int32_t load){
+    float duty;
+
+    //Plant output
+    mrac->x = (float)load*(1.0f/FC_Q16_ONE);
+    if(!mrac->started){
+        mrac->x_ref = mrac->x;
+        mrac->started = 1;
+    }
+
+    //Error
+    mrac->error = mrac->x - mrac->x_ref;
+
+    //Theta integration
+    sumAdd(&mrac->theta_x, &mrac->carry_x, -mrac->gammaDt_x*mrac->error*mrac->x);
+    sumAdd(&mrac->theta_r, &mrac->carry_r, -mrac->gammaDt_r*mrac->error*mrac->goal);
+    if(mrac->theta_x > (float)FC_MRAC_THETA_MAX) mrac->theta_x = (float)FC_MRAC_THETA_MAX;
+    if(mrac->theta_x < -(float)FC_MRAC_THETA_MAX) mrac->theta_x = -(float)FC_MRAC_THETA_MAX;
+    if(mrac->theta_r > (float)FC_MRAC_THETA_MAX) mrac->theta_r = (float)FC_MRAC_THETA_MAX;
+    if(mrac->theta_r < -(float)FC_MRAC_THETA_MAX) mrac->theta_r = -(float)FC_MRAC_THETA_MAX;
+
+    // Calculate output
+    mrac->out = mrac->theta_x*mrac->x + mrac->theta_r*mrac->goal;
+
+    // Reference model, next tick
+    sumAdd(&mrac->x_ref, &mrac->carry_ref, mrac->refStep*(mrac->goal - mrac->x_ref));
+
+    // Limits
+    duty = mrac->out;
+    if(duty < 0.0f){
+        mrac->direction = 0;
+        duty = -duty;
+    }else{
+        mrac->direction = 1;
+    }
+    if(duty > (float)FC_MAX_DUTY){
+        duty = (float)FC_MAX_DUTY;
+    }
+    mrac->duty = (uint32_t)duty;
+}
+
+// Theta limit of the fixed point integrators, Q47
+#define THETA_ACC_MAX ((int64_t)(FC_MRAC_THETA_MAX*140737488355328.0))
+
+//------------------clampAcc()---------------------------
+//Limit a Q47 theta integrator
+//Input: value
+//Output: Clamped value
+static int64_t clampAcc(int64_t v){
+    if(v > THETA_ACC_MAX){
+        return THETA_ACC_MAX;
+    }
+    if(v < -THETA_ACC_MAX){
+        return -THETA_ACC_MAX;
+    }
+    return v;
+}
+
+//------------------FC_MRACInit_Q()---------------------------
+//Reset the adaptive state and load the adaptation gains
+//Input: state, gamma_x, gamma_r (gamma*dt < 1), controller frequency
+//Output: None
+void FC_MRACInit_Q(FC_MRAC_Q *mrac, double gamma_x, double gamma_r, uint32_t controllerFreq){
+    double dt = 1.0/(double)controllerFreq;
+
+    mrac->refStep = gainQ31(1.0 - exp(-FC_MRAC_POLE*dt));
+    mrac->gammaDt_x = gainQ31(gamma_x*dt);
+    mrac->gammaDt_r = gainQ31(gamma_r*dt);
+    mrac->started = 0;
+    mrac->refAcc = 0;
+    mrac->x_ref = 0;
+    mrac->x = 0;
+    mrac->error = 0;
+    mrac->thetaAcc_x = 0;
+    mrac->thetaAcc_r = 0;
+    mrac->theta_x = 0;
+    mrac->theta_r = 0;
+    mrac->out = 0;
+    mrac->duty = 0;
+    mrac->direction = 1;
+}
+
+//------------------FC_MRACSetGoal_Q()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_MRACSetGoal_Q(FC_MRAC_Q *mrac, double goal){
+    mrac->goal = FC_Q16(goal);
+}
+
+//------------------FC_MRACStep_Q()---------------------------
+//Run one controller tick in fixed point
+//gamma*dt is too small for a Q16 theta, so the integrators are Q47 in 64 bit
+//and theta is their upper part
+//Input: state, load in pound (Q16.16)
+//Output: None
+void FC_MRACStep_Q(FC_MRAC_Q *mrac, int32_t load){
+    int32_t ex, er;
+    uint32_t duty;
+
+    //Plant output
+    mrac->x = load;
+    if(!mrac->started){
+        mrac->x_ref = mrac->x;
+        mrac->refAcc = (int64_t)mrac->x << 31;
+        mrac->started = 1;
+    }
+
+    //Error
+    mrac->error = satQ16((int64_t)mrac->x - mrac->x_ref);
+
+    //Theta integration, error*signal in Q16 then gamma*dt (Q31) makes Q47
+    ex = satQ16(((int64_t)mrac->error*mrac->x) >> 16);
+    er = satQ16(((int64_t)mrac->error*mrac->goal) >> 16);
+    mrac->thetaAcc_x = clampAcc(mrac->thetaAcc_x - (int64_t)mrac->gammaDt_x*ex);
+    mrac->thetaAcc_r = clampAcc(mrac->thetaAcc_r - (int64_t)mrac->gammaDt_r*er);
+    mrac->theta_x = (int32_t)(mrac->thetaAcc_x >> 31);
+    mrac->theta_r = (int32_t)(mrac->thetaAcc_r >> 31);
+
+    // Calculate output
+    mrac->out = satQ16((((int64_t)mrac->theta_x*mrac->x) >> 16) +
+                       (((int64_t)mrac->theta_r*mrac->goal) >> 16));
+
+    // Reference model, next tick. Integrated in Q47: a Q16 step rounds to 0
+    // within 0.003 lb of the goal and the error it leaves winds up theta
+    mrac->refAcc += (int64_t)mrac->refStep*((int64_t)mrac->goal - mrac->x_ref);
+    mrac->x_ref = satQ16((mrac->refAcc + (1 << 30)) >> 31);
+
+    // Limits
+    if(mrac->out < 0){
+        mrac->direction = 0;
+        duty = (uint32_t)(-(int64_t)mrac->out >> 16);
+    }else{
+        mrac->direction = 1;
+        duty = (uint32_t)(mrac->out >> 16);
+    }
+    if(duty > FC_MAX_DUTY){
+        duty = FC_MAX_DUTY;
+    }
+    mrac->duty = duty;
+}
@@ -0,0 +1,253 @@
+// forceControl.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Hardware independent force control laws called from the controller ISR.
+// This file contains the PID and adaptive (MRAC) laws in three numeric formats:
+//   FC_NUMERIC_DOUBLE - the original double precision code. The M4F FPU is single
+//                       precision only, so every operation goes through the RTS library
+//   FC_NUMERIC_FLOAT  - float32, every operation runs on the FPU
+//   FC_NUMERIC_FIXED  - integer only. Forces, errors and outputs are Q16.16 in an
+//                       int32_t, PID gains are Q8.24 (|gain| < FC_GAIN_LIMIT),
+//                       the adaptive coefficients Q31, products are 64 bit
+// slug.c uses the format selected by FC_NUMERIC (pre-define it in the project
+// settings, default is FC_NUMERIC_FLOAT). All three are always compiled so
+// the host benchmark can compare them against each other. Every law takes the
+// load in pound as Q16.16, so the fraction of the decimated and calibrated
+// reading reaches it whatever the format. On the trace of Host
+// Tools/controlBenchmark (200000 ticks) the command of the fixed point PID
+// is within 0.001% duty of the double law, the fixed point adaptive law
+// within 0.01%, 0.5% of its ticks send another integer duty. The float32
+// adaptive law sums the reference model and theta with a compensated (Kahan)
+// sum: a plain float32 x_ref stalls short of the goal once its step falls
+// under the resolution, theta integrates that error and the command drifted
+// up to 0.6%, with the carry it is within 0.0001% (one tick of 200000).
+
+#ifndef FORCECONTROL_H_
+#define FORCECONTROL_H_
+
+#include <stdint.h>
+
+// ********************************************************
+// *************** Numeric format select ******************
+// ********************************************************
+#define FC_NUMERIC_DOUBLE   0
+#define FC_NUMERIC_FLOAT    1
+#define FC_NUMERIC_FIXED    2
+
+#ifndef FC_NUMERIC
+#define FC_NUMERIC FC_NUMERIC_FLOAT
+#endif
+
+// Load cell conversion, same as adc2Vol() and Vol2Load() in slug.c
+#define FC_ADC_VREF         3.3
+#define FC_ADC_FULLSCALE    4095.0
+#define FC_VOL2LOAD         25.0
+#define FC_LOAD_PER_COUNT   (FC_ADC_VREF*FC_VOL2LOAD/FC_ADC_FULLSCALE) //pound per ADC count
+
+// Q formats used by the fixed point law
+#define FC_Q16_ONE          65536
+#define FC_Q16(x)           ((int32_t)((x)*65536.0 + (((x) < 0) ? -0.5 : 0.5)))
+#define FC_Q24(x)           ((int32_t)((x)*16777216.0 + (((x) < 0) ? -0.5 : 0.5)))
+#define FC_Q31(x)           ((int32_t)((x)*2147483648.0 + (((x) < 0) ? -0.5 : 0.5)))
+#define FC_GAIN_LIMIT       128     // |PID gain| below this in fixed point, Q8.24
+#define FC_LOAD_PER_COUNT_Q32 ((uint32_t)(FC_LOAD_PER_COUNT*4294967296.0 + 0.5))
+#define FC_LOAD_Q16(counts) ((int32_t)(((int64_t)(counts)*FC_LOAD_PER_COUNT_Q32) >> 16)) // ADC counts to pound
+
+// Duty cycle limit in percent, same as checkLimits() in slug.c
+#define FC_MAX_DUTY         100
+
+// ********************************************************
+// ******************* PID law ****************************
+// ********************************************************
+// Kp = Kbar*abs(error), abs() truncates to an integer as in the original
+// PID_control(). Integral error is clamped to [integralMin, integralMax].
+typedef struct {
+    double Kbar, Ki, Kd;
+    double integralMin, integralMax;
+    double goal;
+    double lastError, totalError;
+    double Kp, error, out;
+    uint32_t duty;      // 0-100 percent
+    int direction;      // 1 when out >= 0
+} FC_PID_F64;
+
+typedef struct {
+    float Kbar, Ki, Kd;
+    float integralMin, integralMax;
+    float goal;
+    float lastError, totalError;
+    float Kp, error, out;
+    uint32_t duty;
+    int direction;
+} FC_PID_F32;
+
+typedef struct {
+    int32_t Kbar, Ki, Kd;               // Q8.24
+    int32_t integralMin, integralMax;   // Q16
+    int32_t goal;                       // Q16
+    int32_t lastError, totalError;      // Q16
+    int32_t Kp, error, out;             // Q16
+    uint32_t duty;
+    int direction;
+} FC_PID_Q;
+
+// ********************************************************
+// ***************** Adaptive law *************************
+// ********************************************************
+// First order reference model x_ref' = FC_MRAC_POLE*(goal - x_ref), updated
+// recursively: x_ref += (1 - exp(-FC_MRAC_POLE*dt))*(goal - x_ref). It starts
+// at the first measured load. The coefficients are computed once in
+// FC_MRACInit, so a tick costs the same after hours of running.
+// Control law out = theta_x*x + theta_r*goal, with the adaptive parameters
+// integrated every tick (MIT rule, plant gain sign +1):
+//   theta_x += -gamma_x*dt*error*x,  theta_r += -gamma_r*dt*error*goal
+// and clamped to +-FC_MRAC_THETA_MAX so they cannot wind up while the duty
+// saturates.
+#define FC_MRAC_POLE        5.0     // 1/s, reference model bandwidth
+#define FC_MRAC_THETA_MAX   10.0    // percent duty per pound
+
+typedef struct {
+    double gamma_x, gamma_r;
+    double goal;
+    double refStep;                 // 1 - exp(-pole*dt)
+    double gammaDt_x, gammaDt_r;    // gamma*dt
+    int started;                    // x_ref seeded from the load
+    double x_ref, x, error;
+    double theta_x, theta_r;
+    double out;
+    uint32_t duty;
+    int direction;
+} FC_MRAC_F64;
+
+typedef struct {
+    float gamma_x, gamma_r;
+    float goal;
+    float refStep;
+    float gammaDt_x, gammaDt_r;
+    int started;
+    float x_ref, x, error;
+    float theta_x, theta_r;
+    float carry_ref, carry_x, carry_r; // low bits of x_ref and theta, sumAdd()
+    float out;
+    uint32_t duty;
+    int direction;
+} FC_MRAC_F32;
+
+typedef struct {
+    int32_t goal;                       // Q16
+    int32_t refStep;                    // Q31
+    int32_t gammaDt_x, gammaDt_r;       // Q31, gamma*dt
+    int started;
+    int64_t refAcc;                     // Q47 reference model
+    int32_t x_ref, x, error;            // Q16, x_ref is the upper part of refAcc
+    int64_t thetaAcc_x, thetaAcc_r;     // Q47 integrators
+    int32_t theta_x, theta_r;           // Q16
+    int32_t out;                        // Q16, saturated
+    uint32_t duty;
+    int direction;
+} FC_MRAC_Q;
+
+// ********************************************************
+// ******************* Functions **************************
+// ********************************************************
+//------------------FC_PIDInit_xxx()---------------------------
+//Reset the PID state and load the gains
+//Input: state, gains, integral error limits
+//Output: None
+void FC_PIDInit_F64(FC_PID_F64 *pid, double Kbar, double Ki, double Kd, double integralMin, double integralMax);
+void FC_PIDInit_F32(FC_PID_F32 *pid, double Kbar, double Ki, double Kd, double integralMin, double integralMax);
+void FC_PIDInit_Q(FC_PID_Q *pid, double Kbar, double Ki, double Kd, double integralMin, double integralMax);
+
+//------------------FC_PIDSetGoal_xxx()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_PIDSetGoal_F64(FC_PID_F64 *pid, double goal);
+void FC_PIDSetGoal_F32(FC_PID_F32 *pid, double goal);
+void FC_PIDSetGoal_Q(FC_PID_Q *pid, double goal);
+
+//------------------FC_PIDStep_xxx()---------------------------
+//Run one controller tick
+//Input: state, load in pound (Q16.16)
+//Output: None, error/out/duty/direction are updated in the state
+void FC_PIDStep_F64(FC_PID_F64 *pid, int32_t load);
+void FC_PIDStep_F32(FC_PID_F32 *pid, int32_t load);
+void FC_PIDStep_Q(FC_PID_Q *pid, int32_t load);
+
+//------------------FC_MRACInit_xxx()---------------------------
+//Reset the adaptive state and load the adaptation gains
+//Input: state, gamma_x, gamma_r, controller frequency
+//Output: None
+void FC_MRACInit_F64(FC_MRAC_F64 *mrac, double gamma_x, double gamma_r, uint32_t controllerFreq);
+void FC_MRACInit_F32(FC_MRAC_F32 *mrac, double gamma_x, double gamma_r, uint32_t controllerFreq);
+void FC_MRACInit_Q(FC_MRAC_Q *mrac, double gamma_x, double gamma_r, uint32_t controllerFreq);
+
+//------------------FC_MRACSetGoal_xxx()---------------------------
+//Set the goal force
+//Input: state, goal force in pound
+//Output: None
+void FC_MRACSetGoal_F64(FC_MRAC_F64 *mrac, double goal);
+void FC_MRACSetGoal_F32(FC_MRAC_F32 *mrac, double goal);
+void FC_MRACSetGoal_Q(FC_MRAC_Q *mrac, double goal);
+
+//------------------FC_MRACStep_xxx()---------------------------
+//Run one controller tick
+//Input: state, load in pound (Q16.16)
+//Output: None, error/out/duty/direction are updated in the state
+void FC_MRACStep_F64(FC_MRAC_F64 *mrac, int32_t load);
+void FC_MRACStep_F32(FC_MRAC_F32 *mrac, int32_t load);
+void FC_MRACStep_Q(FC_MRAC_Q *mrac, int32_t load);
+
+// ********************************************************
+// ************ Selected format for slug.c ****************
+// ********************************************************
+// fc_num_t is the native signal type, FC_NUM() converts a constant at compile
+// time, FC_TO_DOUBLE() converts a signal for logging, FC_TO_CENTI() converts
+// a signal to an integer in 0.01 units for the binary telemetry and
+// FC_FROM_Q16() converts a Q16.16 value (e.g. a gait table force) to a signal.
+#if FC_NUMERIC == FC_NUMERIC_DOUBLE
+typedef double fc_num_t;
+typedef FC_PID_F64 FC_PID;
+typedef FC_MRAC_F64 FC_MRAC;
+#define FC_NUM(x)           ((double)(x))
+#define FC_TO_DOUBLE(x)     ((double)(x))
+#define FC_TO_CENTI(x)      ((int32_t)((x)*100.0))
+#define FC_FROM_Q16(x)      ((double)(x)*(1.0/FC_Q16_ONE))
+#define FC_PIDInit          FC_PIDInit_F64
+#define FC_PIDSetGoal       FC_PIDSetGoal_F64
+#define FC_PIDStep          FC_PIDStep_F64
+#define FC_MRACInit         FC_MRACInit_F64
+#define FC_MRACSetGoal      FC_MRACSetGoal_F64
+#define FC_MRACStep         FC_MRACStep_F64
+#elif FC_NUMERIC == FC_NUMERIC_FLOAT
+typedef float fc_num_t;
+typedef FC_PID_F32 FC_PID;
+typedef FC_MRAC_F32 FC_MRAC;
+#define FC_NUM(x)           ((float)(x))
+#define FC_TO_DOUBLE(x)     ((double)(x))
+#define FC_TO_CENTI(x)      ((int32_t)((x)*100.0f))
+#define FC_FROM_Q16(x)      ((float)(x)*(1.0f/FC_Q16_ONE))
+#define FC_PIDInit          FC_PIDInit_F32
+#define FC_PIDSetGoal       FC_PIDSetGoal_F32
+#define FC_PIDStep          FC_PIDStep_F32
+#define FC_MRACInit         FC_MRACInit_F32
+#define FC_MRACSetGoal      FC_MRACSetGoal_F32
+#define FC_MRACStep         FC_MRACStep_F32
+#elif FC_NUMERIC == FC_NUMERIC_FIXED
+typedef int32_t fc_num_t;
+typedef FC_PID_Q FC_PID;
+typedef FC_MRAC_Q FC_MRAC;
+#define FC_NUM(x)           FC_Q16(x)
+#define FC_TO_DOUBLE(x)     ((double)(x)/FC_Q16_ONE)
+#define FC_TO_CENTI(x)      ((int32_t)(((int64_t)(x)*100) >> 16))
+#define FC_FROM_Q16(x)      ((int32_t)(x))
+#define FC_PIDInit          FC_PIDInit_Q
+#define FC_PIDSetGoal       FC_PIDSetGoal_Q
+#define FC_PIDStep          FC_PIDStep_Q
+#define FC_MRACInit         FC_MRACInit_Q
+#define FC_MRACSetGoal      FC_MRACSetGoal_Q
+#define FC_MRACStep         FC_MRACStep_Q
+#else
+#error "FC_NUMERIC must be FC_NUMERIC_DOUBLE, FC_NUMERIC_FLOAT or FC_NUMERIC_FIXED"
+#endif
+
+#endif /* FORCECONTROL_H_ */
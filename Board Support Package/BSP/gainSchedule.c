@@ -0,0 +1,115 @@
+// gainSchedule.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Gain schedule for the force PID, see gainSchedule.h.
+
+#include "gainSchedule.h"
+
+// Default breakpoints, 0 to 500 N of force goal and 0 to 20 lb of error
+static const float defaultGoal[] = {0.0f, 22.5f, 45.0f, 67.4f, 89.9f, GAIN_SCHEDULE_FORCE_MAX};
+static const float defaultError[] = {0.0f, 1.0f, 5.0f, 20.0f};
+
+// Gains at each error breakpoint, the same at every force goal since the
+// identified spring is linear: stiffer P and less I for large errors, where
+// the duty saturates anyway. Retune per load level on the stand
+static const GainSchedule_Gains defaultGains[] = {
+//   kp     ki     kd
+    {0.6f, 15.0f, 0.3f},
+    {0.8f, 15.0f, 0.3f},
+    {1.2f, 11.0f, 0.3f},
+    {1.6f,  7.5f, 0.3f},
+};
+
+#define COUNT(a) (sizeof(a)/sizeof((a)[0]))
+
+//------------------GainSchedule_Default()---------------------------
+//Fill the table with the gains tuned on Host Tools/seaSim over 0 to 500 N
+//Input: table
+//Output: None
+void GainSchedule_Default(GainSchedule_Table *t){
+    uint32_t i, j;
+
+    t->goals = COUNT(defaultGoal);
+    t->errors = COUNT(defaultError);
+    for(i = 0; i < t->goals; i++){
+        t->goal[i] = defaultGoal[i];
+        for(j = 0; j < t->errors; j++){
+            t->gains[i][j] = defaultGains[j];
+        }
+    }
+    for(j = 0; j < t->errors; j++){
+        t->error[j] = defaultError[j];
+    }
+}
+
+//------------------GainSchedule_Check()---------------------------
+//Check a table before it is used
+//Input: table
+//Output: 1 if usable, 0 if not
+int GainSchedule_Check(const GainSchedule_Table *t){
+    uint32_t i, j;
+
+    if(t->goals < 1 || t->goals > GAIN_SCHEDULE_MAX_GOALS ||
+       t->errors < 1 || t->errors > GAIN_SCHEDULE_MAX_ERRORS){
+        return 0;
+    }
+    for(i = 1; i < t->goals; i++){
+        if(!(t->goal[i] > t->goal[i - 1])) return 0;
+    }
+    for(j = 1; j < t->errors; j++){
+        if(!(t->error[j] > t->error[j - 1])) return 0;
+    }
+    for(i = 0; i < t->goals; i++){
+        for(j = 0; j < t->errors; j++){
+            const GainSchedule_Gains *g = &t->gains[i][j];
+            if(!(g->kp >= 0) || !(g->ki >= 0) || !(g->kd >= 0)) return 0;
+        }
+    }
+    return 1;
+}
+
+//------------------segment()---------------------------
+//Breakpoint at or below x and the fraction of the way to the next one,
+//clamped to the ends of the axis
+static uint32_t segment(const float *axis, uint32_t n, float x, float *frac){
+    uint32_t i = 0;
+
+    while(i + 2 < n && x >= axis[i + 1]){
+        i++;
+    }
+    if(n < 2 || x <= axis[0]){
+        *frac = 0;
+        return 0;
+    }
+    if(x >= axis[i + 1]){
+        *frac = 1;
+    }else{
+        *frac = (x - axis[i])/(axis[i + 1] - axis[i]);
+    }
+    return i;
+}
+
+//------------------GainSchedule_Lookup()---------------------------
+//Interpolate the gains at a force goal and an error magnitude
+//Input: table, force goal (lb), error magnitude (lb), gains out
+//Output: None
+void GainSchedule_Lookup(const GainSchedule_Table *t, float goal, float error, GainSchedule_Gains *g){
+    float fg, fe, w00, w01, w10, w11;
+    uint32_t i, j, i1, j1;
+    const GainSchedule_Gains *a, *b, *c, *d;
+
+    i = segment(t->goal, t->goals, goal, &fg);
+    j = segment(t->error, t->errors, error, &fe);
+    i1 = (t->goals > 1) ? i + 1 : i;
+    j1 = (t->errors > 1) ? j + 1 : j;
+    a = &t->gains[i][j];
+    b = &t->gains[i][j1];
+    c = &t->gains[i1][j];
+    d = &t->gains[i1][j1];
+    w11 = fg*fe;
+    w10 = fg - w11;
+    w01 = fe - w11;
+    w00 = 1.0f - fg - fe + w11;
+    g->kp = w00*a->kp + w01*b->kp + w10*c->kp + w11*d->kp;
+    g->ki = w00*a->ki + w01*b->ki + w10*c->ki + w11*d->ki;
+    g->kd = w00*a->kd + w01*b->kd + w10*c->kd + w11*d->kd;
+}
@@ -0,0 +1,53 @@
+// gainSchedule.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Gain schedule for the force PID: Kp, Ki and Kd at the breakpoints of a
+// grid of force goal x error magnitude, looked up with bilinear
+// interpolation once per controller tick. Outside the grid the gains of the
+// nearest edge are used. The table lives in RAM so it can be retuned while
+// running; GainSchedule_Check() tells if a new table is usable.
+// Forces in pound, gains in duty percent:
+//   kp  percent/lb
+//   ki  percent/(lb s)
+//   kd  percent/(lb/s)
+// Float, runs on the FPU.
+
+#ifndef GAINSCHEDULE_H_
+#define GAINSCHEDULE_H_
+
+#include <stdint.h>
+
+#define GAIN_SCHEDULE_MAX_GOALS     8       // breakpoints of the force goal axis
+#define GAIN_SCHEDULE_MAX_ERRORS    8       // breakpoints of the error magnitude axis
+#define GAIN_SCHEDULE_FORCE_MAX     112.4f  // lb, 500 N
+
+typedef struct {
+    float kp, ki, kd;
+} GainSchedule_Gains;
+
+typedef struct {
+    uint32_t goals, errors;                             // breakpoints used, at least 1
+    float goal[GAIN_SCHEDULE_MAX_GOALS];                // lb, increasing
+    float error[GAIN_SCHEDULE_MAX_ERRORS];              // lb, increasing, from 0
+    GainSchedule_Gains gains[GAIN_SCHEDULE_MAX_GOALS][GAIN_SCHEDULE_MAX_ERRORS];
+} GainSchedule_Table;
+
+//------------------GainSchedule_Default()---------------------------
+//Fill the table with the gains tuned on Host Tools/seaSim over 0 to 500 N
+//Input: table
+//Output: None
+void GainSchedule_Default(GainSchedule_Table *t);
+
+//------------------GainSchedule_Check()---------------------------
+//Check a table before it is used: breakpoint counts within the limits,
+//breakpoints increasing, gains not negative
+//Input: table
+//Output: 1 if usable, 0 if not
+int GainSchedule_Check(const GainSchedule_Table *t);
+
+//------------------GainSchedule_Lookup()---------------------------
+//Interpolate the gains at a force goal and an error magnitude
+//Input: table, force goal (lb), error magnitude (lb), gains out
+//Output: None
+void GainSchedule_Lookup(const GainSchedule_Table *t, float goal, float error, GainSchedule_Gains *g);
+
+#endif /* GAINSCHEDULE_H_ */
@@ -0,0 +1,59 @@
+// gait.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Gait trajectory player, see gait.h.
+
+#include "gait.h"
+
+//------------------Gait_Init()---------------------------
+//Start a table at phase 0, stopped (cadence 0)
+//Input: player, table, Gait_Step() rate (Hz)
+//Output: None
+void Gait_Init(Gait_Player *g, const Gait_Table *table, uint32_t tickFreq){
+    g->table = table;
+    g->tickFreq = tickFreq;
+    g->phase = 0;
+    g->step = 0;
+    g->stepPerSecond = 0;
+    g->cycles = 0;
+    g->value = table->value[0];
+    g->rate = 0;
+}
+
+//------------------Gait_SetCadence()---------------------------
+//Set the cycles per second, from the next Gait_Step() on
+//Input: player, cadence in mHz, limited to GAIT_MAX_CADENCE
+//Output: None
+void Gait_SetCadence(Gait_Player *g, uint32_t milliHz){
+    uint32_t step;
+
+    if(milliHz > GAIT_MAX_CADENCE){
+        milliHz = GAIT_MAX_CADENCE;
+    }
+    // 2^32 per cycle, milliHz/(1000*tickFreq) cycles per tick
+    step = (uint32_t)(((uint64_t)milliHz << 32)/(1000ull*g->tickFreq));
+    g->stepPerSecond = (int64_t)step*g->tickFreq;
+    g->step = step;
+}
+
+//------------------Gait_Step()---------------------------
+//Advance by one tick and interpolate the table
+//Input: player
+//Output: Value at the new phase, see Gait_Kind for the units
+int32_t Gait_Step(Gait_Player *g){
+    const Gait_Table *t = g->table;
+    uint32_t phase = g->phase + g->step;
+    uint32_t i, f;
+    int32_t slope;
+
+    if(phase < g->phase){
+        g->cycles++;
+    }
+    g->phase = phase;
+
+    i = phase >> (32 - t->bits);
+    f = (phase << t->bits) >> 16;
+    slope = t->slope[i];
+    g->value = t->value[i] + (int32_t)(((int64_t)slope*f) >> 16);
+    g->rate = (int32_t)(((int64_t)slope*g->stepPerSecond) >> (32 - t->bits));
+    return g->value;
+}
@@ -0,0 +1,70 @@
+// gait.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Gait trajectory player. A gait profile (force or joint position over one
+// cycle) is compiled ahead of time by Host Tools/gaitTable into a table of
+// 2^bits points with the slope to the next point, so the player only looks
+// up and interpolates:
+//   phase += step              once per controller tick, 2^32 per cycle
+//   i = top bits of phase, f = next 16 bits
+//   value = value[i] + slope[i]*f/2^16
+// The cadence only sets step, so it can change at any time without touching
+// the table and the phase runs on without a jump. The rate of change of the
+// value comes from the same slope, as velocity feedforward. Integer only,
+// the same work every tick.
+
+#ifndef GAIT_H_
+#define GAIT_H_
+
+#include <stdint.h>
+
+#define GAIT_FORCE_FRAC_BITS    16      // force tables, lb*2^16
+#define GAIT_POSITION_FRAC_BITS 8       // position tables, counts*2^8 as encoder.h
+#define GAIT_MAX_BITS           12      // 4096 points per cycle
+#define GAIT_MAX_CADENCE        10000   // mHz
+
+typedef enum {
+    GAIT_FORCE,                 // load cell force goal
+    GAIT_POSITION               // joint position goal, incremental encoder
+} Gait_Kind;
+
+typedef struct {
+    const char *name;
+    Gait_Kind kind;
+    uint32_t bits;              // 2^bits points over one cycle, 1 to GAIT_MAX_BITS
+    const int32_t *value;       // value at phase i/2^bits
+    const int32_t *slope;       // value[i + 1] - value[i], the last one wraps to value[0]
+} Gait_Table;
+
+typedef struct {
+    const Gait_Table *table;
+    uint32_t tickFreq;          // Gait_Step() calls per second
+    uint32_t phase;             // 2^32 per cycle
+    uint32_t step;              // phase per tick, from the cadence
+    int64_t stepPerSecond;      // step*tickFreq, for the rate
+    uint32_t cycles;            // completed since Gait_Init()
+    int32_t value;              // at the current phase
+    int32_t rate;               // value per second
+} Gait_Player;
+
+// Tables built by Host Tools/gaitTable
+extern const Gait_Table gaitSwing;
+
+//------------------Gait_Init()---------------------------
+//Start a table at phase 0, stopped (cadence 0)
+//Input: player, table, Gait_Step() rate (Hz)
+//Output: None
+void Gait_Init(Gait_Player *g, const Gait_Table *table, uint32_t tickFreq);
+
+//------------------Gait_SetCadence()---------------------------
+//Set the cycles per second, from the next Gait_Step() on
+//Input: player, cadence in mHz, limited to GAIT_MAX_CADENCE
+//Output: None
+void Gait_SetCadence(Gait_Player *g, uint32_t milliHz);
+
+//------------------Gait_Step()---------------------------
+//Advance by one tick and interpolate the table
+//Input: player
+//Output: Value at the new phase, see Gait_Kind for the units
+int32_t Gait_Step(Gait_Player *g);
+
+#endif /* GAIT_H_ */
@@ -0,0 +1,78 @@
+// gaitSwing.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Gait table generated by Host Tools/gaitTable from ../Data Collection/feedforward controller/capture3.txt, do not edit.
+// Force in lb*2^16, 256 points, scale 0.020147, folded over 300 samples from sample 301, 8 harmonics
+
+#include "gait.h"
+
+static const int32_t gaitSwingValue[256] = {
+    2949037, 2957044, 2964686, 2971780, 2978151, 2983644, 2988121, 2991472,
+    2993612, 2994492, 2994094, 2992436, 2989569, 2985582, 2980592, 2974749,
+    2968227, 2961222, 2953945, 2946618, 2939468, 2932718, 2926582, 2921262,
+    2916936, 2913758, 2911849, 2911299, 2912159, 2914441, 2918118, 2923125,
+    2929359, 2936683, 2944932, 2953914, 2963417, 2973216, 2983079, 2992775,
+    3002079, 3010778, 3018683, 3025625, 3031470, 3036113, 3039491, 3041577,
+    3042383, 3041960, 3040396, 3037811, 3034357, 3030208, 3025558, 3020613,
+    3015585, 3010687, 3006121, 3002077, 2998725, 2996209, 2994645, 2994113,
+    2994661, 2996298, 2998998, 3002697, 3007302, 3012688, 3018706, 3025185,
+    3031943, 3038788, 3045527, 3051972, 3057948, 3063296, 3067879, 3071589,
+    3074346, 3076105, 3076857, 3076623, 3075464, 3073469, 3070755, 3067468,
+    3063770, 3059838, 3055859, 3052018, 3048500, 3045476, 3043102, 3041510,
+    3040808, 3041073, 3042346, 3044637, 3047917, 3052126, 3057168, 3062917,
+    3069222, 3075908, 3082785, 3089652, 3096303, 3102534, 3108151, 3112971,
+    3116835, 3119606, 3121177, 3121475, 3120461, 3118131, 3114520, 3109696,
+    3103764, 3096855, 3089131, 3080773, 3071981, 3062964, 3053937, 3045114,
+    3036701, 3028893, 3021865, 3015768, 3010729, 3006842, 3004169, 3002741,
+    3002550, 3003558, 3005694, 3008858, 3012923, 3017740, 3023142, 3028950,
+    3034977, 3041034, 3046933, 3052496, 3057556, 3061964, 3065589, 3068327,
+    3070097, 3070844, 3070543, 3069197, 3066833, 3063505, 3059290, 3054284,
+    3048601, 3042367, 3035720, 3028800, 3021751, 3014713, 3007820, 3001199,
+    2994960, 2989202, 2984004, 2979428, 2975515, 2972288, 2969748, 2967879,
+    2966647, 2965999, 2965871, 2966186, 2966859, 2967797, 2968904, 2970083,
+    2971241, 2972286, 2973137, 2973720, 2973972, 2973844, 2973299, 2972315,
+    2970887, 2969021, 2966740, 2964078, 2961084, 2957814, 2954336, 2950722,
+    2947051, 2943403, 2939858, 2936494, 2933383, 2930591, 2928176, 2926185,
+    2924652, 2923598, 2923031, 2922943, 2923313, 2924105, 2925269, 2926746,
+    2928463, 2930338, 2932286, 2934215, 2936032, 2937646, 2938968, 2939920,
+    2940428, 2940434, 2939893, 2938776, 2937071, 2934785, 2931945, 2928596,
+    2924803, 2920646, 2916224, 2911648, 2907039, 2902528, 2898249, 2894337,
+    2890924, 2888135, 2886084, 2884870, 2884574, 2885255, 2886950, 2889669,
+    2893397, 2898090, 2903676, 2910060, 2917121, 2924717, 2932686, 2940854,
+};
+
+static const int32_t gaitSwingSlope[256] = {
+    8007, 7642, 7094, 6371, 5493, 4477, 3351, 2140,
+    880, -398, -1658, -2867, -3987, -4990, -5843, -6522,
+    -7005, -7277, -7327, -7150, -6750, -6136, -5320, -4326,
+    -3178, -1909, -550, 860, 2282, 3677, 5007, 6234,
+    7324, 8249, 8982, 9503, 9799, 9863, 9696, 9304,
+    8699, 7905, 6942, 5845, 4643, 3378, 2086, 806,
+    -423, -1564, -2585, -3454, -4149, -4650, -4945, -5028,
+    -4898, -4566, -4044, -3352, -2516, -1564, -532, 548,
+    1637, 2700, 3699, 4605, 5386, 6018, 6479, 6758,
+    6845, 6739, 6445, 5976, 5348, 4583, 3710, 2757,
+    1759, 752, -234, -1159, -1995, -2714, -3287, -3698,
+    -3932, -3979, -3841, -3518, -3024, -2374, -1592, -702,
+    265, 1273, 2291, 3280, 4209, 5042, 5749, 6305,
+    6686, 6877, 6867, 6651, 6231, 5617, 4820, 3864,
+    2771, 1571, 298, -1014, -2330, -3611, -4824, -5932,
+    -6909, -7724, -8358, -8792, -9017, -9027, -8823, -8413,
+    -7808, -7028, -6097, -5039, -3887, -2673, -1428, -191,
+    1008, 2136, 3164, 4065, 4817, 5402, 5808, 6027,
+    6057, 5899, 5563, 5060, 4408, 3625, 2738, 1770,
+    747, -301, -1346, -2364, -3328, -4215, -5006, -5683,
+    -6234, -6647, -6920, -7049, -7038, -6893, -6621, -6239,
+    -5758, -5198, -4576, -3913, -3227, -2540, -1869, -1232,
+    -648, -128, 315, 673, 938, 1107, 1179, 1158,
+    1045, 851, 583, 252, -128, -545, -984, -1428,
+    -1866, -2281, -2662, -2994, -3270, -3478, -3614, -3671,
+    -3648, -3545, -3364, -3111, -2792, -2415, -1991, -1533,
+    -1054, -567, -88, 370, 792, 1164, 1477, 1717,
+    1875, 1948, 1929, 1817, 1614, 1322, 952, 508,
+    6, -541, -1117, -1705, -2286, -2840, -3349, -3793,
+    -4157, -4422, -4576, -4609, -4511, -4279, -3912, -3413,
+    -2789, -2051, -1214, -296, 681, 1695, 2719, 3728,
+    4693, 5586, 6384, 7061, 7596, 7969, 8168, 8183,
+};
+
+const Gait_Table gaitSwing = {"gaitSwing", GAIT_FORCE, 8, gaitSwingValue, gaitSwingSlope};
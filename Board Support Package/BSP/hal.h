@@ -0,0 +1,513 @@
+// hal.h
+// Runs on TM4C123 with TIVA shield v2.0, or on a host PC with SLUG_HOST defined
+// Thin hardware abstraction layer under slug.c. slug.c only talks to the
+// peripherals through these functions, so the control and logging code can be
+// built and run off-target.
+// Two backends implement this file:
+//   halTiva.c - TivaWare driverlib, used on the board (SLUG_HOST not defined)
+//   halHost.c - host simulation with virtual clock, GPIO, timers, ADC, PWM,
+//               QEI and UART (SLUG_HOST defined). Timers fire their handlers
+//               from virtual time, so the firmware runs as fast as the host can.
+// Both files are part of the BSP project; each one compiles to nothing when
+// the other backend is selected.
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef SLUG_HOST
+#include "utils/uartstdio.h"
+#else
+//------------------UARTprintf()---------------------------
+//printf facility of the console, host backend writes to the virtual UART
+//Input: format string and arguments
+//Output: None
+void UARTprintf(const char *pcString, ...);
+#endif
+
+typedef void (*HAL_Handler)(void);
+
+// ********************************************************
+// *************** Clock and interrupts *******************
+// ********************************************************
+typedef enum {
+    HAL_CLOCK_40MHZ,
+    HAL_CLOCK_80MHZ
+} HAL_Clock;
+
+//------------------HAL_ClockSet()---------------------------
+//Configure system clock from the PLL and the 16MHz crystal
+//Input: HAL_CLOCK_40MHZ or HAL_CLOCK_80MHZ
+//Output: None
+void HAL_ClockSet(HAL_Clock clock);
+
+//------------------HAL_ClockGet()---------------------------
+//Get current system clock frequency
+//Input: None
+//Output: Frequency in Hz
+uint32_t HAL_ClockGet(void);
+
+//------------------HAL_CycleCounterInit()---------------------------
+//Start the free running cycle counter (Cortex-M4 DWT CYCCNT)
+//Input: None
+//Output: None
+void HAL_CycleCounterInit(void);
+
+//------------------HAL_CycleCount()---------------------------
+//Read the cycle counter, wraps every 2^32 cycles (53 s at 80MHz)
+//Input: None
+//Output: System clock cycles
+uint32_t HAL_CycleCount(void);
+
+//------------------HAL_DelayLoops()---------------------------
+//Busy wait, each loop is 3 clock cycles (SysCtlDelay)
+//Input: Number of loops
+//Output: None
+void HAL_DelayLoops(uint32_t loops);
+
+//------------------HAL_IntMasterEnable()---------------------------
+//Enable all interrupts system wide
+//Input: None
+//Output: None
+void HAL_IntMasterEnable(void);
+
+//------------------HAL_EnterCritical()---------------------------
+//Disable all interrupts for a short critical section
+//Input: None
+//Output: State to pass to HAL_ExitCritical()
+uint32_t HAL_EnterCritical(void);
+
+//------------------HAL_ExitCritical()---------------------------
+//End a critical section, interrupts are enabled again only if they were
+//enabled at HAL_EnterCritical()
+//Input: State from HAL_EnterCritical()
+//Output: None
+void HAL_ExitCritical(uint32_t state);
+
+// ********************************************************
+// ********************** GPIO ****************************
+// ********************************************************
+typedef enum {
+    HAL_PIN_BLUE_LED,       // PD7
+    HAL_PIN_YELLOW_LED,     // PC7
+    HAL_PIN_RGB_RED,        // PF1
+    HAL_PIN_RGB_BLUE,       // PF2
+    HAL_PIN_RGB_GREEN,      // PF3
+    HAL_PIN_BUTTON1,        // PF4
+    HAL_PIN_MOTOR_DIR,      // PB7
+    HAL_NUM_PINS
+} HAL_Pin;
+
+//------------------HAL_GPIOInitOutput()---------------------------
+//Enable the port and configure the pin as output
+//Input: Pin
+//Output: None
+void HAL_GPIOInitOutput(HAL_Pin pin);
+
+//------------------HAL_GPIOInitInput()---------------------------
+//Enable the port and configure the pin as input with weak pull up
+//Input: Pin
+//Output: None
+void HAL_GPIOInitInput(HAL_Pin pin);
+
+//------------------HAL_GPIOWrite()---------------------------
+//Drive an output pin
+//Input: Pin, level
+//Output: None
+void HAL_GPIOWrite(HAL_Pin pin, bool level);
+
+//------------------HAL_GPIORead()---------------------------
+//Read a pin
+//Input: Pin
+//Output: Level
+bool HAL_GPIORead(HAL_Pin pin);
+
+// ********************************************************
+// ********************* Timers ***************************
+// ********************************************************
+typedef enum {
+    HAL_TIMER0,             // Timer0A, load cell ADC trigger / blink
+    HAL_TIMER1,             // Timer1A, controller
+    HAL_TIMER2,             // Timer2A, logger
+    HAL_NUM_TIMERS
+} HAL_Timer;
+
+//------------------HAL_TimerInitPeriodic()---------------------------
+//Configure a periodic timer with timeout interrupt, timer is left disabled
+//Input: Timer, period in clock cycles, handler (0 uses the startup vector table)
+//Output: None
+void HAL_TimerInitPeriodic(HAL_Timer timer, uint32_t period, HAL_Handler handler);
+
+//------------------HAL_TimerInitADCTrigger()---------------------------
+//Configure a periodic timer that triggers the ADC, and start it
+//Input: Timer, period in clock cycles
+//Output: None
+void HAL_TimerInitADCTrigger(HAL_Timer timer, uint32_t period);
+
+//------------------HAL_TimerEnable()---------------------------
+//Start a timer
+//Input: Timer
+//Output: None
+void HAL_TimerEnable(HAL_Timer timer);
+
+//------------------HAL_TimerDisable()---------------------------
+//Stop a timer, its interrupt no longer fires
+//Input: Timer
+//Output: None
+void HAL_TimerDisable(HAL_Timer timer);
+
+//------------------HAL_TimerIntClear()---------------------------
+//Clear the timeout interrupt, call first thing in the handler
+//Input: Timer
+//Output: None
+void HAL_TimerIntClear(HAL_Timer timer);
+
+//------------------HAL_TimerValueGet()---------------------------
+//Read the down counter, the difference of two reads in a handler is the
+//number of system clock cycles spent between them
+//Input: Timer
+//Output: Counter value, period-1 down to 0
+uint32_t HAL_TimerValueGet(HAL_Timer timer);
+
+// ********************************************************
+// *********************** ADC ****************************
+// ********************************************************
+typedef enum {
+    HAL_ADC_LOADCELL,       // AIN0 - PE3
+    HAL_ADC_ADDITIONAL,     // AIN1 - PE2
+    HAL_ADC_TEMPSENSOR,     // internal temperature sensor
+    HAL_ADC_CURRENT,        // AIN8 - PE5, motor current monitor
+    HAL_ADC_THERMOCOUPLE,   // AIN3 - PE0
+    HAL_NUM_ADC_CHANNELS
+} HAL_ADCChannel;
+
+#define HAL_ADC_MAX_STEPS   8       // steps of sequencer 0 (1: 4, 2: 4, 3: 1)
+
+typedef enum {
+    HAL_ADC_TRIGGER_PROCESSOR,
+    HAL_ADC_TRIGGER_TIMER
+} HAL_ADCTrigger;
+
+//------------------HAL_ADCInit()---------------------------
+//Enable ADC0 and set hardware averaging
+//Input: hardwareAveraging (0 = off, or 2,4,8,16,32 or 64)
+//Output: None
+void HAL_ADCInit(int hardwareAveraging);
+
+//------------------HAL_ADCSequenceInit()---------------------------
+//Configure a one step sample sequence on ADC0 with interrupt on completion
+//Input: Sequencer number, trigger, channel, handler (0 uses the startup vector table)
+//Output: None
+void HAL_ADCSequenceInit(uint32_t sequence, HAL_ADCTrigger trigger, HAL_ADCChannel channel, HAL_Handler handler);
+
+//------------------HAL_ADCSequenceStepsInit()---------------------------
+//Configure a sample sequence on ADC0 converting several channels back to
+//back, one interrupt after the last step. HAL_ADCDataGet() returns the
+//samples in step order
+//Input: Sequencer number, trigger, channels and their number (up to the
+//       steps of the sequencer), handler (0 uses the startup vector table)
+//Output: None
+void HAL_ADCSequenceStepsInit(uint32_t sequence, HAL_ADCTrigger trigger, const HAL_ADCChannel *channels,
+                              uint32_t steps, HAL_Handler handler);
+
+//------------------HAL_ADCProcessorTrigger()---------------------------
+//Start a processor triggered sequence
+//Input: Sequencer number
+//Output: None
+void HAL_ADCProcessorTrigger(uint32_t sequence);
+
+//------------------HAL_ADCIntClear()---------------------------
+//Clear the sequence interrupt, call first thing in the handler
+//Input: Sequencer number
+//Output: None
+void HAL_ADCIntClear(uint32_t sequence);
+
+//------------------HAL_ADCDataGet()---------------------------
+//Read the sequence FIFO
+//Input: Sequencer number, buffer with room for every step of the sequence
+//Output: Number of samples copied
+int32_t HAL_ADCDataGet(uint32_t sequence, uint32_t *buffer);
+
+// ********************************************************
+// ************** uDMA ADC0 ping-pong *********************
+// ********************************************************
+#define HAL_ADC_DMA_PING    0x1     // HAL_ADCDMAService() flags
+#define HAL_ADC_DMA_PONG    0x2
+
+//------------------HAL_ADCDMAInit()---------------------------
+//Configure a one step, timer triggered sequence on ADC0 whose samples are
+//moved by the uDMA in ping-pong mode: ping fills, then pong, then ping again.
+//The sequence interrupt is taken once per full block, not per sample.
+//Only one sequence can use the uDMA at a time
+//Input: Sequencer number, channel, ping and pong buffers of length samples
+//       (1 to 1024), handler (0 uses the startup vector table)
+//Output: None
+void HAL_ADCDMAInit(uint32_t sequence, HAL_ADCChannel channel, uint16_t *ping, uint16_t *pong,
+                    uint32_t length, HAL_Handler handler);
+
+//------------------HAL_ADCDMAService()---------------------------
+//Find the finished blocks and give them back to the uDMA, call first thing
+//in the sequence handler. A returned buffer may be read until the other one
+//is full
+//Input: None
+//Output: HAL_ADC_DMA_PING and/or HAL_ADC_DMA_PONG for each finished block
+uint32_t HAL_ADCDMAService(void);
+
+// ********************************************************
+// *********************** PWM ****************************
+// ********************************************************
+//------------------HAL_PWMInit()---------------------------
+//Configure M1PWM5 on PF1 (PWM clock = system clock/2), output off
+//Input: Period in PWM clock cycles
+//Output: None
+void HAL_PWMInit(uint32_t period);
+
+//------------------HAL_PWMSetPulseWidth()---------------------------
+//Set motor PWM pulse width
+//Input: Pulse width in PWM clock cycles
+//Output: None
+void HAL_PWMSetPulseWidth(uint32_t width);
+
+//------------------HAL_PWMOutputEnable()---------------------------
+//Turn the motor PWM output on or off
+//Input: true to enable
+//Output: None
+void HAL_PWMOutputEnable(bool enable);
+
+// ********************************************************
+// *********************** QEI ****************************
+// ********************************************************
+//------------------HAL_QEIInit()---------------------------
+//Configure QEI1 on PC5/PC6 in quadrature mode
+//Input: Maximum position, start position
+//Output: None
+void HAL_QEIInit(uint32_t topLimit, uint32_t startVal);
+
+//------------------HAL_QEIPositionGet()---------------------------
+//Get encoder position
+//Input: None
+//Output: Position in counts
+uint32_t HAL_QEIPositionGet(void);
+
+//------------------HAL_QEIVelocityInit()---------------------------
+//Start the QEI1 velocity timer: the edges of each period are counted and
+//latched at its end
+//Input: Period in clock cycles
+//Output: None
+void HAL_QEIVelocityInit(uint32_t period);
+
+//------------------HAL_QEIVelocityGet()---------------------------
+//Get the edges counted in the last full velocity period
+//Input: None
+//Output: Edges, without sign
+uint32_t HAL_QEIVelocityGet(void);
+
+//------------------HAL_QEIDirectionGet()---------------------------
+//Get the direction of the last edge
+//Input: None
+//Output: +1 counting up, -1 counting down
+int32_t HAL_QEIDirectionGet(void);
+
+// ********************************************************
+// ********************** UART0 ***************************
+// ********************************************************
+//------------------HAL_ConsoleInit()---------------------------
+//Configure UART0 on PA0/PA1 for the UARTprintf console, clocked from PIOSC
+//Input: Baud rate
+//Output: None
+void HAL_ConsoleInit(uint32_t baudRate);
+
+//------------------HAL_UARTInit()---------------------------
+//Configure UART0 on PA0/PA1, 8N1, with RX and RX timeout interrupts
+//Input: Baud rate, handler (0 uses the startup vector table)
+//Output: None
+void HAL_UARTInit(uint32_t baudRate, HAL_Handler handler);
+
+//------------------HAL_UARTRxIntEnable()---------------------------
+//Enable the RX and RX timeout interrupts of UART0 after HAL_ConsoleInit or
+//HAL_UARTDMAInit, to receive next to the console or the uDMA transmitter
+//Input: UART0 handler (0 keeps the one registered)
+//Output: None
+void HAL_UARTRxIntEnable(HAL_Handler handler);
+
+//------------------HAL_UARTIntClear()---------------------------
+//Clear all pending UART0 interrupts
+//Input: None
+//Output: Interrupt status before clearing
+uint32_t HAL_UARTIntClear(void);
+
+//------------------HAL_UARTCharsAvail()---------------------------
+//Check the receive FIFO
+//Input: None
+//Output: true if a character is waiting
+bool HAL_UARTCharsAvail(void);
+
+//------------------HAL_UARTCharGet()---------------------------
+//Blocking receive
+//Input: None
+//Output: Character
+int32_t HAL_UARTCharGet(void);
+
+//------------------HAL_UARTCharGetNonBlocking()---------------------------
+//Non blocking receive
+//Input: None
+//Output: Character or -1 when empty
+int32_t HAL_UARTCharGetNonBlocking(void);
+
+//------------------HAL_UARTCharPut()---------------------------
+//Blocking transmit
+//Input: Character
+//Output: None
+void HAL_UARTCharPut(unsigned char c);
+
+//------------------HAL_UARTCharPutNonBlocking()---------------------------
+//Non blocking transmit
+//Input: Character
+//Output: true if the character was queued
+bool HAL_UARTCharPutNonBlocking(unsigned char c);
+
+// ********************************************************
+// ****************** uDMA UART0 TX ***********************
+// ********************************************************
+#define HAL_UART_DMA_MAX    1024    // bytes per transfer, uDMA limit
+
+//------------------HAL_UARTDMAInit()---------------------------
+//Enable the uDMA controller and route UART0 TX to channel 9 (basic mode,
+//8 bit, arbitration size 4). Completion interrupts arrive on the UART0 vector.
+//UART0 must already be configured (HAL_ConsoleInit or HAL_UARTInit)
+//Input: UART0 handler (0 uses the startup vector table)
+//Output: None
+void HAL_UARTDMAInit(HAL_Handler handler);
+
+//------------------HAL_UARTDMAStart()---------------------------
+//Start one transfer to the UART0 data register. The buffer must not change
+//until HAL_UARTDMABusy() returns false
+//Input: Data, length (1 to HAL_UART_DMA_MAX)
+//Output: None
+void HAL_UARTDMAStart(const uint8_t *data, uint32_t length);
+
+//------------------HAL_UARTDMABusy()---------------------------
+//Check for a transfer in progress
+//Input: None
+//Output: true while the channel is still moving data
+bool HAL_UARTDMABusy(void);
+
+// ********************************************************
+// ********************** EEPROM **************************
+// ********************************************************
+#define HAL_EEPROM_ERASED   0xFFFFFFFF  // word of an erased EEPROM
+
+//------------------HAL_EEPROMInit()---------------------------
+//Enable the EEPROM and recover from a write cut short by a reset. Reads and
+//writes block the caller, keep them out of the interrupt handlers
+//Input: None
+//Output: Size in bytes, 0 if the EEPROM cannot be used
+uint32_t HAL_EEPROMInit(void);
+
+//------------------HAL_EEPROMRead()---------------------------
+//Read words
+//Input: Byte address (multiple of 4), buffer, number of words
+//Output: None
+void HAL_EEPROMRead(uint32_t address, uint32_t *words, uint32_t count);
+
+//------------------HAL_EEPROMProgram()---------------------------
+//Write words, several milliseconds per 16 word block
+//Input: Byte address (multiple of 4), data, number of words
+//Output: true if written
+bool HAL_EEPROMProgram(uint32_t address, const uint32_t *words, uint32_t count);
+
+#ifdef SLUG_HOST
+// ********************************************************
+// *************** Host simulation control ****************
+// ********************************************************
+// Used by host programs to drive the virtual peripherals.
+typedef uint32_t (*HAL_SimADCSource)(void *context);
+
+//------------------HAL_SimReset()---------------------------
+//Reset virtual time and all virtual peripherals
+//Input: None
+//Output: None
+void HAL_SimReset(void);
+
+//------------------HAL_SimRun()---------------------------
+//Advance virtual time, firing timer, ADC and UART interrupts on the way.
+//Handlers run to completion in time order, nesting is not modelled.
+//Input: Number of clock cycles
+//Output: None
+void HAL_SimRun(uint64_t cycles);
+
+//------------------HAL_SimCycles()---------------------------
+//Get virtual time
+//Input: None
+//Output: Clock cycles since HAL_SimReset()
+uint64_t HAL_SimCycles(void);
+
+//------------------HAL_SimSetADCValue()---------------------------
+//Set a constant value for an ADC channel
+//Input: Channel, 12 bit value
+//Output: None
+void HAL_SimSetADCValue(HAL_ADCChannel channel, uint32_t value);
+
+//------------------HAL_SimSetADCSource()---------------------------
+//Sample an ADC channel from a callback at each conversion
+//Input: Channel, callback (0 returns to the constant value), callback context
+//Output: None
+void HAL_SimSetADCSource(HAL_ADCChannel channel, HAL_SimADCSource source, void *context);
+
+//------------------HAL_SimGetPWM()---------------------------
+//Get the motor PWM state
+//Input: Pointers for period, pulse width and output enable (may be 0)
+//Output: None
+void HAL_SimGetPWM(uint32_t *period, uint32_t *width, bool *enabled);
+
+//------------------HAL_SimGetPin()---------------------------
+//Get the level of a pin
+//Input: Pin
+//Output: Level
+bool HAL_SimGetPin(HAL_Pin pin);
+
+//------------------HAL_SimSetPin()---------------------------
+//Drive an input pin (button)
+//Input: Pin, level
+//Output: None
+void HAL_SimSetPin(HAL_Pin pin, bool level);
+
+//------------------HAL_SimSetQEIPosition()---------------------------
+//Set the encoder position, the edges on the way (the shorter way round
+//the top limit) count for the velocity timer
+//Input: Position in counts
+//Output: None
+void HAL_SimSetQEIPosition(uint32_t position);
+
+//------------------HAL_SimUARTRead()---------------------------
+//Drain characters the firmware transmitted
+//Input: Buffer, buffer size
+//Output: Number of characters copied
+size_t HAL_SimUARTRead(char *buffer, size_t size);
+
+//------------------HAL_SimUARTWrite()---------------------------
+//Send characters to the firmware, the UART handler fires on the next HAL_SimRun()
+//Input: Data, length
+//Output: Number of characters accepted
+size_t HAL_SimUARTWrite(const char *data, size_t length);
+
+//------------------HAL_SimUARTEcho()---------------------------
+//Copy transmitted characters to stdout as well as the TX buffer
+//Input: true to echo
+//Output: None
+void HAL_SimUARTEcho(bool echo);
+
+//------------------HAL_SimSetEEPROMFile()---------------------------
+//Back the EEPROM with a file: it is read by the next HAL_EEPROMInit() (a
+//missing or short file reads as erased) and written again after every
+//HAL_EEPROMProgram(). Without a file the EEPROM is erased memory. Either way
+//its contents outlive HAL_SimReset(), as over a power cycle
+//Input: Path, 0 for memory only
+//Output: None
+void HAL_SimSetEEPROMFile(const char *path);
+#endif
+
+#endif /* HAL_H_ */
@@ -0,0 +1,700 @@
+// halHost.c
+// Runs on a host PC, compiled with SLUG_HOST defined
+// Simulation backend of the hardware abstraction layer (hal.h).
+// Peripherals are modelled at the level slug.c uses them:
+//   - one virtual clock counting system clock cycles
+//   - periodic timers that call their handler and/or trigger the ADC
+//   - ADC0 sequencers of up to HAL_ADC_MAX_STEPS steps, samples come from a
+//     constant value or a callback per channel (HAL_SimSetADCSource, used by
+//     plant models)
+//   - PWM1 output 5 (period, pulse width, enable), GPIO levels, QEI1 position
+//     and velocity timer (edges between two positions set by the host)
+//   - UART0 with a receive queue and a transmit buffer, UARTprintf writes here
+//   - uDMA UART0 TX channel: a transfer takes 10 bit times per byte at the
+//     configured baud rate, the bytes are read from the source buffer when the
+//     transfer completes (so a buffer reused too early shows up in the output),
+//     then the UART0 handler is called
+//   - uDMA ADC0 ping-pong: samples of the DMA sequence go to the active
+//     buffer, the sequence handler is called once per full block. A block
+//     not given back with HAL_ADCDMAService() in time stops the stream
+//   - EEPROM of HAL_SIM_EEPROM_SIZE bytes, erased memory or the image in a
+//     file (HAL_SimSetEEPROMFile). It is not part of the reset state
+// Time only advances in HAL_SimRun() and in HAL_DelayLoops(), so a host program
+// can run the firmware faster (or slower) than real time. Interrupts are taken
+// only after HAL_IntMasterEnable(), in time order, and run to completion.
+// Character by character UART transmit time is not modelled.
+// Compiles to nothing in the target build, see halTiva.c.
+
+#ifdef SLUG_HOST
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "hal.h"
+
+#define HAL_SIM_RESET_CLOCK     16000000    // PIOSC, clock before HAL_ClockSet()
+#define HAL_SIM_ADC_SEQUENCES   4
+#define HAL_SIM_ADC_MAX         4095
+#define HAL_SIM_UART_TX_SIZE    65536
+#define HAL_SIM_UART_RX_SIZE    4096
+#define HAL_SIM_EEPROM_SIZE     2048        // bytes, TM4C123GH6PM
+
+typedef struct {
+    bool enabled;
+    bool intEnabled;
+    bool adcTrigger;
+    uint32_t period;
+    uint64_t next;          // cycle of next timeout
+    HAL_Handler handler;
+} HAL_SimTimer;
+
+typedef struct {
+    bool configured;
+    HAL_ADCTrigger trigger;
+    HAL_ADCChannel channel[HAL_ADC_MAX_STEPS];
+    uint32_t steps;
+    HAL_Handler handler;
+    uint32_t sample[HAL_ADC_MAX_STEPS];
+    uint32_t count;         // samples waiting in the FIFO (0 or steps)
+    bool dma;               // samples go to the ping-pong buffers
+} HAL_SimSequence;
+
+static struct {
+    uint64_t cycles;
+    uint32_t clock;
+    bool intMaster;
+    int isrDepth;
+
+    bool pins[HAL_NUM_PINS];
+
+    HAL_SimTimer timers[HAL_NUM_TIMERS];
+
+    HAL_SimSequence sequences[HAL_SIM_ADC_SEQUENCES];
+    uint32_t adcValue[HAL_NUM_ADC_CHANNELS];
+    HAL_SimADCSource adcSource[HAL_NUM_ADC_CHANNELS];
+    void *adcContext[HAL_NUM_ADC_CHANNELS];
+
+    uint32_t pwmPeriod, pwmWidth;
+    bool pwmEnabled;
+
+    uint32_t qeiTop, qeiPosition;
+    int32_t qeiDirection;
+    bool qeiVelocity;       // velocity timer running
+    uint32_t qeiPeriod, qeiEdges, qeiSpeed;
+    uint64_t qeiNext;       // cycle the velocity period ends
+
+    HAL_Handler uartHandler;
+    uint32_t baud;
+    char tx[HAL_SIM_UART_TX_SIZE];
+    size_t txLen;
+    char rx[HAL_SIM_UART_RX_SIZE];
+    size_t rxHead, rxTail;
+    bool echo;
+
+    HAL_Handler dmaHandler;
+    const uint8_t *dmaSource;
+    uint32_t dmaLength;
+    bool dmaBusy;
+    uint64_t dmaDone;       // cycle the transfer completes
+
+    uint16_t *adcDMABuffer[2];
+    uint32_t adcDMALength, adcDMAIndex;
+    int adcDMAActive;       // buffer being filled
+    bool adcDMAArmed[2];
+    uint32_t adcDMADone;    // HAL_ADC_DMA_PING/PONG flags
+} sim = {.clock = HAL_SIM_RESET_CLOCK};
+
+// Kept over HAL_SimReset()
+static struct {
+    uint8_t data[HAL_SIM_EEPROM_SIZE];  // little endian words
+    bool loaded;            // data holds the file or the erased state
+    const char *path;
+} eeprom;
+
+// ********************* Internal ****************************
+//------------------isr()---------------------------
+//Call an interrupt handler if interrupts are enabled
+static void isr(HAL_Handler handler){
+    if(handler && sim.intMaster){
+        sim.isrDepth++;
+        handler();
+        sim.isrDepth--;
+    }
+}
+
+//------------------adcSample()---------------------------
+//Convert one channel
+static uint32_t adcSample(HAL_ADCChannel channel){
+    uint32_t value = sim.adcSource[channel] ? sim.adcSource[channel](sim.adcContext[channel]) : sim.adcValue[channel];
+    return (value > HAL_SIM_ADC_MAX) ? HAL_SIM_ADC_MAX : value;
+}
+
+//------------------adcDMASample()---------------------------
+//Store one sample in the active ping-pong buffer, switch buffers and take
+//the sequence interrupt when the block is full
+static void adcDMASample(HAL_SimSequence *seq, uint32_t sample){
+    int active = sim.adcDMAActive;
+
+    if(!sim.adcDMAArmed[active]){
+        return; // channel stopped, sample lost
+    }
+    sim.adcDMABuffer[active][sim.adcDMAIndex++] = (uint16_t)sample;
+    if(sim.adcDMAIndex < sim.adcDMALength){
+        return;
+    }
+    sim.adcDMAIndex = 0;
+    sim.adcDMAArmed[active] = false;
+    sim.adcDMADone |= active ? HAL_ADC_DMA_PONG : HAL_ADC_DMA_PING;
+    sim.adcDMAActive = active ^ 1;
+    isr(seq->handler);
+}
+
+//------------------adcConvert()---------------------------
+//Run every configured sequence with the given trigger
+static void adcConvert(HAL_ADCTrigger trigger, int onlySequence){
+    uint32_t step;
+    int s;
+    for(s = 0; s < HAL_SIM_ADC_SEQUENCES; s++){
+        HAL_SimSequence *seq = &sim.sequences[s];
+        if(!seq->configured || seq->trigger != trigger || (onlySequence >= 0 && s != onlySequence)){
+            continue;
+        }
+        if(seq->dma){
+            adcDMASample(seq, adcSample(seq->channel[0]));
+            continue;
+        }
+        for(step = 0; step < seq->steps; step++){
+            seq->sample[step] = adcSample(seq->channel[step]);
+        }
+        seq->count = seq->steps;
+        isr(seq->handler);
+    }
+}
+
+//------------------uartService()---------------------------
+//Take the UART receive interrupt while characters are waiting
+static void uartService(void){
+    while(sim.uartHandler && sim.intMaster && sim.isrDepth == 0 && sim.rxHead != sim.rxTail){
+        size_t before = sim.rxTail;
+        isr(sim.uartHandler);
+        if(sim.rxTail == before){
+            break; // handler did not read, avoid spinning
+        }
+    }
+}
+
+//------------------txPut()---------------------------
+//Append one character to the transmit buffer
+static void txPut(char c){
+    if(sim.txLen < HAL_SIM_UART_TX_SIZE){
+        sim.tx[sim.txLen++] = c;
+    }
+    if(sim.echo && c != '\r'){
+        putchar(c);
+    }
+}
+
+// ********************* Clock and interrupts ****************************
+void HAL_ClockSet(HAL_Clock clock){
+    sim.clock = (clock == HAL_CLOCK_40MHZ) ? 40000000 : 80000000;
+}
+
+uint32_t HAL_ClockGet(void){
+    return sim.clock;
+}
+
+void HAL_CycleCounterInit(void){
+}
+
+// Handlers take no time here, so only latencies show up
+uint32_t HAL_CycleCount(void){
+    return (uint32_t)sim.cycles;
+}
+
+void HAL_DelayLoops(uint32_t loops){
+    if(sim.isrDepth){
+        sim.cycles += 3ull*loops; // events are caught up after the handler returns
+    }else{
+        HAL_SimRun(3ull*loops);
+    }
+}
+
+void HAL_IntMasterEnable(void){
+    sim.intMaster = true;
+}
+
+uint32_t HAL_EnterCritical(void){
+    uint32_t state = !sim.intMaster;
+    sim.intMaster = false;
+    return state;
+}
+
+void HAL_ExitCritical(uint32_t state){
+    if(!state){
+        sim.intMaster = true;
+    }
+}
+
+// ********************* GPIO ****************************
+void HAL_GPIOInitOutput(HAL_Pin pin){
+    sim.pins[pin] = false;
+}
+
+void HAL_GPIOInitInput(HAL_Pin pin){
+    sim.pins[pin] = true; // weak pull up
+}
+
+void HAL_GPIOWrite(HAL_Pin pin, bool level){
+    sim.pins[pin] = level;
+}
+
+bool HAL_GPIORead(HAL_Pin pin){
+    return sim.pins[pin];
+}
+
+// ********************* Timers ****************************
+void HAL_TimerInitPeriodic(HAL_Timer timer, uint32_t period, HAL_Handler handler){
+    HAL_SimTimer *t = &sim.timers[timer];
+    t->enabled = false;
+    t->intEnabled = true;
+    t->adcTrigger = false;
+    t->period = period ? period : 1;
+    t->handler = handler;
+}
+
+void HAL_TimerInitADCTrigger(HAL_Timer timer, uint32_t period){
+    HAL_SimTimer *t = &sim.timers[timer];
+    t->intEnabled = false;
+    t->adcTrigger = true;
+    t->period = period ? period : 1;
+    t->handler = 0;
+    HAL_TimerEnable(timer);
+}
+
+void HAL_TimerEnable(HAL_Timer timer){
+    HAL_SimTimer *t = &sim.timers[timer];
+    t->enabled = true;
+    t->next = sim.cycles + t->period;
+}
+
+void HAL_TimerDisable(HAL_Timer timer){
+    sim.timers[timer].enabled = false;
+}
+
+void HAL_TimerIntClear(HAL_Timer timer){
+    (void)timer;
+}
+
+uint32_t HAL_TimerValueGet(HAL_Timer timer){
+    HAL_SimTimer *t = &sim.timers[timer];
+    // Handlers take no time here, so step costs read as 0
+    if(!t->enabled || t->next <= sim.cycles){
+        return 0;
+    }
+    return (uint32_t)((t->next - sim.cycles) % t->period);
+}
+
+// ********************* ADC ****************************
+void HAL_ADCInit(int hardwareAveraging){
+    (void)hardwareAveraging;
+}
+
+void HAL_ADCSequenceInit(uint32_t sequence, HAL_ADCTrigger trigger, HAL_ADCChannel channel, HAL_Handler handler){
+    HAL_ADCSequenceStepsInit(sequence, trigger, &channel, 1, handler);
+}
+
+void HAL_ADCSequenceStepsInit(uint32_t sequence, HAL_ADCTrigger trigger, const HAL_ADCChannel *channels,
+                              uint32_t steps, HAL_Handler handler){
+    static const uint32_t maxSteps[HAL_SIM_ADC_SEQUENCES] = {8, 4, 4, 1};
+    HAL_SimSequence *seq = &sim.sequences[sequence % HAL_SIM_ADC_SEQUENCES];
+    uint32_t step;
+
+    if(steps > maxSteps[sequence % HAL_SIM_ADC_SEQUENCES]){
+        steps = maxSteps[sequence % HAL_SIM_ADC_SEQUENCES];
+    }
+    seq->configured = true;
+    seq->trigger = trigger;
+    for(step = 0; step < steps; step++){
+        seq->channel[step] = channels[step];
+    }
+    seq->steps = steps;
+    seq->handler = handler;
+    seq->count = 0;
+    seq->dma = false;
+}
+
+void HAL_ADCDMAInit(uint32_t sequence, HAL_ADCChannel channel, uint16_t *ping, uint16_t *pong,
+                    uint32_t length, HAL_Handler handler){
+    HAL_ADCSequenceInit(sequence, HAL_ADC_TRIGGER_TIMER, channel, handler);
+    sim.sequences[sequence % HAL_SIM_ADC_SEQUENCES].dma = true;
+    sim.adcDMABuffer[0] = ping;
+    sim.adcDMABuffer[1] = pong;
+    sim.adcDMALength = length;
+    sim.adcDMAIndex = 0;
+    sim.adcDMAActive = 0;
+    sim.adcDMAArmed[0] = true;
+    sim.adcDMAArmed[1] = true;
+    sim.adcDMADone = 0;
+}
+
+uint32_t HAL_ADCDMAService(void){
+    uint32_t done = sim.adcDMADone;
+    sim.adcDMADone = 0;
+    if(done & HAL_ADC_DMA_PING) sim.adcDMAArmed[0] = true;
+    if(done & HAL_ADC_DMA_PONG) sim.adcDMAArmed[1] = true;
+    return done;
+}
+
+void HAL_ADCProcessorTrigger(uint32_t sequence){
+    adcConvert(HAL_ADC_TRIGGER_PROCESSOR, (int)(sequence % HAL_SIM_ADC_SEQUENCES));
+}
+
+void HAL_ADCIntClear(uint32_t sequence){
+    (void)sequence;
+}
+
+int32_t HAL_ADCDataGet(uint32_t sequence, uint32_t *buffer){
+    HAL_SimSequence *seq = &sim.sequences[sequence % HAL_SIM_ADC_SEQUENCES];
+    int32_t count = seq->count;
+    if(count){
+        memcpy(buffer, seq->sample, count*sizeof(uint32_t));
+        seq->count = 0;
+    }
+    return count;
+}
+
+// ********************* PWM ****************************
+void HAL_PWMInit(uint32_t period){
+    sim.pwmPeriod = period;
+    sim.pwmWidth = 0;
+    sim.pwmEnabled = false;
+}
+
+void HAL_PWMSetPulseWidth(uint32_t width){
+    sim.pwmWidth = width;
+}
+
+void HAL_PWMOutputEnable(bool enable){
+    sim.pwmEnabled = enable;
+}
+
+// ********************* QEI ****************************
+void HAL_QEIInit(uint32_t topLimit, uint32_t startVal){
+    sim.qeiTop = topLimit;
+    sim.qeiPosition = startVal;
+}
+
+uint32_t HAL_QEIPositionGet(void){
+    return sim.qeiPosition;
+}
+
+void HAL_QEIVelocityInit(uint32_t period){
+    sim.qeiVelocity = (period > 0);
+    sim.qeiPeriod = period;
+    sim.qeiNext = sim.cycles + period;
+    sim.qeiEdges = 0;
+    sim.qeiSpeed = 0;
+}
+
+uint32_t HAL_QEIVelocityGet(void){
+    return sim.qeiSpeed;
+}
+
+int32_t HAL_QEIDirectionGet(void){
+    return sim.qeiDirection ? sim.qeiDirection : 1;
+}
+
+// ********************* UART0 ****************************
+void HAL_ConsoleInit(uint32_t baudRate){
+    sim.baud = baudRate;
+}
+
+void HAL_UARTInit(uint32_t baudRate, HAL_Handler handler){
+    sim.baud = baudRate;
+    sim.uartHandler = handler;
+}
+
+void HAL_UARTRxIntEnable(HAL_Handler handler){
+    if(handler){
+        sim.uartHandler = handler;
+    }
+}
+
+uint32_t HAL_UARTIntClear(void){
+    return 0;
+}
+
+bool HAL_UARTCharsAvail(void){
+    return sim.rxHead != sim.rxTail;
+}
+
+int32_t HAL_UARTCharGet(void){
+    // Nothing can arrive while the firmware waits, return -1 instead of hanging
+    return HAL_UARTCharGetNonBlocking();
+}
+
+int32_t HAL_UARTCharGetNonBlocking(void){
+    unsigned char c;
+    if(sim.rxHead == sim.rxTail){
+        return -1;
+    }
+    c = (unsigned char)sim.rx[sim.rxTail];
+    sim.rxTail = (sim.rxTail + 1) % HAL_SIM_UART_RX_SIZE;
+    return c;
+}
+
+void HAL_UARTCharPut(unsigned char c){
+    txPut((char)c);
+}
+
+bool HAL_UARTCharPutNonBlocking(unsigned char c){
+    txPut((char)c);
+    return true;
+}
+
+// ********************* uDMA UART0 TX ****************************
+void HAL_UARTDMAInit(HAL_Handler handler){
+    sim.dmaHandler = handler ? handler : sim.uartHandler;
+    sim.dmaBusy = false;
+}
+
+void HAL_UARTDMAStart(const uint8_t *data, uint32_t length){
+    uint32_t baud = sim.baud ? sim.baud : 115200;
+    if(length == 0 || length > HAL_UART_DMA_MAX){
+        return;
+    }
+    sim.dmaSource = data;
+    sim.dmaLength = length;
+    sim.dmaBusy = true;
+    sim.dmaDone = sim.cycles + (uint64_t)length*10*sim.clock/baud;
+}
+
+bool HAL_UARTDMABusy(void){
+    return sim.dmaBusy;
+}
+
+//------------------UARTprintf()---------------------------
+//Same conversions as utils/uartstdio.c for what slug.c uses, \n is sent as \r\n
+void UARTprintf(const char *pcString, ...){
+    char buffer[256];
+    va_list args;
+    int i, n;
+
+    va_start(args, pcString);
+    n = vsnprintf(buffer, sizeof(buffer), pcString, args);
+    va_end(args);
+    if(n > (int)sizeof(buffer) - 1){
+        n = sizeof(buffer) - 1;
+    }
+    for(i = 0; i < n; i++){
+        if(buffer[i] == '\n'){
+            txPut('\r');
+        }
+        txPut(buffer[i]);
+    }
+}
+
+// ********************* EEPROM ****************************
+uint32_t HAL_EEPROMInit(void){
+    FILE *f;
+
+    if(!eeprom.loaded){
+        memset(eeprom.data, 0xFF, sizeof(eeprom.data));
+        if(eeprom.path && (f = fopen(eeprom.path, "rb")) != 0){
+            if(fread(eeprom.data, 1, sizeof(eeprom.data), f) == 0){
+                memset(eeprom.data, 0xFF, sizeof(eeprom.data)); // empty file
+            }
+            fclose(f);
+        }
+        eeprom.loaded = true;
+    }
+    return HAL_SIM_EEPROM_SIZE;
+}
+
+void HAL_EEPROMRead(uint32_t address, uint32_t *words, uint32_t count){
+    uint32_t i;
+    const uint8_t *p;
+
+    for(i = 0; i < count; i++, address += 4){
+        if(address + 4 > HAL_SIM_EEPROM_SIZE){
+            words[i] = HAL_EEPROM_ERASED;
+            continue;
+        }
+        p = &eeprom.data[address];
+        words[i] = p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+}
+
+bool HAL_EEPROMProgram(uint32_t address, const uint32_t *words, uint32_t count){
+    uint32_t i;
+    uint8_t *p;
+    FILE *f;
+
+    if((address & 3) || address + 4*count > HAL_SIM_EEPROM_SIZE){
+        return false;
+    }
+    for(i = 0; i < count; i++){
+        p = &eeprom.data[address + 4*i];
+        p[0] = words[i];
+        p[1] = words[i] >> 8;
+        p[2] = words[i] >> 16;
+        p[3] = words[i] >> 24;
+    }
+    if(eeprom.path){
+        f = fopen(eeprom.path, "wb");
+        if(!f || fwrite(eeprom.data, 1, sizeof(eeprom.data), f) != sizeof(eeprom.data)){
+            if(f) fclose(f);
+            return false;
+        }
+        fclose(f);
+    }
+    return true;
+}
+
+// ********************* Simulation control ****************************
+void HAL_SimReset(void){
+    memset(&sim, 0, sizeof(sim));
+    sim.clock = HAL_SIM_RESET_CLOCK;
+}
+
+void HAL_SimRun(uint64_t cycles){
+    uint64_t end = sim.cycles + cycles;
+
+    uartService();
+    while(1){
+        int t, first = -1;
+        HAL_SimTimer *timer;
+
+        // Earliest timeout before end
+        for(t = 0; t < HAL_NUM_TIMERS; t++){
+            if(sim.timers[t].enabled && sim.timers[t].next <= end &&
+               (first < 0 || sim.timers[t].next < sim.timers[first].next)){
+                first = t;
+            }
+        }
+
+        // QEI velocity period ending first
+        if(sim.qeiVelocity && sim.qeiNext <= end && (first < 0 || sim.qeiNext < sim.timers[first].next) &&
+           (!sim.dmaBusy || sim.qeiNext < sim.dmaDone)){
+            if(sim.qeiNext > sim.cycles){
+                sim.cycles = sim.qeiNext;
+            }
+            sim.qeiNext += sim.qeiPeriod;
+            sim.qeiSpeed = sim.qeiEdges;
+            sim.qeiEdges = 0;
+            continue;
+        }
+
+        // uDMA transfer completing first
+        if(sim.dmaBusy && sim.dmaDone <= end && (first < 0 || sim.dmaDone < sim.timers[first].next)){
+            if(sim.dmaDone > sim.cycles){
+                sim.cycles = sim.dmaDone;
+            }
+            for(t = 0; t < (int)sim.dmaLength; t++){
+                txPut((char)sim.dmaSource[t]);
+            }
+            sim.dmaBusy = false;
+            isr(sim.dmaHandler);
+            uartService();
+            continue;
+        }
+        if(first < 0){
+            break;
+        }
+
+        timer = &sim.timers[first];
+        if(timer->next > sim.cycles){
+            sim.cycles = timer->next;
+        }
+        timer->next += timer->period;
+
+        if(timer->adcTrigger){
+            adcConvert(HAL_ADC_TRIGGER_TIMER, -1);
+        }
+        if(timer->intEnabled){
+            isr(timer->handler);
+        }
+        uartService();
+    }
+    if(end > sim.cycles){
+        sim.cycles = end;
+    }
+}
+
+uint64_t HAL_SimCycles(void){
+    return sim.cycles;
+}
+
+void HAL_SimSetADCValue(HAL_ADCChannel channel, uint32_t value){
+    sim.adcValue[channel] = value;
+}
+
+void HAL_SimSetADCSource(HAL_ADCChannel channel, HAL_SimADCSource source, void *context){
+    sim.adcSource[channel] = source;
+    sim.adcContext[channel] = context;
+}
+
+void HAL_SimGetPWM(uint32_t *period, uint32_t *width, bool *enabled){
+    if(period) *period = sim.pwmPeriod;
+    if(width) *width = sim.pwmWidth;
+    if(enabled) *enabled = sim.pwmEnabled;
+}
+
+bool HAL_SimGetPin(HAL_Pin pin){
+    return sim.pins[pin];
+}
+
+void HAL_SimSetPin(HAL_Pin pin, bool level){
+    sim.pins[pin] = level;
+}
+
+void HAL_SimSetQEIPosition(uint32_t position){
+    int32_t d = (int32_t)(position - sim.qeiPosition);
+    int32_t range = (int32_t)(sim.qeiTop + 1);
+
+    if(range > 0){
+        if(d > range/2){
+            d -= range;
+        }else if(d < -(range/2)){
+            d += range;
+        }
+    }
+    if(d != 0){
+        sim.qeiDirection = (d > 0) ? 1 : -1;
+        sim.qeiEdges += (d > 0) ? d : -d;
+    }
+    sim.qeiPosition = position;
+}
+
+size_t HAL_SimUARTRead(char *buffer, size_t size){
+    size_t n = (sim.txLen < size) ? sim.txLen : size;
+    memcpy(buffer, sim.tx, n);
+    memmove(sim.tx, sim.tx + n, sim.txLen - n);
+    sim.txLen -= n;
+    return n;
+}
+
+size_t HAL_SimUARTWrite(const char *data, size_t length){
+    size_t n = 0;
+    while(n < length){
+        size_t head = (sim.rxHead + 1) % HAL_SIM_UART_RX_SIZE;
+        if(head == sim.rxTail){
+            break; // receive queue full
+        }
+        sim.rx[sim.rxHead] = data[n++];
+        sim.rxHead = head;
+    }
+    return n;
+}
+
+void HAL_SimUARTEcho(bool echo){
+    sim.echo = echo;
+}
+
+void HAL_SimSetEEPROMFile(const char *path){
+    eeprom.path = path;
+    eeprom.loaded = false;
+}
+
+#endif // SLUG_HOST
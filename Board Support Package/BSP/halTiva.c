@@ -0,0 +1,656 @@
+// halTiva.c
+// Runs on TM4C123 with TIVA shield v2.0
+// TivaWare backend of the hardware abstraction layer (hal.h).
+// This is the only file below slug.c that touches driverlib. Compiles to
+// nothing in the host build (SLUG_HOST defined), see halHost.c.
+// With SLUG_RTOS pre-defined the interrupt handlers are TI-RTOS Hwi objects
+// created at the priorities of hwiPriority(), and the critical sections use
+// Hwi_disable(), see RTOS/ForceControl_RTOS. Every handler must then be passed
+// to its init function, a handler left in the startup file is never called.
+
+#ifndef SLUG_HOST
+
+#include "hal.h"
+
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_uart.h"
+#include "inc/hw_adc.h"
+
+#include "driverlib/sysctl.h"
+#include "driverlib/gpio.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/pwm.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/timer.h"
+#include "driverlib/uart.h"
+#include "driverlib/adc.h"
+#include "driverlib/qei.h"
+#include "driverlib/udma.h"
+#include "driverlib/eeprom.h"
+
+#ifdef SLUG_RTOS
+#include <xdc/std.h>
+#include <ti/sysbios/hal/Hwi.h>
+#endif
+
+// ***************************** Tables ****************************
+typedef struct {
+    uint32_t periph;
+    uint32_t base;
+    uint8_t pin;
+} HAL_PinMap;
+
+static const HAL_PinMap pinMap[HAL_NUM_PINS] = {
+    {SYSCTL_PERIPH_GPIOD, GPIO_PORTD_BASE, GPIO_PIN_7},    // HAL_PIN_BLUE_LED
+    {SYSCTL_PERIPH_GPIOC, GPIO_PORTC_BASE, GPIO_PIN_7},    // HAL_PIN_YELLOW_LED
+    {SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_1},    // HAL_PIN_RGB_RED
+    {SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_2},    // HAL_PIN_RGB_BLUE
+    {SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_3},    // HAL_PIN_RGB_GREEN
+    {SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_4},    // HAL_PIN_BUTTON1
+    {SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE, GPIO_PIN_7},    // HAL_PIN_MOTOR_DIR
+};
+
+typedef struct {
+    uint32_t periph;
+    uint32_t base;
+    uint32_t interrupt;
+} HAL_TimerMap;
+
+static const HAL_TimerMap timerMap[HAL_NUM_TIMERS] = {
+    {SYSCTL_PERIPH_TIMER0, TIMER0_BASE, INT_TIMER0A},      // HAL_TIMER0
+    {SYSCTL_PERIPH_TIMER1, TIMER1_BASE, INT_TIMER1A},      // HAL_TIMER1
+    {SYSCTL_PERIPH_TIMER2, TIMER2_BASE, INT_TIMER2A},      // HAL_TIMER2
+};
+
+typedef struct {
+    uint32_t control;       // ADCSequenceStepConfigure channel select
+    uint32_t gpioBase;      // 0 for internal channels
+    uint8_t gpioPin;
+} HAL_ADCMap;
+
+static const HAL_ADCMap adcMap[HAL_NUM_ADC_CHANNELS] = {
+    {ADC_CTL_CH0, GPIO_PORTE_BASE, GPIO_PIN_3},            // HAL_ADC_LOADCELL
+    {ADC_CTL_CH1, GPIO_PORTE_BASE, GPIO_PIN_2},            // HAL_ADC_ADDITIONAL
+    {ADC_CTL_TS, 0, 0},                                    // HAL_ADC_TEMPSENSOR
+    {ADC_CTL_CH8, GPIO_PORTE_BASE, GPIO_PIN_5},            // HAL_ADC_CURRENT
+    {ADC_CTL_CH3, GPIO_PORTE_BASE, GPIO_PIN_0},            // HAL_ADC_THERMOCOUPLE
+};
+
+static const uint32_t adcSeqInt[4] = {INT_ADC0SS0, INT_ADC0SS1, INT_ADC0SS2, INT_ADC0SS3};
+static const uint32_t adcSeqSteps[4] = {8, 4, 4, 1};
+
+// uDMA channel control table, must be 1024 byte aligned
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_ALIGN(dmaControlTable, 1024)
+#elif defined(__GNUC__)
+__attribute__ ((aligned (1024)))
+#endif
+static tDMAControlTable dmaControlTable[32];
+static bool dmaInitialized = false;
+static volatile uint32_t dmaErrors = 0;
+
+// ADC0 ping-pong stream (HAL_ADCDMAInit)
+static const uint32_t adcDMAChannel[4] = {UDMA_CH14_ADC0_0, UDMA_CH15_ADC0_1, UDMA_CH16_ADC0_2, UDMA_CH17_ADC0_3};
+static uint32_t adcDMASequence;
+static uint16_t *adcDMABuffer[2];
+static uint32_t adcDMALength;
+
+#ifdef SLUG_RTOS
+// Hwi objects created by intRegister()
+#define HAL_MAX_HWIS        8
+typedef struct {
+    uint32_t interrupt;
+    Hwi_Handle hwi;
+} HAL_HwiMap;
+
+static HAL_HwiMap hwiMap[HAL_MAX_HWIS];
+static uint32_t numHwis = 0;
+
+//------------------hwiPriority()---------------------------
+//Hwi priority of an interrupt, lower is more urgent. The load cell samples
+//come first, then the controller tick, then the UART and the slow timers
+static int hwiPriority(uint32_t interrupt){
+    switch(interrupt){
+    case INT_ADC0SS0: case INT_ADC0SS1: case INT_ADC0SS2: case INT_ADC0SS3:
+        return 0x20;
+    case INT_TIMER1A:
+        return 0x40;
+    case INT_UART0: case INT_UDMAERR:
+        return 0xA0;
+    default:
+        return 0xC0;
+    }
+}
+#endif
+
+//------------------intRegister()---------------------------
+//Register and enable the handler of an interrupt, as a Hwi with SLUG_RTOS
+static void intRegister(uint32_t interrupt, HAL_Handler handler){
+#ifdef SLUG_RTOS
+    Hwi_Params params;
+    uint32_t i;
+
+    for(i = 0; i < numHwis; i++){
+        if(hwiMap[i].interrupt == interrupt){
+            Hwi_setFunc(hwiMap[i].hwi, (Hwi_FuncPtr)handler, 0);
+            return;
+        }
+    }
+    if(numHwis < HAL_MAX_HWIS){
+        Hwi_Params_init(&params);
+        params.priority = hwiPriority(interrupt);
+        hwiMap[numHwis].interrupt = interrupt;
+        hwiMap[numHwis].hwi = Hwi_create(interrupt, (Hwi_FuncPtr)handler, &params, NULL);
+        numHwis++;
+    }
+#else
+    IntRegister(interrupt, handler);
+    IntEnable(interrupt);
+#endif
+}
+
+// ********************* Clock and interrupts ****************************
+void HAL_ClockSet(HAL_Clock clock){
+    if(clock == HAL_CLOCK_40MHZ){
+        // 400MHz PLL, /2 default divider, /5 -> 40MHz
+        SysCtlClockSet(SYSCTL_SYSDIV_5|SYSCTL_USE_PLL|SYSCTL_XTAL_16MHZ|SYSCTL_OSC_MAIN);
+    }else{
+        SysCtlClockSet(SYSCTL_SYSDIV_2_5|SYSCTL_USE_PLL|SYSCTL_XTAL_16MHZ|SYSCTL_OSC_MAIN);
+    }
+}
+
+uint32_t HAL_ClockGet(void){
+    return SysCtlClockGet();
+}
+
+// Debug unit registers, not in TivaWare
+#define DEMCR               0xE000EDFC  // debug exception and monitor control
+#define DEMCR_TRCENA        0x01000000  // enables the DWT
+#define DWT_CTRL            0xE0001000
+#define DWT_CTRL_CYCCNTENA  0x00000001
+#define DWT_CYCCNT          0xE0001004
+
+void HAL_CycleCounterInit(void){
+    HWREG(DEMCR) |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+uint32_t HAL_CycleCount(void){
+    return HWREG(DWT_CYCCNT);
+}
+
+void HAL_DelayLoops(uint32_t loops){
+    SysCtlDelay(loops);
+}
+
+#ifdef SLUG_RTOS
+void HAL_IntMasterEnable(void){
+    // BIOS_start() enables the interrupts
+}
+
+uint32_t HAL_EnterCritical(void){
+    return Hwi_disable(); // also holds off the Swis, they are posted by Hwis
+}
+
+void HAL_ExitCritical(uint32_t state){
+    Hwi_restore(state);
+}
+#else
+void HAL_IntMasterEnable(void){
+    IntMasterEnable();
+}
+
+uint32_t HAL_EnterCritical(void){
+    return IntMasterDisable(); // true if interrupts were already disabled
+}
+
+void HAL_ExitCritical(uint32_t state){
+    if(!state){
+        IntMasterEnable();
+    }
+}
+#endif
+
+// ********************* GPIO ****************************
+//------------------gpioEnable()---------------------------
+//Enable and wait for the port to be ready for access
+static void gpioEnable(HAL_Pin pin){
+    SysCtlPeripheralEnable(pinMap[pin].periph);
+    while(!SysCtlPeripheralReady(pinMap[pin].periph)){
+    }
+}
+
+void HAL_GPIOInitOutput(HAL_Pin pin){
+    gpioEnable(pin);
+    if(pin == HAL_PIN_BLUE_LED){
+        // Unlock PD7
+        HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+        HWREG(GPIO_PORTD_BASE + GPIO_O_CR) |= 0x80;
+        HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = 0;
+    }
+    GPIOPinTypeGPIOOutput(pinMap[pin].base, pinMap[pin].pin);
+}
+
+void HAL_GPIOInitInput(HAL_Pin pin){
+    gpioEnable(pin);
+    GPIOPinTypeGPIOInput(pinMap[pin].base, pinMap[pin].pin);
+    GPIOPadConfigSet(pinMap[pin].base, pinMap[pin].pin, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
+}
+
+void HAL_GPIOWrite(HAL_Pin pin, bool level){
+    GPIOPinWrite(pinMap[pin].base, pinMap[pin].pin, level ? pinMap[pin].pin : 0);
+}
+
+bool HAL_GPIORead(HAL_Pin pin){
+    return GPIOPinRead(pinMap[pin].base, pinMap[pin].pin) != 0;
+}
+
+// ********************* Timers ****************************
+void HAL_TimerInitPeriodic(HAL_Timer timer, uint32_t period, HAL_Handler handler){
+    uint32_t base = timerMap[timer].base;
+
+    SysCtlPeripheralEnable(timerMap[timer].periph);
+    while(!SysCtlPeripheralReady(timerMap[timer].periph)){
+    }
+
+    TimerConfigure(base, TIMER_CFG_PERIODIC);
+    TimerLoadSet(base, TIMER_A, period-1);
+
+    // register the timer interrupt service routine
+    if(handler){
+        intRegister(timerMap[timer].interrupt, handler);
+    }
+
+    // clear rollover interrupt and then enable it
+    TimerIntClear(base, TIMER_TIMA_TIMEOUT);
+    TimerIntEnable(base, TIMER_TIMA_TIMEOUT);
+    IntEnable(timerMap[timer].interrupt);
+}
+
+void HAL_TimerInitADCTrigger(HAL_Timer timer, uint32_t period){
+    uint32_t base = timerMap[timer].base;
+
+    SysCtlPeripheralEnable(timerMap[timer].periph);
+    SysCtlDelay(2);
+
+    TimerConfigure(base, TIMER_CFG_PERIODIC);
+    TimerLoadSet(base, TIMER_A, period-1);
+    TimerControlTrigger(base, TIMER_A, true);
+    TimerEnable(base, TIMER_A);
+}
+
+void HAL_TimerEnable(HAL_Timer timer){
+    TimerEnable(timerMap[timer].base, TIMER_A);
+}
+
+void HAL_TimerDisable(HAL_Timer timer){
+    TimerDisable(timerMap[timer].base, TIMER_A);
+}
+
+void HAL_TimerIntClear(HAL_Timer timer){
+    TimerIntClear(timerMap[timer].base, TIMER_TIMA_TIMEOUT);
+}
+
+uint32_t HAL_TimerValueGet(HAL_Timer timer){
+    return TimerValueGet(timerMap[timer].base, TIMER_A);
+}
+
+// ********************* ADC ****************************
+void HAL_ADCInit(int hardwareAveraging){
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
+    SysCtlDelay(2);
+
+    if(hardwareAveraging > 0){
+        ADCHardwareOversampleConfigure(ADC0_BASE, hardwareAveraging); //average n samples
+    }
+}
+
+void HAL_ADCSequenceInit(uint32_t sequence, HAL_ADCTrigger trigger, HAL_ADCChannel channel, HAL_Handler handler){
+    HAL_ADCSequenceStepsInit(sequence, trigger, &channel, 1, handler);
+}
+
+void HAL_ADCSequenceStepsInit(uint32_t sequence, HAL_ADCTrigger trigger, const HAL_ADCChannel *channels,
+                              uint32_t steps, HAL_Handler handler){
+    uint32_t step;
+
+    sequence &= 3;
+    if(steps > adcSeqSteps[sequence]){
+        steps = adcSeqSteps[sequence];
+    }
+
+    // Configure the pins as ADC inputs
+    for(step = 0; step < steps; step++){
+        if(adcMap[channels[step]].gpioBase){
+            SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
+            SysCtlDelay(2);
+            GPIOPinTypeADC(adcMap[channels[step]].gpioBase, adcMap[channels[step]].gpioPin);
+        }
+    }
+
+    // Base, Seq Num, Trigger source, Priority
+    // Priorities must differ between sequencers, the lowest number wins
+    ADCSequenceDisable(ADC0_BASE, sequence);
+    ADCSequenceConfigure(ADC0_BASE, sequence,
+                         (trigger == HAL_ADC_TRIGGER_TIMER) ? ADC_TRIGGER_TIMER : ADC_TRIGGER_PROCESSOR, sequence);
+
+    // One step per channel, interrupt flag on the last sample
+    for(step = 0; step < steps; step++){
+        ADCSequenceStepConfigure(ADC0_BASE, sequence, step,
+                                 adcMap[channels[step]].control|((step == steps - 1) ? (ADC_CTL_IE|ADC_CTL_END) : 0));
+    }
+    ADCSequenceEnable(ADC0_BASE, sequence);
+
+    // Interrupt enable
+    if(handler){
+        intRegister(adcSeqInt[sequence], handler);
+    }
+    ADCIntClear(ADC0_BASE, sequence);
+    ADCIntEnable(ADC0_BASE, sequence);
+    IntEnable(adcSeqInt[sequence]);
+}
+
+void HAL_ADCProcessorTrigger(uint32_t sequence){
+    ADCProcessorTrigger(ADC0_BASE, sequence);
+}
+
+void HAL_ADCIntClear(uint32_t sequence){
+    ADCIntClear(ADC0_BASE, sequence);
+}
+
+int32_t HAL_ADCDataGet(uint32_t sequence, uint32_t *buffer){
+    return ADCSequenceDataGet(ADC0_BASE, sequence, buffer);
+}
+
+// ********************* PWM ****************************
+void HAL_PWMInit(uint32_t period){
+    /* PWM clock: systemClock/2 = 80/2 MHZ */
+    SysCtlPWMClockSet(SYSCTL_PWMDIV_2);
+
+    /* Enable PWM*/
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_PWM1); // Module 1 for PF1
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_PWM1)){}
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF); //PF1
+
+    // Configure PWM pin
+    GPIOPinTypePWM(GPIO_PORTF_BASE, GPIO_PIN_1);
+    GPIOPinConfigure(GPIO_PF1_M1PWM5);
+
+    PWMGenConfigure(PWM1_BASE, PWM_GEN_2, PWM_GEN_MODE_DOWN);
+    PWMGenPeriodSet(PWM1_BASE, PWM_GEN_2, period);
+
+    // Enable the PWM generator with the output off
+    PWMPulseWidthSet(PWM1_BASE, PWM_OUT_5, 0);
+    PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT, false);
+    PWMGenEnable(PWM1_BASE, PWM_GEN_2);
+}
+
+void HAL_PWMSetPulseWidth(uint32_t width){
+    PWMPulseWidthSet(PWM1_BASE, PWM_OUT_5, width);
+}
+
+void HAL_PWMOutputEnable(bool enable){
+    PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT, enable);
+}
+
+// ********************* QEI ****************************
+void HAL_QEIInit(uint32_t topLimit, uint32_t startVal){
+    // Enable QEI 1 Peripherals
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOC);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_QEI1);
+
+    //Set ChA and ChB
+    GPIOPinConfigure(GPIO_PC5_PHA1);
+    GPIOPinConfigure(GPIO_PC6_PHB1);
+    GPIOPinTypeQEI(GPIO_PORTC_BASE, GPIO_PIN_5|GPIO_PIN_6);
+
+    //Disable peripheral and all sources of interrupts during configuration
+    QEIDisable(QEI1_BASE);
+    QEIIntDisable(QEI1_BASE, QEI_INTERROR|QEI_INTDIR|QEI_INTTIMER|QEI_INTINDEX);
+
+    // Configure quadrature encoder, set top limit
+    QEIConfigure(QEI1_BASE, (QEI_CONFIG_CAPTURE_A_B|QEI_CONFIG_NO_RESET|QEI_CONFIG_QUADRATURE|QEI_CONFIG_NO_SWAP), topLimit);
+    QEIEnable(QEI1_BASE);
+
+    //Set position to the required start value
+    QEIPositionSet(QEI1_BASE, startVal);
+}
+
+uint32_t HAL_QEIPositionGet(void){
+    return QEIPositionGet(QEI1_BASE);
+}
+
+void HAL_QEIVelocityInit(uint32_t period){
+    // No predivider, the timer interrupt stays off (read by the controller)
+    QEIVelocityDisable(QEI1_BASE);
+    QEIVelocityConfigure(QEI1_BASE, QEI_VELDIV_1, period);
+    QEIVelocityEnable(QEI1_BASE);
+}
+
+uint32_t HAL_QEIVelocityGet(void){
+    return QEIVelocityGet(QEI1_BASE);
+}
+
+int32_t HAL_QEIDirectionGet(void){
+    return QEIDirectionGet(QEI1_BASE);
+}
+
+// ********************* UART0 ****************************
+//------------------uartPins()---------------------------
+//Enable UART0 and configure PA0/PA1
+static void uartPins(void){
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+    SysCtlDelay(3); //Just to be sure that the peripherals were enabled
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
+    SysCtlDelay(3);
+
+    GPIOPinConfigure(GPIO_PA0_U0RX);
+    GPIOPinConfigure(GPIO_PA1_U0TX);
+    GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0|GPIO_PIN_1);
+}
+
+void HAL_ConsoleInit(uint32_t baudRate){
+    uartPins();
+
+    // Configure UART clock and Baud rate
+    UARTClockSourceSet(UART0_BASE, UART_CLOCK_PIOSC); //Precision internal clock
+    UARTStdioConfig(0, baudRate, 16000000);
+}
+
+void HAL_UARTInit(uint32_t baudRate, HAL_Handler handler){
+    uartPins();
+
+    // Set UART functionality - Baud rate, parity etc
+    UARTConfigSetExpClk(UART0_BASE, SysCtlClockGet(), baudRate, (UART_CONFIG_WLEN_8|UART_CONFIG_STOP_ONE|UART_CONFIG_PAR_NONE));
+
+    if(handler){
+        intRegister(INT_UART0, handler);
+    }
+    IntEnable(INT_UART0);
+    UARTIntEnable(UART0_BASE, UART_INT_RX|UART_INT_RT); //Enable RX and RT interrupt sources only
+}
+
+void HAL_UARTRxIntEnable(HAL_Handler handler){
+    if(handler){
+        intRegister(INT_UART0, handler);
+    }
+    IntEnable(INT_UART0);
+    UARTIntEnable(UART0_BASE, UART_INT_RX|UART_INT_RT);
+}
+
+uint32_t HAL_UARTIntClear(void){
+    uint32_t status;
+    status = UARTIntStatus(UART0_BASE, true);
+    UARTIntClear(UART0_BASE, status);
+    return status;
+}
+
+bool HAL_UARTCharsAvail(void){
+    return UARTCharsAvail(UART0_BASE);
+}
+
+int32_t HAL_UARTCharGet(void){
+    return UARTCharGet(UART0_BASE);
+}
+
+int32_t HAL_UARTCharGetNonBlocking(void){
+    return UARTCharGetNonBlocking(UART0_BASE);
+}
+
+void HAL_UARTCharPut(unsigned char c){
+    UARTCharPut(UART0_BASE, c);
+}
+
+bool HAL_UARTCharPutNonBlocking(unsigned char c){
+    return UARTCharPutNonBlocking(UART0_BASE, c);
+}
+
+// ********************* uDMA ****************************
+//------------------dmaErrorHandler()---------------------------
+//uDMA bus error, clear it and count it
+static void dmaErrorHandler(void){
+    uDMAErrorStatusClear();
+    dmaErrors++;
+}
+
+//------------------dmaInit()---------------------------
+//Enable the uDMA controller once, same as EK_TM4C123GXL_initDMA()
+static void dmaInit(void){
+    if(!dmaInitialized){
+        SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+        while(!SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA)){
+        }
+        uDMAEnable();
+        uDMAControlBaseSet(dmaControlTable);
+        intRegister(INT_UDMAERR, dmaErrorHandler);
+        dmaInitialized = true;
+    }
+}
+
+void HAL_UARTDMAInit(HAL_Handler handler){
+    dmaInit();
+
+    // Half full TX FIFO requests a burst of 4
+    UARTFIFOEnable(UART0_BASE);
+    UARTFIFOLevelSet(UART0_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+
+    uDMAChannelAssign(UDMA_CH9_UART0TX);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_UART0TX, UDMA_ATTR_ALTSELECT|UDMA_ATTR_HIGH_PRIORITY|UDMA_ATTR_REQMASK);
+    uDMAChannelAttributeEnable(UDMA_CHANNEL_UART0TX, UDMA_ATTR_USEBURST);
+    uDMAChannelControlSet(UDMA_CHANNEL_UART0TX|UDMA_PRI_SELECT, UDMA_SIZE_8|UDMA_SRC_INC_8|UDMA_DST_INC_NONE|UDMA_ARB_4);
+    UARTDMAEnable(UART0_BASE, UART_DMA_TX);
+
+    // Completion is signalled on the UART0 interrupt
+    if(handler){
+        intRegister(INT_UART0, handler);
+    }
+    IntEnable(INT_UART0);
+}
+
+void HAL_UARTDMAStart(const uint8_t *data, uint32_t length){
+    uDMAChannelTransferSet(UDMA_CHANNEL_UART0TX|UDMA_PRI_SELECT, UDMA_MODE_BASIC,
+                           (void *)data, (void *)(UART0_BASE + UART_O_DR), length);
+    uDMAChannelEnable(UDMA_CHANNEL_UART0TX);
+}
+
+bool HAL_UARTDMABusy(void){
+    return uDMAChannelIsEnabled(UDMA_CHANNEL_UART0TX);
+}
+
+//------------------adcDMAArm()---------------------------
+//Point the primary (ping) or alternate (pong) control structure at its buffer
+static void adcDMAArm(uint32_t select){
+    uint32_t channel = (adcDMAChannel[adcDMASequence] & 0xFF)|select;
+    uDMAChannelTransferSet(channel, UDMA_MODE_PINGPONG,
+                           (void *)(ADC0_BASE + ADC_O_SSFIFO0 + 0x20*adcDMASequence),
+                           adcDMABuffer[select == UDMA_ALT_SELECT], adcDMALength);
+}
+
+void HAL_ADCDMAInit(uint32_t sequence, HAL_ADCChannel channel, uint16_t *ping, uint16_t *pong,
+                    uint32_t length, HAL_Handler handler){
+    uint32_t dmaChannel;
+
+    dmaInit();
+    adcDMASequence = sequence & 3;
+    adcDMABuffer[0] = ping;
+    adcDMABuffer[1] = pong;
+    adcDMALength = length;
+    dmaChannel = adcDMAChannel[adcDMASequence] & 0xFF;
+
+    // Configure the pin as ADC input
+    if(adcMap[channel].gpioBase){
+        SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
+        SysCtlDelay(2);
+        GPIOPinTypeADC(adcMap[channel].gpioBase, adcMap[channel].gpioPin);
+    }
+
+    ADCSequenceDisable(ADC0_BASE, adcDMASequence);
+    ADCSequenceConfigure(ADC0_BASE, adcDMASequence, ADC_TRIGGER_TIMER, adcDMASequence);
+    ADCSequenceStepConfigure(ADC0_BASE, adcDMASequence, 0, adcMap[channel].control|ADC_CTL_IE|ADC_CTL_END);
+
+    // 16 bit reads of the FIFO, one sample per request
+    uDMAChannelAssign(adcDMAChannel[adcDMASequence]);
+    uDMAChannelAttributeDisable(dmaChannel, UDMA_ATTR_ALTSELECT|UDMA_ATTR_USEBURST|UDMA_ATTR_HIGH_PRIORITY|UDMA_ATTR_REQMASK);
+    uDMAChannelControlSet(dmaChannel|UDMA_PRI_SELECT, UDMA_SIZE_16|UDMA_SRC_INC_NONE|UDMA_DST_INC_16|UDMA_ARB_1);
+    uDMAChannelControlSet(dmaChannel|UDMA_ALT_SELECT, UDMA_SIZE_16|UDMA_SRC_INC_NONE|UDMA_DST_INC_16|UDMA_ARB_1);
+    adcDMAArm(UDMA_PRI_SELECT);
+    adcDMAArm(UDMA_ALT_SELECT);
+    uDMAChannelEnable(dmaChannel);
+
+    ADCSequenceDMAEnable(ADC0_BASE, adcDMASequence);
+    ADCSequenceEnable(ADC0_BASE, adcDMASequence);
+
+    // The per sample interrupt stays masked, block completion is signalled
+    // on the sequence interrupt by the uDMA
+    if(handler){
+        intRegister(adcSeqInt[adcDMASequence], handler);
+    }
+    ADCIntClear(ADC0_BASE, adcDMASequence);
+    IntEnable(adcSeqInt[adcDMASequence]);
+}
+
+uint32_t HAL_ADCDMAService(void){
+    uint32_t dmaChannel = adcDMAChannel[adcDMASequence] & 0xFF;
+    uint32_t done = 0;
+
+    ADCIntClear(ADC0_BASE, adcDMASequence);
+    if(uDMAChannelModeGet(dmaChannel|UDMA_PRI_SELECT) == UDMA_MODE_STOP){
+        adcDMAArm(UDMA_PRI_SELECT);
+        done |= HAL_ADC_DMA_PING;
+    }
+    if(uDMAChannelModeGet(dmaChannel|UDMA_ALT_SELECT) == UDMA_MODE_STOP){
+        adcDMAArm(UDMA_ALT_SELECT);
+        done |= HAL_ADC_DMA_PONG;
+    }
+    // Both stopped means the channel ran out of buffers and turned off
+    if(!uDMAChannelIsEnabled(dmaChannel)){
+        uDMAChannelEnable(dmaChannel);
+    }
+    return done;
+}
+
+// ********************* EEPROM ****************************
+uint32_t HAL_EEPROMInit(void){
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_EEPROM0)){
+    }
+    // An error means the last write was cut short and could not be finished
+    if(EEPROMInit() != EEPROM_INIT_OK){
+        return 0;
+    }
+    return EEPROMSizeGet();
+}
+
+void HAL_EEPROMRead(uint32_t address, uint32_t *words, uint32_t count){
+    EEPROMRead(words, address, 4*count);
+}
+
+bool HAL_EEPROMProgram(uint32_t address, const uint32_t *words, uint32_t count){
+    return EEPROMProgram((uint32_t *)words, address, 4*count) == 0;
+}
+
+#endif // SLUG_HOST
@@ -0,0 +1,81 @@
+// ident.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Excitation signals for the identification of the actuator, see ident.h.
+
+#include <math.h>
+#include <string.h>
+#include "ident.h"
+
+#define IDENT_TWO_PI 6.28318531f
+
+//------------------Ident_Init()---------------------------
+//Set up an excitation from its first tick. f0 and f1 are limited to the
+//Nyquist frequency, f0 to f1
+//Input: state, kind, amplitude and bias (percent), f0 and f1 (Hz, PRBS uses
+//       f1), length (s), controller frequency (Hz)
+//Output: None
+void Ident_Init(Ident_State *s, Ident_Kind kind, float amplitude, float bias, float f0, float f1,
+                float seconds, uint32_t freq){
+    float nyquist = 0.5f*(float)freq;
+    float bitTicks;
+
+    memset(s, 0, sizeof(*s));
+    s->kind = kind;
+    s->amplitude = amplitude;
+    s->bias = bias;
+    s->ticks = (seconds > 0) ? (uint32_t)(seconds*(float)freq) : 0;
+    if(f1 > nyquist){
+        f1 = nyquist;
+    }
+    if(f0 > f1){
+        f0 = f1;
+    }
+    if(f0 <= 0 || s->ticks == 0){
+        s->ticks = 0;       // nothing to send
+        return;
+    }
+    s->step = IDENT_TWO_PI*f0/(float)freq;
+    s->ratio = expf(logf(f1/f0)/(float)s->ticks);
+    s->lfsr = (1u << IDENT_PRBS_BITS) - 1;
+    bitTicks = IDENT_PRBS_BANDWIDTH*(float)freq/f1;
+    s->bitTicks = (bitTicks > 1) ? (uint32_t)(bitTicks + 0.5f) : 1;
+}
+
+//------------------Ident_Step()---------------------------
+//Advance one tick
+//Input: state
+//Output: Duty cycle in percent, 0 once done
+float Ident_Step(Ident_State *s){
+    uint32_t feedback;
+
+    if(s->tick >= s->ticks){
+        s->value = 0;
+        return 0;
+    }
+    s->tick++;
+    if(s->kind == IDENT_CHIRP){
+        s->value = s->bias + s->amplitude*sinf(s->phase);
+        s->phase += s->step;
+        if(s->phase >= IDENT_TWO_PI){
+            s->phase -= IDENT_TWO_PI;
+        }
+        s->step *= s->ratio;
+    }else{
+        s->value = s->bias + ((s->lfsr & 1) ? s->amplitude : -s->amplitude);
+        if(++s->bitCount >= s->bitTicks){
+            s->bitCount = 0;
+            // Fibonacci LFSR, x^9 + x^5 + 1
+            feedback = (s->lfsr ^ (s->lfsr >> (IDENT_PRBS_BITS - IDENT_PRBS_TAP))) & 1;
+            s->lfsr = (s->lfsr >> 1) | (feedback << (IDENT_PRBS_BITS - 1));
+        }
+    }
+    return s->value;
+}
+
+//------------------Ident_Done()---------------------------
+//Tell if the excitation is over
+//Input: state
+//Output: 1 when done, 0 while running
+int Ident_Done(const Ident_State *s){
+    return s->tick >= s->ticks;
+}
@@ -0,0 +1,66 @@
+// ident.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Excitation signals for the identification of the actuator, one value per
+// controller tick, duty cycle in percent around a bias:
+//   chirp - sine sweeping from f0 to f1 at a constant rate per octave
+//           (logarithmic), so every decade gets the same time. It starts at
+//           phase 0, without a jump from the bias
+//   PRBS  - maximum length pseudo random binary sequence (9 bit LFSR,
+//           x^9 + x^5 + 1, 511 bits) of +-amplitude. A bit lasts
+//           IDENT_PRBS_BANDWIDTH*rate/f1 ticks, at least 1, so the spectrum is
+//           flat within 3 dB up to f1
+// After the given time the value is 0, not the bias, and Ident_Done() is 1.
+// The input and output are streamed by the telemetry of the controller tick,
+// Host Tools/sysIdent estimates the frequency response from them.
+// Float, runs on the FPU.
+
+#ifndef IDENT_H_
+#define IDENT_H_
+
+#include <stdint.h>
+
+#define IDENT_PRBS_BITS         9
+#define IDENT_PRBS_TAP          5
+#define IDENT_PRBS_BANDWIDTH    0.44f   // -3 dB frequency of the PRBS spectrum times the bit time
+
+typedef enum {
+    IDENT_CHIRP,
+    IDENT_PRBS,
+    NUM_IDENT_KINDS
+} Ident_Kind;
+
+typedef struct {
+    Ident_Kind kind;
+    float amplitude, bias;  // percent
+    uint32_t tick, ticks;   // elapsed, length
+    float value;            // last value, percent
+    // chirp
+    float phase;            // rad
+    float step, ratio;      // phase step of this tick, growth per tick
+    // PRBS
+    uint32_t lfsr;
+    uint32_t bitTicks, bitCount;
+} Ident_State;
+
+//------------------Ident_Init()---------------------------
+//Set up an excitation from its first tick. f0 and f1 are limited to the
+//Nyquist frequency, f0 to f1
+//Input: state, kind, amplitude and bias (percent), f0 and f1 (Hz, PRBS uses
+//       f1), length (s), controller frequency (Hz)
+//Output: None
+void Ident_Init(Ident_State *s, Ident_Kind kind, float amplitude, float bias, float f0, float f1,
+                float seconds, uint32_t freq);
+
+//------------------Ident_Step()---------------------------
+//Advance one tick
+//Input: state
+//Output: Duty cycle in percent, 0 once done
+float Ident_Step(Ident_State *s);
+
+//------------------Ident_Done()---------------------------
+//Tell if the excitation is over
+//Input: state
+//Output: 1 when done, 0 while running
+int Ident_Done(const Ident_State *s);
+
+#endif /* IDENT_H_ */
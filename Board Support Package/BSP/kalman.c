@@ -0,0 +1,180 @@
+// kalman.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Steady state Kalman filter of the load cell force, see kalman.h.
+
+#include <math.h>
+#include <string.h>
+#include "kalman.h"
+
+//------------------multiply()---------------------------
+//3x3 product c = a*b, c may not be a or b
+static void multiply(double c[3][3], const double a[3][3], const double b[3][3]){
+    int i, j;
+
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            c[i][j] = a[i][0]*b[0][j] + a[i][1]*b[1][j] + a[i][2]*b[2][j];
+        }
+    }
+}
+
+//------------------invert()---------------------------
+//3x3 inverse by cofactors
+//Output: 1 if done, 0 if singular
+static int invert(double c[3][3], const double a[3][3]){
+    double det;
+    int i, j;
+
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            c[j][i] = a[(i + 1)%3][(j + 1)%3]*a[(i + 2)%3][(j + 2)%3] -
+                      a[(i + 1)%3][(j + 2)%3]*a[(i + 2)%3][(j + 1)%3];
+        }
+    }
+    det = a[0][0]*c[0][0] + a[0][1]*c[1][0] + a[0][2]*c[2][0];
+    if(det == 0){
+        return 0;
+    }
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            c[i][j] /= det;
+        }
+    }
+    return 1;
+}
+
+//------------------Kalman_Design()---------------------------
+//Discretise the model and compute the steady state gain. The model can be
+//swapped into a running filter, its state carries on
+//Input: model, tick (s), acceleration noise q (lb/s^2), offset walk qo
+//       (lb/sqrt(s)), reading noise r (lb)
+//Output: 1 if the gain converged, 0 otherwise (the gain is the last one)
+int Kalman_Design(Kalman_Model *m, double dt, double q, double qo, double r){
+    double ac[2][2] = {{0, 1}, {-KALMAN_SEA_DEN0, -KALMAN_SEA_DEN1}};
+    double term[2][2] = {{1, 0}, {0, 1}};   // (ac*dt)^n/n!
+    double bd[2] = {0, 0}, t[2][2];
+    double g[3] = {0.5*dt*dt, dt, 0};       // acceleration held over a tick
+    double alpha[3][3], beta[3][3], gamma[3][3], w[3][3], wi[3][3], m1[3][3], m2[3][3], s, change;
+    int n, i, j, converged = 0;
+
+    // Zero order hold: ad = sum (ac*dt)^n/n!, bd = sum (ac*dt)^n/(n+1)! dt*bc.
+    // alpha holds ad transposed, the offset row is 1
+    memset(alpha, 0, sizeof(alpha));
+    alpha[0][0] = alpha[1][1] = alpha[2][2] = 1;
+    for(n = 0; n < KALMAN_EXP_TERMS; n++){
+        bd[0] += term[0][1]*dt*KALMAN_SEA_NUM/(n + 1);
+        bd[1] += term[1][1]*dt*KALMAN_SEA_NUM/(n + 1);
+        for(i = 0; i < 2; i++){
+            for(j = 0; j < 2; j++){
+                t[i][j] = (term[i][0]*ac[0][j] + term[i][1]*ac[1][j])*dt/(n + 1);
+            }
+        }
+        memcpy(term, t, sizeof(term));
+        for(i = 0; i < 2; i++){
+            for(j = 0; j < 2; j++){
+                alpha[j][i] += term[i][j];
+            }
+        }
+    }
+    for(i = 0; i < 2; i++){
+        for(j = 0; j < 2; j++){
+            m->a[i][j] = (float)alpha[j][i];
+        }
+        m->b[i] = (float)bd[i];
+    }
+
+    // Riccati equation of the predicted covariance by doubling, each pass
+    // doubles the horizon:
+    //   w = (I + beta*gamma)^-1
+    //   gamma += alpha' gamma w alpha, beta += alpha w beta alpha', alpha = alpha w alpha
+    // from beta = H'H/r^2 (H = [1 0 1]) and gamma = Q, gamma ends at P
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            beta[i][j] = (i != 1 && j != 1) ? 1.0/(r*r) : 0;
+            gamma[i][j] = g[i]*g[j]*q*q;
+        }
+    }
+    gamma[2][2] += qo*qo*dt;
+    for(n = 0; n < KALMAN_ITERATIONS && !converged; n++){
+        multiply(m1, beta, gamma);
+        for(i = 0; i < 3; i++){
+            m1[i][i] += 1;
+        }
+        if(!invert(w, m1)){
+            break;
+        }
+        // gamma += alpha' gamma w alpha
+        multiply(m1, gamma, w);
+        multiply(m2, m1, alpha);
+        change = 0;
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                s = alpha[0][i]*m2[0][j] + alpha[1][i]*m2[1][j] + alpha[2][i]*m2[2][j];
+                gamma[i][j] += s;
+                if(fabs(s) > change*fabs(gamma[i][j])){
+                    change = fabs(s/gamma[i][j]);
+                }
+            }
+        }
+        // beta += alpha w beta alpha'
+        multiply(m1, alpha, w);
+        multiply(m2, m1, beta);
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                beta[i][j] += m2[i][0]*alpha[j][0] + m2[i][1]*alpha[j][1] + m2[i][2]*alpha[j][2];
+            }
+        }
+        // alpha = alpha w alpha
+        memcpy(wi, alpha, sizeof(wi));
+        multiply(alpha, m1, wi);
+        converged = change < KALMAN_TOLERANCE;
+    }
+
+    // Gain from the predicted covariance, K = P H'/(H P H' + r^2)
+    s = gamma[0][0] + gamma[0][2] + gamma[2][0] + gamma[2][2] + r*r;
+    for(i = 0; i < 3; i++){
+        m->gain[i] = (float)((gamma[i][0] + gamma[i][2])/s);
+    }
+    return converged;
+}
+
+//------------------Kalman_Reset()---------------------------
+//Forget the state, the next reading primes it at the steady state of the
+//duty
+//Input: filter
+//Output: None
+void Kalman_Reset(Kalman_Filter *k){
+    k->x[0] = k->x[1] = k->x[2] = 0;
+    k->load = 0;
+    k->innovation = 0;
+    k->primed = 0;
+}
+
+//------------------Kalman_Step()---------------------------
+//Run one tick
+//Input: filter, load cell reading (lb), signed duty applied since the last
+//       tick (percent)
+//Output: Estimate of the reading, lb
+float Kalman_Step(Kalman_Filter *k, float load, float duty){
+    const Kalman_Model *m = &k->model;
+    float f, rate;
+
+    if(!k->primed){
+        k->x[0] = duty*(float)(KALMAN_SEA_NUM/KALMAN_SEA_DEN0);
+        k->x[1] = 0;
+        k->x[2] = load - k->x[0];
+        k->load = load;
+        k->primed = 1;
+        return load;
+    }
+
+    // Prediction from the duty, then the correction
+    f = m->a[0][0]*k->x[0] + m->a[0][1]*k->x[1] + m->b[0]*duty;
+    rate = m->a[1][0]*k->x[0] + m->a[1][1]*k->x[1] + m->b[1]*duty;
+    k->innovation = load - (f + k->x[2]);
+    k->x[0] = f + m->gain[0]*k->innovation;
+    k->x[1] = rate + m->gain[1]*k->innovation;
+    k->x[2] += m->gain[2]*k->innovation;
+    k->load = k->x[0] + k->x[2];
+    return k->load;
+}
@@ -0,0 +1,71 @@
+// kalman.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Steady state Kalman filter of the load cell force, updated once per
+// controller tick. The model is the series elastic actuator identified in
+// Data Collection/PI control step resp/SEA_analysis.m, driven by the signed
+// duty commanded over the last tick, plus a slow offset:
+//   F'' = -KALMAN_SEA_DEN1*F' - KALMAN_SEA_DEN0*F + KALMAN_SEA_NUM*duty
+//   load = F + offset + v
+// State x = [F, F', offset] in lb, lb/s and lb. The force part is
+// discretised with a zero order hold on the duty (series of the matrix
+// exponential). Noise:
+//   q  - force acceleration the model misses, white over a tick, lb/s^2
+//   qo - offset random walk (preload, drift), lb/sqrt(s)
+//   r  - load cell reading, lb
+// Kalman_Design() solves the Riccati equation for the steady state gain
+// once, so Kalman_Step() costs the same few multiply-adds every tick: a
+// prediction from the duty and a correction by the gain times the
+// innovation. The prediction follows the motor command without waiting for
+// the load cell, so the estimate is less noisy than averaging for the same
+// lag. The offset absorbs the preload and the DC error of the model.
+// Float step, the design runs in double.
+
+#ifndef KALMAN_H_
+#define KALMAN_H_
+
+#include <stdint.h>
+
+#define KALMAN_SEA_NUM          11.349  // lb/(s^2 percent), 11358.64*100/225 N per duty fraction
+#define KALMAN_SEA_DEN1         3.823   // 1/s
+#define KALMAN_SEA_DEN0         50.126  // 1/s^2
+#define KALMAN_EXP_TERMS        12      // series terms of the discretisation
+#define KALMAN_ITERATIONS       64      // doubling passes at most, 2^64 ticks
+#define KALMAN_TOLERANCE        1e-12   // relative change of the covariance to stop
+
+typedef struct {
+    // x[k+1] = a*x[k] + b*duty[k], the offset is constant
+    float a[2][2], b[2];        // lb, lb/s per percent
+    float gain[3];              // steady state Kalman gain
+} Kalman_Model;
+
+typedef struct {
+    Kalman_Model model;
+    float x[3];                 // F lb, F' lb/s, offset lb
+    float load;                 // estimate of the reading, F + offset
+    float innovation;           // last reading minus the prediction, lb
+    int primed;                 // 0 until the first reading
+} Kalman_Filter;
+
+//------------------Kalman_Design()---------------------------
+//Discretise the model and compute the steady state gain. The model can be
+//swapped into a running filter, its state carries on
+//Input: model, tick (s), acceleration noise q (lb/s^2), offset walk qo
+//       (lb/sqrt(s)), reading noise r (lb)
+//Output: 1 if the gain converged, 0 otherwise (the gain is the last one)
+int Kalman_Design(Kalman_Model *m, double dt, double q, double qo, double r);
+
+//------------------Kalman_Reset()---------------------------
+//Forget the state, the next reading primes it at the steady state of the
+//duty
+//Input: filter
+//Output: None
+void Kalman_Reset(Kalman_Filter *k);
+
+//------------------Kalman_Step()---------------------------
+//Run one tick
+//Input: filter, load cell reading (lb), signed duty applied since the last
+//       tick (percent)
+//Output: Estimate of the reading, lb
+float Kalman_Step(Kalman_Filter *k, float load, float duty);
+
+#endif /* KALMAN_H_ */
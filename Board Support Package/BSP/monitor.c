@@ -0,0 +1,111 @@
+// monitor.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Deadline monitor of a periodic interrupt handler, see monitor.h.
+
+#include <string.h>
+#include "monitor.h"
+
+//------------------overrun()---------------------------
+//Count n overruns and trip when the bucket is full
+static void overrun(Monitor_State *m, uint32_t n){
+    m->overruns += n;
+    m->bucket += n;
+    m->leakCount = 0;
+    if(m->bucket >= m->limit){
+        m->tripped = 1;
+    }
+}
+
+//------------------Monitor_Init()---------------------------
+//Clear the measurements and arm the monitor
+//Input: monitor, period in cycles, overruns to trip, ticks to lose one overrun
+//Output: None
+void Monitor_Init(Monitor_State *m, uint32_t period, uint32_t limit, uint32_t leak){
+    memset(m, 0, sizeof(*m));
+    m->period = period;
+    m->jitterMin = INT32_MAX;
+    m->jitterMax = INT32_MIN;
+    Monitor_SetLimit(m, limit, leak);
+    Monitor_Arm(m);
+}
+
+//------------------Monitor_Arm()---------------------------
+//Empty the bucket, clear a trip and start the releases from the next
+//entry, after the handler was stopped. The measurements are kept
+//Input: monitor
+//Output: None
+void Monitor_Arm(Monitor_State *m){
+    m->bucket = 0;
+    m->leakCount = 0;
+    m->tripped = 0;
+    m->armed = 1;
+}
+
+//------------------Monitor_SetLimit()---------------------------
+//Change the trip limit
+//Input: monitor, overruns to trip, ticks to lose one overrun
+//Output: None
+void Monitor_SetLimit(Monitor_State *m, uint32_t limit, uint32_t leak){
+    m->limit = limit ? limit : 1;
+    m->leak = leak ? leak : 1;
+}
+
+//------------------Monitor_Entry()---------------------------
+//Record the entry of a tick
+//Input: monitor, cycle count
+//Output: None
+void Monitor_Entry(Monitor_State *m, uint32_t now){
+    int32_t jitter, bin;
+    uint32_t late, skipped;
+
+    m->ticks++;
+    if(m->armed){
+        m->armed = 0;
+        m->entry = now;
+        m->release = now;
+        return;
+    }
+
+    jitter = (int32_t)(now - m->entry - m->period);
+    m->entry = now;
+    if(jitter < m->jitterMin){
+        m->jitterMin = jitter;
+    }
+    if(jitter > m->jitterMax){
+        m->jitterMax = jitter;
+    }
+    bin = jitter + ((MONITOR_BINS/2) << MONITOR_BIN_SHIFT);
+    bin = (bin < 0) ? 0 : (bin >> MONITOR_BIN_SHIFT);
+    m->histogram[(bin < MONITOR_BINS) ? bin : MONITOR_BINS - 1]++;
+
+    m->release += m->period;
+    late = now - m->release;
+    if((int32_t)late < 0){
+        // Earlier than any tick so far, move the phase of the releases
+        m->release = now;
+    }else if(late >= m->period){
+        // Releases without a tick
+        skipped = late/m->period;
+        m->release += skipped*m->period;
+        overrun(m, skipped);
+    }
+}
+
+//------------------Monitor_Exit()---------------------------
+//Record the exit of the tick
+//Input: monitor, cycle count
+//Output: 1 if the monitor is tripped
+int Monitor_Exit(Monitor_State *m, uint32_t now){
+    uint32_t exec = now - m->entry;
+
+    if(exec > m->execMax){
+        m->execMax = exec;
+    }
+    if(now - m->release > m->period){
+        overrun(m, 1);
+    }else if(m->bucket && ++m->leakCount >= m->leak){
+        m->leakCount = 0;
+        m->bucket--;
+    }
+    return m->tripped;
+}
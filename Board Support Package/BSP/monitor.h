@@ -0,0 +1,75 @@
+// monitor.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Deadline monitor of a periodic interrupt handler, the controller tick of
+// slug.c. The handler passes the cycle count (HAL_CycleCount) at its entry
+// and at its exit:
+//   - jitter: entry to entry time less the period, in a histogram of
+//     MONITOR_BINS bins of 2^MONITOR_BIN_SHIFT cycles centred on 0, the end
+//     bins are open
+//   - overrun: a tick that exits more than one period after its release, or
+//     a release that got no tick at all (the timer fired again before the
+//     tick ran). Releases are one period apart in the phase of the earliest
+//     entry seen
+// Overruns fill a leaky bucket that loses one overrun every leak ticks. When
+// it holds limit overruns the monitor trips and stays tripped until
+// Monitor_Arm(). Integer only, hardware independent.
+
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include <stdint.h>
+
+#define MONITOR_BINS            16
+#define MONITOR_BIN_SHIFT       6       // 64 cycles per bin, 0.8 us at 80MHz
+#define MONITOR_LIMIT           4       // default overruns in the bucket to trip
+#define MONITOR_LEAK_TIME       0.05    // s, default time for the bucket to lose one overrun
+
+typedef struct {
+    uint32_t period;            // cycles between releases
+    uint32_t limit;             // overruns in the bucket to trip
+    uint32_t leak;              // ticks for the bucket to lose one overrun
+    uint32_t ticks;             // ticks since Monitor_Init()
+    uint32_t overruns;          // since Monitor_Init()
+    uint32_t bucket;
+    uint32_t leakCount;
+    int32_t jitterMin, jitterMax;   // cycles, entry to entry less the period
+    uint32_t execMax;           // cycles from entry to exit
+    uint32_t histogram[MONITOR_BINS];
+    uint32_t entry;             // cycle count at the last entry
+    uint32_t release;           // release of the running tick
+    uint32_t armed;             // next entry starts the releases again
+    uint32_t tripped;
+} Monitor_State;
+
+//------------------Monitor_Init()---------------------------
+//Clear the measurements and arm the monitor
+//Input: monitor, period in cycles, overruns to trip, ticks to lose one overrun
+//Output: None
+void Monitor_Init(Monitor_State *m, uint32_t period, uint32_t limit, uint32_t leak);
+
+//------------------Monitor_Arm()---------------------------
+//Empty the bucket, clear a trip and start the releases from the next
+//entry, after the handler was stopped. The measurements are kept
+//Input: monitor
+//Output: None
+void Monitor_Arm(Monitor_State *m);
+
+//------------------Monitor_SetLimit()---------------------------
+//Change the trip limit
+//Input: monitor, overruns to trip, ticks to lose one overrun
+//Output: None
+void Monitor_SetLimit(Monitor_State *m, uint32_t limit, uint32_t leak);
+
+//------------------Monitor_Entry()---------------------------
+//Record the entry of a tick
+//Input: monitor, cycle count
+//Output: None
+void Monitor_Entry(Monitor_State *m, uint32_t now);
+
+//------------------Monitor_Exit()---------------------------
+//Record the exit of the tick
+//Input: monitor, cycle count
+//Output: 1 if the monitor is tripped
+int Monitor_Exit(Monitor_State *m, uint32_t now);
+
+#endif /* MONITOR_H_ */
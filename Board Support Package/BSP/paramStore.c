@@ -0,0 +1,274 @@
+// paramStore.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Persistent parameter store in the EEPROM, see paramStore.h.
+
+#include <string.h>
+#include "paramStore.h"
+#include "slug.h"
+#include "hal.h"
+#include "telemetry.h"
+
+#define PARAMSTORE_TYPE_MASK    ((1u << PARAMSTORE_TYPE_BITS) - 1)
+#define PARAMSTORE_WORDS        (PARAMSTORE_HEADER_WORDS + PARAMSTORE_RECORD_WORDS*PARAMSTORE_MAX_PARAMS)
+#define SCHEDULE_WORDS          (sizeof(GainSchedule_Table)/4)
+
+static ParamStore_Info info;
+static uint32_t eepromSize;                     // bytes, 0 when unusable
+static uint32_t numParams;                      // 0 until the build values are taken
+static uint32_t keys[PARAMSTORE_MAX_PARAMS];    // record key, 0 for a parameter not stored
+static double defaults[PARAMSTORE_MAX_PARAMS];  // build values
+static uint32_t image[PARAMSTORE_WORDS];        // header and records
+static uint32_t scheduleImage[2 + SCHEDULE_WORDS]; // magic, CRC and gain schedule
+static GainSchedule_Table table;                // off the 512 byte stack
+
+//------------------hashName()---------------------------
+//FNV-1a hash of a parameter name
+static uint32_t hashName(const char *name){
+    uint32_t h = 2166136261u;
+
+    while(*name){
+        h = (h ^ (uint8_t)*name++)*16777619u;
+    }
+    return h;
+}
+
+//------------------start()---------------------------
+//Take the build values and the record keys, and enable the EEPROM, once
+static void start(void){
+    uint32_t i, tag;
+
+    if(numParams){
+        return;
+    }
+    numParams = Param_Count();
+    if(numParams > PARAMSTORE_MAX_PARAMS){
+        numParams = PARAMSTORE_MAX_PARAMS;
+    }
+    for(i = 0; i < numParams; i++){
+        Param_Get(i, &defaults[i]);
+        switch(Param_GetType(i)){
+        case PARAM_REAL:
+            tag = PARAMSTORE_REAL;
+            break;
+        case PARAM_INT:
+        case PARAM_BOOT:
+            tag = PARAMSTORE_INT;
+            break;
+        default:
+            tag = 0;
+            break;
+        }
+        keys[i] = tag ? (hashName(Param_Name(i)) & ~PARAMSTORE_TYPE_MASK) | tag : 0;
+    }
+    eepromSize = HAL_EEPROMInit();
+    if(eepromSize < PARAMSTORE_SCHEDULE_BASE + 4*(2 + SCHEDULE_WORDS)){
+        eepromSize = 0;
+    }
+}
+
+//------------------finish()---------------------------
+//Record the result of an action
+static ParamStore_Status finish(ParamStore_Status status){
+    info.status = status;
+    return status;
+}
+
+//------------------crc()---------------------------
+//CRC of the saves count and n records, the image is in EEPROM byte order
+static uint32_t crc(uint32_t n){
+    return Telemetry_CRC16((const uint8_t *)&image[PARAMSTORE_HEADER_WORDS - 1], 4*(1 + PARAMSTORE_RECORD_WORDS*n));
+}
+
+//------------------scheduleCRC()---------------------------
+//CRC of the gain schedule words of the image
+static uint32_t scheduleCRC(void){
+    return Telemetry_CRC16((const uint8_t *)&scheduleImage[2], 4*SCHEDULE_WORDS);
+}
+
+//------------------loadSchedule()---------------------------
+//Set the gain schedule from the EEPROM
+//Output: 1 if set, 0 if missing, damaged or refused
+static int loadSchedule(void){
+    HAL_EEPROMRead(PARAMSTORE_SCHEDULE_BASE, scheduleImage, 2 + SCHEDULE_WORDS);
+    if(scheduleImage[0] != PARAMSTORE_SCHEDULE_MAGIC || (scheduleImage[1] & 0xFFFF) != scheduleCRC()){
+        return 0;
+    }
+    memcpy(&table, &scheduleImage[2], sizeof(table));
+    return Scheduled_SetTable(&table);
+}
+
+//------------------saveSchedule()---------------------------
+//Write the gain schedule in use to the EEPROM, the magic word last
+//Output: 1 if written, 0 if a write failed
+static int saveSchedule(void){
+    uint32_t state;
+
+    state = HAL_EnterCritical(); // one consistent table
+    memcpy(&scheduleImage[2], Scheduled_GetTable(), sizeof(table));
+    HAL_ExitCritical(state);
+    scheduleImage[0] = PARAMSTORE_SCHEDULE_MAGIC;
+    scheduleImage[1] = scheduleCRC();
+    return HAL_EEPROMProgram(PARAMSTORE_SCHEDULE_BASE + 4, &scheduleImage[1], 1 + SCHEDULE_WORDS) &&
+           HAL_EEPROMProgram(PARAMSTORE_SCHEDULE_BASE, scheduleImage, 1);
+}
+
+//------------------loadRecord()---------------------------
+//Set the parameter of one record
+//Output: 1 if set, 0 if unknown, of another type or out of range
+static int loadRecord(const uint32_t *record){
+    uint32_t i;
+    double real;
+
+    for(i = 0; i < numParams; i++){
+        if(keys[i] == record[0]){
+            if((record[0] & PARAMSTORE_TYPE_MASK) == PARAMSTORE_REAL){
+                memcpy(&real, &record[1], sizeof(real));
+                return Param_Set(i, real);
+            }
+            return Param_Set(i, (int32_t)record[1]);
+        }
+    }
+    return 0;
+}
+
+//------------------ParamStore_Load()---------------------------
+//Load the parameters from the EEPROM. The first call also takes the build
+//values, call it before anything sets a parameter
+//Input: None
+//Output: PARAMSTORE_LOADED, or why the build values were kept
+ParamStore_Status ParamStore_Load(void){
+    uint32_t n, i;
+
+    start();
+    info.loaded = 0;
+    info.skipped = 0;
+    info.schedule = 0;
+    if(!eepromSize){
+        return finish(PARAMSTORE_FAILED);
+    }
+    HAL_EEPROMRead(PARAMSTORE_BASE, image, PARAMSTORE_HEADER_WORDS);
+    if(image[0] != PARAMSTORE_MAGIC){
+        return finish(PARAMSTORE_BLANK);
+    }
+    if((image[1] & 0xFFFF) != PARAMSTORE_VERSION){
+        return finish(PARAMSTORE_BAD_VERSION);
+    }
+    n = image[1] >> 16;
+    if(n > PARAMSTORE_MAX_PARAMS){
+        return finish(PARAMSTORE_BAD_CRC);
+    }
+    HAL_EEPROMRead(PARAMSTORE_BASE + 4*PARAMSTORE_HEADER_WORDS, &image[PARAMSTORE_HEADER_WORDS], PARAMSTORE_RECORD_WORDS*n);
+    if(crc(n) != (image[2] & 0xFFFF)){
+        return finish(PARAMSTORE_BAD_CRC);
+    }
+    info.saves = image[3];
+    for(i = 0; i < n; i++){
+        if(loadRecord(&image[PARAMSTORE_HEADER_WORDS + PARAMSTORE_RECORD_WORDS*i])){
+            info.loaded++;
+        }else{
+            info.skipped++;
+        }
+    }
+    info.schedule = loadSchedule();
+    return finish(PARAMSTORE_LOADED);
+}
+
+//------------------ParamStore_Save()---------------------------
+//Write the parameters to the EEPROM, tens of milliseconds. Call from the
+//background loop, the interrupts keep running
+//Input: None
+//Output: PARAMSTORE_SAVED or PARAMSTORE_FAILED
+ParamStore_Status ParamStore_Save(void){
+    uint32_t *record = &image[PARAMSTORE_HEADER_WORDS];
+    uint32_t n = 0, i;
+    double value;
+    int32_t whole;
+
+    start();
+    info.loaded = 0;
+    info.skipped = 0;
+    info.schedule = 0;
+    if(!eepromSize){
+        return finish(PARAMSTORE_FAILED);
+    }
+    for(i = 0; i < numParams; i++){
+        if(!keys[i] || !Param_Get(i, &value)){
+            continue;
+        }
+        record[0] = keys[i];
+        if((keys[i] & PARAMSTORE_TYPE_MASK) == PARAMSTORE_REAL){
+            memcpy(&record[1], &value, sizeof(value));
+        }else{
+            whole = (int32_t)value;
+            record[1] = (uint32_t)whole;
+            record[2] = 0;
+        }
+        record += PARAMSTORE_RECORD_WORDS;
+        n++;
+    }
+    image[0] = PARAMSTORE_MAGIC;
+    image[1] = PARAMSTORE_VERSION | n << 16;
+    image[3] = info.saves + 1;
+    image[2] = crc(n);
+
+    // Records and saves count first, the header that makes them valid last
+    if(!saveSchedule() ||
+       !HAL_EEPROMProgram(PARAMSTORE_BASE + 4*(PARAMSTORE_HEADER_WORDS - 1), &image[PARAMSTORE_HEADER_WORDS - 1], 1 + PARAMSTORE_RECORD_WORDS*n) ||
+       !HAL_EEPROMProgram(PARAMSTORE_BASE, image, PARAMSTORE_HEADER_WORDS - 1)){
+        return finish(PARAMSTORE_FAILED);
+    }
+    info.saves++;
+    info.loaded = n;
+    info.schedule = 1;
+    return finish(PARAMSTORE_SAVED);
+}
+
+//------------------ParamStore_Defaults()---------------------------
+//Set the parameters back to their build values, the store is kept. The boot
+//parameters take effect at the next reset
+//Input: None
+//Output: PARAMSTORE_DEFAULTS
+ParamStore_Status ParamStore_Defaults(void){
+    uint32_t i;
+
+    start();
+    info.loaded = 0;
+    info.skipped = 0;
+    for(i = 0; i < numParams; i++){
+        if(keys[i]){
+            Param_Set(i, defaults[i]);
+        }
+    }
+    GainSchedule_Default(&table);
+    info.schedule = Scheduled_SetTable(&table);
+    return finish(PARAMSTORE_DEFAULTS);
+}
+
+//------------------ParamStore_Erase()---------------------------
+//Erase the store, the next reset boots on the build values. The parameters
+//in RAM are kept
+//Input: None
+//Output: PARAMSTORE_ERASED or PARAMSTORE_FAILED
+ParamStore_Status ParamStore_Erase(void){
+    uint32_t header[PARAMSTORE_HEADER_WORDS];
+
+    start();
+    info.loaded = 0;
+    info.skipped = 0;
+    info.schedule = 0;
+    memset(header, 0xFF, sizeof(header));
+    if(!eepromSize || !HAL_EEPROMProgram(PARAMSTORE_BASE, header, PARAMSTORE_HEADER_WORDS) ||
+       !HAL_EEPROMProgram(PARAMSTORE_SCHEDULE_BASE, header, 1)){
+        return finish(PARAMSTORE_FAILED);
+    }
+    info.saves = 0;
+    return finish(PARAMSTORE_ERASED);
+}
+
+//------------------ParamStore_Get()---------------------------
+//Get the result of the last action
+//Input: None
+//Output: Store state
+const ParamStore_Info *ParamStore_Get(void){
+    return &info;
+}
@@ -0,0 +1,112 @@
+// paramStore.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Persistent store of the named parameters of slug.c (Param_Count() and the
+// rest) in the on-chip EEPROM. Every parameter but the PARAM_COMMAND ones is
+// saved as a record keyed by its name and type, so a store outlives
+// parameters added, removed or moved in the table. Layout, 32 bit words at
+// PARAMSTORE_BASE:
+//   word  contents
+//   0     PARAMSTORE_MAGIC
+//   1     layout version (low 16 bits), number of records n (high 16 bits)
+//   2     CRC-16/CCITT-FALSE of words 3 to 2+3n (Telemetry_CRC16), low 16 bits
+//   3     saves made so far
+//   4+3i  key: FNV-1a hash of the name, type in the low PARAMSTORE_TYPE_BITS
+//   5+3i  value: float64 (PARAMSTORE_REAL, two words) or int32 (PARAMSTORE_INT,
+//         the second word 0)
+// A real is kept at the precision it has in RAM, so a value at a limit of
+// its range loads back at that limit.
+// ParamStore_Load() runs once in the start up sequence, before the
+// peripherals and the controller: the records go through Param_Set(), so a
+// value out of range is refused as from the host and the hooks load the
+// control laws. From there on the parameters live in RAM, the control path
+// never reads the EEPROM. A blank EEPROM, another layout version or a bad CRC
+// leaves every parameter at its build value; a record of an unknown name or
+// of a changed type is skipped, a parameter without a record keeps its build
+// value. Raise PARAMSTORE_VERSION when the units or the encoding of the
+// records change, old stores then boot on the build values.
+// Saving only happens on request (COMMAND_STORE), in the background loop.
+// The header is written last, so a save cut short reads as a bad CRC.
+// The gain schedule of CONTROLLER_SCHEDULED (Scheduled_GetTable()) is kept
+// next to the records, at PARAMSTORE_SCHEDULE_BASE, and goes with them on
+// every action (ParamStore_Defaults() sets GainSchedule_Default()):
+//   word  contents
+//   0     PARAMSTORE_SCHEDULE_MAGIC
+//   1     CRC-16/CCITT-FALSE of the table words, low 16 bits
+//   2     GainSchedule_Table as it is in RAM, 32 bit words
+// A missing or damaged table, or one GainSchedule_Check() refuses, leaves the
+// schedule in use as it is.
+// The host build keeps the EEPROM in memory or in a file
+// (HAL_SimSetEEPROMFile()).
+
+#ifndef PARAMSTORE_H_
+#define PARAMSTORE_H_
+
+#include <stdint.h>
+
+#define PARAMSTORE_MAGIC        0x47554C53  // "SLUG" in EEPROM byte order
+#define PARAMSTORE_VERSION      2           // 1 kept reals as float32
+#define PARAMSTORE_BASE         0           // byte address in the EEPROM
+#define PARAMSTORE_HEADER_WORDS 4
+#define PARAMSTORE_RECORD_WORDS 3
+#define PARAMSTORE_MAX_PARAMS   96          // parameters past this are not stored
+#define PARAMSTORE_TYPE_BITS    4
+#define PARAMSTORE_REAL         1           // record types
+#define PARAMSTORE_INT          2
+#define PARAMSTORE_SCHEDULE_MAGIC 0x44454853  // "SHED" in EEPROM byte order
+#define PARAMSTORE_SCHEDULE_BASE (PARAMSTORE_BASE + 4*(PARAMSTORE_HEADER_WORDS + PARAMSTORE_RECORD_WORDS*PARAMSTORE_MAX_PARAMS))
+
+typedef enum {
+    PARAMSTORE_NONE = 0,        // nothing done yet
+    PARAMSTORE_LOADED,          // records loaded from the EEPROM
+    PARAMSTORE_SAVED,           // parameters written to the EEPROM
+    PARAMSTORE_DEFAULTS,        // parameters back to the build values
+    PARAMSTORE_ERASED,          // store erased
+    PARAMSTORE_BLANK,           // no store found, build values kept
+    PARAMSTORE_BAD_VERSION,     // store of another layout, build values kept
+    PARAMSTORE_BAD_CRC,         // store damaged, build values kept
+    PARAMSTORE_FAILED           // EEPROM unusable or a write failed
+} ParamStore_Status;
+
+typedef struct {
+    ParamStore_Status status;   // of the last action
+    uint32_t loaded;            // records loaded or saved by it
+    uint32_t skipped;           // records not loaded: unknown, changed type or out of range
+    uint32_t saves;             // saves made to the store
+    uint32_t schedule;          // 1 if the gain schedule was loaded, saved or set back by it
+} ParamStore_Info;
+
+//------------------ParamStore_Load()---------------------------
+//Load the parameters from the EEPROM. The first call also takes the build
+//values, call it before anything sets a parameter
+//Input: None
+//Output: PARAMSTORE_LOADED, or why the build values were kept
+ParamStore_Status ParamStore_Load(void);
+
+//------------------ParamStore_Save()---------------------------
+//Write the parameters to the EEPROM, tens of milliseconds. Call from the
+//background loop, the interrupts keep running
+//Input: None
+//Output: PARAMSTORE_SAVED or PARAMSTORE_FAILED
+ParamStore_Status ParamStore_Save(void);
+
+//------------------ParamStore_Defaults()---------------------------
+//Set the parameters back to their build values, the store is kept. The boot
+//parameters take effect at the next reset
+//Input: None
+//Output: PARAMSTORE_DEFAULTS
+ParamStore_Status ParamStore_Defaults(void);
+
+//------------------ParamStore_Erase()---------------------------
+//Erase the store, the next reset boots on the build values. The parameters
+//in RAM are kept
+//Input: None
+//Output: PARAMSTORE_ERASED or PARAMSTORE_FAILED
+ParamStore_Status ParamStore_Erase(void);
+
+//------------------ParamStore_Get()---------------------------
+//Get the result of the last action
+//Input: None
+//Output: Store state
+const ParamStore_Info *ParamStore_Get(void);
+
+#endif /* PARAMSTORE_H_ */
@@ -0,0 +1,212 @@
+// profile.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Interrupt handler profiling, see profile.h. Empty unless SLUG_PROFILE is 1.
+
+#include "profile.h"
+
+#if SLUG_PROFILE
+
+#include <string.h>
+
+Profile_Stats profileStats[NUM_PROFILES];
+static uint32_t overhead;       // cycles between two back to back counter reads
+
+static const char *const profileName[NUM_PROFILES] = {
+    "Controller",
+    "LoadCell",
+    "Sensors",
+    "Logger",
+    "UART",
+};
+
+//------------------bin()---------------------------
+//Histogram bin of a latency, the number of significant bits
+static uint32_t bin(uint32_t cycles){
+    uint32_t b = 0;
+    while(cycles && b < PROFILE_BINS - 1){
+        cycles >>= 1;
+        b++;
+    }
+    return b;
+}
+
+//------------------clear()---------------------------
+//Clear the measurements of one handler
+static void clear(Profile_Stats *p){
+    p->count = 0;
+    p->min = 0xFFFFFFFF;
+    p->max = 0;
+    p->total = 0;
+    p->latencyMax = 0;
+    memset(p->histogram, 0, sizeof(p->histogram));
+    p->missed = 0;
+}
+
+//------------------Profile_Init()---------------------------
+//Start the cycle counter, measure its read cost and clear every profile
+//Input: None
+//Output: None
+void Profile_Init(void){
+    uint32_t start;
+
+    HAL_CycleCounterInit();
+    start = HAL_CycleCount();
+    overhead = HAL_CycleCount() - start;
+    memset(profileStats, 0, sizeof(profileStats));
+    Profile_Reset();
+}
+
+//------------------Profile_SetPeriod()---------------------------
+//Profile a handler as periodic, the deadline is the period
+//Input: Handler, period in clock cycles (0 for aperiodic)
+//Output: None
+void Profile_SetPeriod(Profile_Id id, uint32_t period){
+    uint32_t state;
+
+    if((uint32_t)id >= NUM_PROFILES){
+        return;
+    }
+    state = HAL_EnterCritical();
+    profileStats[id].period = period;
+    profileStats[id].deadline = period;
+    clear(&profileStats[id]); // releases start again from the next entry
+    HAL_ExitCritical(state);
+}
+
+//------------------Profile_SetDeadline()---------------------------
+//Set the deadline of a periodic handler
+//Input: Handler, cycles from release to exit
+//Output: None
+void Profile_SetDeadline(Profile_Id id, uint32_t deadline){
+    if((uint32_t)id >= NUM_PROFILES){
+        return;
+    }
+    profileStats[id].deadline = deadline;
+}
+
+//------------------Profile_Reset()---------------------------
+//Clear the measurements, keep the periods and deadlines
+//Input: None
+//Output: None
+void Profile_Reset(void){
+    Profile_Stats *p;
+    uint32_t state = HAL_EnterCritical();
+
+    for(p = profileStats; p < profileStats + NUM_PROFILES; p++){
+        clear(p);
+    }
+    HAL_ExitCritical(state);
+}
+
+//------------------Profile_Exit()---------------------------
+//Record one activation, called by PROFILE_EXIT at the end of the handler
+//Input: Handler
+//Output: None
+void Profile_Exit(Profile_Id id){
+    uint32_t now = HAL_CycleCount();
+    Profile_Stats *p = &profileStats[id];
+    uint32_t cycles = now - p->start;
+    uint32_t latency, skipped;
+
+    cycles = (cycles > overhead) ? cycles - overhead : 0;
+    if(cycles < p->min){
+        p->min = cycles;
+    }
+    if(cycles > p->max){
+        p->max = cycles;
+    }
+    p->total += cycles;
+
+    if(p->period){
+        if(p->count == 0){
+            p->release = p->start;
+        }
+        latency = p->start - p->release;
+        if((int32_t)latency < 0){
+            // Earlier than any entry so far, move the phase of the releases
+            p->release = p->start;
+            latency = 0;
+        }else if(latency >= p->period){
+            // Releases without an entry, the timer fired again before this one ran
+            skipped = latency/p->period;
+            p->missed += skipped;
+            p->release += skipped*p->period;
+            latency -= skipped*p->period;
+        }
+        if(latency > p->latencyMax){
+            p->latencyMax = latency;
+        }
+        p->histogram[bin(latency)]++;
+        if(now - p->release > p->deadline){
+            p->missed++;
+        }
+        p->release += p->period;
+    }
+    p->count++;
+}
+
+//------------------Profile_Get()---------------------------
+//Get the measurements of a handler
+//Input: Handler
+//Output: Measurements, 0 for an unknown handler
+const Profile_Stats *Profile_Get(Profile_Id id){
+    if((uint32_t)id >= NUM_PROFILES){
+        return 0;
+    }
+    return &profileStats[id];
+}
+
+//------------------Profile_Mean()---------------------------
+//Get the mean cycles from entry to exit
+//Input: Handler
+//Output: Mean cycles, 0 before the first activation
+uint32_t Profile_Mean(Profile_Id id){
+    uint64_t total;
+    uint32_t count, state;
+
+    if((uint32_t)id >= NUM_PROFILES){
+        return 0;
+    }
+    state = HAL_EnterCritical(); // total is two words
+    total = profileStats[id].total;
+    count = profileStats[id].count;
+    HAL_ExitCritical(state);
+    return count ? (uint32_t)(total/count) : 0;
+}
+
+//------------------Profile_Name()---------------------------
+//Get the name of a handler
+//Input: Handler
+//Output: Name, 0 for an unknown handler
+const char *Profile_Name(Profile_Id id){
+    if((uint32_t)id >= NUM_PROFILES){
+        return 0;
+    }
+    return profileName[id];
+}
+
+//------------------Profile_Print()---------------------------
+//Print every profile on the console (UARTprintf), in cycles
+//Input: None
+//Output: None
+void Profile_Print(void){
+    const Profile_Stats *p;
+    uint32_t id, b;
+
+    UARTprintf("handler, count, min, mean, max, period, latency max, missed\n");
+    for(id = 0; id < NUM_PROFILES; id++){
+        p = &profileStats[id];
+        UARTprintf("%s, %u, %u, %u, %u, %u, %u, %u\n", profileName[id], p->count,
+                   p->count ? p->min : 0, Profile_Mean((Profile_Id)id), p->max,
+                   p->period, p->latencyMax, p->missed);
+        if(p->period){
+            UARTprintf("  latency bins");
+            for(b = 0; b < PROFILE_BINS; b++){
+                UARTprintf(" %u", p->histogram[b]);
+            }
+            UARTprintf("\n");
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,130 @@
+// profile.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Interrupt handler profiling with the Cortex-M4 DWT cycle counter
+// (HAL_CycleCount). Each profiled handler brackets its body with
+// PROFILE_ENTER(id) and PROFILE_EXIT(id), which records:
+//   - the cycles from entry to exit: minimum, maximum and mean. The cost of
+//     the two counter reads is measured at Profile_Init() and taken off
+//   - for a periodic handler (Profile_SetPeriod), the latency of each entry
+//     after its release, in a histogram of PROFILE_BINS power of 2 bins.
+//     Releases are one period apart, in the phase of the earliest entry seen,
+//     so the latency is the jitter on top of the fixed entry latency of the
+//     core (12 cycles)
+//   - missed deadlines: an activation that ends more than its deadline after
+//     its release (the period unless set), or a release without an entry
+// Read the results with Profile_Get() or the PROFILE command (command.h), or
+// print them with Profile_Print().
+// Everything compiles out unless SLUG_PROFILE is pre-defined to 1 in the
+// project settings: the macros expand to nothing, the calls below to no-ops
+// and profile.c to an empty unit.
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+
+#ifndef SLUG_PROFILE
+#define SLUG_PROFILE 0
+#endif
+
+#define PROFILE_BINS        16      // bin 0 is 0 cycles, bin b is 2^(b-1) to 2^b - 1, the last bin is open
+
+// Profiled interrupt handlers of slug.c
+typedef enum {
+    PROFILE_CONTROLLER,         // ControllerIntHandler
+    PROFILE_LOADCELL,           // LoadCellIntHandler or LoadCellBlockIntHandler
+    PROFILE_SENSORS,            // SensorsIntHandler
+    PROFILE_LOGGER,             // LoggerIntHandler
+    PROFILE_UART,               // UARTIntHandler
+    NUM_PROFILES
+} Profile_Id;
+
+typedef struct {
+    uint32_t count;             // activations
+    uint32_t min, max;          // cycles from entry to exit
+    uint64_t total;
+    uint32_t period;            // cycles between releases, 0 for an aperiodic handler
+    uint32_t deadline;          // cycles from release to exit
+    uint32_t latencyMax;        // cycles from release to entry
+    uint32_t histogram[PROFILE_BINS];
+    uint32_t missed;            // missed deadlines
+    uint32_t start;             // cycle count at the last entry
+    uint32_t release;           // release of the running activation
+} Profile_Stats;
+
+#if SLUG_PROFILE
+
+extern Profile_Stats profileStats[NUM_PROFILES];
+
+#include "hal.h"
+
+#define PROFILE_ENTER(id)   (profileStats[id].start = HAL_CycleCount())
+#define PROFILE_EXIT(id)    Profile_Exit(id)
+
+//------------------Profile_Init()---------------------------
+//Start the cycle counter, measure its read cost and clear every profile
+//Input: None
+//Output: None
+void Profile_Init(void);
+
+//------------------Profile_SetPeriod()---------------------------
+//Profile a handler as periodic, the deadline is the period
+//Input: Handler, period in clock cycles (0 for aperiodic)
+//Output: None
+void Profile_SetPeriod(Profile_Id id, uint32_t period);
+
+//------------------Profile_SetDeadline()---------------------------
+//Set the deadline of a periodic handler
+//Input: Handler, cycles from release to exit
+//Output: None
+void Profile_SetDeadline(Profile_Id id, uint32_t deadline);
+
+//------------------Profile_Reset()---------------------------
+//Clear the measurements, keep the periods and deadlines
+//Input: None
+//Output: None
+void Profile_Reset(void);
+
+//------------------Profile_Exit()---------------------------
+//Record one activation, called by PROFILE_EXIT at the end of the handler
+//Input: Handler
+//Output: None
+void Profile_Exit(Profile_Id id);
+
+//------------------Profile_Get()---------------------------
+//Get the measurements of a handler
+//Input: Handler
+//Output: Measurements, 0 for an unknown handler
+const Profile_Stats *Profile_Get(Profile_Id id);
+
+//------------------Profile_Mean()---------------------------
+//Get the mean cycles from entry to exit
+//Input: Handler
+//Output: Mean cycles, 0 before the first activation
+uint32_t Profile_Mean(Profile_Id id);
+
+//------------------Profile_Name()---------------------------
+//Get the name of a handler
+//Input: Handler
+//Output: Name, 0 for an unknown handler
+const char *Profile_Name(Profile_Id id);
+
+//------------------Profile_Print()---------------------------
+//Print every profile on the console (UARTprintf), in cycles
+//Input: None
+//Output: None
+void Profile_Print(void);
+
+#else
+
+#define PROFILE_ENTER(id)
+#define PROFILE_EXIT(id)
+#define Profile_Init()                  ((void)0)
+#define Profile_SetPeriod(id, period)   ((void)0)
+#define Profile_SetDeadline(id, cycles) ((void)0)
+#define Profile_Reset()                 ((void)0)
+#define Profile_Print()                 ((void)0)
+
+#endif
+
+#endif /* PROFILE_H_ */
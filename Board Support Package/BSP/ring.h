@@ -0,0 +1,108 @@
+// ring.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Single producer, single consumer ring buffer, header only.
+// RING_DEFINE(Name, Type, Size) declares the ring type Name holding Size
+// items of Type (Size a power of 2) and its functions Name_Init, Name_Push,
+// Name_Pop, ... Only the producer writes head and only the consumer writes
+// tail, so neither side ever waits or locks: an ISR may be the producer
+// and the background loop the consumer, or the other way round, or two ISRs.
+// head and tail run freely and wrap at 2^32, head - tail is the fill level.
+//
+// Zero copy use:
+//   producer: slot = Name_Claim(&r); if(slot){ fill *slot; Name_Publish(&r); }
+//   consumer: item = Name_Peek(&r);  if(item){ read *item; Name_Release(&r); }
+// The barriers order the slot accesses against the index updates, on the
+// Cortex-M4 a DMB, on the host a full fence for threads on other cores.
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__TI_COMPILER_VERSION__)
+#define RING_BARRIER()  __asm(" dmb")
+#else
+#define RING_BARRIER()  __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+#define RING_DEFINE(Name, Type, Size)                                               \
+typedef struct {                                                                    \
+    volatile uint32_t head;         /* next slot to write, producer only */         \
+    volatile uint32_t tail;         /* next slot to read, consumer only */          \
+    Type slot[Size];                                                                \
+} Name;                                                                             \
+                                                                                    \
+typedef char Name##_SizeIsPowerOf2[((Size) > 0 && ((Size) & ((Size) - 1)) == 0) ? 1 : -1]; \
+                                                                                    \
+/* Empty the ring, only while neither side runs */                                  \
+static inline void Name##_Init(Name *r){                                            \
+    r->head = 0;                                                                    \
+    r->tail = 0;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Producer: free slot to fill, 0 when full */                                      \
+static inline Type *Name##_Claim(Name *r){                                          \
+    uint32_t h = r->head;                                                           \
+    if(h - r->tail >= (Size)){                                                      \
+        return 0;                                                                   \
+    }                                                                               \
+    RING_BARRIER(); /* the consumer is done with the slot */                        \
+    return &r->slot[h & ((Size) - 1)];                                              \
+}                                                                                   \
+                                                                                    \
+/* Producer: hand the claimed slot to the consumer */                               \
+static inline void Name##_Publish(Name *r){                                         \
+    RING_BARRIER(); /* slot written before head moves */                            \
+    r->head = r->head + 1;                                                          \
+}                                                                                   \
+                                                                                    \
+/* Consumer: oldest item, 0 when empty */                                           \
+static inline const Type *Name##_Peek(Name *r){                                     \
+    uint32_t t = r->tail;                                                           \
+    if(r->head == t){                                                               \
+        return 0;                                                                   \
+    }                                                                               \
+    RING_BARRIER(); /* slot read after head */                                      \
+    return &r->slot[t & ((Size) - 1)];                                              \
+}                                                                                   \
+                                                                                    \
+/* Consumer: give the peeked slot back to the producer */                           \
+static inline void Name##_Release(Name *r){                                         \
+    RING_BARRIER(); /* slot read before tail moves */                               \
+    r->tail = r->tail + 1;                                                          \
+}                                                                                   \
+                                                                                    \
+/* Producer: copy one item in, false when full */                                   \
+static inline bool Name##_Push(Name *r, const Type *item){                          \
+    Type *s = Name##_Claim(r);                                                      \
+    if(!s){                                                                         \
+        return false;                                                               \
+    }                                                                               \
+    *s = *item;                                                                     \
+    Name##_Publish(r);                                                              \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Consumer: copy the oldest item out, false when empty */                          \
+static inline bool Name##_Pop(Name *r, Type *item){                                 \
+    const Type *s = Name##_Peek(r);                                                 \
+    if(!s){                                                                         \
+        return false;                                                               \
+    }                                                                               \
+    *item = *s;                                                                     \
+    Name##_Release(r);                                                              \
+    return true;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Consumer: drop everything queued */                                              \
+static inline void Name##_Flush(Name *r){                                           \
+    r->tail = r->head;                                                              \
+}                                                                                   \
+                                                                                    \
+/* Either side: items queued, the other side may change it right after */          \
+static inline uint32_t Name##_Count(const Name *r){                                 \
+    return r->head - r->tail;                                                       \
+}
+
+#endif /* RING_H_ */
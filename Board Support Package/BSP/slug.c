@@ -83,7 +83,28 @@
 // PB6, PF4, PE1
 
 
+#include <string.h>
+
 #include "slug.h"
+#include "forceControl.h"
+#include "telemetry.h"
+#include "uartTx.h"
+#include "decimator.h"
+#include "ring.h"
+#include "encoder.h"
+#include "gainSchedule.h"
+#include "ident.h"
+#include "autotune.h"
+#include "kalman.h"
+#include "calib.h"
+#include "command.h"
+#include "profile.h"
+#include "paramStore.h"
+
+#if TELEMETRY_BLOCK_SAMPLES != DECIMATOR_RATE
+#error "raw telemetry blocks must hold one decimator block"
+#endif
+
 // ***************************** Constants ****************************
 // ------------------------ Pin defines -------------------------------
 #define BLUE_LED PD7
@@ -93,24 +114,56 @@
 const int clockFreq = 80000000; //80MHz
 const int PWMclockFreq = clockFreq/2; //40MHz
 
-// Error
-const double MinSteadyError = 0;
-const double MaxSteadyError = 100;
+// Error, clamp of the PID integral in lb ticks (steady_min, steady_max)
+double MinSteadyError = 0;
+double MaxSteadyError = 100;
 
 // Controller
 const double DEADBAND = 0.01;
 const int BIAS = 5; //5% duty bias
 
+// Sensors
+#define SENSORS_SEQUENCE 0 // ADC0 sequencer with 8 steps, highest priority
+#define COUNTS_TO_VOLTS (3.3f/4095.0f)
+#define THERMOCOUPLE_VOLTS_PER_C 0.005f // amplifier output, AD8495 type
+#define SENSORS_QUEUE_SIZE 16 // snapshots, power of 2, at least sample rate/controller rate
+
+// Encoder
+#define ENCODER_DEFAULT_FREQ 2000 // estimator rate before Controller_Init()
+
 
 // ****** Variables ******
-uint16_t samplePeriod; //For load cell sampling period calculation
+uint32_t samplePeriod; //For load cell sampling period calculation, clock cycles
 uint32_t rawTemp[1];
 uint32_t loadCellValue[1];
+static uint16_t loadCellBlock[2][DECIMATOR_RATE]; // uDMA ping-pong buffers
+static Decimator loadCellDecimator;
+volatile int32_t loadCellFine; // decimated load cell, ADC counts*2^DECIMATOR_FRAC_BITS
+static volatile uint32_t chipTempValue; // chip temperature of the last snapshot, ADC counts
+volatile uint32_t loadCellBlocks = 0; // blocks filtered since LoadCell_initBlock()
+volatile int loadCellBlockMode = 0;
+static int32_t loadCellPendingFine; // last block, published with the next snapshot
 uint32_t ADCValue[1];
+static Sensors_Snapshot sensorsBuffer[2]; // published one is sensorsCount & 1
+static volatile uint32_t sensorsCount = 0;
+RING_DEFINE(SensorsQueue, Sensors_Snapshot, SENSORS_QUEUE_SIZE)
+static SensorsQueue sensorsQueue; // sensor ISR to controller ISR
+static volatile uint32_t sensorsDropped = 0;
+
+// Sensor channels, indexed by Sensor_Id, converted in this order
+static const Sensor_Channel sensorTable[NUM_SENSORS] = {
+//   name       units  channel                gain                                       offset
+    {"load",    "lb",  HAL_ADC_LOADCELL,      COUNTS_TO_VOLTS*25.0f,                     0},
+    {"current", "V",   HAL_ADC_CURRENT,       COUNTS_TO_VOLTS,                           0},
+    {"thermo",  "C",   HAL_ADC_THERMOCOUPLE,  COUNTS_TO_VOLTS/THERMOCOUPLE_VOLTS_PER_C,  0},
+    {"aux",     "V",   HAL_ADC_ADDITIONAL,    COUNTS_TO_VOLTS,                           0},
+    {"chip",    "C",   HAL_ADC_TEMPSENSOR,    -247.5f/4096.0f,                           147.5f},
+};
 
 volatile uint32_t goalReached; //flag
 
 double pwmPeriod; // Variables for motor control
+uint32_t pwmPeriodCounts; // pwmPeriod as an integer for the controller path
 volatile double pwmDuty;
 
 uint32_t swingloopCount = 0; // variables in swing control
@@ -118,20 +171,27 @@ int swingDir = 1; //motor direction in swing behavior
 int swingDuty = 2; // duty cycle in swing behavior
 
 uint32_t loggerCount = 0; //Logger timing count
+volatile uint32_t telemetryEnabled = 0; //Binary telemetry from the controller ISR
+static int consoleDMA = 0; //UART0 transmit goes through uartTx.c, Logger_InitTelemetry()
+static uint32_t repliesDropped = 0; // command replies that did not fit the transmitter
+static HAL_Handler commandNotify = 0; //SerialMonitor_SetNotify()
+static SerialMonitor_Extension commandExtension = 0; //SerialMonitor_SetExtension()
 
 // ******* PID Control *********************
+// Control laws run in the format selected by FC_NUMERIC (forceControl.h)
 double goalPos;
-volatile double ERROR;
-volatile double LAST_ERROR = 0;
-volatile double TOTAL_ERROR = 0;
-volatile double PID_OUT;
-volatile double P, D, I;
-
-//PID VALUES
-volatile double Kp; //P from PID 20
-volatile double Kbar = .04; //P from PID 0.1
-volatile double Ki = 0.008; //.01; //I from PID 1
-volatile double Kd = 0.0; //D from PID
+volatile fc_num_t ERROR;
+volatile fc_num_t PID_OUT;
+FC_PID pidState;
+
+//PID VALUES, loaded into pidState by Controller_Init()
+#define PID_GAIN_MAX 10 // parameter limit of Kbar, Ki and Kd
+#if PID_GAIN_MAX >= FC_GAIN_LIMIT
+#error "the fixed point PID gains are Q8.24"
+#endif
+double Kbar = .04; //P from PID 0.1
+double Ki = 0.008; //.01; //I from PID 1
+double Kd = 0.0; //D from PID
 
 // *********Globals******************************
 uint32_t globalDutyCycle = 0;
@@ -142,20 +202,211 @@ uint32_t globalControllerTick;
 volatile double globalControllerPeriod;
 
 // ******* MRAC Control *********************
-volatile double theta_x, theta_r;
-volatile double theta_x_final, theta_r_final;
-volatile double theta_x_prev = 0;
-volatile double theta_r_prev = 0;
-volatile double MRAC_OUT = 0;
-
-volatile double ref_sys, time, delta_t, x_ref, x;
-
-// GAins
-volatile double gamma_x = 0.01; //0.1
-volatile double gamma_r = 0.001; //0.01
+volatile fc_num_t MRAC_OUT = 0;
+FC_MRAC mracState;
+
+// GAins, loaded into mracState by Controller_Init()
+double gamma_x = 0.0002; //integrated MIT rule, tuned on Host Tools/seaSim
+double gamma_r = 0.002;
+
+// ******* Cascade Control *********************
+// Position loop -> velocity loop -> force loop. The force loop runs every
+// controller tick, the velocity and position loops every CASCADE_VELOCITY_DIV
+// and CASCADE_POSITION_DIV ticks. The force loop is a linear PI: the PID law
+// has no proportional term below 1 lb of error (Kp = Kbar*abs(error)), which
+// is the range the joint moves in. Float, so all three run on the FPU
+// whatever FC_NUMERIC is
+#define CASCADE_VELOCITY_DIV 4 // 500 Hz at 2 kHz
+#define CASCADE_POSITION_DIV 20 // 100 Hz at 2 kHz
+#define CASCADE_VELOCITY_MAX 2000.0f // counts/s, velocity goal limit
+#define CASCADE_FORCE_MIN 5.0f // lb, force goal limits within the load cell range
+#define CASCADE_FORCE_MAX 80.0f
+volatile fc_num_t CASCADE_OUT = 0;
+
+// Gains, loaded by Controller_Init(), tuned on Host Tools/seaSim
+double Kpos = 1.0; // velocity goal per position error, 1/s
+double Kvel = 0.002; // force goal per velocity error, lb/(count/s)
+double KiVel = 0.02; // lb/count
+double KpForce = 1.0; // duty per force error, percent/lb
+double KiForce = 10.0; // percent/(lb s)
+
+typedef struct {
+    uint32_t velocityDiv, positionDiv; // controller ticks per loop update
+    uint32_t velocityCount, positionCount;
+    float kpos, kvel, kivel, kpforce, kiforce;
+    float velocityDt, forceDt;
+    int32_t positionGoal; // counts*2^ENCODER_FRAC_BITS
+    float velocityFeedforward; // counts/s
+    float velocityGoal; // counts/s, position loop output
+    float forceBias; // lb, load when the cascade took over
+    float integral; // lb, velocity loop integral
+    float forceGoal; // lb, velocity loop output
+    float forceIntegral; // percent, force loop integral
+} Cascade_State;
+static Cascade_State cascade;
+
+// ******* Scheduled PID Control *********************
+// PID with Kp, Ki and Kd interpolated every tick from a gain schedule of force
+// goal x error magnitude (gainSchedule.h), in RAM so it can be retuned without
+// flashing, Scheduled_SetTable() or the SCHEDULE command (command.h), saved
+// to the EEPROM with the parameters (paramStore.h). Controller_Init() keeps
+// it, GainSchedule_Default() is only loaded when none was set. Inside the deadband (Scheduled_SetDeadband())
+// P and I see no error. The integral is kept in percent duty, its magnitude
+// limited to SCHEDULED_INTEGRAL_LIMIT, and it stops while the duty is limited,
+// so it cannot wind up; a gain change moves no step through it. The derivative acts on
+// the measured load, not the error, so goal steps do not kick the output,
+// through a first order filter of time constant SCHEDULED_DERIVATIVE_TAU.
+// Float, runs on the FPU whatever FC_NUMERIC is
+#define SCHEDULED_DERIVATIVE_TAU 0.005f // s
+#define SCHEDULED_INTEGRAL_LIMIT ((float)FC_MAX_DUTY) // percent
+volatile fc_num_t SCHEDULED_OUT = 0;
+double deadBand = DEADBAND; // lb, Scheduled_SetDeadband()
+
+typedef struct {
+    float goal; // lb
+    float dt; // s, controller period
+    float filterStep; // dt/(tau + dt)
+    float integral; // percent
+    float seed; // percent, integral of the next reset, set by the relay tuning
+    float deadBand; // lb, float copy of deadBand for the tick
+    float lastLoad; // lb
+    float rate; // lb/s, filtered
+    GainSchedule_Gains gains; // at the last tick
+} Scheduled_State;
+static Scheduled_State scheduled;
+static GainSchedule_Table schedule; // goals 0 until the first is set
+static GainSchedule_Table scheduleUpload; // SCHEDULE command, BEGIN to COMMIT
+
+// ******* Identification *********************
+// Open loop excitation of ident.h, a chirp or a PRBS of duty around a bias,
+// started from its first tick whenever the strategy is selected. The
+// telemetry record of every tick carries the duty sent to the motor and the
+// load cell value, Host Tools/sysIdent estimates the frequency response from
+// them. The duty is 0 once the excitation is over
+volatile fc_num_t IDENT_OUT = 0;
+int32_t identKind = IDENT_CHIRP; // Ident_Kind
+double identAmplitude = 10.0; // percent
+double identBias = 0.0; // percent
+double identF0 = 0.1; // Hz, chirp start
+double identF1 = 20.0; // Hz, chirp end and PRBS bandwidth
+double identTime = 60.0; // s
+static Ident_State ident;
+
+// ******* Relay auto-tuning *********************
+// Relay feedback around the goal (autotune.h). Select it once a controller
+// holds the goal, the relay is centred on the duty it held with. At the end
+// the tick holds the bias and Tune_Background() computes the gains of the
+// tuning rule from the background loop, they go to the row of the gain
+// schedule nearest the goal, its other error columns scaled by the same
+// ratio, and the scheduled PID takes over (controllerHandover) with its
+// integral at the bias that held the goal. A failed run (timeout, overload,
+// no oscillation) hands over to no controller, the motor ramps down as in a
+// safe stop (safeStopping) until ControllerEnable(). The PID strategy is not
+// tuned: its integral error is clamped to MinSteadyError..MaxSteadyError lb
+// ticks, which cannot hold the spring at any gains. The result is printed by
+// the text logger (logger_Tune), the bias is held up to TUNE_REPORT_TIME for
+// it
+#define TUNE_REPORT_TIME 0.05 // s
+volatile fc_num_t TUNE_OUT = 0;
+double tuneAmplitude = 20.0; // percent, relay
+double tuneHysteresis = 0.5; // lb
+double tuneRange = 20.0; // lb, abort when the load leaves goal +- range
+int32_t tuneCycles = 4; // cycles measured after AUTOTUNE_SETTLE_CYCLES
+double tuneTime = 20.0; // s, abort after
+int32_t tuneRule = AUTOTUNE_ZN_PI; // Autotune_Rule
+static Autotune_State tune;
+static Autotune_Gains tuneGains;
+static volatile int tuneApplied; // gains went to the schedule
+static volatile int tuneComputed; // Tune_Background() set tuneGains and tuneApplied
+static volatile uint32_t tuneRun; // runs started, a result of an older one is not used
+static uint32_t tuneHold; // ticks since the result was computed
+static volatile int tuneReported; // logger_Tune() printed the result
+
+// ******* Load cell Kalman filter *********************
+// Steady state Kalman filter of the load (kalman.h), stepped by the
+// controller tick with the newest reading and the duty of the last tick
+// while kalmanUse is 1, not at all while it is 0. Turning it on primes the
+// filter and runs it KALMAN_WARMUP_TIME on the reading, then the strategies
+// get the estimate in pound, Q16.16, instead of the reading (controllerLoad)
+#define KALMAN_WARMUP_TIME 0.1 // s, filter settles before its estimate is used
+int32_t kalmanUse = 0; // 1 to control on the estimate
+static volatile uint32_t kalmanOn = 0; // kalmanUse for the tick, applyKalmanUse()
+static uint32_t kalmanWarm; // ticks left before the estimate is used
+double kalmanQ = 1000.0; // lb/s^2, force acceleration the model misses
+double kalmanQo = 0.01; // lb/sqrt(s), offset drift
+double kalmanR = 0.1; // lb, reading noise
+static Kalman_Filter kalman;
+
+// ******* Load cell calibration *********************
+// Calibration table of the load cell (calib.h), applied to the reading of
+// every controller tick and to measuredLoad(). Both take the reading with
+// the fraction bits of the decimator, the strategies get the result in
+// pound, Q16.16 (controllerLoad), not rounded to counts. The cal_*
+// parameters rebuild it, the defaults are the nominal 25 lb/V scale. Setting
+// tare to 1 takes the current load as the zero (cal_tare) and puts tare back
+// to 0. With cal_log the text logger prints the calibration log of Host
+// Tools/calFit instead of the strategy line (logger_Calibration)
+#if CALIB_FRAC_BITS != DECIMATOR_FRAC_BITS
+#error "the calibration takes the decimator output"
+#endif
+#define CAL_NOMINAL_LB(i) ((i)*CALIB_SEGMENT*FC_LOAD_PER_COUNT)
+double calPoint[CALIB_POINTS] = { // lb at counts i*CALIB_SEGMENT
+    CAL_NOMINAL_LB(0), CAL_NOMINAL_LB(1), CAL_NOMINAL_LB(2), CAL_NOMINAL_LB(3), CAL_NOMINAL_LB(4),
+    CAL_NOMINAL_LB(5), CAL_NOMINAL_LB(6), CAL_NOMINAL_LB(7), CAL_NOMINAL_LB(8)
+};
+double calSpan = 0; // 1/C
+double calOffset = 0; // lb/C
+double calTempRef = 25.0; // C
+double calTare = 0; // lb
+int32_t tareCapture = 0; // 1 to tare
+int32_t calLog = 0; // 1 for the calibration log
+static volatile uint32_t calLogOn = 0; // calLog for the logger, applyCalLog()
+static Calib_Table calib = {
+    {CALIB_NOMINAL(0), CALIB_NOMINAL(1), CALIB_NOMINAL(2), CALIB_NOMINAL(3), CALIB_NOMINAL(4),
+     CALIB_NOMINAL(5), CALIB_NOMINAL(6), CALIB_NOMINAL(7), CALIB_NOMINAL(8)}, 0, 0, 0, 0
+};
+
+// ******* Boot settings *********************
+// Rates of the start up sequence, Param_GetBoot() after ParamStore_Load().
+// A new value takes effect at the next reset
+int32_t bootPWMFreq = 20000; // Hz
+int32_t bootADCAveraging = 8; // 0 or a power of 2 up to 64
+int32_t bootADCFreq = 32000; // Hz, DECIMATOR_RATE samples per controller tick in block mode
+int32_t bootControllerFreq = 2000; // Hz
+
+// ******* Trajectory *********************
+// Gait table played as the controller goal, Trajectory_Start()
+static Gait_Player trajectory;
+static volatile int trajectoryRunning = 0;
 
 uint32_t globalDummy = 0;
 
+// ******* Controller strategies *********************
+// Table is in the controller section, Controller_Select() switches at runtime
+static const Controller_Strategy *volatile activeController;
+Controller_Cost controllerCost[NUM_CONTROLLERS]; // step cost, Timer1 cycles
+
+// Deadline monitor of the controller tick, safe stop when it trips
+#define SAFE_STOP_TIME 0.1 // s, motor ramp from 100 % duty to 0
+static Monitor_State controllerMonitor;
+static uint32_t safeStopDiv = 1; // ticks per 1 % of duty in the ramp
+static uint32_t safeStopCount;
+static volatile int safeStopping; // safe stop without a trip, a failed relay tuning
+int32_t overrunLimit = MONITOR_LIMIT; // overruns to trip, Controller_SetOverrunLimit()
+volatile fc_num_t SWING_OUT = 0;
+
+// Bumpless transfer, duty in 1/256 percent
+#define BUMPLESS_SHIFT 5 // offset decays by 1/32 per tick, 16 ms at 2 kHz
+volatile int32_t bumpOffset = 0; // added to the strategy output
+volatile int32_t bumpHeld = 0; // output when the switch happened
+volatile int32_t bumpArm = 0; // 1 until the first tick after a switch
+static uint32_t controllerHandover = NUM_CONTROLLERS; // switch asked by a step hook, done after it
+static Sensors_Snapshot controllerSensors; // newest snapshot taken by the controller
+static int32_t controllerLoad; // pound, Q16.16, load used by this tick
+static int32_t controllerRaw; // pound, Q16.16, calibrated load cell of the newest snapshot
+static Encoder_Estimator encoder; // QEI1 position and velocity, IncEncoder_Init()
+static int encoderEnabled = 0;
+
 // ********************* Clock ***************************************
 //------------------Clock_set_40MHz---------------------------
 // Configure system clock to run at fastest settings
@@ -165,8 +416,8 @@ uint32_t globalDummy = 0;
 // Input: None
 // Output: None
 void Clock_set_40MHz(void){
-    SysCtlClockSet(SYSCTL_SYSDIV_5|SYSCTL_USE_PLL|SYSCTL_XTAL_16MHZ|
-                        SYSCTL_OSC_MAIN);  // Setup system clock at 40MHz from PLL with Crystal
+    HAL_ClockSet(HAL_CLOCK_40MHZ);  // Setup system clock at 40MHz from PLL with Crystal
+    Profile_Init();
 }
 
 //------------------Clock_set_80MHz---------------------------
@@ -174,8 +425,8 @@ void Clock_set_40MHz(void){
 // Input: None
 // Output: None
 void Clock_set_80MHz(void){
-    SysCtlClockSet(SYSCTL_SYSDIV_2_5|SYSCTL_USE_PLL|SYSCTL_XTAL_16MHZ|
-                            SYSCTL_OSC_MAIN);  // Setup system clock at 80MHz from PLL with Crystal
+    HAL_ClockSet(HAL_CLOCK_80MHZ);  // Setup system clock at 80MHz from PLL with Crystal
+    Profile_Init();
 }
 
 //------------------Clock_get_frequency---------------------------
@@ -183,7 +434,7 @@ void Clock_set_80MHz(void){
 // Input: None
 // Output: Frequency
 uint32_t Clock_get_frequency(void){
-    return SysCtlClockGet();
+    return HAL_ClockGet();
 }
 
 // ******************* Enable Interrupts ******************************
@@ -192,7 +443,7 @@ uint32_t Clock_get_frequency(void){
 // Input: None
 // Output: None
 void EnableInterrupts(void){
-    IntMasterEnable();
+    HAL_IntMasterEnable();
 }
 
 // ********************* Delay *********************************
@@ -201,7 +452,7 @@ void EnableInterrupts(void){
 // It is not accurate and blocking
 // Input: delay cycles
 void Delay_cycle(uint32_t delay){
-    SysCtlDelay(delay);
+    HAL_DelayLoops(delay);
 }
 
 //------------------delayMS----------------------------
@@ -209,7 +460,7 @@ void Delay_cycle(uint32_t delay){
 // It is not accurate and blocking
 // Input: ms
 void delayMS(int ms) {
-    SysCtlDelay( (SysCtlClockGet()/(3*1000))*ms ) ;
+    HAL_DelayLoops( (HAL_ClockGet()/(3*1000))*ms ) ;
 }
 
 
@@ -220,17 +471,8 @@ void delayMS(int ms) {
 // Input: None
 // Output: None
 void BlueLED_Init(){
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
-     while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOD)){
-          } // Enable and wait for the port to be ready for access
-
-     // Unlock PD7
-     HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-     HWREG(GPIO_PORTD_BASE + GPIO_O_CR) |= 0x80;
-     HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = 0;
-
-     //Configure port for LED operation
-     GPIOPinTypeGPIOOutput(GPIO_PORTD_BASE, GPIO_PIN_7);
+     //Configure port for LED operation, PD7 is unlocked by the HAL
+     HAL_GPIOInitOutput(HAL_PIN_BLUE_LED);
 }
 
 // ----------------BlueLED_Set-----------------------
@@ -238,7 +480,7 @@ void BlueLED_Init(){
 // Input: None
 // Output: None
 void BlueLED_Set(){
-    GPIOPinWrite(GPIO_PORTD_BASE, GPIO_PIN_7, GPIO_PIN_7);
+    HAL_GPIOWrite(HAL_PIN_BLUE_LED, true);
 }
 
 // ----------------BlueLED_Clear-----------------------
@@ -246,7 +488,7 @@ void BlueLED_Set(){
 // Input: None
 // Output: None
 void BlueLED_Clear(){
-    GPIOPinWrite(GPIO_PORTD_BASE, GPIO_PIN_7, ~GPIO_PIN_7);
+    HAL_GPIOWrite(HAL_PIN_BLUE_LED, false);
 }
 
 // ----------------BlueLED_Toggle-----------------------
@@ -255,11 +497,7 @@ void BlueLED_Clear(){
 // Output: None
 void BlueLED_Toggle(){
     //Read current state and write back the opposite state
-    if(GPIOPinRead(GPIO_PORTD_BASE, GPIO_PIN_7)){
-        GPIOPinWrite(GPIO_PORTD_BASE, GPIO_PIN_7, ~GPIO_PIN_7);
-    }else{
-        GPIOPinWrite(GPIO_PORTD_BASE,GPIO_PIN_7, GPIO_PIN_7);
-    }
+    HAL_GPIOWrite(HAL_PIN_BLUE_LED, !HAL_GPIORead(HAL_PIN_BLUE_LED));
 }
 
 // ----------------YellowLED_Init-----------------------
@@ -267,12 +505,8 @@ void BlueLED_Toggle(){
 // Input: None
 // Output: None
 void YellowLED_Init(){
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOC);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOC)){
-             } // Enable and wait for the port to be ready for access
-
-        //Configure port for LED operation
-        GPIOPinTypeGPIOOutput(GPIO_PORTC_BASE, GPIO_PIN_7);
+    //Configure port for LED operation
+    HAL_GPIOInitOutput(HAL_PIN_YELLOW_LED);
 }
 
 // ----------------YellowLED_Set-----------------------
@@ -280,7 +514,7 @@ void YellowLED_Init(){
 // Input: None
 // Output: None
 void YellowLED_Set(){
-    GPIOPinWrite(GPIO_PORTC_BASE, GPIO_PIN_7, GPIO_PIN_7);
+    HAL_GPIOWrite(HAL_PIN_YELLOW_LED, true);
 }
 
 // ----------------BYellowLED_Clear-----------------------
@@ -288,7 +522,7 @@ void YellowLED_Set(){
 // Input: None
 // Output: None
 void YellowLED_Clear(){
-    GPIOPinWrite(GPIO_PORTC_BASE, GPIO_PIN_7, ~GPIO_PIN_7);
+    HAL_GPIOWrite(HAL_PIN_YELLOW_LED, false);
 }
 
 // ----------------YellowLED_Toggle-----------------------
@@ -297,11 +531,7 @@ void YellowLED_Clear(){
 // Output: None
 void YellowLED_Toggle(void){
     //Read current state and write back the opposite state
-    if(GPIOPinRead(GPIO_PORTC_BASE, GPIO_PIN_7)){
-        GPIOPinWrite(GPIO_PORTC_BASE, GPIO_PIN_7, ~GPIO_PIN_7);
-    }else{
-        GPIOPinWrite(GPIO_PORTC_BASE,GPIO_PIN_7, GPIO_PIN_7);
-    }
+    HAL_GPIOWrite(HAL_PIN_YELLOW_LED, !HAL_GPIORead(HAL_PIN_YELLOW_LED));
 }
 
 
@@ -311,12 +541,7 @@ void YellowLED_Toggle(void){
 //Input: None
 //Output: None
 void Button1_Init(void){
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOF)){
-       } //Enable Peripheral
-
-    GPIOPinTypeGPIOInput(GPIO_PORTF_BASE, GPIO_PIN_4);
-    GPIOPadConfigSet(GPIO_PORTF_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
+    HAL_GPIOInitInput(HAL_PIN_BUTTON1); //Weak pull up
 }
 
 //----------------Button1_Input---------------------
@@ -327,7 +552,7 @@ void Button1_Init(void){
 //         Button pressed - zero
 // Call Button1_init() first
 uint8_t Button1_Input(void){
-    if(((GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_4))&GPIO_PIN_4) == 0) //Button Pressed
+    if(!HAL_GPIORead(HAL_PIN_BUTTON1)) //Button Pressed
         return 0;
     else
         return 1;
@@ -337,17 +562,13 @@ uint8_t Button1_Input(void){
 // Initializes the RGB LED on PF1, PF2 and PF3
 void RGBled_Init(uint8_t red, uint8_t green, uint8_t blue){
 
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOF)){
-       } // Enable and wait for the port to be ready for access
-
     //Configure port for LED operation
     if(red>0){
-        GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE, GPIO_PIN_1);
+        HAL_GPIOInitOutput(HAL_PIN_RGB_RED);
     }if(blue>0){
-        GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE, GPIO_PIN_2);
+        HAL_GPIOInitOutput(HAL_PIN_RGB_BLUE);
     }if(green>0){
-        GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE, GPIO_PIN_3);
+        HAL_GPIOInitOutput(HAL_PIN_RGB_GREEN);
     }
 }
 
@@ -356,21 +577,9 @@ void RGBled_Init(uint8_t red, uint8_t green, uint8_t blue){
 // Input: non zero input sets the LEDs
 // Output: None
 void RGBled_Set(uint8_t red, uint8_t green, uint8_t blue){
-    if(red>0){
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_1, GPIO_PIN_1);
-    }else{
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_1, ~GPIO_PIN_1);
-    }
-    if(blue>0){
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_2, GPIO_PIN_2);
-    }else{
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_2, ~GPIO_PIN_2);
-    }
-    if(green>0){
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, GPIO_PIN_3);
-    }else{
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, ~GPIO_PIN_3);
-    }
+    HAL_GPIOWrite(HAL_PIN_RGB_RED, red>0);
+    HAL_GPIOWrite(HAL_PIN_RGB_BLUE, blue>0);
+    HAL_GPIOWrite(HAL_PIN_RGB_GREEN, green>0);
 }
 
 // ----------------RGBled_Toggle-----------------------
@@ -381,27 +590,15 @@ void RGBled_Set(uint8_t red, uint8_t green, uint8_t blue){
 //         green is toggle for green
 // Output: None
 void RGBled_Toggle(uint8_t red, uint8_t green, uint8_t blue){
-    if(red){
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_1, GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_1)^GPIO_PIN_1);
-    }else{
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_1, ~GPIO_PIN_1);
-    }
-    if(green){
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_3)^GPIO_PIN_3);
-    }else{
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, ~GPIO_PIN_3);
-    }
-    if(blue){
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_2, GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_2)^GPIO_PIN_2);
-    }else{
-        GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_2, ~GPIO_PIN_2);
-    }
+    HAL_GPIOWrite(HAL_PIN_RGB_RED, red ? !HAL_GPIORead(HAL_PIN_RGB_RED) : false);
+    HAL_GPIOWrite(HAL_PIN_RGB_GREEN, green ? !HAL_GPIORead(HAL_PIN_RGB_GREEN) : false);
+    HAL_GPIOWrite(HAL_PIN_RGB_BLUE, blue ? !HAL_GPIORead(HAL_PIN_RGB_BLUE) : false);
 }
 
 // ----------------Timer0IntHandler-----------------------
 // ISR for Blink LED
 void Timer0IntHandler(void){
-    TimerIntClear(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+    HAL_TimerIntClear(HAL_TIMER0);
 
     //RedledTimer_Toggle();
     RGBled_Toggle(0, 0, 1);
@@ -415,21 +612,15 @@ void Timer0IntHandler(void){
 void initTimer0(int frequency){
     uint32_t periods; // Timer delays
 
-    //Configure Timer
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
-    TimerConfigure(TIMER0_BASE, TIMER_CFG_PERIODIC);
-
     // Define period
-    periods = (SysCtlClockGet()/frequency)/2; //We want 10 Hz toggle frequency therefore the period should be the
+    periods = (HAL_ClockGet()/frequency)/2; //We want 10 Hz toggle frequency therefore the period should be the
     //system clock / desired toggle freq/2
-    TimerLoadSet(TIMER0_BASE, TIMER_A, periods-1);
 
-    //Enable iNTERRUPTS
-    IntEnable(INT_TIMER0A);
-    TimerIntEnable(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+    //Configure Timer, interrupt goes through the startup vector table
+    HAL_TimerInitPeriodic(HAL_TIMER0, periods, 0);
 
     //Enable Timer
-    TimerEnable(TIMER0_BASE, TIMER_A);
+    HAL_TimerEnable(HAL_TIMER0);
 }
 
 // ********************* Logger *********************************
@@ -439,20 +630,8 @@ void initTimer0(int frequency){
 // Input: None
 // Output: None
 void initConsole(int BaudRate){
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-    SysCtlDelay(3); //Just to be sure that the peripherals were enabled
-
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
-    SysCtlDelay(3); //Just to be sure that the peripherals were enabled
-
-    //Configure Pins for UART functionality
-    GPIOPinConfigure(GPIO_PA0_U0RX);
-    GPIOPinConfigure(GPIO_PA1_U0TX);
-    GPIOPinTypeUART(GPIO_PORTA_BASE,GPIO_PIN_0|GPIO_PIN_1);
-
-    // Configure UART clock and Baud rate
-    UARTClockSourceSet(UART0_BASE, UART_CLOCK_PIOSC); //Precision internal clock
-    UARTStdioConfig(0, BaudRate, 16000000); // UART Module 0, Baud Rate 115200 and System clock 16MHZ
+    // UART Module 0 on PA0/PA1, Baud Rate 115200 and Precision internal clock 16MHZ
+    HAL_ConsoleInit(BaudRate);
 }
 
 //------------------Console_Send()---------------------------
@@ -464,6 +643,10 @@ void Console_Send(char* input){
 }
 
 
+static void commandStart(void);
+static int32_t calibPound(int32_t fine);
+static float controllerPound(void);
+
 //------------------Logger_Init()---------------------------
 //Initializes a timer routine for the controller
 //Input: Logger frequency and Baud Rate
@@ -475,35 +658,88 @@ void Logger_Init(uint32_t LoggerFreq, int BaudRate){
 
         uint32_t periods; // Timer delays
 
-        //Configure Timer
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
-        // wait for timer module 1 to be ready
-        while(!SysCtlPeripheralReady(SYSCTL_PERIPH_TIMER2))
-            {
-            }
+        // Define period
+        periods = (HAL_ClockGet()/LoggerFreq);
+        //periods = (clockFreq/Controllerfreq);
 
-        TimerConfigure(TIMER2_BASE, TIMER_CFG_PERIODIC);
+        //Configure Timer 2 and register the timer interrupt service routine
+        HAL_TimerInitPeriodic(HAL_TIMER2, periods, LoggerIntHandler);
+        Profile_SetPeriod(PROFILE_LOGGER, periods);
 
-        // set timer 1 to run off of system clock
-       // TimerClockSourceSet(TIMER1_BASE, TIMER_CLOCK_SYSTEM);
+        HAL_TimerEnable(HAL_TIMER2);
 
-        // Define period
-        periods = (SysCtlClockGet()/LoggerFreq);
-        //periods = (clockFreq/Controllerfreq);
-        TimerLoadSet(TIMER2_BASE, TIMER_A, periods-1);
+        loggerCount = 0;
+        commandStart();
+}
 
-        // register the timer interrupt service routine
-        TimerIntRegister(TIMER2_BASE, TIMER_A, *LoggerIntHandler);
+//------------------Logger_InitTelemetry()---------------------------
+//Initializes the binary telemetry logger, one record per controller tick.
+//Records are sent by the uDMA on UART0. No logger timer is used, call
+//Logger_Drain() from the background loop
+//Input: Baud Rate (TELEMETRY_BAUD_RATE or more for a 2 kHz controller)
+//Output: None
+void Logger_InitTelemetry(int BaudRate){
+    initConsole(BaudRate);
+    HAL_UARTDMAInit(UARTIntHandler);
+    UARTTx_Init();
+    Telemetry_Init();
+    telemetryEnabled = 1;
+    consoleDMA = 1;
+    commandStart();
+}
+
+//------------------Logger_Enable()---------------------------
+//Start or stop the logger set up by Logger_Init or Logger_InitTelemetry
+//Input: 1 to start, 0 to stop
+//Output: None
+void Logger_Enable(int enable){
+    if(consoleDMA){
+        telemetryEnabled = enable ? 1 : 0;
+    }else if(enable){
+        HAL_TimerEnable(HAL_TIMER2);
+    }else{
+        HAL_TimerDisable(HAL_TIMER2);
+    }
+}
 
-        // clear rollover interrupt and then enable it
-        TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
-        TimerIntEnable(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
+//------------------Logger_Drain()---------------------------
+//Send the queued telemetry records, call from the background loop
+//Input: None
+//Output: Number of records sent
+uint32_t Logger_Drain(void){
+    return Telemetry_Drain();
+}
 
-        IntEnable(INT_TIMER2A);
+//------------------Logger_EnableRawCapture()---------------------------
+//Add the raw load cell blocks to the telemetry stream
+//Input: 1 to start, 0 to stop
+//Output: None
+void Logger_EnableRawCapture(int enable){
+    Telemetry_EnableBlocks(enable);
+}
 
-        TimerEnable(TIMER2_BASE, TIMER_A);
+//------------------centi()---------------------------
+//Convert a controller signal to 0.01 units, limited to the int16 record field
+//Input: Signal
+//Output: Signal*100
+static int32_t centi(fc_num_t x){
+    if(x > FC_NUM(327.67)) return 32767;
+    if(x < FC_NUM(-327.68)) return -32768;
+    return FC_TO_CENTI(x);
+}
 
-        loggerCount = 0;
+//------------------logTelemetry()---------------------------
+//Queue one telemetry record from the controller ISR
+//Input: Controller output
+//Output: None
+static void logTelemetry(fc_num_t out){
+    int32_t duty;
+    float load; // ADC counts
+    if(telemetryEnabled){
+        duty = globalDirection ? (int32_t)globalDutyCycle : -(int32_t)globalDutyCycle;
+        load = controllerPound()*(float)(1.0/FC_LOAD_PER_COUNT) + 0.5f;
+        Telemetry_Log(globalControllerTick, (load > 0) ? (uint32_t)load : 0, duty, centi(ERROR), centi(out));
+    }
 }
 
 //
@@ -523,12 +759,15 @@ void print_loadCell(){
 //Input: None
 //Output: None
 void LoggerIntHandler(void){
-    TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
-    //print_loadCell();
-    //logger_PID_ForceControl();
+    PROFILE_ENTER(PROFILE_LOGGER);
+    HAL_TimerIntClear(HAL_TIMER2);
     //logPID();
-    logger_Adaptive_ForceControl();
-
+    if(calLogOn){
+        logger_Calibration();
+    }else{
+        activeController->log(); // log hook of the selected controller
+    }
+    PROFILE_EXIT(PROFILE_LOGGER);
 }
 
 //------------------SerialMonitor_Init()---------------------------
@@ -538,35 +777,21 @@ void LoggerIntHandler(void){
 //Output: None
 void SerialMonitor_Init(){
 
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-    SysCtlDelay(3); //Just to be sure that the peripherals were enabled
-
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
-    SysCtlDelay(3); //Just to be sure that the peripherals were enabled
-
-    //Configure Pins for UART functionality
-    GPIOPinConfigure(GPIO_PA0_U0RX);
-    GPIOPinConfigure(GPIO_PA1_U0TX);
-    GPIOPinTypeUART(GPIO_PORTA_BASE,GPIO_PIN_0|GPIO_PIN_1);
-
-    // Set UART functionality - Baud rate, parity etc
-    UARTConfigSetExpClk(UART0_BASE, SysCtlClockGet(), 115200, (UART_CONFIG_WLEN_8|UART_CONFIG_STOP_ONE|UART_CONFIG_PAR_NONE));
-
-    //Enable Interrupts
+    // Set UART functionality - Baud rate 115200, 8N1, RX and RT interrupt sources only
     //IntMasterEnable();
-    IntEnable(INT_UART0);
-    UARTIntEnable(UART0_BASE, UART_INT_RX|UART_INT_RT); //Enable RX and RT interrupt sources only
+    HAL_UARTInit(115200, UARTIntHandler);
+    Command_Init();
 
     // Initial UART message
-       UARTCharPut(UART0_BASE, 'S');
-       UARTCharPut(UART0_BASE, 't');
-       UARTCharPut(UART0_BASE, 'a');
-       UARTCharPut(UART0_BASE, 'r');
-       UARTCharPut(UART0_BASE, 't');
-       UARTCharPut(UART0_BASE, 'u');
-       UARTCharPut(UART0_BASE, 'p');
-       UARTCharPut(UART0_BASE, '!');
-       UARTCharPut(UART0_BASE, ' ');
+       HAL_UARTCharPut('S');
+       HAL_UARTCharPut('t');
+       HAL_UARTCharPut('a');
+       HAL_UARTCharPut('r');
+       HAL_UARTCharPut('t');
+       HAL_UARTCharPut('u');
+       HAL_UARTCharPut('p');
+       HAL_UARTCharPut('!');
+       HAL_UARTCharPut(' ');
 }
 
 //------------------SerialMonitor_Loop()---------------------------
@@ -575,56 +800,593 @@ void SerialMonitor_Init(){
 //Input: None
 //Output: None
 void SerialMonitor_Loop(){
-    if(UARTCharsAvail(UART0_BASE))
-        UARTCharPut(UART0_BASE, UARTCharGet(UART0_BASE));
+    if(HAL_UARTCharsAvail())
+        HAL_UARTCharPut(HAL_UARTCharGet());
 }
 
 //------------------UARTIntHandler()---------------------------
-//ISR for UART
+//ISR for UART, also taken when a uDMA transmit block is done. Received bytes
+//go to the command framer (command.h)
 //Input: None
 //Output: None
 void UARTIntHandler(void){
-    uint32_t status;
-    status = UARTIntStatus(UART0_BASE, true); //get the interrupt status
-    UARTIntClear(UART0_BASE, status); //clear the interrupts
-    while(UARTCharsAvail(UART0_BASE)){
-        UARTCharPutNonBlocking(UART0_BASE, UARTCharGetNonBlocking(UART0_BASE)); //Echo Character
+    int received = 0;
+
+    PROFILE_ENTER(PROFILE_UART);
+    HAL_UARTIntClear(); //clear the interrupts
+    while(HAL_UARTCharsAvail()){
+        Command_Receive((uint8_t)HAL_UARTCharGetNonBlocking());
+        received = 1;
     }
+    if(received && commandNotify){
+        commandNotify();
+    }
+    UARTTx_Service(); //next telemetry block
+    PROFILE_EXIT(PROFILE_UART);
 }
 
-//------------------SerialMonitor_Receive()---------------------------
-//Receive data from the serial monitor using UART
+//------------------SerialMonitor_SetNotify()---------------------------
+//Call a function from the UART interrupt whenever bytes arrive, to wake the
+//thread that calls SerialMonitor_Receive()
+//Input: function, 0 for none
+//Output: None
+void SerialMonitor_SetNotify(HAL_Handler notify){
+    commandNotify = notify;
+}
+
+//------------------SerialMonitor_SetExtension()---------------------------
+//Run the commands unknown to slug.c with another function
+//Input: function, 0 for none
+//Output: None
+void SerialMonitor_SetExtension(SerialMonitor_Extension extension){
+    commandExtension = extension;
+}
+
+//------------------commandStart()---------------------------
+//Take commands on UART0 next to the console or the telemetry
 //Input: None
 //Output: None
-void SerialMonitor_Receive();
+static void commandStart(void){
+    Command_Init();
+    HAL_UARTRxIntEnable(UARTIntHandler);
+}
+
+// ****** Parameters ******
+// Named parameters for the command protocol. Setting one calls its apply
+// hook, so a gain reaches the control law while it runs. The type tells
+// paramStore.c how to keep it in the EEPROM
+static void applyGoal(void);
+static void applyPID(void);
+static void applyAdaptive(void);
+static void cascadeGains(void);
+static void applyMonitor(void);
+static void applyIdent(void);
+static void applyTune(void);
+static void applyKalman(void);
+static void applyKalmanUse(void);
+static void applyCalib(void);
+static void applyTare(void);
+static void applyCalLog(void);
+static void applyAveraging(void);
+static void applyDeadband(void);
+
+typedef struct {
+    const char *name;
+    double *real;                   // PARAM_REAL and the goal
+    int32_t *whole;                 // PARAM_INT, PARAM_BOOT and the actions, one store
+    double min, max;
+    void (*apply)(void);            // 0 when the value is used as it is
+    Param_Type type;
+} Param;
+
+static const Param paramTable[] = {
+//   name             real, whole             min  max    apply  type
+    {"goal",          &goalPos, 0,            0,   FC_ADC_VREF*FC_VOL2LOAD, applyGoal, PARAM_COMMAND},
+    {"Kbar",          &Kbar, 0,               0,   PID_GAIN_MAX, applyPID, PARAM_REAL},
+    {"Ki",            &Ki, 0,                 0,   PID_GAIN_MAX, applyPID, PARAM_REAL},
+    {"Kd",            &Kd, 0,                 0,   PID_GAIN_MAX, applyPID, PARAM_REAL},
+    {"steady_min",    &MinSteadyError, 0,     -1000, 0, applyPID, PARAM_REAL},
+    {"steady_max",    &MaxSteadyError, 0,     0, 1000,  applyPID, PARAM_REAL},
+    {"gamma_x",       &gamma_x, 0,            0,   1,     applyAdaptive, PARAM_REAL},
+    {"gamma_r",       &gamma_r, 0,            0,   1,     applyAdaptive, PARAM_REAL},
+    {"Kpos",          &Kpos, 0,               0,   100,   cascadeGains, PARAM_REAL},
+    {"Kvel",          &Kvel, 0,               0,   1,     cascadeGains, PARAM_REAL},
+    {"KiVel",         &KiVel, 0,              0,   10,    cascadeGains, PARAM_REAL},
+    {"KpForce",       &KpForce, 0,            0,   100,   cascadeGains, PARAM_REAL},
+    {"KiForce",       &KiForce, 0,            0,   1000,  cascadeGains, PARAM_REAL},
+    {"deadBand",      &deadBand, 0,           0,   10,    applyDeadband, PARAM_REAL},
+    {"overrunLimit",  0, &overrunLimit,       1,   1000,  applyMonitor, PARAM_INT},
+    {"ident_kind",    0, &identKind,          0,   NUM_IDENT_KINDS - 1, applyIdent, PARAM_INT},
+    {"ident_amp",     &identAmplitude, 0,     0, FC_MAX_DUTY, applyIdent, PARAM_REAL},
+    {"ident_bias",    &identBias, 0,          -FC_MAX_DUTY, FC_MAX_DUTY, applyIdent, PARAM_REAL},
+    {"ident_f0",      &identF0, 0,            0.01, 1000, applyIdent, PARAM_REAL},
+    {"ident_f1",      &identF1, 0,            0.01, 1000, applyIdent, PARAM_REAL},
+    {"ident_time",    &identTime, 0,          0,   600,   applyIdent, PARAM_REAL},
+    {"tune_amp",      &tuneAmplitude, 0,      1,  FC_MAX_DUTY, applyTune, PARAM_REAL},
+    {"tune_hyst",     &tuneHysteresis, 0,     0, 10,    applyTune, PARAM_REAL},
+    {"tune_range",    &tuneRange, 0,          1,   FC_ADC_VREF*FC_VOL2LOAD, applyTune, PARAM_REAL},
+    {"tune_cycles",   0, &tuneCycles,         1,   50,    applyTune, PARAM_INT},
+    {"tune_time",     &tuneTime, 0,           1,   120,   applyTune, PARAM_REAL},
+    {"tune_rule",     0, &tuneRule,           0,   NUM_AUTOTUNE_RULES - 1, applyTune, PARAM_INT},
+    {"kalman",        0, &kalmanUse,          0,   1,     applyKalmanUse, PARAM_INT},
+    {"kalman_q",      &kalmanQ, 0,            0,   100000, applyKalman, PARAM_REAL},
+    {"kalman_qo",     &kalmanQo, 0,           0,   100,   applyKalman, PARAM_REAL},
+    {"kalman_r",      &kalmanR, 0,            0.001, 10,  applyKalman, PARAM_REAL},
+    {"cal_p0",        &calPoint[0], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p1",        &calPoint[1], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p2",        &calPoint[2], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p3",        &calPoint[3], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p4",        &calPoint[4], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p5",        &calPoint[5], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p6",        &calPoint[6], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p7",        &calPoint[7], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_p8",        &calPoint[8], 0,        -FC_ADC_VREF*FC_VOL2LOAD, 2*FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"cal_span",      &calSpan, 0,            -0.1, 0.1,  applyCalib, PARAM_REAL},
+    {"cal_offset",    &calOffset, 0,          -10, 10,    applyCalib, PARAM_REAL},
+    {"cal_tref",      &calTempRef, 0,         -40, 150,   applyCalib, PARAM_REAL},
+    {"cal_tare",      &calTare, 0,            -FC_ADC_VREF*FC_VOL2LOAD, FC_ADC_VREF*FC_VOL2LOAD, applyCalib, PARAM_REAL},
+    {"tare",          0, &tareCapture,        0,   1,     applyTare, PARAM_COMMAND},
+    {"cal_log",       0, &calLog,             0,   1,     applyCalLog, PARAM_COMMAND},
+    {"pwm_freq",      0, &bootPWMFreq,        1000, 40000, 0,     PARAM_BOOT},
+    {"adc_avg",       0, &bootADCAveraging,   0, 64,  applyAveraging, PARAM_BOOT},
+    {"adc_rate",      0, &bootADCFreq,        1000, 125000, 0,    PARAM_BOOT},
+    {"ctrl_freq",     0, &bootControllerFreq, 100, 10000, 0, PARAM_BOOT},
+};
+#define NUM_PARAMS (sizeof(paramTable)/sizeof(paramTable[0]))
+
+//------------------Param_Count()---------------------------
+//Get the number of named parameters
+//Input: None
+//Output: Count
+uint32_t Param_Count(void){
+    return NUM_PARAMS;
+}
+
+//------------------Param_Name()---------------------------
+//Get the name of a parameter
+//Input: Parameter number
+//Output: Name, 0 for an unknown parameter
+const char *Param_Name(uint32_t id){
+    return (id < NUM_PARAMS) ? paramTable[id].name : 0;
+}
+
+//------------------Param_Find()---------------------------
+//Find a parameter by name
+//Input: Name
+//Output: Parameter number, -1 if unknown
+int Param_Find(const char *name){
+    uint32_t i;
+    for(i = 0; i < NUM_PARAMS; i++){
+        if(strcmp(name, paramTable[i].name) == 0){
+            return (int)i;
+        }
+    }
+    return -1;
+}
 
-//------------------tempSensor_init()---------------------------
-//Initialize the Temperature Sensor on Board, processor triggered
-//Input: hardwareAverage (can be 2,4,8,16,32 or 64)
+//------------------Param_Get()---------------------------
+//Get the value of a parameter
+//Input: Parameter number, value out
+//Output: 1 if read, 0 for an unknown parameter
+int Param_Get(uint32_t id, double *value){
+    if(id >= NUM_PARAMS){
+        return 0;
+    }
+    *value = paramTable[id].whole ? (double)*paramTable[id].whole : *paramTable[id].real;
+    return 1;
+}
+
+//------------------Param_Set()---------------------------
+//Set a parameter and hand it to the control law
+//Input: Parameter number, value
+//Output: 1 if set, 0 for an unknown parameter or a value out of range
+int Param_Set(uint32_t id, double value){
+    const Param *p;
+    uint32_t state;
+
+    if(id >= NUM_PARAMS){
+        return 0;
+    }
+    p = &paramTable[id];
+    // The command protocol sends float32, a limit arrives rounded
+    if((float)value == (float)p->min){
+        value = (value < p->min) ? p->min : value;
+    }else if((float)value == (float)p->max){
+        value = (value > p->max) ? p->max : value;
+    }
+    if(!(value >= p->min && value <= p->max)){
+        return 0;
+    }
+    if(p->whole){
+        *p->whole = (int32_t)(value + (value < 0 ? -0.5 : 0.5));
+    }else{
+        // A double is two stores, the interrupts must not see half of one
+        state = HAL_EnterCritical();
+        *p->real = value;
+        HAL_ExitCritical(state);
+    }
+    if(p->apply){
+        p->apply();
+    }
+    return 1;
+}
+
+//------------------Param_GetType()---------------------------
+//Get the type of a parameter
+//Input: Parameter number
+//Output: Type, PARAM_COMMAND for an unknown parameter
+Param_Type Param_GetType(uint32_t id){
+    return (id < NUM_PARAMS) ? paramTable[id].type : PARAM_COMMAND;
+}
+
+//------------------Param_GetBoot()---------------------------
+//Get the rates of the start up sequence
+//Input: Rates out
 //Output: None
-void tempSensor_Init(int hardwareAverage){
-    // Enable ADC0
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
-    SysCtlDelay(2);
+void Param_GetBoot(Param_Boot *boot){
+    boot->pwmFreq = (uint32_t)bootPWMFreq;
+    boot->adcAveraging = (int)bootADCAveraging;
+    boot->adcFreq = (int)bootADCFreq;
+    boot->controllerFreq = (uint32_t)bootControllerFreq;
+}
+
+//------------------applyAveraging()---------------------------
+//Parameter hook of the ADC hardware averaging, down to a factor the ADC has
+static void applyAveraging(void){
+    int n = 2;
+
+    if(bootADCAveraging < 2){
+        bootADCAveraging = 0;
+        return;
+    }
+    while(2*n <= bootADCAveraging){
+        n *= 2;
+    }
+    bootADCAveraging = n;
+}
+
+//------------------commandStore()---------------------------
+//Reply payload of the STORE command, runs the action on the parameter store
+//Input: action, reply payload out, reply length out
+//Output: Status
+static Command_Status commandStore(uint32_t action, uint8_t *out, uint32_t *length){
+    const ParamStore_Info *info;
+
+    switch(action){
+    case COMMAND_STORE_INFO:
+        break;
+    case COMMAND_STORE_SAVE:
+        ParamStore_Save();
+        break;
+    case COMMAND_STORE_LOAD:
+        ParamStore_Load();
+        break;
+    case COMMAND_STORE_DEFAULTS:
+        ParamStore_Defaults();
+        break;
+    case COMMAND_STORE_ERASE:
+        ParamStore_Erase();
+        break;
+    default:
+        return COMMAND_BAD_ID;
+    }
+    info = ParamStore_Get();
+    out[0] = action;
+    out[1] = info->status;
+    out[2] = info->loaded;
+    out[3] = info->skipped;
+    Command_PutUint32(&out[4], info->saves);
+    out[8] = info->schedule;
+    *length = 9;
+    return COMMAND_OK;
+}
+
+//------------------commandSchedule()---------------------------
+//Reply payload of the SCHEDULE command, reads the gain schedule in use or
+//uploads a new one
+//Input: request, reply payload out, reply length out
+//Output: Status
+static Command_Status commandSchedule(const Command_Request *r, uint8_t *out, uint32_t *length){
+    const GainSchedule_Gains *g;
+    uint32_t i, j, state;
+
+    if(r->length < 1) return COMMAND_BAD_LENGTH;
+    out[0] = r->payload[0];
+    switch(r->payload[0]){
+    case COMMAND_SCHEDULE_INFO:
+        if(r->length != 1) return COMMAND_BAD_LENGTH;
+        out[1] = schedule.goals;
+        out[2] = schedule.errors;
+        *length = 3;
+        return COMMAND_OK;
+    case COMMAND_SCHEDULE_GET:
+        if(r->length != 3) return COMMAND_BAD_LENGTH;
+        i = r->payload[1];
+        j = r->payload[2];
+        if(i >= schedule.goals || j >= schedule.errors) return COMMAND_BAD_ID;
+        g = &schedule.gains[i][j];
+        out[1] = i;
+        out[2] = j;
+        Command_PutFloat(&out[3], schedule.goal[i]);
+        Command_PutFloat(&out[7], schedule.error[j]);
+        Command_PutFloat(&out[11], g->kp);
+        Command_PutFloat(&out[15], g->ki);
+        Command_PutFloat(&out[19], g->kd);
+        *length = 23;
+        return COMMAND_OK;
+    case COMMAND_SCHEDULE_BEGIN:
+        if(r->length != 3) return COMMAND_BAD_LENGTH;
+        if(r->payload[1] < 1 || r->payload[1] > GAIN_SCHEDULE_MAX_GOALS ||
+           r->payload[2] < 1 || r->payload[2] > GAIN_SCHEDULE_MAX_ERRORS) return COMMAND_OUT_OF_RANGE;
+        state = HAL_EnterCritical(); // one consistent table
+        scheduleUpload = schedule;
+        HAL_ExitCritical(state);
+        scheduleUpload.goals = r->payload[1];
+        scheduleUpload.errors = r->payload[2];
+        out[1] = r->payload[1];
+        out[2] = r->payload[2];
+        *length = 3;
+        return COMMAND_OK;
+    case COMMAND_SCHEDULE_PUT:
+        if(r->length != 23) return COMMAND_BAD_LENGTH;
+        i = r->payload[1];
+        j = r->payload[2];
+        if(i >= scheduleUpload.goals || j >= scheduleUpload.errors) return COMMAND_BAD_ID;
+        scheduleUpload.goal[i] = Command_GetFloat(&r->payload[3]);
+        scheduleUpload.error[j] = Command_GetFloat(&r->payload[7]);
+        scheduleUpload.gains[i][j].kp = Command_GetFloat(&r->payload[11]);
+        scheduleUpload.gains[i][j].ki = Command_GetFloat(&r->payload[15]);
+        scheduleUpload.gains[i][j].kd = Command_GetFloat(&r->payload[19]);
+        out[1] = i;
+        out[2] = j;
+        *length = 3;
+        return COMMAND_OK;
+    case COMMAND_SCHEDULE_COMMIT:
+        if(r->length != 1) return COMMAND_BAD_LENGTH;
+        if(!Scheduled_SetTable(&scheduleUpload)) return COMMAND_OUT_OF_RANGE;
+        *length = 1;
+        return COMMAND_OK;
+    }
+    return COMMAND_BAD_ID;
+}
+
+//------------------commandRoom()---------------------------
+//Check the reply transmitter has room for a frame, the console always has
+static int commandRoom(uint32_t length){
+    return !consoleDMA || UARTTx_Free() >= length;
+}
+
+//------------------commandReply()---------------------------
+//Send a reply frame through the telemetry transmitter or the console
+//Input: frame, length
+//Output: None
+static void commandReply(const uint8_t *frame, uint32_t length){
+    uint32_t i;
+
+    if(consoleDMA){
+        // Whole frame or nothing, part of one would split the telemetry
+        // stream. The host times out and sends the request again
+        if(!commandRoom(length)){
+            repliesDropped++;
+            return;
+        }
+        UARTTx_Write(frame, length);
+        return;
+    }
+    for(i = 0; i < length; i++){
+        HAL_UARTCharPut(frame[i]);
+    }
+}
 
-    if(hardwareAverage > 0){
-        //Hardware Averaging
-        ADCHardwareOversampleConfigure(ADC0_BASE, hardwareAverage); //average n samples (can be 2,4,8,16,32 or 64)
+//------------------commandMonitor()---------------------------
+//Reply payload of the MONITOR command, a summary or a page of jitter bins
+//Input: page, reply payload out, reply length out
+//Output: Status
+static Command_Status commandMonitor(uint32_t page, uint8_t *out, uint32_t *length){
+    uint32_t first, n, i, state;
+    Monitor_State copy;
+
+    first = page ? (page - 1)*COMMAND_PAGE_BINS : 0;
+    if(first >= MONITOR_BINS) return COMMAND_OUT_OF_RANGE;
+    state = HAL_EnterCritical(); // one consistent set
+    copy = controllerMonitor;
+    HAL_ExitCritical(state);
+
+    out[0] = page;
+    if(page == 0){
+        Command_PutUint32(&out[1], copy.ticks);
+        Command_PutUint32(&out[5], copy.overruns);
+        Command_PutUint32(&out[9], copy.bucket);
+        Command_PutUint32(&out[13], copy.tripped);
+        Command_PutUint32(&out[17], (copy.ticks > 1) ? (uint32_t)copy.jitterMin : 0);
+        Command_PutUint32(&out[21], (copy.ticks > 1) ? (uint32_t)copy.jitterMax : 0);
+        Command_PutUint32(&out[25], copy.execMax);
+        *length = 29;
+        return COMMAND_OK;
     }
+    n = MONITOR_BINS - first;
+    if(n > COMMAND_PAGE_BINS) n = COMMAND_PAGE_BINS;
+    for(i = 0; i < n; i++){
+        Command_PutUint32(&out[1 + 4*i], copy.histogram[first + i]);
+    }
+    *length = 1 + 4*n;
+    return COMMAND_OK;
+}
+
+#if SLUG_PROFILE
+//------------------commandProfile()---------------------------
+//Reply payload of the PROFILE command, a summary or a page of latency bins
+//Input: handler, page, reply payload out, reply length out
+//Output: Status
+static Command_Status commandProfile(Profile_Id id, uint32_t page, uint8_t *out, uint32_t *length){
+    const Profile_Stats *p = Profile_Get(id);
+    uint32_t first, n, i, state;
+    Profile_Stats copy;
+
+    if(!p) return COMMAND_BAD_ID;
+    first = page ? (page - 1)*COMMAND_PAGE_BINS : 0;
+    if(first >= PROFILE_BINS) return COMMAND_OUT_OF_RANGE;
+    state = HAL_EnterCritical(); // one consistent set
+    copy = *p;
+    HAL_ExitCritical(state);
+
+    out[0] = id;
+    out[1] = page;
+    if(page == 0){
+        Command_PutUint32(&out[2], copy.count);
+        Command_PutUint32(&out[6], copy.count ? copy.min : 0);
+        Command_PutUint32(&out[10], copy.count ? (uint32_t)(copy.total/copy.count) : 0);
+        Command_PutUint32(&out[14], copy.max);
+        Command_PutUint32(&out[18], copy.period);
+        Command_PutUint32(&out[22], copy.latencyMax);
+        Command_PutUint32(&out[26], copy.missed);
+        *length = 30;
+        return COMMAND_OK;
+    }
+    n = PROFILE_BINS - first;
+    if(n > COMMAND_PAGE_BINS) n = COMMAND_PAGE_BINS;
+    for(i = 0; i < n; i++){
+        Command_PutUint32(&out[2 + 4*i], copy.histogram[first + i]);
+    }
+    *length = 2 + 4*n;
+    return COMMAND_OK;
+}
+#endif
+
+//------------------commandRun()---------------------------
+//Run one request
+//Input: request, reply payload out, reply length out
+//Output: Status
+static Command_Status commandRun(const Command_Request *r, uint8_t *out, uint32_t *length){
+    const char *name;
+    double value;
+    uint32_t n;
+
+    *length = 0;
+    switch(r->code & ~COMMAND_NO_REPLY){
+    case COMMAND_PING:
+        out[0] = COMMAND_VERSION;
+        *length = 1;
+        return COMMAND_OK;
+    case COMMAND_PARAM_COUNT:
+        out[0] = NUM_PARAMS;
+        *length = 1;
+        return COMMAND_OK;
+    case COMMAND_PARAM_NAME:
+        if(r->length != 1) return COMMAND_BAD_LENGTH;
+        name = Param_Name(r->payload[0]);
+        if(!name) return COMMAND_BAD_ID;
+        n = strlen(name);
+        if(n > COMMAND_MAX_PAYLOAD - 1) n = COMMAND_MAX_PAYLOAD - 1;
+        out[0] = r->payload[0];
+        memcpy(&out[1], name, n);
+        *length = 1 + n;
+        return COMMAND_OK;
+    case COMMAND_SET:
+        if(r->length != 5) return COMMAND_BAD_LENGTH;
+        if(r->payload[0] >= NUM_PARAMS) return COMMAND_BAD_ID;
+        if(!Param_Set(r->payload[0], Command_GetFloat(&r->payload[1]))) return COMMAND_OUT_OF_RANGE;
+        // reply with the value now set
+        // fall through
+    case COMMAND_GET:
+        // SET checked its own length
+        if((r->code & ~COMMAND_NO_REPLY) == COMMAND_GET && r->length != 1) return COMMAND_BAD_LENGTH;
+        if(!Param_Get(r->payload[0], &value)) return COMMAND_BAD_ID;
+        out[0] = r->payload[0];
+        Command_PutFloat(&out[1], (float)value);
+        *length = 5;
+        return COMMAND_OK;
+    case COMMAND_GOAL:
+        if(r->length != 4) return COMMAND_BAD_LENGTH;
+        value = Command_GetFloat(r->payload);
+        if(!(value >= 0 && value <= FC_ADC_VREF*FC_VOL2LOAD)) return COMMAND_OUT_OF_RANGE;
+        setGoalForce(value);
+        return COMMAND_OK;
+    case COMMAND_START:
+        Controller_Select(Controller_Active()); // restart the law from where the motor is
+        ControllerEnable();
+        return COMMAND_OK;
+    case COMMAND_STOP:
+        ControllerDisable();
+        return COMMAND_OK;
+    case COMMAND_LOGGER:
+        if(r->length != 1) return COMMAND_BAD_LENGTH;
+        Logger_Enable(r->payload[0]);
+        return COMMAND_OK;
+    case COMMAND_SELECT:
+        if(r->length != 1) return COMMAND_BAD_LENGTH;
+        if(!Controller_Select((Controller_Id)r->payload[0])) return COMMAND_BAD_ID;
+        return COMMAND_OK;
+    case COMMAND_MONITOR:
+        if(r->length != 1) return COMMAND_BAD_LENGTH;
+        return commandMonitor(r->payload[0], out, length);
+    case COMMAND_STORE:
+        if(r->length != 1) return COMMAND_BAD_LENGTH;
+        return commandStore(r->payload[0], out, length);
+    case COMMAND_SCHEDULE:
+        return commandSchedule(r, out, length);
+#if SLUG_PROFILE
+    case COMMAND_PROFILE:
+        if(r->length != 2) return COMMAND_BAD_LENGTH;
+        return commandProfile((Profile_Id)r->payload[0], r->payload[1], out, length);
+    case COMMAND_PROFILE_RESET:
+        Profile_Reset();
+        return COMMAND_OK;
+#endif
+    }
+    if(commandExtension){
+        return commandExtension(r, out, length);
+    }
+    return COMMAND_UNKNOWN;
+}
 
-    // Configure Sequencer, sample sequencer 1, processor triggered - 1 MSPS, highest priority
-    ADCSequenceConfigure(ADC0_BASE, 1, ADC_TRIGGER_PROCESSOR, 0);
+//------------------SerialMonitor_Dropped()---------------------------
+//Get the number of replies dropped because the telemetry transmitter had no
+//room even for a COMMAND_BUSY reply, the host timed out on them and sent the
+//request again
+//Input: None
+//Output: Dropped replies
+uint32_t SerialMonitor_Dropped(void){
+    return repliesDropped;
+}
 
-    // Configure interrupt flag to be set on last sample and notify that this is last sequence
-    ADCSequenceStepConfigure(ADC0_BASE, 1, 0, ADC_CTL_TS|ADC_CTL_IE|ADC_CTL_END);
+//------------------SerialMonitor_Receive()---------------------------
+//Run the commands received on UART0 (command.h) and reply, call from the
+//background loop
+//Input: None
+//Output: None
+void SerialMonitor_Receive(void){
+    Command_Request request;
+    Command_Status status;
+    uint8_t payload[COMMAND_MAX_PAYLOAD];
+    uint8_t frame[COMMAND_REPLY_SIZE(COMMAND_MAX_PAYLOAD)];
+    uint32_t length;
+
+    while(Command_Get(&request)){
+        if(!(request.code & COMMAND_NO_REPLY) && !commandRoom(COMMAND_REPLY_SIZE(COMMAND_MAX_PAYLOAD))){
+            // not run, so sending it again is safe for every command
+            status = COMMAND_BUSY;
+            length = 0;
+        }else{
+            status = commandRun(&request, payload, &length);
+        }
+        if(!(request.code & COMMAND_NO_REPLY)){
+            commandReply(frame, Command_EncodeReply(&request, status, payload, length, frame));
+        }
+    }
+}
 
-    //Enable ADC sequencer 1
-    ADCSequenceEnable(ADC0_BASE, 1);
+//------------------tempSensor_init()---------------------------
+//Initialize the Temperature Sensor on Board, processor triggered
+//Input: hardwareAverage (can be 2,4,8,16,32 or 64)
+//Output: None
+void tempSensor_Init(int hardwareAverage){
+    // Enable ADC0, Hardware Averaging (can be 2,4,8,16,32 or 64)
+    HAL_ADCInit(hardwareAverage);
 
-    // Interrupt enable
-    ADCIntClear(ADC0_BASE, 1);
-    ADCIntEnable(ADC0_BASE, 1);
-    IntEnable(INT_ADC0SS1);
+    // Configure Sequencer, sample sequencer 2 (1 is the load cell), processor triggered
+    // Interrupt flag is set on last sample
+    HAL_ADCSequenceInit(2, HAL_ADC_TRIGGER_PROCESSOR, HAL_ADC_TEMPSENSOR, tempSensor_handler);
 }
 
 //------------------tempSensor_handler()---------------------------
@@ -632,8 +1394,8 @@ void tempSensor_Init(int hardwareAverage){
 //Input: None
 //Output: None
 void tempSensor_handler(void){
-    ADCIntClear(ADC0_BASE, 1);
-    ADCSequenceDataGet(ADC0_BASE, 1, rawTemp);
+    HAL_ADCIntClear(2);
+    HAL_ADCDataGet(2, rawTemp);
 }
 
 //------------------getAvgTemp()---------------------------
@@ -649,7 +1411,7 @@ uint32_t getAvgTemp(){
 //Input: None
 //Output: None
 void tempSensor_startConversion(void){
-    ADCProcessorTrigger(ADC0_BASE, 1);
+    HAL_ADCProcessorTrigger(2);
 }
 
 //------------------convert2C()---------------------------
@@ -684,33 +1446,13 @@ uint32_t convert2F(uint32_t TempAvg){
 void Motor_Init(uint32_t PWMFreq){
 
     pwmPeriod = PWMclockFreq/PWMFreq;
-
-    /* PWM clock: systemClock/2 = 80/2 MHZ */
-    SysCtlPWMClockSet(SYSCTL_PWMDIV_2);
-
-    /*Enable Peripheral Direction pin*/
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOB)){}
-
-    /* Enable PWM*/
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_PWM1); // Module 1 for PF1
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_PWM1)){}
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF); //PF1
+    pwmPeriodCounts = (uint32_t)pwmPeriod;
 
     // Configure direction pin
-    GPIOPinTypeGPIOOutput(GPIO_PORTB_BASE, GPIO_PIN_7); //PB7
-
-    // Configure PWM pin
-    GPIOPinTypePWM(GPIO_PORTF_BASE,GPIO_PIN_1);
-    GPIOPinConfigure(GPIO_PF1_M1PWM5);
-
-    PWMGenConfigure(PWM1_BASE, PWM_GEN_2, PWM_GEN_MODE_DOWN);
-    PWMGenPeriodSet(PWM1_BASE, PWM_GEN_2, (int)pwmPeriod);
+    HAL_GPIOInitOutput(HAL_PIN_MOTOR_DIR); //PB7
 
-    // Enable the PWM generator
-    PWMPulseWidthSet(PWM1_BASE, PWM_OUT_5, 0); //Turn OFF
-    PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT, false);
-    PWMGenEnable(PWM1_BASE, PWM_GEN_2);
+    // PWM clock: systemClock/2 = 80/2 MHZ, M1PWM5 on PF1, output turned OFF
+    HAL_PWMInit(pwmPeriodCounts);
 
 }
 
@@ -720,7 +1462,7 @@ void Motor_Init(uint32_t PWMFreq){
 //Output: None
 void Motor_SetDuty(uint32_t dutyCycle){
     pwmDuty = convert2PWMDuty(dutyCycle);
-    PWMPulseWidthSet(PWM1_BASE, PWM_OUT_5, pwmDuty);
+    HAL_PWMSetPulseWidth(pwmDuty);
 }
 
 
@@ -736,25 +1478,26 @@ double convert2PWMDuty(uint32_t dutyCycle){
 //------------------motorSendCommand()---------------------------
 //Sends the final commands to the motor driver
 // If duty cycle is 0, motor stops
+// Called every controller tick, pulse width is computed in integer
 //Input: duty cycle, direction
 //Output: None
 void motorSendCommand(uint32_t dutyCycle, int direction){
-    double dutyCycleApplied = convert2PWMDuty(dutyCycle);
+    uint32_t dutyCycleApplied = (dutyCycle*pwmPeriodCounts)/100;
     setglobals4Motor(dutyCycle, direction);
 
     if(direction == 0){
         clearDirection();
-        PWMPulseWidthSet(PWM1_BASE, PWM_OUT_5, dutyCycleApplied);
+        HAL_PWMSetPulseWidth(dutyCycleApplied);
     }else{
         setDirection();
-        PWMPulseWidthSet(PWM1_BASE, PWM_OUT_5, dutyCycleApplied);
+        HAL_PWMSetPulseWidth(dutyCycleApplied);
     }
 
     if(dutyCycle == 0){
-        PWMPulseWidthSet(PWM1_BASE, PWM_OUT_5, dutyCycleApplied);
-        PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT, false);
+        HAL_PWMSetPulseWidth(dutyCycleApplied);
+        HAL_PWMOutputEnable(false);
     }else{
-        PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT, true);
+        HAL_PWMOutputEnable(true);
     }
 
 }
@@ -772,7 +1515,7 @@ double getMotorPWMPeriod(void){
 //Input: None
 //Output: None
 void setDirection(){
-    GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_7, GPIO_PIN_7);
+    HAL_GPIOWrite(HAL_PIN_MOTOR_DIR, true);
 }
 
 //------------------clearDirection()---------------------------
@@ -780,7 +1523,7 @@ void setDirection(){
 //Input: None
 //Output: None
 void clearDirection(){
-    GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_7, ~(GPIO_PIN_7));
+    HAL_GPIOWrite(HAL_PIN_MOTOR_DIR, false);
 }
 
 //------------------enableMotor()---------------------------
@@ -789,7 +1532,7 @@ void clearDirection(){
 //Output: None
 void enableMotor(){
     // Turn off the Output pins
-     PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT, true);
+     HAL_PWMOutputEnable(true);
 }
 
 //------------------disableMotor()---------------------------
@@ -798,7 +1541,7 @@ void enableMotor(){
 //Output: None
 void disableMotor(){
     // Turn off the Output pins
-     PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT, false);
+     HAL_PWMOutputEnable(false);
 }
 
 //------------------setglobals4Motor()---------------------------
@@ -848,47 +1591,51 @@ void checkLimits(double duty){
 // ********************************************************
 // ****************** Load cell **************************
 // ********************************************************
+static void sensorsStart(HAL_ADCTrigger trigger);
+
 //------------------LoadCell_init()---------------------------
 //Initialize the Load Cell input on Board
-// Load Cell connected to PE3, ADC0, seq 3
-//Input: None
+// Load Cell connected to PE3, converted with the other sensors (Sensors_Init)
+//Input: Hardware averaging, ADCsampleFreq sets the timer trigger freq
 //Output: None
 void LoadCell_init(int hardwareAveraging, int ADCsampleFreq){
+    Sensors_Init(hardwareAveraging, ADCsampleFreq);
+}
 
-    //Enable Peripherals
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
-    SysCtlDelay(2);
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
-    SysCtlDelay(2);
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
-    SysCtlDelay(2);
+//------------------LoadCell_initBlock()---------------------------
+//Initialize the Load Cell input with uDMA block sampling
+// Load Cell connected to PE3, ADC0, seq 1. Samples are moved by the uDMA
+// into ping-pong buffers of DECIMATOR_RATE samples, one interrupt per block
+// runs the CIC decimator (decimator.c)
+//Input: Hardware averaging, ADCsampleFreq sets the timer trigger freq, the
+//       load cell value updates at ADCsampleFreq/DECIMATOR_RATE
+//Output: None
+void LoadCell_initBlock(int hardwareAveraging, int ADCsampleFreq){
 
-    // Configure PE3 as ADC input
-    GPIOPinTypeADC(GPIO_PORTE_BASE, GPIO_PIN_3);
+    //ADC0, Average n readings
+    HAL_ADCInit(hardwareAveraging);
 
-    //ADC0
-    if(hardwareAveraging > 0){
-        ADCHardwareOversampleConfigure(ADC0_BASE, hardwareAveraging); //Average n readings
-    }
-    //ADCReferenceSet(ADC0_BASE, ADC_REF_INT);
-    ADCSequenceConfigure(ADC0_BASE, 1, ADC_TRIGGER_TIMER, 0); //Base, Seq Num, Trigger source, Priority
-    ADCSequenceStepConfigure(ADC0_BASE, 1, 0, ADC_CTL_CH0|ADC_CTL_IE|ADC_CTL_END); // Base, Seq Num, Step, Config
+    // Start the filter at mid scale, it settles after DECIMATOR_ORDER blocks
+    Decimator_Init(&loadCellDecimator, 2048);
+    loadCellFine = 2048 << DECIMATOR_FRAC_BITS;
+    loadCellValue[0] = 2048;
+    loadCellPendingFine = loadCellFine;
+    loadCellBlocks = 0;
+    loadCellBlockMode = 1;
 
-    //Config: produce interrupt when step is complete
-    ADCSequenceEnable(ADC0_BASE, 1); // Enable sequencer 3
+    // All sensors, Seq 0, started by the block handler so the snapshot holds
+    // the block that just finished
+    sensorsStart(HAL_ADC_TRIGGER_PROCESSOR);
 
-    // Interrupt enable
-    ADCIntClear(ADC0_BASE, 1);
-    ADCIntEnable(ADC0_BASE, 1);
-    IntEnable(INT_ADC0SS1);
+    // PE3 as ADC input, Seq 1, timer triggered, uDMA ping-pong
+    HAL_ADCDMAInit(1, HAL_ADC_LOADCELL, loadCellBlock[0], loadCellBlock[1], DECIMATOR_RATE, LoadCellBlockIntHandler);
 
     //Timer0
     // It acts as the trigger source
-    TimerConfigure(TIMER0_BASE, TIMER_CFG_PERIODIC);
-    samplePeriod = SysCtlClockGet()/ADCsampleFreq;
-    TimerLoadSet(TIMER0_BASE, TIMER_A, samplePeriod-1);
-    TimerControlTrigger(TIMER0_BASE, TIMER_A, true);
-    TimerEnable(TIMER0_BASE, TIMER_A);
+    samplePeriod = HAL_ClockGet()/ADCsampleFreq;
+    HAL_TimerInitADCTrigger(HAL_TIMER0, samplePeriod);
+    Profile_SetPeriod(PROFILE_LOADCELL, samplePeriod*DECIMATOR_RATE);
+    Profile_SetPeriod(PROFILE_SENSORS, samplePeriod*DECIMATOR_RATE);
 }
 
 //------------------getLoadCellValue()---------------------------
@@ -899,17 +1646,26 @@ uint32_t getLoadCellValue(){
     return loadCellValue[0];
 }
 
+//------------------getLoadCellFine()---------------------------
+//Get Load Cell Value with the fractional bits of the decimator
+//Input: None
+//Output: Load Cell value in ADC units*2^DECIMATOR_FRAC_BITS
+int32_t getLoadCellFine(){
+    if(loadCellBlockMode){
+        return loadCellFine;
+    }
+    return (int32_t)(loadCellValue[0] << DECIMATOR_FRAC_BITS);
+}
+
 //------------------measuredLoad()---------------------------
 //Get Load Cell Value
 //Input: None
-//Output: Load Cell value in pounds
+//Output: Load Cell value in pounds, negative below the tare
 double measuredLoad(void){
-    uint32_t loadADC;
-    double OutputLoad;
+    int32_t fine;
 
-    loadADC = getLoadCellValue();
-    OutputLoad = Vol2Load(adc2Vol(loadADC));
-    return OutputLoad;
+    fine = Calib_Apply(&calib, (uint32_t)getLoadCellFine(), chipTempValue);
+    return fine*(FC_LOAD_PER_COUNT/(1 << CALIB_FRAC_BITS));
 }
 
 //------------------getLoadCellValue()---------------------------
@@ -934,73 +1690,608 @@ double Vol2Load(double vol){
 //Interrupts
 // Timer 0A is being used to trigger load cell ADC
 void LoadCellTrigger(void){
-    TimerIntClear(ADC0_BASE, 1);
-    TimerIntClear(ADC0_BASE, 3);
+    HAL_TimerIntClear(HAL_TIMER0);
 }
 
 // Handler for ADC Load cell
 void LoadCellIntHandler(void){
-    ADCIntClear(ADC0_BASE, 1);
+    PROFILE_ENTER(PROFILE_LOADCELL);
+    HAL_ADCIntClear(1);
    // while(!ADCIntStauts(ADC0_BASE, 3, false)){}
-    ADCSequenceDataGet(ADC0_BASE, 1, loadCellValue);
+    HAL_ADCDataGet(1, loadCellValue);
+    PROFILE_EXIT(PROFILE_LOADCELL);
+}
+
+// Handler for the uDMA load cell blocks, one call per DECIMATOR_RATE samples
+// The decimated value is published by SensorsIntHandler() with the other sensors
+void LoadCellBlockIntHandler(void){
+    uint32_t done;
+    int b;
+
+    PROFILE_ENTER(PROFILE_LOADCELL);
+    done = HAL_ADCDMAService();
+    for(b = 0; b < 2; b++){
+        if(done & (b ? HAL_ADC_DMA_PONG : HAL_ADC_DMA_PING)){
+            loadCellPendingFine = Decimator_Block(&loadCellDecimator, loadCellBlock[b]);
+            Telemetry_LogBlock(loadCellBlocks, loadCellBlock[b]);
+            loadCellBlocks++;
+        }
+    }
+    if(done){
+        HAL_ADCProcessorTrigger(SENSORS_SEQUENCE);
+    }
+    PROFILE_EXIT(PROFILE_LOADCELL);
+}
+
+// ********************************************************
+// ******************** Sensors **************************
+// ********************************************************
+//------------------sensorsStart()---------------------------
+//Configure the sensor sequence from the channel table
+//Input: Trigger, timer (Sensors_Init) or processor (block mode)
+//Output: None
+static void sensorsStart(HAL_ADCTrigger trigger){
+    HAL_ADCChannel channels[NUM_SENSORS];
+    int i;
+
+    for(i = 0; i < NUM_SENSORS; i++){
+        channels[i] = sensorTable[i].channel;
+    }
+    memset(sensorsBuffer, 0, sizeof(sensorsBuffer));
+    sensorsCount = 0;
+    SensorsQueue_Init(&sensorsQueue);
+    sensorsDropped = 0;
+    HAL_ADCSequenceStepsInit(SENSORS_SEQUENCE, trigger, channels, NUM_SENSORS, SensorsIntHandler);
+}
+
+//------------------Sensors_Init()---------------------------
+//Convert every sensor in one sequence triggered by Timer0, one interrupt
+//per period publishes the snapshot and the load cell value
+//Input: Hardware averaging, ADCsampleFreq sets the timer trigger freq
+//Output: None
+void Sensors_Init(int hardwareAveraging, int ADCsampleFreq){
+
+    //ADC0, Average n readings
+    HAL_ADCInit(hardwareAveraging);
+    loadCellBlockMode = 0;
+
+    // All channels of sensorTable, Seq 0, timer triggered, interrupt after the last step
+    sensorsStart(HAL_ADC_TRIGGER_TIMER);
+
+    //Timer0
+    // It acts as the trigger source
+    samplePeriod = HAL_ClockGet()/ADCsampleFreq;
+    HAL_TimerInitADCTrigger(HAL_TIMER0, samplePeriod);
+    Profile_SetPeriod(PROFILE_SENSORS, samplePeriod);
+}
+
+//------------------SensorsIntHandler()---------------------------
+//Scale the samples of one sequence and publish them. The snapshot is written
+//into the buffer that is not published, then the count switches buffers
+//Input: None
+//Output: None
+void SensorsIntHandler(void){
+    uint32_t samples[HAL_ADC_MAX_STEPS];
+    uint32_t n = sensorsCount;
+    Sensors_Snapshot *snapshot = &sensorsBuffer[(n + 1) & 1];
+    int i;
+
+    PROFILE_ENTER(PROFILE_SENSORS);
+    HAL_ADCIntClear(SENSORS_SEQUENCE);
+    if(HAL_ADCDataGet(SENSORS_SEQUENCE, samples) < NUM_SENSORS){
+        PROFILE_EXIT(PROFILE_SENSORS);
+        return;
+    }
+
+    for(i = 0; i < NUM_SENSORS; i++){
+        snapshot->raw[i] = (uint16_t)samples[i];
+        snapshot->value[i] = sensorTable[i].gain*samples[i] + sensorTable[i].offset;
+    }
+    snapshot->loadFine = (int32_t)(samples[SENSOR_LOADCELL] << DECIMATOR_FRAC_BITS);
+
+    // In block mode the load cell is the decimated value of the last block
+    if(loadCellBlockMode){
+        loadCellFine = loadCellPendingFine;
+        snapshot->loadFine = loadCellPendingFine;
+        snapshot->raw[SENSOR_LOADCELL] = (loadCellPendingFine + (1 << (DECIMATOR_FRAC_BITS - 1))) >> DECIMATOR_FRAC_BITS;
+        snapshot->value[SENSOR_LOADCELL] = sensorTable[SENSOR_LOADCELL].gain*loadCellPendingFine*(1.0f/(1 << DECIMATOR_FRAC_BITS))
+                                           + sensorTable[SENSOR_LOADCELL].offset;
+    }
+    loadCellValue[0] = snapshot->raw[SENSOR_LOADCELL];
+    chipTempValue = snapshot->raw[SENSOR_CHIP_TEMP];
+
+    snapshot->tick = globalControllerTick;
+    snapshot->count = n + 1;
+    sensorsCount = n + 1;
+
+    // Every snapshot also goes to the controller
+    if(!SensorsQueue_Push(&sensorsQueue, snapshot)){
+        sensorsDropped++;
+    }
+    PROFILE_EXIT(PROFILE_SENSORS);
+}
+
+//------------------Sensors_Read()---------------------------
+//Copy the latest snapshot. A copy interrupted by a new snapshot is taken again
+//Input: Snapshot to fill
+//Output: None
+void Sensors_Read(Sensors_Snapshot *snapshot){
+    uint32_t n;
+    do{
+        n = sensorsCount;
+        *snapshot = sensorsBuffer[n & 1];
+    }while(n != sensorsCount);
+}
+
+//------------------Sensors_Channel()---------------------------
+//Get the name, units and scaling of a sensor
+//Input: Sensor
+//Output: Channel description, 0 for an unknown sensor
+const Sensor_Channel *Sensors_Channel(Sensor_Id id){
+    if((uint32_t)id >= NUM_SENSORS){
+        return 0;
+    }
+    return &sensorTable[id];
+}
+
+//------------------Sensors_Dropped()---------------------------
+//Get number of snapshots the controller did not take in time
+//Input: None
+//Output: Dropped snapshots
+uint32_t Sensors_Dropped(void){
+    return sensorsDropped;
 }
 
 // ********************************************************
 // ****************** Controller **************************
 // ********************************************************
 //------------------Force control loop --------------------
+static int32_t pidStep(void);
+static int32_t adaptiveStep(void);
+static int32_t swingStep(void);
+static void pidInit(void);
+static void pidReset(void);
+static void adaptiveInit(void);
+static void swingInit(void);
+static int32_t cascadeStep(void);
+static void cascadeInit(void);
+static void cascadeReset(void);
+static int32_t scheduledStep(void);
+static void scheduledInit(void);
+static void scheduledReset(void);
+static int32_t identStep(void);
+static void identInit(void);
+static int32_t tuneStep(void);
+static void tuneInit(void);
+static void sendSignedDuty(int32_t duty);
+static void controllerTakeSensors(void);
+static void trajectoryStep(void);
+static void safeStopStep(void);
+static void controllerSwitch(Controller_Id id);
+static void encoderStart(uint32_t freq);
+
+// Controller strategies, indexed by Controller_Id
+static const Controller_Strategy controllerTable[NUM_CONTROLLERS] = {
+//   name         init           reset           step           log                            output
+    {"PID",       pidInit,       pidReset,       pidStep,       logger_PID_ForceControl,       &PID_OUT},
+    {"Adaptive",  adaptiveInit,  adaptiveInit,   adaptiveStep,  logger_Adaptive_ForceControl,  &MRAC_OUT},
+    {"Swing",     swingInit,     swingInit,      swingStep,     print_loadCell,                &SWING_OUT},
+    {"Cascade",   cascadeInit,   cascadeReset,   cascadeStep,   logger_Cascade,                &CASCADE_OUT},
+    {"Scheduled", scheduledInit, scheduledReset, scheduledStep, logger_Scheduled,              &SCHEDULED_OUT},
+    {"Ident",     identInit,     identInit,      identStep,     logger_Ident,                  &IDENT_OUT},
+    {"Tune",      tuneInit,      tuneInit,       tuneStep,      logger_Tune,                   &TUNE_OUT},
+};
+
 //------------------Controller_Init()---------------------------
-//Initializes a timer routine for the controller
+//Initializes a timer routine for the controller, loads the gains of every
+//strategy and selects the adaptive controller
 //Input: None
 //Output: None
 void Controller_Init(uint32_t Controllerfreq){
+    Controller_InitTick(Controllerfreq, ControllerIntHandler);
+}
+
+//------------------Controller_InitTick()---------------------------
+//Controller_Init() with another Timer1 handler, which must clear the timer
+//and lead to one ControllerIntHandler() call per period (an RTOS posting the
+//control law to a software interrupt)
+//Input: Controller Frequency, Timer1 handler
+//Output: None
+void Controller_InitTick(uint32_t Controllerfreq, HAL_Handler tick){
 
         uint32_t periods; // Timer delays
-        TOTAL_ERROR = 0;
+        int i;
         setGoalFlag(0);
 
         setGlobalControllerFreq(Controllerfreq);
         setGlobalControllerTicks(0);
 
-        //Configure Timer
-        SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
-        // wait for timer module 1 to be ready
-        while(!SysCtlPeripheralReady(SYSCTL_PERIPH_TIMER1))
-            {
-            }
-
-        TimerConfigure(TIMER1_BASE, TIMER_CFG_PERIODIC);
-
-        // set timer 1 to run off of system clock
-       // TimerClockSourceSet(TIMER1_BASE, TIMER_CLOCK_SYSTEM);
+        // Reset control laws
+        for(i = 0; i < NUM_CONTROLLERS; i++){
+            controllerTable[i].init();
+            controllerCost[i].last = 0;
+            controllerCost[i].max = 0;
+            controllerCost[i].count = 0;
+            controllerCost[i].total = 0;
+        }
+        activeController = &controllerTable[CONTROLLER_ADAPTIVE];
+        bumpOffset = 0;
+        bumpArm = 0;
+        Sensors_Read(&controllerSensors);
+        controllerRaw = calibPound(getLoadCellFine());
+        controllerLoad = controllerRaw;
+        Kalman_Design(&kalman.model, 1.0/Controllerfreq, kalmanQ, kalmanQo, kalmanR);
+        Kalman_Reset(&kalman);
+        kalmanWarm = (uint32_t)(KALMAN_WARMUP_TIME*Controllerfreq);
+        if(encoderEnabled){
+            encoderStart(Controllerfreq);
+        }
 
         // Define period
-        periods = (SysCtlClockGet()/Controllerfreq);
+        periods = (HAL_ClockGet()/Controllerfreq);
         //periods = (clockFreq/Controllerfreq);
-        TimerLoadSet(TIMER1_BASE, TIMER_A, periods-1);
 
-        // register the timer interrupt service routine
-        TimerIntRegister(TIMER1_BASE, TIMER_A, *ControllerIntHandler);
+        //Configure Timer 1 and register the timer interrupt service routine
+        //Timer is started by ControllerEnable()
+        HAL_TimerInitPeriodic(HAL_TIMER1, periods, tick);
+        Profile_SetPeriod(PROFILE_CONTROLLER, periods);
 
-        // clear rollover interrupt and then enable it
-        TimerIntClear(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
-        TimerIntEnable(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
-
-        IntEnable(INT_TIMER1A);
+        // Deadline monitor, armed again by ControllerEnable()
+        Monitor_Init(&controllerMonitor, periods, (uint32_t)overrunLimit, (uint32_t)(MONITOR_LEAK_TIME*Controllerfreq));
+        safeStopDiv = (uint32_t)(SAFE_STOP_TIME*Controllerfreq/100);
+        if(safeStopDiv == 0){
+            safeStopDiv = 1;
+        }
+        safeStopCount = 0;
 }
 
 //------------------ControllerIntHandler()---------------------------
-//Interrupt handler for the controller
+//Interrupt handler for the controller, runs the selected strategy. Once the
+//deadline monitor tripped it only ramps the motor down (safe stop)
 //Input: None
 //Output: None
 void ControllerIntHandler(void){
-    TimerIntClear(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
+    const Controller_Strategy *c = activeController;
+    Controller_Cost *cost = &controllerCost[c - controllerTable];
+    uint32_t start, cycles;
+    int32_t duty;
+
+    PROFILE_ENTER(PROFILE_CONTROLLER);
+    Monitor_Entry(&controllerMonitor, HAL_CycleCount());
+    HAL_TimerIntClear(HAL_TIMER1);
+    if(controllerMonitor.tripped || safeStopping){
+        safeStopStep();
+        PROFILE_EXIT(PROFILE_CONTROLLER);
+        return;
+    }
+    start = HAL_TimerValueGet(HAL_TIMER1);
+    setGlobalControllerTicks(getGlobalControllerTicks()+1);
+    controllerTakeSensors();
+    trajectoryStep();
+
+    duty = c->step()*256;
+    if(controllerHandover < NUM_CONTROLLERS){
+        controllerSwitch((Controller_Id)controllerHandover);
+        controllerHandover = NUM_CONTROLLERS;
+    }
+
+    // Bumpless transfer: the first tick after a switch loads the offset that
+    // continues the previous output, then the offset decays to 0. The decay
+    // rounds half away from 0 for either sign, the last 1/8 % is dropped
+    bumpOffset += bumpArm*(bumpHeld - duty - bumpOffset);
+    bumpArm = 0;
+    duty += bumpOffset;
+    if(bumpOffset > -(1 << BUMPLESS_SHIFT) && bumpOffset < (1 << BUMPLESS_SHIFT)){
+        bumpOffset = 0;
+    }else{
+        bumpOffset -= (bumpOffset + ((bumpOffset < 0) ? -(1 << (BUMPLESS_SHIFT - 1)) : (1 << (BUMPLESS_SHIFT - 1))))/(1 << BUMPLESS_SHIFT);
+    }
+
+    sendSignedDuty((duty + 128) >> 8);
+    logTelemetry(*c->out);
+
+    // Timer1 counts down
+    cycles = start - HAL_TimerValueGet(HAL_TIMER1);
+    cost->last = cycles;
+    if(cycles > cost->max){
+        cost->max = cycles;
+    }
+    cost->total += cycles;
+    cost->count++;
+    Monitor_Exit(&controllerMonitor, HAL_CycleCount());
+    PROFILE_EXIT(PROFILE_CONTROLLER);
+}
+
+//------------------safeStopStep()---------------------------
+//One tick of the safe stop: lower the duty by 1 % every safeStopDiv ticks
+//with motorSendCommand(), stop the controller timer at 0
+//Input: None
+//Output: None
+static void safeStopStep(void){
+    uint32_t duty = globalDutyCycle;
+
+    if(++safeStopCount >= safeStopDiv){
+        safeStopCount = 0;
+        if(duty){
+            duty--;
+        }
+    }
+    motorSendCommand(duty, globalDirection);
+    if(duty == 0){
+        HAL_TimerDisable(HAL_TIMER1);
+    }
+}
+
+//------------------Controller_Select()---------------------------
+//Switch to another controller strategy at runtime. The new strategy starts
+//from its reset state and its output is blended from the current duty
+//Input: Controller
+//Output: 1 if selected, 0 for an unknown controller
+int Controller_Select(Controller_Id id){
+    uint32_t state;
+
+    if((uint32_t)id >= NUM_CONTROLLERS){
+        return 0;
+    }
+    state = HAL_EnterCritical();
+    controllerSwitch(id);
+    HAL_ExitCritical(state);
+    return 1;
+}
+
+//------------------controllerSwitch()---------------------------
+//Reset a strategy and make it the selected one, blended from the current
+//duty. Runs with the controller interrupt masked or from it
+static void controllerSwitch(Controller_Id id){
+    bumpHeld = (globalDirection ? (int32_t)globalDutyCycle : -(int32_t)globalDutyCycle)*256;
+    controllerTable[id].reset();
+    activeController = &controllerTable[id];
+    bumpArm = 1;
+}
+
+//------------------controllerReload()---------------------------
+//Run the init hook of a strategy again to load new gains. When it is the
+//selected one the output is carried over as in Controller_Select()
+static void controllerReload(Controller_Id id){
+    uint32_t state;
+
+    if(globalControllerFreq == 0){
+        return; // Controller_Init() runs every init
+    }
+    state = HAL_EnterCritical();
+    if(activeController == &controllerTable[id]){
+        bumpHeld = (globalDirection ? (int32_t)globalDutyCycle : -(int32_t)globalDutyCycle)*256;
+        bumpArm = 1;
+    }
+    controllerTable[id].init();
+    HAL_ExitCritical(state);
+}
 
-    // feed forward leg swing
-    //PID_control();
+//------------------applyGoal()---------------------------
+//Parameter hook of the goal force
+static void applyGoal(void){
+    setGoalForce(goalPos);
+}
 
-    Adaptive_control();
+//------------------applyPID()---------------------------
+//Parameter hook of the PID gains
+static void applyPID(void){
+    controllerReload(CONTROLLER_PID);
+}
 
+//------------------applyAdaptive()---------------------------
+//Parameter hook of the adaptation gains
+static void applyAdaptive(void){
+    controllerReload(CONTROLLER_ADAPTIVE);
+}
+
+//------------------Controller_Active()---------------------------
+//Get the selected controller strategy
+//Input: None
+//Output: Controller
+Controller_Id Controller_Active(void){
+    return (Controller_Id)(activeController - controllerTable);
+}
+
+//------------------Controller_Get()---------------------------
+//Get a controller strategy, e.g. for its name
+//Input: Controller
+//Output: Strategy, 0 for an unknown controller
+const Controller_Strategy *Controller_Get(Controller_Id id){
+    if((uint32_t)id >= NUM_CONTROLLERS){
+        return 0;
+    }
+    return &controllerTable[id];
+}
+
+//------------------Controller_GetCost()---------------------------
+//Get the measured step cost of a controller strategy (interrupt entry to
+//motor command and telemetry), in system clock cycles
+//Input: Controller
+//Output: Cost, 0 for an unknown controller
+const Controller_Cost *Controller_GetCost(Controller_Id id){
+    if((uint32_t)id >= NUM_CONTROLLERS){
+        return 0;
+    }
+    return &controllerCost[id];
+}
+
+//------------------Controller_GetMonitor()---------------------------
+//Get the deadline monitor of the controller tick
+//Input: None
+//Output: Monitor
+const Monitor_State *Controller_GetMonitor(void){
+    return &controllerMonitor;
+}
+
+//------------------Controller_SetOverrunLimit()---------------------------
+//Set how many overruns trip the safe stop
+//Input: Overruns in the bucket, controller ticks for it to lose one
+//Output: None
+void Controller_SetOverrunLimit(uint32_t overruns, uint32_t leakTicks){
+    uint32_t state = HAL_EnterCritical();
+    Monitor_SetLimit(&controllerMonitor, overruns, leakTicks);
+    HAL_ExitCritical(state);
+    overrunLimit = (int32_t)controllerMonitor.limit;
+}
+
+//------------------applyMonitor()---------------------------
+//Load the overrun limit, keep the leak time
+static void applyMonitor(void){
+    Controller_SetOverrunLimit((uint32_t)overrunLimit, controllerMonitor.leak);
+}
+
+//------------------Controller_Sensors()---------------------------
+//Get the sensor snapshot of the current tick, for the strategy hooks
+//Input: None
+//Output: Snapshot
+const Sensors_Snapshot *Controller_Sensors(void){
+    return &controllerSensors;
+}
+
+//------------------Controller_SetLoad()---------------------------
+//Set the load cell value the strategies use until the next sensor snapshot,
+//to replay a capture tick by tick (Host Tools/replay.c)
+//Input: Load cell ADC value
+//Output: None
+void Controller_SetLoad(uint32_t loadADC){
+    controllerRaw = FC_LOAD_Q16(loadADC);
+    controllerLoad = controllerRaw;
+}
+
+//------------------calibPound()---------------------------
+//Convert a calibrated load cell reading (counts*2^CALIB_FRAC_BITS) to pound
+//in Q16.16, the fraction of the decimator is kept
+static int32_t calibPound(int32_t fine){
+    return (int32_t)(((int64_t)fine*FC_LOAD_PER_COUNT_Q32) >> (16 + CALIB_FRAC_BITS));
+}
+
+//------------------controllerPound()---------------------------
+//Load used by this tick in pound, for the float strategies
+static float controllerPound(void){
+    return (float)controllerLoad*(1.0f/FC_Q16_ONE);
+}
+
+//------------------controllerTakeSensors()---------------------------
+//Take the snapshots queued since the last tick, the newest one is used by
+//the strategies (controllerLoad), older ones are skipped. Update the
+//encoder estimate and the Kalman filter of the load
+//Input: None
+//Output: None
+static void controllerTakeSensors(void){
+    const Sensors_Snapshot *s;
+    float load;
+
+    if(encoderEnabled){
+        Encoder_Update(&encoder, HAL_QEIPositionGet(), HAL_QEIVelocityGet(), HAL_QEIDirectionGet());
+    }
+
+    while((s = SensorsQueue_Peek(&sensorsQueue)) != 0){
+        if(SensorsQueue_Count(&sensorsQueue) == 1){
+            controllerSensors = *s;
+            controllerRaw = calibPound(Calib_Apply(&calib, (uint32_t)s->loadFine, s->raw[SENSOR_CHIP_TEMP]));
+        }
+        SensorsQueue_Release(&sensorsQueue);
+    }
+
+    controllerLoad = controllerRaw;
+    if(kalmanOn){
+        load = Kalman_Step(&kalman, (float)controllerRaw*(1.0f/FC_Q16_ONE),
+                           globalDirection ? (float)globalDutyCycle : -(float)globalDutyCycle);
+        if(kalmanWarm){
+            kalmanWarm--;
+        }else{
+            controllerLoad = (int32_t)(load*(float)FC_Q16_ONE);
+        }
+    }
+}
+
+//------------------applyKalmanUse()---------------------------
+//Parameter hook of kalman, a word the tick reads in one load. Turning it
+//on primes the filter at the next reading and starts the warm up
+static void applyKalmanUse(void){
+    uint32_t state;
+
+    state = HAL_EnterCritical();
+    if(kalmanUse != 0 && !kalmanOn){
+        Kalman_Reset(&kalman);
+        kalmanWarm = (uint32_t)(KALMAN_WARMUP_TIME*globalControllerFreq);
+    }
+    kalmanOn = (kalmanUse != 0);
+    HAL_ExitCritical(state);
+}
+
+//------------------applyKalman()---------------------------
+//Parameter hook of the Kalman filter, the new gain takes over from the
+//current state
+static void applyKalman(void){
+    Kalman_Model model;
+    uint32_t state;
+
+    if(globalControllerFreq == 0){
+        return; // Controller_Init() designs it
+    }
+    Kalman_Design(&model, 1.0/globalControllerFreq, kalmanQ, kalmanQo, kalmanR);
+    state = HAL_EnterCritical();
+    kalman.model = model;
+    HAL_ExitCritical(state);
+}
+
+//------------------applyCalib()---------------------------
+//Parameter hook of the load cell calibration, rebuilds the table
+static void applyCalib(void){
+    Calib_Table t;
+    uint32_t state;
+
+    Calib_Set(&t, calPoint, FC_LOAD_PER_COUNT, calSpan, calOffset, calTempRef,
+              sensorTable[SENSOR_CHIP_TEMP].gain, sensorTable[SENSOR_CHIP_TEMP].offset, calTare);
+    state = HAL_EnterCritical();
+    calib = t;
+    HAL_ExitCritical(state);
+}
+
+//------------------applyTare()---------------------------
+//Parameter hook of tare, the current calibrated load becomes cal_tare
+static void applyTare(void){
+    if(tareCapture != 0){
+        calTare = 0;
+        applyCalib();
+        calTare = measuredLoad();
+        tareCapture = 0;
+    }
+    applyCalib();
+}
+
+//------------------applyCalLog()---------------------------
+//Parameter hook of cal_log, a word the logger reads in one load
+static void applyCalLog(void){
+    calLogOn = (calLog != 0);
+}
+
+//------------------Controller_Kalman()---------------------------
+//Get the Kalman filter of the load
+//Input: None
+//Output: Filter, its estimate of this tick in load (lb)
+const Kalman_Filter *Controller_Kalman(void){
+    return &kalman;
+}
+
+//------------------sendSignedDuty()---------------------------
+//Send a signed duty cycle to the motor, positive sets the direction pin
+//Input: Duty in percent, limited to +-100
+//Output: None
+static void sendSignedDuty(int32_t duty){
+    if(duty > 100){
+        duty = 100;
+    }
+    if(duty < -100){
+        duty = -100;
+    }
+    if(duty < 0){
+        motorSendCommand(-duty, 0);
+    }else{
+        motorSendCommand(duty, 1);
+    }
 }
 
 //------------------setGlobalControllerFreq()---------------------------
@@ -1035,52 +2326,103 @@ uint32_t getGlobalControllerTicks(){
     return globalControllerTick;
 }
 
-//------------------Swing_control()---------------------------
-//Implement simple feedforward swing motion on leg
-//Input: None
-//Output: None
-void Swing_control(void){
+//------------------swingInit()---------------------------
+//Swing strategy init and reset hook
+static void swingInit(void){
+    swingloopCount = 0;
+    swingDir = 1;
+}
+
+//------------------swingStep()---------------------------
+//Swing strategy step hook, feedforward only
+//Output: Signed duty in percent
+static int32_t swingStep(void){
     swingloopCount++;
     if(swingloopCount > 3000){
         swingDir = !swingDir;
         swingloopCount = 0;
         RGBled_Toggle(0, 0, 1);
     }
-    motorSendCommand(swingDuty, swingDir);
+    SWING_OUT = swingDir ? FC_NUM(swingDuty) : -FC_NUM(swingDuty);
+    return swingDir ? swingDuty : -swingDuty;
 }
 
-//------------------PID_conrol()---------------------------
-//PID control function
+//------------------Swing_control()---------------------------
+//Implement simple feedforward swing motion on leg
 //Input: None
 //Output: None
-void PID_control(void){
+void Swing_control(void){
+    sendSignedDuty(swingStep());
+}
+
+//------------------pidInit()---------------------------
+//PID strategy init hook, loads the gains
+static void pidInit(void){
+    FC_PIDInit(&pidState, Kbar, Ki, Kd, MinSteadyError, MaxSteadyError);
+    FC_PIDSetGoal(&pidState, goalPos);
+}
+
+//------------------pidReset()---------------------------
+//PID strategy reset hook, clears the integral and derivative state
+static void pidReset(void){
+    pidState.lastError = 0;
+    pidState.totalError = 0;
+    setGoalFlag(0);
+}
+
+//------------------pidStep()---------------------------
+//PID strategy step hook
+//Output: Signed duty in percent
+static int32_t pidStep(void){
     //check if goal reached
     if(~getGoalFlag()){
 
-        //calculate error
-        ERROR = (getGoalForce() - measuredLoad());
+        //calculate error and output
+        FC_PIDStep(&pidState, controllerLoad);
+        ERROR = pidState.error;
 
         //Goal reaching criteria
-        if(ERROR < 0.05){
+        if(ERROR < FC_NUM(0.05)){
             setGoalFlag(1);
             RGBled_Set(0, 1, 0); //turn on Blue
         }
 
-            Kp = Kbar*abs(ERROR);
-            P = Kp*ERROR;
+        PID_OUT = pidState.out;
+        return pidState.direction ? (int32_t)pidState.duty : -(int32_t)pidState.duty;
+    }
+    PID_OUT = 0;
+    return 0;
+}
 
-            D = Kd*(ERROR-LAST_ERROR);
-            LAST_ERROR = ERROR;
+//------------------PID_conrol()---------------------------
+//PID control function
+//Input: None
+//Output: None
+void PID_control(void){
+    setGlobalControllerTicks(getGlobalControllerTicks()+1);
+    controllerTakeSensors();
+    trajectoryStep();
+    sendSignedDuty(pidStep());
+    logTelemetry(PID_OUT);
+}
 
-            TOTAL_ERROR = TOTAL_ERROR + ERROR;
-            TOTAL_ERROR = checkIntegralLimit(TOTAL_ERROR);
-            I = Ki*TOTAL_ERROR;
+//------------------adaptiveInit()---------------------------
+//Adaptive strategy init and reset hook, loads the gains and restarts the
+//reference model
+static void adaptiveInit(void){
+    FC_MRACInit(&mracState, gamma_x, gamma_r, globalControllerFreq);
+    FC_MRACSetGoal(&mracState, goalPos);
+}
 
-            PID_OUT = P + D + I;
-    }else{
-        PID_OUT = 0;
-    }
-    checkLimits(PID_OUT);
+//------------------adaptiveStep()---------------------------
+//Adaptive strategy step hook
+//Output: Signed duty in percent
+static int32_t adaptiveStep(void){
+    // Reference model, theta update and output
+    FC_MRACStep(&mracState, controllerLoad);
+    ERROR = mracState.error;
+    MRAC_OUT = mracState.out;
+    return mracState.direction ? (int32_t)mracState.duty : -(int32_t)mracState.duty;
 }
 
 //------------------Adaptive_control()---------------------------
@@ -1088,42 +2430,447 @@ void PID_control(void){
 //Input: None
 //Output: None
 void Adaptive_control(){
-    //double ref_sys, time, delta_t, x_ref, x;
-    uint32_t controllerfrequency;
-
-    controllerfrequency = getGlobalControllerFreq();
     setGlobalControllerTicks(getGlobalControllerTicks()+1);
+    controllerTakeSensors();
+    trajectoryStep();
+    sendSignedDuty(adaptiveStep());
+    logTelemetry(MRAC_OUT);
+}
+
+//------------------cascadeInit()---------------------------
+//Cascade strategy init hook, loads the gains and the default loop rates
+static void cascadeInit(void){
+    cascade.velocityDiv = CASCADE_VELOCITY_DIV;
+    cascade.positionDiv = CASCADE_POSITION_DIV;
+    cascadeGains();
+    cascadeReset();
+}
+
+//------------------cascadeGains()---------------------------
+//Load the cascade gains, the loops run on from where they are
+static void cascadeGains(void){
+    uint32_t state = HAL_EnterCritical();
+    cascade.kpos = (float)Kpos;
+    cascade.kvel = (float)Kvel;
+    cascade.kivel = (float)KiVel;
+    cascade.kpforce = (float)KpForce;
+    cascade.kiforce = (float)KiForce;
+    HAL_ExitCritical(state);
+}
+
+//------------------cascadeReset()---------------------------
+//Cascade strategy reset hook: hold the joint where it is with the load it
+//has now, clear the integrals
+static void cascadeReset(void){
+    cascade.velocityDt = (float)cascade.velocityDiv/(float)globalControllerFreq;
+    cascade.forceDt = 1.0f/(float)globalControllerFreq;
+    // Position loop on the first tick, velocity loop on the second, so the
+    // two never share a tick while positionDiv is a multiple of velocityDiv
+    cascade.positionCount = cascade.positionDiv - 1;
+    cascade.velocityCount = (cascade.velocityDiv > 1) ? cascade.velocityDiv - 2 : 0;
+    cascade.positionGoal = encoder.position;
+    cascade.velocityFeedforward = 0;
+    cascade.velocityGoal = 0;
+    cascade.forceBias = controllerPound();
+    cascade.integral = 0;
+    cascade.forceGoal = cascade.forceBias;
+    cascade.forceIntegral = 0;
+}
+
+//------------------cascadeStep()---------------------------
+//Cascade strategy step hook. The force loop runs every tick, the velocity
+//and position loops only on their ticks and hand their goal to the next loop
+//in. Without the encoder the force goal stays where it was
+//Output: Signed duty in percent
+static int32_t cascadeStep(void){
+    float error, force, duty;
+
+    if(encoderEnabled){
+        // Position loop, velocity goal
+        if(++cascade.positionCount >= cascade.positionDiv){
+            cascade.positionCount = 0;
+            error = (float)(cascade.positionGoal - encoder.position)*(1.0f/(1 << ENCODER_FRAC_BITS));
+            cascade.velocityGoal = cascade.kpos*error + cascade.velocityFeedforward;
+            if(cascade.velocityGoal > CASCADE_VELOCITY_MAX) cascade.velocityGoal = CASCADE_VELOCITY_MAX;
+            if(cascade.velocityGoal < -CASCADE_VELOCITY_MAX) cascade.velocityGoal = -CASCADE_VELOCITY_MAX;
+        }
 
-    delta_t = getControllerTimePeriod(controllerfrequency);
+        // Velocity loop, force goal. The integral stops while the force goal
+        // is limited, so it cannot wind up
+        if(++cascade.velocityCount >= cascade.velocityDiv){
+            cascade.velocityCount = 0;
+            error = cascade.velocityGoal - (float)encoder.velocity*(1.0f/(1 << ENCODER_FRAC_BITS));
+            force = cascade.forceBias + cascade.integral + cascade.kvel*error;
+            if(force > CASCADE_FORCE_MAX){
+                force = CASCADE_FORCE_MAX;
+            }else if(force < CASCADE_FORCE_MIN){
+                force = CASCADE_FORCE_MIN;
+            }else{
+                cascade.integral += cascade.kivel*cascade.velocityDt*error;
+            }
+            cascade.forceGoal = force;
+        }
+    }
 
-    time = GetSystemTime(getGlobalControllerTicks(), delta_t); //in ms
+    // Force loop, same anti-windup at the duty limits
+    error = cascade.forceGoal - controllerPound();
+    duty = cascade.forceIntegral + cascade.kpforce*error;
+    if(duty > (float)FC_MAX_DUTY){
+        duty = (float)FC_MAX_DUTY;
+    }else if(duty < -(float)FC_MAX_DUTY){
+        duty = -(float)FC_MAX_DUTY;
+    }else{
+        cascade.forceIntegral += cascade.kiforce*cascade.forceDt*error;
+    }
+    ERROR = FC_NUM(error);
+    CASCADE_OUT = FC_NUM(duty);
+    return (int32_t)(duty + ((duty < 0) ? -0.5f : 0.5f));
+}
 
-    // Ref system output
-    ref_sys = exp(-5.0*time)*delta_t;
-    x_ref = ref_sys*getGoalForce();
+//------------------Cascade_SetGoal()---------------------------
+//Set the joint position goal of the cascade strategy
+//Input: Position in counts*2^ENCODER_FRAC_BITS (getIncEncoderPositionFine()),
+//       velocity feedforward in counts/s*2^ENCODER_FRAC_BITS
+//Output: None
+void Cascade_SetGoal(int32_t position, int32_t velocity){
+    uint32_t state = HAL_EnterCritical();
+    cascade.positionGoal = position;
+    cascade.velocityFeedforward = (float)velocity*(1.0f/(1 << ENCODER_FRAC_BITS));
+    HAL_ExitCritical(state);
+}
+
+//------------------Cascade_SetRates()---------------------------
+//Set how often the outer loops of the cascade strategy run, in controller
+//ticks. positionDiv should be a multiple of velocityDiv so the two loops
+//never run in the same tick
+//Input: Velocity loop divider, position loop divider
+//Output: 1 if set, 0 for a divider of 0
+int Cascade_SetRates(uint32_t velocityDiv, uint32_t positionDiv){
+    uint32_t state;
+
+    if(velocityDiv == 0 || positionDiv == 0){
+        return 0;
+    }
+    state = HAL_EnterCritical();
+    cascade.velocityDiv = velocityDiv;
+    cascade.positionDiv = positionDiv;
+    cascade.velocityDt = (float)velocityDiv/(float)globalControllerFreq;
+    cascade.positionCount = positionDiv - 1;
+    cascade.velocityCount = (velocityDiv > 1) ? velocityDiv - 2 : 0;
+    HAL_ExitCritical(state);
+    return 1;
+}
+
+//------------------scheduledInit()---------------------------
+//Scheduled PID strategy init hook, loads the default gain schedule unless
+//one was set, from the EEPROM, the host or the relay tuning
+static void scheduledInit(void){
+    if(schedule.goals == 0){
+        GainSchedule_Default(&schedule);
+    }
+    scheduled.goal = (float)goalPos;
+    scheduled.dt = 1.0f/(float)globalControllerFreq;
+    scheduled.filterStep = scheduled.dt/(SCHEDULED_DERIVATIVE_TAU + scheduled.dt);
+    scheduled.deadBand = (float)deadBand;
+    scheduledReset();
+}
+
+//------------------scheduledIntegralLimit()---------------------------
+//Clamp the integral of the scheduled PID to +-SCHEDULED_INTEGRAL_LIMIT
+static float scheduledIntegralLimit(float integral){
+    if(integral > SCHEDULED_INTEGRAL_LIMIT){
+        return SCHEDULED_INTEGRAL_LIMIT;
+    }
+    if(integral < -SCHEDULED_INTEGRAL_LIMIT){
+        return -SCHEDULED_INTEGRAL_LIMIT;
+    }
+    return integral;
+}
 
-    //Plant output
-    x = measuredLoad();
+//------------------scheduledReset()---------------------------
+//Scheduled PID strategy reset hook, starts the integral from the seed (0
+//unless the relay tuning hands over) and the derivative from the current load
+static void scheduledReset(void){
+    scheduled.integral = scheduled.seed;
+    scheduled.seed = 0;
+    scheduled.lastLoad = controllerPound();
+    scheduled.rate = 0;
+}
 
-    //Error
-    ERROR = x - x_ref;
+//------------------scheduledStep()---------------------------
+//Scheduled PID strategy step hook
+//Output: Signed duty in percent
+static int32_t scheduledStep(void){
+    float load, error, magnitude, duty;
 
-    //Theta update
-    theta_x = -gamma_x*ERROR*x*Sgn(MRAC_OUT);
-    theta_r = -gamma_r*ERROR*getGoalForce()*Sgn(MRAC_OUT);
+    load = controllerPound();
+    error = scheduled.goal - load;
+    magnitude = (error < 0) ? -error : error;
+    GainSchedule_Lookup(&schedule, scheduled.goal, magnitude, &scheduled.gains);
 
-    theta_x_final = (theta_x - theta_x_prev)/delta_t;
-    theta_r_final = (theta_r - theta_r_prev)/delta_t;
+    // Derivative on measurement, filtered
+    scheduled.rate += scheduled.filterStep*((load - scheduled.lastLoad)/scheduled.dt - scheduled.rate);
+    scheduled.lastLoad = load;
 
-    theta_x_prev = theta_x;
-    theta_r_prev = theta_r;
+    if(magnitude < scheduled.deadBand){
+        error = 0;
+    }
+    duty = scheduled.integral + scheduled.gains.kp*error - scheduled.gains.kd*scheduled.rate;
+    if(duty > (float)FC_MAX_DUTY){
+        duty = (float)FC_MAX_DUTY;
+    }else if(duty < -(float)FC_MAX_DUTY){
+        duty = -(float)FC_MAX_DUTY;
+    }else{
+        scheduled.integral = scheduledIntegralLimit(scheduled.integral + scheduled.gains.ki*scheduled.dt*error);
+    }
+    ERROR = FC_NUM(error);
+    SCHEDULED_OUT = FC_NUM(duty);
+    return (int32_t)(duty + ((duty < 0) ? -0.5f : 0.5f));
+}
+
+//------------------Scheduled_SetTable()---------------------------
+//Replace the gain schedule of the scheduled PID strategy
+//Input: table
+//Output: 1 if set, 0 if GainSchedule_Check() rejects it
+int Scheduled_SetTable(const GainSchedule_Table *table){
+    uint32_t state;
+
+    if(!GainSchedule_Check(table)){
+        return 0;
+    }
+    state = HAL_EnterCritical();
+    schedule = *table;
+    HAL_ExitCritical(state);
+    return 1;
+}
+
+//------------------Scheduled_GetTable()---------------------------
+//Get the gain schedule of the scheduled PID strategy
+//Input: None
+//Output: table
+const GainSchedule_Table *Scheduled_GetTable(void){
+    return &schedule;
+}
+
+//------------------Scheduled_SetDeadband()---------------------------
+//Set the deadband of the scheduled PID, the tick reads a float copy
+//Input: Deadband in lb, negative is taken as 0
+//Output: None
+void Scheduled_SetDeadband(double lb){
+    deadBand = (lb > 0) ? lb : 0;
+    scheduled.deadBand = (float)deadBand;
+}
+
+//------------------applyDeadband()---------------------------
+//Parameter hook of the scheduled PID deadband
+static void applyDeadband(void){
+    Scheduled_SetDeadband(deadBand);
+}
+
+//------------------identInit()---------------------------
+//Identification strategy init and reset hook, restarts the excitation
+static void identInit(void){
+    Ident_Init(&ident, (Ident_Kind)identKind, (float)identAmplitude, (float)identBias, (float)identF0,
+               (float)identF1, (float)identTime, globalControllerFreq);
+    IDENT_OUT = 0;
+}
+
+//------------------identStep()---------------------------
+//Identification strategy step hook, open loop
+//Output: Signed duty in percent
+static int32_t identStep(void){
+    float duty = Ident_Step(&ident);
+
+    if(duty > (float)FC_MAX_DUTY){
+        duty = (float)FC_MAX_DUTY;
+    }else if(duty < -(float)FC_MAX_DUTY){
+        duty = -(float)FC_MAX_DUTY;
+    }
+    ERROR = FC_NUM(0);
+    IDENT_OUT = FC_NUM(duty);
+    return (int32_t)(duty + ((duty < 0) ? -0.5f : 0.5f));
+}
+
+//------------------applyIdent()---------------------------
+//Parameter hook of the excitation, restarts it when it is running
+static void applyIdent(void){
+    controllerReload(CONTROLLER_IDENT);
+}
+
+//------------------Ident_Running()---------------------------
+//Tell if the identification strategy is selected and still exciting
+//Input: None
+//Output: 1 while the excitation runs, 0 otherwise
+int Ident_Running(void){
+    return activeController == &controllerTable[CONTROLLER_IDENT] && !Ident_Done(&ident);
+}
+
+//------------------tuneInit()---------------------------
+//Relay tuning strategy init and reset hook, starts a run from the current
+//duty
+static void tuneInit(void){
+    float bias = globalDirection ? (float)globalDutyCycle : -(float)globalDutyCycle;
+
+    Autotune_Init(&tune, (float)goalPos, (float)tuneAmplitude, (float)tuneHysteresis, (float)tuneRange, bias,
+                  (uint32_t)tuneCycles, (float)tuneTime, globalControllerFreq);
+    tuneRun++;
+    tuneApplied = 0;
+    tuneComputed = 0;
+    tuneHold = 0;
+    tuneReported = 0;
+    TUNE_OUT = FC_NUM(bias);
+}
+
+//------------------tuneStep()---------------------------
+//Relay tuning strategy step hook. Once the run is over the bias is held
+//until Tune_Background() computed the result and it is printed, then the
+//scheduled PID takes over after this tick (controllerHandover), or the
+//motor ramps down from the next tick when the run failed (safeStopping)
+//Output: Signed duty in percent
+static int32_t tuneStep(void){
+    float load = controllerPound();
+    float duty = Autotune_Step(&tune, load);
+
+    ERROR = FC_NUM(tune.goal - load);
+    TUNE_OUT = FC_NUM(duty);
+    if(tune.status != AUTOTUNE_RUNNING && tuneComputed){
+        if(tuneReported || ++tuneHold > (uint32_t)(TUNE_REPORT_TIME*globalControllerFreq)){
+            if(tuneApplied){
+                scheduled.goal = tune.goal;
+                scheduled.seed = scheduledIntegralLimit(duty);
+                controllerHandover = CONTROLLER_SCHEDULED;
+            }else{
+                safeStopCount = 0;
+                safeStopping = 1;
+            }
+        }
+    }
+    return (int32_t)(duty + ((duty < 0) ? -0.5f : 0.5f));
+}
+
+//------------------Tune_Background()---------------------------
+//Compute the result of a finished relay tuning and put the gains in the
+//schedule row nearest the goal, call from the background loop
+//Input: None
+//Output: None
+void Tune_Background(void){
+    static GainSchedule_Table t; // off the 512 byte stack
+    Autotune_State s;
+    Autotune_Gains gains = {0, 0, 0};
+    GainSchedule_Gains *row, old;
+    uint32_t run, state, i, j;
+    int applied;
+
+    if(tuneComputed || tune.status == AUTOTUNE_RUNNING){
+        return;
+    }
+    state = HAL_EnterCritical(); // one consistent run
+    s = tune;
+    run = tuneRun;
+    t = schedule;
+    HAL_ExitCritical(state);
+
+    applied = Autotune_Compute(&s, (Autotune_Rule)tuneRule, &gains);
+    if(applied){
+        for(i = 0; i + 1 < t.goals && t.goal[i + 1] - s.goal < s.goal - t.goal[i]; i++){
+        }
+        row = t.gains[i];
+        old = row[0];
+        for(j = 0; j < t.errors; j++){
+            row[j].kp = (old.kp > 0) ? row[j].kp*gains.kp/old.kp : gains.kp;
+            row[j].ki = (old.ki > 0) ? row[j].ki*gains.ki/old.ki : gains.ki;
+            row[j].kd = (old.kd > 0) ? row[j].kd*gains.kd/old.kd : gains.kd;
+        }
+        applied = Scheduled_SetTable(&t);
+    }
+
+    state = HAL_EnterCritical();
+    if(run == tuneRun){ // not restarted meanwhile
+        tuneGains = gains;
+        tuneApplied = applied;
+        tuneComputed = 1;
+    }
+    HAL_ExitCritical(state);
+}
+
+//------------------applyTune()---------------------------
+//Parameter hook of the relay tuning, restarts a running tuning
+static void applyTune(void){
+    controllerReload(CONTROLLER_TUNE);
+}
+
+//------------------Tune_Get()---------------------------
+//Get the state of the last relay tuning and the gains it gave
+//Input: gains out, filled when the run was done
+//Output: Relay state
+const Autotune_State *Tune_Get(Autotune_Gains *gains){
+    if(gains){
+        *gains = tuneGains;
+    }
+    return &tune;
+}
 
-    // Calculate output
-    MRAC_OUT = theta_x_final*x + theta_r_final*getGoalForce();
+//------------------trajectoryStep()---------------------------
+//Advance the gait table by one tick and hand its point to the controllers
+//Input: None
+//Output: None
+static void trajectoryStep(void){
+    fc_num_t goal;
+
+    if(!trajectoryRunning){
+        return;
+    }
+    Gait_Step(&trajectory);
+    if(trajectory.table->kind == GAIT_POSITION){
+        cascade.positionGoal = trajectory.value;
+        cascade.velocityFeedforward = (float)trajectory.rate*(1.0f/(1 << GAIT_POSITION_FRAC_BITS));
+    }else{
+        goal = FC_FROM_Q16(trajectory.value);
+        pidState.goal = goal;
+        mracState.goal = goal;
+        scheduled.goal = (float)trajectory.value*(1.0f/(1 << GAIT_FORCE_FRAC_BITS));
+    }
+}
 
-    // Send output
-    checkLimits(MRAC_OUT);
+//------------------Trajectory_Start()---------------------------
+//Play a gait table as the goal of the controller, from phase 0
+//Input: table (gait.h), cadence in mHz
+//Output: None
+void Trajectory_Start(const Gait_Table *table, uint32_t milliHz){
+    uint32_t state = HAL_EnterCritical();
+    Gait_Init(&trajectory, table, globalControllerFreq);
+    Gait_SetCadence(&trajectory, milliHz);
+    trajectoryRunning = 1;
+    HAL_ExitCritical(state);
+}
 
+//------------------Trajectory_SetCadence()---------------------------
+//Change the cadence of the playing table
+//Input: cadence in mHz
+//Output: None
+void Trajectory_SetCadence(uint32_t milliHz){
+    uint32_t state = HAL_EnterCritical();
+    Gait_SetCadence(&trajectory, milliHz);
+    HAL_ExitCritical(state);
+}
+
+//------------------Trajectory_Stop()---------------------------
+//Stop playing, the goal stays at the last point
+//Input: None
+//Output: None
+void Trajectory_Stop(void){
+    trajectoryRunning = 0;
+    if(trajectory.table && trajectory.table->kind == GAIT_FORCE){
+        setGoalForce((double)trajectory.value/(1 << GAIT_FORCE_FRAC_BITS));
+    }
+}
+
+//------------------Trajectory_Get()---------------------------
+//Get the player state
+//Input: None
+//Output: Player
+const Gait_Player *Trajectory_Get(void){
+    return &trajectory;
 }
 
 //------------------getControllerTimePeriod()---------------------------
@@ -1153,8 +2900,26 @@ double GetSystemTime(uint32_t controllerTick, double delta_t){
 //Input: None
 //Output: None
 void ControllerEnable(){
+    uint32_t state;
+
+    // Start from the next snapshot, not from those queued before
+    SensorsQueue_Flush(&sensorsQueue);
+    // The time stopped is no overrun, and a safe stop is cleared
+    state = HAL_EnterCritical();
+    Monitor_Arm(&controllerMonitor);
+    safeStopping = 0;
+    HAL_ExitCritical(state);
     //Enable Timer
-    TimerEnable(TIMER1_BASE, TIMER_A);
+    HAL_TimerEnable(HAL_TIMER1);
+}
+
+//------------------ControllerDisable()---------------------------
+//Stop the controller timer and the motor
+//Input: None
+//Output: None
+void ControllerDisable(void){
+    HAL_TimerDisable(HAL_TIMER1);
+    motorSendCommand(0, 1);
 }
 
 //------------------Sgn()---------------------------
@@ -1183,10 +2948,10 @@ double checkIntegralLimit(double e){
 
 //------------------deadBandCheck()---------------------------
 //Dead Band for PID loop
-//Input: None
+//Input: Error
 //Output: flag of whether goal reached or not
 uint32_t deadBandCheck(double error){
-    if (abs(error)<DEADBAND){
+    if (error<deadBand && error>-deadBand){
         return 1;
     }else{
         return 0;
@@ -1215,6 +2980,9 @@ void setGoalFlag(uint32_t g){
 //Output: None
 void setGoalForce(double ref){
     goalPos = ref;
+    FC_PIDSetGoal(&pidState, ref);
+    FC_MRACSetGoal(&mracState, ref);
+    scheduled.goal = (float)ref;
 }
 
 //------------------getGoalForce()---------------------------
@@ -1230,7 +2998,7 @@ double getGoalForce(void){
 //Input: None
 //Output: Kp
 double getKp(void){
-    return Kp;
+    return FC_TO_DOUBLE(pidState.Kp);
 }
 
 
@@ -1239,7 +3007,7 @@ double getKp(void){
 //Input: None
 //Output: Error
 double getError(void){
-    return ERROR;
+    return FC_TO_DOUBLE(ERROR);
 }
 
 //------------------getPIDoutput()---------------------------
@@ -1247,7 +3015,7 @@ double getError(void){
 //Input: None
 //Output: out
 double getPIDoutput(void){
-    return PID_OUT;
+    return FC_TO_DOUBLE(PID_OUT);
 }
 
 //------------------getMRACoutput()---------------------------
@@ -1255,7 +3023,7 @@ double getPIDoutput(void){
 //Input: None
 //Output: out
 double getMRACoutput(void){
-    return MRAC_OUT;
+    return FC_TO_DOUBLE(MRAC_OUT);
 }
 
 
@@ -1314,24 +3082,11 @@ UARTprintf("%d.%2d, %d.%2d, %d.%2d \n", intload, fracload, intPWM, fracPWM, intE
 //Output: None
 void addADC_Init(int hardwareAveraging, int ADCsampleFreq){
 
-    // Configure PE3 as ADC input
-    GPIOPinTypeADC(GPIO_PORTE_BASE, GPIO_PIN_2);
-
-    //ADC0
-    if(hardwareAveraging > 0){
-        ADCHardwareOversampleConfigure(ADC0_BASE, hardwareAveraging); //Average n readings
-    }
-    //ADCReferenceSet(ADC0_BASE, ADC_REF_INT);
-    ADCSequenceConfigure(ADC0_BASE, 3, ADC_TRIGGER_TIMER, 0); //Base, Seq Num, Trigger source, Priority
-    ADCSequenceStepConfigure(ADC0_BASE, 3, 0, ADC_CTL_CH1|ADC_CTL_IE|ADC_CTL_END); // Base, Seq Num, Step, Config
-
-    //Config: produce interrupt when step is complete
-    ADCSequenceEnable(ADC0_BASE, 3); // Enable sequencer 3
+    //ADC0, Average n readings
+    HAL_ADCInit(hardwareAveraging);
 
-    // Interrupt enable
-    ADCIntClear(ADC0_BASE, 3);
-    ADCIntEnable(ADC0_BASE, 3);
-    IntEnable(INT_ADC0SS3);
+    // PE2 as ADC input, Seq 3, timer triggered, produce interrupt when step is complete
+    HAL_ADCSequenceInit(3, HAL_ADC_TRIGGER_TIMER, HAL_ADC_ADDITIONAL, addADCIntHandler);
 
     //Timer0
 //    // It acts as the trigger source
@@ -1345,9 +3100,9 @@ void addADC_Init(int hardwareAveraging, int ADCsampleFreq){
 
 
 void addADCIntHandler(){
-    ADCIntClear(ADC0_BASE, 3);
+    HAL_ADCIntClear(3);
    // while(!ADCIntStauts(ADC0_BASE, 3, false)){}
-    ADCSequenceDataGet(ADC0_BASE, 3, ADCValue);
+    HAL_ADCDataGet(3, ADCValue);
 }
 
 uint32_t getaddADCVal(){
@@ -1429,52 +3184,166 @@ void logger_Adaptive_ForceControl(void){
     UARTprintf("%d.%2d, %d.%2d, %d.%2d \n", intload, fracload, intPWM, fracPWM, intErr, fracErr);
 }
 
-//------------------IncEncoder_Init()---------------------------
-//Initialize Incremental Encoder
+//------------------loadCenti()---------------------------
+//measuredLoad() in 0.01 lb for the text loggers, as a sign and a magnitude
+//so a load below the tare prints as -0.50, not 0.-50
+static int32_t loadCenti(const char **sign){
+    int32_t load = (int32_t)(measuredLoad()*100.0);
+
+    *sign = (load < 0) ? "-" : "";
+    return (load < 0) ? -load : load;
+}
+
+//------------------logger_Cascade()---------------------------
+//Logger function for the cascade strategy: position goal and position in
+//counts, velocity goal and velocity in counts/s, force goal and load in lb
 //Input: None
 //Output: None
-void IncEncoder_Init(uint32_t topLimit, uint32_t startVal){
-    // Enable QEI 1 Peripherals
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOC);
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_QEI1);
+void logger_Cascade(void){
+    int32_t forceGoal, load;
+    const char *sign;
 
-    //Set ChA and ChB
-    GPIOPinConfigure(GPIO_PC5_PHA1);
-    GPIOPinConfigure(GPIO_PC6_PHB1);
+    forceGoal = (int32_t)(cascade.forceGoal*100.0f);
+    load = loadCenti(&sign);
+    UARTprintf("%d, %d, %d, %d, %d.%02d, %s%d.%02d\n",
+               cascade.positionGoal >> ENCODER_FRAC_BITS, encoder.position >> ENCODER_FRAC_BITS,
+               (int32_t)cascade.velocityGoal, encoder.velocity >> ENCODER_FRAC_BITS,
+               forceGoal/100, forceGoal%100, sign, load/100, load%100);
+}
 
-    //Set GPIO pins for QEI
-    GPIOPinTypeQEI(GPIO_PORTC_BASE, GPIO_PIN_5 |  GPIO_PIN_6);
+//------------------logger_Scheduled()---------------------------
+//Logger function for the scheduled PID strategy: goal and load in lb,
+//scheduled Kp in 0.001 percent/lb, duty in percent
+//Input: None
+//Output: None
+void logger_Scheduled(void){
+    int32_t goal, load, kp, duty;
+    const char *sign;
 
-    //Disable peripheral during configuration
-    QEIDisable(QEI1_BASE);
-    QEIIntDisable(QEI1_BASE,QEI_INTERROR | QEI_INTDIR | QEI_INTTIMER | QEI_INTINDEX); //diablabe all siurces of interrupts
+    goal = (int32_t)(scheduled.goal*100.0f);
+    load = loadCenti(&sign);
+    kp = (int32_t)(scheduled.gains.kp*1000.0f);
+    duty = (int32_t)FC_TO_DOUBLE(SCHEDULED_OUT);
+    UARTprintf("%d.%02d, %s%d.%02d, %d, %d\n", goal/100, goal%100, sign, load/100, load%100, kp, duty);
+}
 
-    // Configure quadrature encoder, set top limit
-    QEIConfigure(QEI1_BASE, (QEI_CONFIG_CAPTURE_A_B  | QEI_CONFIG_NO_RESET  | QEI_CONFIG_QUADRATURE | QEI_CONFIG_NO_SWAP), topLimit);
+//------------------logger_Ident()---------------------------
+//Logger function for the identification strategy: load in lb, duty in
+//percent
+//Input: None
+//Output: None
+void logger_Ident(void){
+    int32_t load, duty;
+    const char *sign;
 
-    // Enable
-    QEIEnable(QEI1_BASE);
+    load = loadCenti(&sign);
+    duty = (int32_t)FC_TO_DOUBLE(IDENT_OUT);
+    UARTprintf("%s%d.%02d, %d\n", sign, load/100, load%100, duty);
+}
 
-    //Set position to the required start value
-    QEIPositionSet(QEI1_BASE, startVal);
+//------------------logger_Calibration()---------------------------
+//Logger function of the calibration log (cal_log): load cell reading in
+//counts*2^DECIMATOR_FRAC_BITS, chip temperature in C, calibrated load in lb
+//Input: None
+//Output: None
+void logger_Calibration(void){
+    int32_t temp, load;
+    const char *sign;
+
+    temp = (int32_t)((sensorTable[SENSOR_CHIP_TEMP].gain*chipTempValue + sensorTable[SENSOR_CHIP_TEMP].offset)*100.0f);
+    load = loadCenti(&sign);
+    UARTprintf("%d, %d.%02d, %s%d.%02d\n", getLoadCellFine(), temp/100, temp%100, sign, load/100, load%100);
+}
+
+//------------------logger_Tune()---------------------------
+//Logger function for the relay tuning strategy: goal and load in lb, duty in
+//percent and the cycle while it runs, then one line with the result:
+//status, Ku in percent/lb, Tu in ms, oscillation in lb, and the kp, ki and kd
+//that went to the schedule
+//Input: None
+//Output: None
+void logger_Tune(void){
+    static const char *const status[] = {"running", "done", "timeout", "overload", "no oscillation"};
+    int32_t goal, load, duty, ku, a, kp, ki, kd;
+    const char *sign;
+
+    if(tune.status == AUTOTUNE_RUNNING){
+        goal = (int32_t)(tune.goal*100.0f);
+        load = loadCenti(&sign);
+        duty = (int32_t)FC_TO_DOUBLE(TUNE_OUT);
+        UARTprintf("%d.%02d, %s%d.%02d, %d, %d\n", goal/100, goal%100, sign, load/100, load%100, duty, tune.cycle);
+        return;
+    }
+    if(tuneReported || !tuneComputed){
+        return;
+    }
+    ku = (int32_t)(tune.ku*100.0f);
+    a = (int32_t)(tune.oscillation*100.0f);
+    kp = (int32_t)(tuneGains.kp*1000.0f);
+    ki = (int32_t)(tuneGains.ki*100.0f);
+    kd = (int32_t)(tuneGains.kd*1000.0f);
+    UARTprintf("tune %s, Ku %d.%02d, Tu %d ms, a %d.%02d lb", status[tune.status], ku/100, ku%100,
+               (int32_t)(tune.tu*1000.0f), a/100, a%100);
+    if(tuneApplied){
+        UARTprintf(", kp %d.%03d, ki %d.%02d, kd %d.%03d", kp/1000, kp%1000, ki/100, ki%100, kd/1000, kd%1000);
+    }
+    UARTprintf("\n");
+    tuneReported = 1;
+}
+
+//------------------encoderStart()---------------------------
+//Start the velocity timer and the estimator at the controller rate
+//Input: Controller frequency
+//Output: None
+static void encoderStart(uint32_t freq){
+    HAL_QEIVelocityInit(HAL_ClockGet()/freq);
+    Encoder_Init(&encoder, HAL_QEIPositionGet(), encoder.top, freq, freq);
+    encoderEnabled = 1;
+}
+
+//------------------IncEncoder_Init()---------------------------
+//Initialize Incremental Encoder
+// The velocity timer counts edges over one controller period, the estimator
+// runs at every controller tick (controllerTakeSensors). Controller_Init()
+// restarts both if it changes the rate
+//Input: Maximum position, start position
+//Output: None
+void IncEncoder_Init(uint32_t topLimit, uint32_t startVal){
+    // QEI 1 on PC5 (ChA) and PC6 (ChB), quadrature, no reset, no interrupts
+    // Set top limit and position to the required start value
+    HAL_QEIInit(topLimit, startVal);
+    encoder.top = topLimit;
+    encoderStart(globalControllerFreq ? globalControllerFreq : ENCODER_DEFAULT_FREQ);
 }
 
 //------------------getIncEncoderPosition()---------------------------
 //Get position from Incremental encoder
 //Input: None
-//Output: None
+//Output: Position in counts
 uint32_t getIncEncoderPosition(void){
-    return QEIPositionGet(QEI1_BASE);
+    return HAL_QEIPositionGet();
+}
+
+//------------------getIncEncoderPositionFine()---------------------------
+//Get the estimated position at the last controller tick
+//Input: None
+//Output: Position in counts*2^ENCODER_FRAC_BITS
+int32_t getIncEncoderPositionFine(void){
+    return encoder.position;
 }
 
 //------------------getIncEncoderVelocity()---------------------------
-//Get velocity from Incremental encoder
+//Get velocity from Incremental encoder, estimated at the last controller tick
 //Input: None
-//Output: None
-uint32_t getIncEncoderVelocity(void);
+//Output: Velocity in counts/s*2^ENCODER_FRAC_BITS
+int32_t getIncEncoderVelocity(void){
+    return encoder.velocity;
+}
 
 //------------------getIncEncoderDirection()---------------------------
-//Get velocity from Incremental encoder
+//Get direction from Incremental encoder
 //Input: None
-//Output: None
-uint32_t getIncEncoderDirection(void);
+//Output: 1 counting up, 0 counting down
+uint32_t getIncEncoderDirection(void){
+    return (HAL_QEIDirectionGet() > 0) ? 1 : 0;
+}
@@ -91,8 +91,17 @@
 #include <stdbool.h>
 #include <math.h>
 
-#include "utils/uartstdio.h"
-
+#include "hal.h"
+#include "command.h"
+#include "forceControl.h"
+#include "gait.h"
+#include "gainSchedule.h"
+#include "monitor.h"
+#include "autotune.h"
+#include "kalman.h"
+#include "calib.h"
+
+#ifndef SLUG_HOST
 #include "inc/hw_types.h"
 #include "inc/hw_memmap.h"
 #include "inc/tm4c123gh6pm.h"
@@ -109,6 +118,7 @@
 #include "driverlib/adc.h"
 #include "driverlib/debug.h"
 #include "driverlib/qei.h"
+#endif
 
 // ********************************************************
 // *************** Clock and timing ***********************
@@ -265,6 +275,33 @@ void Console_Send(char* input);
 //Output: None
 void Logger_Init(uint32_t LoggerFreq,  int BaudRate);
 
+//------------------Logger_InitTelemetry()---------------------------
+//Initializes the binary telemetry logger (telemetry.h), one record per
+//controller tick queued from the controller ISR
+//Input: Baud Rate
+//Output: None
+void Logger_InitTelemetry(int BaudRate);
+
+//------------------Logger_Enable()---------------------------
+//Start or stop the logger set up by Logger_Init (logger timer) or
+//Logger_InitTelemetry (records from the controller ISR)
+//Input: 1 to start, 0 to stop
+//Output: None
+void Logger_Enable(int enable);
+
+//------------------Logger_Drain()---------------------------
+//Send the queued telemetry records, call from the background loop
+//Input: None
+//Output: Number of records sent
+uint32_t Logger_Drain(void);
+
+//------------------Logger_EnableRawCapture()---------------------------
+//Add the raw load cell blocks (LoadCell_initBlock) to the telemetry stream,
+//needs TELEMETRY_RAW_BAUD_RATE
+//Input: 1 to start, 0 to stop
+//Output: None
+void Logger_EnableRawCapture(int enable);
+
 //------------------LoggerIntHandler()---------------------------
 //Interrupt Handler for the Logger
 //Input: None
@@ -284,12 +321,106 @@ void SerialMonitor_Init(void);
 //Output: None
 void SerialMonitor_Loop(void);
 
+//------------------UARTIntHandler()---------------------------
+//ISR for UART
+//Input: None
+//Output: None
+void UARTIntHandler(void);
+
 //------------------SerialMonitor_Receive()---------------------------
-//Receive data from the serial monitor using UART
+//Run the commands received on UART0 and send the replies (command.h), call
+//from the background loop. Logger_Init, Logger_InitTelemetry and
+//SerialMonitor_Init start the receiver
 //Input: None
 //Output: None
 void SerialMonitor_Receive(void);
 
+//------------------SerialMonitor_Dropped()---------------------------
+//Get the number of replies dropped because the telemetry transmitter had no
+//room even for a COMMAND_BUSY reply, the host timed out on them and sent the
+//request again
+//Input: None
+//Output: Dropped replies
+uint32_t SerialMonitor_Dropped(void);
+
+// Runs a command unknown to slug.c: request, reply payload out, reply length out
+typedef Command_Status (*SerialMonitor_Extension)(const Command_Request *request, uint8_t *out, uint32_t *length);
+
+//------------------SerialMonitor_SetNotify()---------------------------
+//Call a function from the UART interrupt whenever bytes arrive, to wake the
+//thread that calls SerialMonitor_Receive()
+//Input: function, 0 for none
+//Output: None
+void SerialMonitor_SetNotify(HAL_Handler notify);
+
+//------------------SerialMonitor_SetExtension()---------------------------
+//Run the commands unknown to slug.c with another function, it replies
+//COMMAND_UNKNOWN for those it does not know either
+//Input: function, 0 for none
+//Output: None
+void SerialMonitor_SetExtension(SerialMonitor_Extension extension);
+
+// What a parameter holds, and whether paramStore.h keeps it
+typedef enum {
+    PARAM_REAL,             // double, stored as float64
+    PARAM_INT,              // int32_t, set values are rounded, stored as int32
+    PARAM_BOOT,             // PARAM_INT read by the start up sequence, Param_GetBoot()
+    PARAM_COMMAND           // goal (double) or action (int32_t), never stored
+} Param_Type;
+
+// Rates of the start up sequence, stored like the gains so a stand keeps them
+typedef struct {
+    uint32_t pwmFreq;       // Hz, Motor_Init()
+    int adcAveraging;       // LoadCell_initBlock()
+    int adcFreq;            // Hz
+    uint32_t controllerFreq;    // Hz, Controller_Init()
+} Param_Boot;
+
+//------------------Param_Count()---------------------------
+//Get the number of named parameters (gains, goal, deadband) the command
+//protocol reads and writes
+//Input: None
+//Output: Count
+uint32_t Param_Count(void);
+
+//------------------Param_Name()---------------------------
+//Get the name of a parameter
+//Input: Parameter number
+//Output: Name, 0 for an unknown parameter
+const char *Param_Name(uint32_t id);
+
+//------------------Param_Find()---------------------------
+//Find a parameter by name
+//Input: Name
+//Output: Parameter number, -1 if unknown
+int Param_Find(const char *name);
+
+//------------------Param_Get()---------------------------
+//Get the value of a parameter
+//Input: Parameter number, value out
+//Output: 1 if read, 0 for an unknown parameter
+int Param_Get(uint32_t id, double *value);
+
+//------------------Param_Set()---------------------------
+//Set a parameter, a gain is loaded into its control law right away
+//(bumpless when the law is running)
+//Input: Parameter number, value
+//Output: 1 if set, 0 for an unknown parameter or a value out of range
+int Param_Set(uint32_t id, double value);
+
+//------------------Param_GetType()---------------------------
+//Get the type of a parameter
+//Input: Parameter number
+//Output: Type, PARAM_COMMAND for an unknown parameter
+Param_Type Param_GetType(uint32_t id);
+
+//------------------Param_GetBoot()---------------------------
+//Get the rates of the start up sequence: pwm_freq, adc_avg, adc_rate and
+//ctrl_freq. Call after ParamStore_Load(), before the peripherals are set up
+//Input: Rates out
+//Output: None
+void Param_GetBoot(Param_Boot *boot);
+
 // ********************************************************
 // *************** Temperature Sensor *********************
 // ********************************************************
@@ -416,17 +547,43 @@ void checkLimits(double duty);
 // ********************************************************
 
 //------------------LoadCell_init()---------------------------
-//Initialize the Load Cell input on Board
+//Initialize the Load Cell input on Board, same as Sensors_Init()
 //Input: Hardware averaging, ADCsampleFreq sets the timer trigger freq
 //Output: None
 void LoadCell_init(int hardwareAveraging, int ADCsampleFreq);
 
+//------------------LoadCell_initBlock()---------------------------
+//Initialize the Load Cell input, uDMA block sampling with CIC decimation.
+//The other sensors are converted once per block (Sensors_Read())
+//Input: Hardware averaging, ADCsampleFreq sets the timer trigger freq
+//       (the value updates at ADCsampleFreq/DECIMATOR_RATE)
+//Output: None
+void LoadCell_initBlock(int hardwareAveraging, int ADCsampleFreq);
+
 //------------------getLoadCellValue()---------------------------
 //Get Load Cell Value
 //Input: None
 //Output: Load Cell value ADC units
 uint32_t getLoadCellValue(void);
 
+//------------------getLoadCellFine()---------------------------
+//Get Load Cell Value with extra resolution, decimated in block mode
+//Input: None
+//Output: Load Cell value in ADC units*2^DECIMATOR_FRAC_BITS
+int32_t getLoadCellFine(void);
+
+//------------------LoadCellIntHandler()---------------------------
+//Interrupt handler for the load cell ADC sequence
+//Input: None
+//Output: None
+void LoadCellIntHandler(void);
+
+//------------------LoadCellBlockIntHandler()---------------------------
+//Interrupt handler for the load cell uDMA blocks (LoadCell_initBlock)
+//Input: None
+//Output: None
+void LoadCellBlockIntHandler(void);
+
 //------------------measuredLoad()---------------------------
 //Get Load Cell Value
 //Input: None
@@ -445,19 +602,177 @@ double adc2Vol(uint32_t);
 //Output: Pound
 double Vol2Load(double);
 
+// ********************************************************
+// ******************** Sensors **************************
+// ********************************************************
+// Every analog input is converted in one ADC0 sequence (sequencer 0). One
+// interrupt per sequence scales the samples and publishes a snapshot, so all
+// sensors read by the controller come from the same instant. The load cell
+// value and getLoadCellValue() are updated from the same interrupt. Each
+// snapshot is also queued to the controller ISR (ring.h), which takes the
+// newest at every tick (Controller_Sensors()).
+typedef enum {
+    SENSOR_LOADCELL,        // PE3
+    SENSOR_CURRENT,         // PE5, current monitor
+    SENSOR_THERMOCOUPLE,    // PE0
+    SENSOR_AUX,             // PE2, additional ADC
+    SENSOR_CHIP_TEMP,       // internal temperature sensor
+    NUM_SENSORS
+} Sensor_Id;
+
+typedef struct {
+    const char *name;
+    const char *units;
+    HAL_ADCChannel channel;
+    float gain;                     // value = gain*counts + offset
+    float offset;
+} Sensor_Channel;
+
+typedef struct {
+    uint32_t count;                 // snapshots since start up, 0 before the first
+    uint32_t tick;                  // controller tick when it was published
+    uint16_t raw[NUM_SENSORS];      // ADC counts (load cell decimated in block mode)
+    int32_t loadFine;               // load cell, ADC counts*2^DECIMATOR_FRAC_BITS
+    float value[NUM_SENSORS];       // scaled, units of Sensor_Channel
+} Sensors_Snapshot;
+
+//------------------Sensors_Init()---------------------------
+//Convert every sensor in one sequence triggered by Timer0
+//Input: Hardware averaging, ADCsampleFreq sets the timer trigger freq
+//Output: None
+void Sensors_Init(int hardwareAveraging, int ADCsampleFreq);
+
+//------------------Sensors_Read()---------------------------
+//Copy the latest snapshot, safe from the background loop and from ISRs
+//Input: Snapshot to fill
+//Output: None
+void Sensors_Read(Sensors_Snapshot *snapshot);
+
+//------------------Sensors_Channel()---------------------------
+//Get the name, units and scaling of a sensor
+//Input: Sensor
+//Output: Channel description, 0 for an unknown sensor
+const Sensor_Channel *Sensors_Channel(Sensor_Id id);
+
+//------------------Sensors_Dropped()---------------------------
+//Get number of snapshots the controller did not take in time
+//Input: None
+//Output: Dropped snapshots
+uint32_t Sensors_Dropped(void);
+
+//------------------SensorsIntHandler()---------------------------
+//Interrupt handler for the sensor sequence
+//Input: None
+//Output: None
+void SensorsIntHandler(void);
+
+
+// Controller strategies, ControllerIntHandler() calls the step hook of the
+// selected one. Hooks run in the controller ISR except init (Controller_Init)
+// and reset (Controller_Select)
+typedef enum {
+    CONTROLLER_PID,
+    CONTROLLER_ADAPTIVE,
+    CONTROLLER_SWING,
+    CONTROLLER_CASCADE,
+    CONTROLLER_SCHEDULED,
+    CONTROLLER_IDENT,               // open loop excitation, ident.h
+    CONTROLLER_TUNE,                // relay auto-tuning, autotune.h
+    NUM_CONTROLLERS
+} Controller_Id;
+
+typedef struct {
+    const char *name;
+    void (*init)(void);             // load gains and reset
+    void (*reset)(void);            // clear state before taking over
+    int32_t (*step)(void);          // one tick, returns signed duty in percent
+    void (*log)(void);              // one line for the text logger
+    volatile fc_num_t *out;         // controller output for the telemetry
+} Controller_Strategy;
+
+typedef struct {
+    uint32_t last, max;             // system clock cycles
+    uint32_t count;                 // ticks measured
+    uint64_t total;                 // mean = total/count
+} Controller_Cost;
 
 //------------------Controller_Init()---------------------------
-//Initializes a timer routine for the controller
+//Initializes a timer routine for the controller, loads the gains of all
+//strategies and selects CONTROLLER_ADAPTIVE
 //Input: Controller Frequency
 //Output: None
 void Controller_Init(uint32_t Controllerfreq);
 
+//------------------Controller_InitTick()---------------------------
+//Controller_Init() with another Timer1 handler, which must clear the timer
+//and lead to one ControllerIntHandler() call per period
+//Input: Controller Frequency, Timer1 handler
+//Output: None
+void Controller_InitTick(uint32_t Controllerfreq, HAL_Handler tick);
+
 //------------------ControllerIntHandler()---------------------------
 //Interrupt handler for the controller
 //Input: None
 //Output: None
 void ControllerIntHandler(void);
 
+//------------------Controller_Select()---------------------------
+//Switch the controller strategy at runtime, bumpless
+//Input: Controller
+//Output: 1 if selected, 0 for an unknown controller
+int Controller_Select(Controller_Id id);
+
+//------------------Controller_Active()---------------------------
+//Get the selected controller strategy
+//Input: None
+//Output: Controller
+Controller_Id Controller_Active(void);
+
+//------------------Controller_Get()---------------------------
+//Get a controller strategy
+//Input: Controller
+//Output: Strategy, 0 for an unknown controller
+const Controller_Strategy *Controller_Get(Controller_Id id);
+
+//------------------Controller_GetCost()---------------------------
+//Get the measured step cost of a controller strategy
+//Input: Controller
+//Output: Cost in system clock cycles, 0 for an unknown controller
+const Controller_Cost *Controller_GetCost(Controller_Id id);
+
+//------------------Controller_GetMonitor()---------------------------
+//Get the deadline monitor of the controller tick (monitor.h). When it trips
+//the controller ramps the motor to 0 and stops, ControllerEnable() restarts it
+//Input: None
+//Output: Monitor
+const Monitor_State *Controller_GetMonitor(void);
+
+//------------------Controller_SetOverrunLimit()---------------------------
+//Set how many overruns trip the safe stop, also the overrunLimit parameter
+//Input: Overruns in the bucket, controller ticks for it to lose one
+//Output: None
+void Controller_SetOverrunLimit(uint32_t overruns, uint32_t leakTicks);
+
+//------------------Controller_Sensors()---------------------------
+//Get the sensor snapshot the controller uses in the current tick
+//Input: None
+//Output: Snapshot
+const Sensors_Snapshot *Controller_Sensors(void);
+
+//------------------Controller_Kalman()---------------------------
+//Get the Kalman filter of the load, stepped by the controller tick while the
+//kalman parameter is 1. The strategies use its estimate once it warmed up
+//Input: None
+//Output: Filter, its estimate of the last tick it ran in load (lb)
+const Kalman_Filter *Controller_Kalman(void);
+
+//------------------Controller_SetLoad()---------------------------
+//Set the load cell value the strategies use until the next sensor snapshot,
+//to replay a capture tick by tick without the sensor sequence running
+//Input: Load cell ADC value
+//Output: None
+void Controller_SetLoad(uint32_t loadADC);
+
 //------------------setGlobalControllerFreq()---------------------------
 //Set global variable controller freq
 //Input: Controller freq
@@ -500,6 +815,91 @@ void PID_control(void);
 //Output: None
 void Adaptive_control(void);
 
+//------------------Cascade_SetGoal()---------------------------
+//Set the joint position goal of CONTROLLER_CASCADE, position loop ->
+//velocity loop -> force loop. Needs IncEncoder_Init()
+//Input: Position in counts*256 (getIncEncoderPositionFine()),
+//       velocity feedforward in counts/s*256
+//Output: None
+void Cascade_SetGoal(int32_t position, int32_t velocity);
+
+//------------------Cascade_SetRates()---------------------------
+//Set how often the velocity and position loops of CONTROLLER_CASCADE run,
+//in controller ticks (default 4 and 20). The force loop runs every tick
+//Input: Velocity loop divider, position loop divider
+//Output: 1 if set, 0 for a divider of 0
+int Cascade_SetRates(uint32_t velocityDiv, uint32_t positionDiv);
+
+//------------------Scheduled_SetTable()---------------------------
+//Replace the gain schedule of CONTROLLER_SCHEDULED, force goal x error
+//magnitude (gainSchedule.h). Controller_Init() keeps it, it loads
+//GainSchedule_Default() only when no table was set
+//Input: table, copied
+//Output: 1 if set, 0 if GainSchedule_Check() rejects it
+int Scheduled_SetTable(const GainSchedule_Table *table);
+
+//------------------Scheduled_GetTable()---------------------------
+//Get the gain schedule of CONTROLLER_SCHEDULED
+//Input: None
+//Output: table
+const GainSchedule_Table *Scheduled_GetTable(void);
+
+//------------------Scheduled_SetDeadband()---------------------------
+//Set the deadband of CONTROLLER_SCHEDULED, it holds P and I inside it
+//(default DEADBAND)
+//Input: Deadband in lb
+//Output: None
+void Scheduled_SetDeadband(double lb);
+
+//------------------Ident_Running()---------------------------
+//Tell if CONTROLLER_IDENT is selected and its excitation still runs. The
+//excitation is set by the ident_* parameters and restarts when one changes
+//Input: None
+//Output: 1 while the excitation runs, 0 otherwise
+int Ident_Running(void);
+
+//------------------Tune_Get()---------------------------
+//Get the state of the last relay tuning of CONTROLLER_TUNE and the gains it
+//put in the schedule of CONTROLLER_SCHEDULED. The run is set by the tune_*
+//parameters and restarts when one changes
+//Input: gains out (0 to skip), valid when the status is AUTOTUNE_DONE
+//Output: Relay state
+const Autotune_State *Tune_Get(Autotune_Gains *gains);
+
+//------------------Tune_Background()---------------------------
+//Compute the gains of a finished relay tuning and put them in the schedule of
+//CONTROLLER_SCHEDULED, call from the background loop. The tuning holds its
+//bias until this ran
+//Input: None
+//Output: None
+void Tune_Background(void);
+
+//------------------Trajectory_Start()---------------------------
+//Play a gait table as the goal of the controller, one step per controller
+//tick from phase 0. Force tables set the force goal of the force strategies,
+//position tables the goal and velocity feedforward of CONTROLLER_CASCADE
+//Input: table (gait.h), cadence in mHz
+//Output: None
+void Trajectory_Start(const Gait_Table *table, uint32_t milliHz);
+
+//------------------Trajectory_SetCadence()---------------------------
+//Change the cadence of the playing table, the phase runs on without a jump
+//Input: cadence in mHz, 0 holds the current point
+//Output: None
+void Trajectory_SetCadence(uint32_t milliHz);
+
+//------------------Trajectory_Stop()---------------------------
+//Stop playing, the goal stays at the last point
+//Input: None
+//Output: None
+void Trajectory_Stop(void);
+
+//------------------Trajectory_Get()---------------------------
+//Get the player state: table, phase, cycles, value and rate
+//Input: None
+//Output: Player, its table is 0 before the first Trajectory_Start()
+const Gait_Player *Trajectory_Get(void);
+
 //------------------getControllerTimePeriod()---------------------------
 //Get time period of controller in seconds
 //Input: Controller frequency
@@ -513,11 +913,17 @@ double getControllerTimePeriod(uint32_t);
 double GetSystemTime(uint32_t, double);
 
 //------------------ControllerEnable()---------------------------
-//Enable Timer 1A
+//Enable Timer 1A, arms the deadline monitor again
 //Input: None
 //Output: None
 void ControllerEnable(void);
 
+//------------------ControllerDisable()---------------------------
+//Stop the controller timer and the motor
+//Input: None
+//Output: None
+void ControllerDisable(void);
+
 //------------------Sgn()---------------------------
 //Return sign
 //Input: None
@@ -581,7 +987,7 @@ double checkIntegralLimit(double);
 
 //------------------deadBandCheck()---------------------------
 //Dead Band for PID loop
-//Input: None
+//Input: Error
 //Output: flag of whether goal reached or not
 uint32_t deadBandCheck(double);
 
@@ -597,6 +1003,37 @@ void logger_PID_ForceControl(void);
 //Output: None
 void logger_Adaptive_ForceControl(void);
 
+//------------------logger_Cascade()---------------------------
+//Logger function for the cascade strategy
+//Input: None
+//Output: None
+void logger_Cascade(void);
+
+//------------------logger_Scheduled()---------------------------
+//Logger function for CONTROLLER_SCHEDULED
+//Input: None
+//Output: None
+void logger_Scheduled(void);
+
+//------------------logger_Ident()---------------------------
+//Logger function for CONTROLLER_IDENT
+//Input: None
+//Output: None
+void logger_Ident(void);
+
+//------------------logger_Calibration()---------------------------
+//Logger function of the load cell calibration log, replaces the one of the
+//strategy while the cal_log parameter is 1
+//Input: None
+//Output: None
+void logger_Calibration(void);
+
+//------------------logger_Tune()---------------------------
+//Logger function for CONTROLLER_TUNE, prints the result once at the end
+//Input: None
+//Output: None
+void logger_Tune(void);
+
 void addADCIntHandler(void);
 
 void addADC_Init(int hardwareAveraging, int ADCsampleFreq);
@@ -606,27 +1043,35 @@ uint32_t getaddADCVal(void);
 void logPID(void);
 
 //------------------IncEncoder_Init()---------------------------
-//Initialize Incremental Encoder
-//Input: None
+//Initialize Incremental Encoder with its velocity timer and estimator
+//(encoder.h), updated at every controller tick
+//Input: Maximum position, start position
 //Output: None
 void IncEncoder_Init(uint32_t, uint32_t);
 
 //------------------getIncEncoderPosition()---------------------------
 //Get position from Incremental encoder
 //Input: None
-//Output: None
+//Output: Position in counts
 uint32_t getIncEncoderPosition(void);
 
+//------------------getIncEncoderPositionFine()---------------------------
+//Get the estimated position at the last controller tick, unwrapped, with
+//the motion since the last edge
+//Input: None
+//Output: Position in counts*2^ENCODER_FRAC_BITS
+int32_t getIncEncoderPositionFine(void);
+
 //------------------getIncEncoderVelocity()---------------------------
-//Get velocity from Incremental encoder
+//Get velocity from Incremental encoder, estimated at the last controller tick
 //Input: None
-//Output: None
-uint32_t getIncEncoderVelocity(void);
+//Output: Velocity in counts/s*2^ENCODER_FRAC_BITS
+int32_t getIncEncoderVelocity(void);
 
 //------------------getIncEncoderDirection()---------------------------
-//Get velocity from Incremental encoder
+//Get direction from Incremental encoder
 //Input: None
-//Output: None
+//Output: 1 counting up, 0 counting down
 uint32_t getIncEncoderDirection(void);
 
 
@@ -0,0 +1,209 @@
+// telemetry.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Binary telemetry stream, see telemetry.h for the record format.
+// Single producer (controller ISR) and single consumer (background loop), so
+// the queues are lock free rings (ring.h), filled and drained in place.
+
+#include "telemetry.h"
+#include "uartTx.h"
+#include "ring.h"
+
+RING_DEFINE(RecordQueue, Telemetry_Record, TELEMETRY_QUEUE_SIZE)
+
+static RecordQueue queue;
+static volatile uint32_t dropped;
+static uint8_t sequence;
+
+typedef struct {
+    uint32_t block;
+    uint16_t samples[TELEMETRY_BLOCK_SAMPLES];
+} Telemetry_Block;
+
+RING_DEFINE(BlockQueue, Telemetry_Block, TELEMETRY_BLOCK_QUEUE_SIZE)
+
+static BlockQueue blockQueue;           // ADC ISR to background
+static volatile uint32_t blocksDropped;
+static volatile int blocksEnabled;
+static uint8_t blockSequence;
+
+//------------------Telemetry_Init()---------------------------
+//Empty the queue and reset the sequence number and drop count
+//Input: None
+//Output: None
+void Telemetry_Init(void){
+    RecordQueue_Init(&queue);
+    dropped = 0;
+    sequence = 0;
+    BlockQueue_Init(&blockQueue);
+    blocksDropped = 0;
+    blocksEnabled = 0;
+    blockSequence = 0;
+}
+
+//------------------Telemetry_Log()---------------------------
+//Queue one record, called from the controller ISR
+//Input: tick, raw ADC, signed duty, error and output in 0.01 units
+//Output: None
+void Telemetry_Log(uint32_t tick, uint32_t adc, int32_t duty, int32_t error, int32_t out){
+    Telemetry_Record *r = RecordQueue_Claim(&queue);
+
+    if(!r){
+        dropped++;
+        sequence++; // keep the gap visible to the decoder
+        return;
+    }
+
+    // Saturate to the record fields
+    if(error > 32767) error = 32767;
+    if(error < -32768) error = -32768;
+    if(out > 32767) out = 32767;
+    if(out < -32768) out = -32768;
+
+    r->tick = tick;
+    r->adc = adc;
+    r->error = error;
+    r->out = out;
+    r->duty = duty;
+    r->seq = sequence++;
+    RecordQueue_Publish(&queue);
+}
+
+//------------------Telemetry_EnableBlocks()---------------------------
+//Start or stop the raw block stream
+//Input: 1 to send blocks, 0 to stop
+//Output: None
+void Telemetry_EnableBlocks(int enable){
+    blocksEnabled = enable;
+}
+
+//------------------Telemetry_LogBlock()---------------------------
+//Queue one raw ADC block, called from the ADC interrupt
+//Input: block counter, samples
+//Output: None
+void Telemetry_LogBlock(uint32_t block, const uint16_t *samples){
+    Telemetry_Block *b;
+    int i;
+
+    if(!blocksEnabled){
+        return;
+    }
+    b = BlockQueue_Claim(&blockQueue);
+    if(!b){
+        blocksDropped++;
+        return; // the block counter shows the gap
+    }
+    b->block = block;
+    for(i = 0; i < TELEMETRY_BLOCK_SAMPLES; i++){
+        b->samples[i] = samples[i];
+    }
+    BlockQueue_Publish(&blockQueue);
+}
+
+//------------------Telemetry_BlocksDropped()---------------------------
+//Get number of raw blocks dropped because the queue was full
+//Input: None
+//Output: Dropped blocks
+uint32_t Telemetry_BlocksDropped(void){
+    return blocksDropped;
+}
+
+//------------------encodeBlock()---------------------------
+//Frame one raw block, little endian
+static void encodeBlock(const Telemetry_Block *b, uint8_t *frame){
+    uint16_t crc;
+    int i;
+
+    frame[0] = TELEMETRY_BLOCK_SYNC & 0xFF;
+    frame[1] = TELEMETRY_BLOCK_SYNC >> 8;
+    frame[2] = blockSequence++;
+    frame[3] = TELEMETRY_BLOCK_SAMPLES;
+    frame[4] = b->block;
+    frame[5] = b->block >> 8;
+    frame[6] = b->block >> 16;
+    frame[7] = b->block >> 24;
+    for(i = 0; i < TELEMETRY_BLOCK_SAMPLES; i++){
+        frame[8 + 2*i] = b->samples[i];
+        frame[9 + 2*i] = b->samples[i] >> 8;
+    }
+    crc = Telemetry_CRC16(&frame[2], TELEMETRY_BLOCK_SIZE - 4);
+    frame[TELEMETRY_BLOCK_SIZE - 2] = crc;
+    frame[TELEMETRY_BLOCK_SIZE - 1] = crc >> 8;
+}
+
+//------------------Telemetry_CRC16()---------------------------
+//CRC-16/CCITT-FALSE, bitwise. Only runs in the background loop
+//Input: data, length
+//Output: CRC
+uint16_t Telemetry_CRC16(const uint8_t *data, uint32_t length){
+    uint16_t crc = 0xFFFF;
+    uint32_t i;
+    int bit;
+
+    for(i = 0; i < length; i++){
+        crc ^= (uint16_t)data[i] << 8;
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+//------------------Telemetry_Encode()---------------------------
+//Frame one record, little endian
+//Input: record, output buffer
+//Output: None
+void Telemetry_Encode(const Telemetry_Record *record, uint8_t *frame){
+    uint16_t crc;
+
+    frame[0] = TELEMETRY_SYNC & 0xFF;
+    frame[1] = TELEMETRY_SYNC >> 8;
+    frame[2] = record->seq;
+    frame[3] = (uint8_t)record->duty;
+    frame[4] = record->tick;
+    frame[5] = record->tick >> 8;
+    frame[6] = record->tick >> 16;
+    frame[7] = record->tick >> 24;
+    frame[8] = record->adc;
+    frame[9] = record->adc >> 8;
+    frame[10] = (uint16_t)record->error;
+    frame[11] = (uint16_t)record->error >> 8;
+    frame[12] = (uint16_t)record->out;
+    frame[13] = (uint16_t)record->out >> 8;
+
+    crc = Telemetry_CRC16(&frame[2], 12);
+    frame[14] = crc;
+    frame[15] = crc >> 8;
+}
+
+//------------------Telemetry_Drain()---------------------------
+//Frame queued records, then raw blocks, into the uDMA transmit buffer
+//(uartTx.c). Never waits, what does not fit stays queued for the next call
+//Input: None
+//Output: Number of records sent
+uint32_t Telemetry_Drain(void){
+    uint8_t frame[TELEMETRY_BLOCK_SIZE];
+    const Telemetry_Record *r;
+    const Telemetry_Block *b;
+    uint32_t sent = 0;
+
+    while(UARTTx_Free() >= TELEMETRY_RECORD_SIZE && (r = RecordQueue_Peek(&queue)) != 0){
+        Telemetry_Encode(r, frame);
+        RecordQueue_Release(&queue); // slot is free once it is copied to the frame
+        UARTTx_Write(frame, TELEMETRY_RECORD_SIZE);
+        sent++;
+    }
+    while(UARTTx_Free() >= TELEMETRY_BLOCK_SIZE && (b = BlockQueue_Peek(&blockQueue)) != 0){
+        encodeBlock(b, frame);
+        BlockQueue_Release(&blockQueue);
+        UARTTx_Write(frame, TELEMETRY_BLOCK_SIZE);
+    }
+    return sent;
+}
+
+//------------------Telemetry_Dropped()---------------------------
+//Get number of records dropped because the queue was full
+//Input: None
+//Output: Dropped records
+uint32_t Telemetry_Dropped(void){
+    return dropped;
+}
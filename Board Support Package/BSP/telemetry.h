@@ -0,0 +1,115 @@
+// telemetry.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Binary telemetry stream on UART0, one record per controller tick.
+// The controller ISR only copies a few values into a queue slot
+// (Telemetry_Log), framing and CRC happen in the background loop
+// (Telemetry_Drain), transmission is done by the uDMA (uartTx.c).
+// Host Tools/telemetryDecode.c turns the stream into CSV.
+//
+// Record on the wire, 16 bytes, little endian:
+//   offset size
+//   0      2    sync word 0xA55A (bytes 0x5A 0xA5)
+//   2      1    sequence number, +1 per record, gaps show dropped records
+//   3      1    signed duty cycle in percent, negative when direction is 0
+//   4      4    controller tick
+//   8      2    raw load cell ADC value
+//   10     2    error, 0.01 lb
+//   12     2    controller output, 0.01 percent
+//   14     2    CRC-16/CCITT-FALSE of bytes 2 to 13
+// At 2 kHz this is 32000 bytes/s, use 460800 baud or more.
+//
+// Raw load cell blocks (Telemetry_EnableBlocks), one per uDMA ADC block:
+//   offset size
+//   0      2    sync word 0xB55A (bytes 0x5A 0xB5)
+//   2      1    sequence number of blocks, separate from the records
+//   3      1    samples in the block (TELEMETRY_BLOCK_SAMPLES)
+//   4      4    block counter
+//   8      2*n  raw ADC samples
+//   8+2n   2    CRC-16/CCITT-FALSE of bytes 2 to 7+2n
+// At 32 kHz sampling this adds 84000 bytes/s, use 1500000 baud.
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+#define TELEMETRY_SYNC          0xA55A
+#define TELEMETRY_RECORD_SIZE   16
+#define TELEMETRY_QUEUE_SIZE    64      // records, power of 2 (32 ms at 2 kHz)
+#define TELEMETRY_BAUD_RATE     460800
+
+#define TELEMETRY_BLOCK_SYNC        0xB55A
+#define TELEMETRY_BLOCK_SAMPLES     16      // same as DECIMATOR_RATE
+#define TELEMETRY_BLOCK_SIZE        (10 + 2*TELEMETRY_BLOCK_SAMPLES)
+#define TELEMETRY_BLOCK_QUEUE_SIZE  8       // blocks, power of 2
+#define TELEMETRY_RAW_BAUD_RATE     1500000
+
+typedef struct {
+    uint32_t tick;
+    uint16_t adc;
+    int16_t error;      // 0.01 lb
+    int16_t out;        // 0.01 percent
+    int8_t duty;        // signed percent
+    uint8_t seq;
+} Telemetry_Record;
+
+//------------------Telemetry_Init()---------------------------
+//Empty the queue and reset the sequence number and drop count.
+//UART0 and its uDMA channel must already be set up (Logger_InitTelemetry)
+//Input: None
+//Output: None
+void Telemetry_Init(void);
+
+//------------------Telemetry_Log()---------------------------
+//Queue one record, called from the controller ISR. Record is dropped when the
+//queue is full
+//Input: controller tick, raw load cell ADC, signed duty (percent),
+//       error (0.01 lb), controller output (0.01 percent)
+//Output: None
+void Telemetry_Log(uint32_t tick, uint32_t adc, int32_t duty, int32_t error, int32_t out);
+
+//------------------Telemetry_Drain()---------------------------
+//Frame queued records into the uDMA transmit buffer, call from the
+//background loop. Does not wait for the UART
+//Input: None
+//Output: Number of records sent
+uint32_t Telemetry_Drain(void);
+
+//------------------Telemetry_Dropped()---------------------------
+//Get number of records dropped because the queue was full
+//Input: None
+//Output: Dropped records
+uint32_t Telemetry_Dropped(void);
+
+//------------------Telemetry_EnableBlocks()---------------------------
+//Start or stop the raw block stream
+//Input: 1 to send blocks, 0 to stop
+//Output: None
+void Telemetry_EnableBlocks(int enable);
+
+//------------------Telemetry_LogBlock()---------------------------
+//Queue one raw ADC block, called from the ADC interrupt. Does nothing unless
+//enabled, the block is dropped when the queue is full
+//Input: block counter, TELEMETRY_BLOCK_SAMPLES samples
+//Output: None
+void Telemetry_LogBlock(uint32_t block, const uint16_t *samples);
+
+//------------------Telemetry_BlocksDropped()---------------------------
+//Get number of raw blocks dropped because the queue was full
+//Input: None
+//Output: Dropped blocks
+uint32_t Telemetry_BlocksDropped(void);
+
+//------------------Telemetry_Encode()---------------------------
+//Frame one record
+//Input: record, output buffer of TELEMETRY_RECORD_SIZE bytes
+//Output: None
+void Telemetry_Encode(const Telemetry_Record *record, uint8_t *frame);
+
+//------------------Telemetry_CRC16()---------------------------
+//CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+//Input: data, length
+//Output: CRC
+uint16_t Telemetry_CRC16(const uint8_t *data, uint32_t length);
+
+#endif /* TELEMETRY_H_ */
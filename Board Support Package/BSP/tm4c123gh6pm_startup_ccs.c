@@ -42,12 +42,13 @@ static void IntDefaultHandler(void);
 //*****************************************************************************
 extern void _c_int00(void);
 extern void UARTIntHandler(void);
-extern void tempSensor_handler(void); //ADC seq1 interrupt
+extern void tempSensor_handler(void); //ADC seq2 interrupt
 extern void LoadCellTrigger(void); //Timer 0 for triggering the load cell
 //extern void Timer0IntHandler(void);
 extern void LoadCellIntHandler(void); //ADC0, seq3 interrupt
 extern void ControllerIntHandler(void); //Timer 1A interuupt
 extern void LoggerIntHandler(void);
+extern void SensorsIntHandler(void); //ADC0, seq0 interrupt
 extern void addADCIntHandler(void);
 //*****************************************************************************
 //
@@ -104,9 +105,9 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // PWM Generator 1
     IntDefaultHandler,                      // PWM Generator 2
     IntDefaultHandler,                      // Quadrature Encoder 0
-    IntDefaultHandler,                      // ADC Sequence 0
+    SensorsIntHandler,                      // ADC Sequence 0
     LoadCellIntHandler,                      // ADC Sequence 1
-    IntDefaultHandler,                      // ADC Sequence 2
+    tempSensor_handler,                      // ADC Sequence 2
     addADCIntHandler,                      // ADC Sequence 3
     IntDefaultHandler,                      // Watchdog timer
     LoadCellTrigger,                      // Timer 0 subtimer A
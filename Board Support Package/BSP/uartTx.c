@@ -0,0 +1,85 @@
+// uartTx.c
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Double buffered UART0 transmit through the uDMA, see uartTx.h.
+// buffers[fill] belongs to the background loop, buffers[fill ^ 1] to the uDMA
+// while inFlight is set. Swapping happens in the UART0 ISR and in
+// UARTTx_Write() with interrupts disabled, so the two never race.
+
+#include "uartTx.h"
+#include "hal.h"
+
+static uint8_t buffers[2][UARTTX_BLOCK_SIZE];
+static volatile uint32_t fill;          // buffer being filled
+static volatile uint32_t fillLength;    // bytes in buffers[fill]
+static volatile uint32_t inFlight;      // buffers[fill ^ 1] is being sent
+
+//------------------startFill()---------------------------
+//Hand the fill buffer to the uDMA and start filling the other one.
+//Interrupts must be disabled or this must run in the ISR
+static void startFill(void){
+    uint32_t length = fillLength;
+
+    if(length == 0){
+        return;
+    }
+    fill ^= 1;
+    fillLength = 0;
+    inFlight = 1;
+    HAL_UARTDMAStart(buffers[fill ^ 1], length);
+}
+
+//------------------UARTTx_Init()---------------------------
+//Empty both buffers. HAL_UARTDMAInit() must already be called
+//Input: None
+//Output: None
+void UARTTx_Init(void){
+    fill = 0;
+    fillLength = 0;
+    inFlight = 0;
+}
+
+//------------------UARTTx_Write()---------------------------
+//Copy data into the fill buffer and start a transfer if the uDMA is idle
+//Input: data, length
+//Output: Number of bytes accepted
+uint32_t UARTTx_Write(const uint8_t *data, uint32_t length){
+    uint32_t state, n, i;
+    uint8_t *dest;
+
+    // Short copy (one telemetry frame), the ISR may swap buffers otherwise
+    state = HAL_EnterCritical();
+    n = UARTTX_BLOCK_SIZE - fillLength;
+    if(length < n){
+        n = length;
+    }
+    dest = &buffers[fill][fillLength];
+    for(i = 0; i < n; i++){
+        dest[i] = data[i];
+    }
+    fillLength += n;
+    if(!inFlight || !HAL_UARTDMABusy()){
+        inFlight = 0;
+        startFill();
+    }
+    HAL_ExitCritical(state);
+    return n;
+}
+
+//------------------UARTTx_Free()---------------------------
+//Get free space in the fill buffer
+//Input: None
+//Output: Free bytes
+uint32_t UARTTx_Free(void){
+    return UARTTX_BLOCK_SIZE - fillLength;
+}
+
+//------------------UARTTx_Service()---------------------------
+//Start the next transfer once the previous one is done, UART0 ISR
+//Input: None
+//Output: None
+void UARTTx_Service(void){
+    if(inFlight && !HAL_UARTDMABusy()){
+        inFlight = 0;
+        startFill();
+    }
+}
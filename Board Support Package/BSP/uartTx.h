@@ -0,0 +1,42 @@
+// uartTx.h
+// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC
+// Double buffered UART0 transmit through the uDMA (HAL_UARTDMAStart).
+// The background loop copies bytes into the fill buffer, the uDMA sends the
+// other one. When a transfer completes, the UART0 interrupt calls
+// UARTTx_Service() which swaps the buffers and starts the next transfer,
+// so the CPU is involved once per block instead of once per character.
+
+#ifndef UARTTX_H_
+#define UARTTX_H_
+
+#include <stdint.h>
+
+#define UARTTX_BLOCK_SIZE   512     // bytes per buffer, at most HAL_UART_DMA_MAX
+
+//------------------UARTTx_Init()---------------------------
+//Empty both buffers. HAL_UARTDMAInit() must already be called
+//Input: None
+//Output: None
+void UARTTx_Init(void);
+
+//------------------UARTTx_Write()---------------------------
+//Copy data into the fill buffer and start a transfer if the uDMA is idle.
+//Does not wait, call from the background loop only
+//Input: data, length
+//Output: Number of bytes accepted (less than length when the buffer is full)
+uint32_t UARTTx_Write(const uint8_t *data, uint32_t length);
+
+//------------------UARTTx_Free()---------------------------
+//Get free space in the fill buffer
+//Input: None
+//Output: Bytes UARTTx_Write() accepts right now
+uint32_t UARTTx_Free(void);
+
+//------------------UARTTx_Service()---------------------------
+//Hand the fill buffer to the uDMA once the previous transfer is done,
+//call from the UART0 interrupt handler
+//Input: None
+//Output: None
+void UARTTx_Service(void);
+
+#endif /* UARTTX_H_ */
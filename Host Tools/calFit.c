@@ -0,0 +1,229 @@
+// calFit.c
+// Runs on a host PC
+// Fits the load cell calibration of the firmware (calib.h) from calibration
+// logs. A log is the text logger output with the cal_log parameter set to 1
+// (logger_Calibration() in slug.c: "reading counts*16, chip C, load lb")
+// taken with a known load on the cell, given after the file name. Log the
+// loads over the temperature range the stand sees, e.g. from a cold start.
+// The table points and the temperature terms come from one linear least
+// squares fit:
+//   reference = sum_i point_i*w_i(reading) + span*dT*reference + offset*dT
+// w_i is the interpolation weight of point i in the table, dT the chip
+// temperature less the reference temperature (-tref, mean of the logs by
+// default). The span term takes the reference for the table value, which
+// drops a second order term only. A small second difference penalty
+// (-smooth) ties points no reading falls next to to their neighbours, so the
+// table extends the fit linearly. The temperature terms are left at 0 with
+// -notemp or when the logs span less than MIN_TEMP_SPAN.
+// The parameters go to stdout as "set name value" lines for slugCmd. The fit
+// is then checked through Calib_Apply() of the firmware and the error of the
+// nominal 25 lb/V scale and of the calibration go to stderr.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -I"../Board Support Package/BSP" -o calFit calFit.c "../Board Support Package/BSP/calib.c" -lm
+// Run:
+//   ./calFit log.txt lb [log.txt lb]... [-tref C] [-smooth w] [-notemp] > cal.txt
+//   while read c n v; do ./slugCmd /dev/ttyACM0 $c $n $v; done < cal.txt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "calib.h"
+#include "forceControl.h"
+
+#define MAX_ROWS        1000000
+#define MAX_COLUMNS     8
+#define MAX_UNKNOWNS    (CALIB_POINTS + 2)
+#define MIN_TEMP_SPAN   2.0             // C, logs narrower fit no temperature terms
+#define CHIP_GAIN       (-247.5/4096.0) // C per count, chip entry of sensorTable in slug.c
+#define CHIP_OFFSET     147.5           // C
+
+typedef struct {
+    double counts;          // reading, counts*2^CALIB_FRAC_BITS
+    double temp;            // chip, C
+    double reference;       // lb
+} Row;
+
+static Row rows[MAX_ROWS];
+
+//------------------readLog()---------------------------
+//Append the rows of one calibration log
+//Output: Rows read, -1 on error
+static int readLog(const char *path, double reference, int n){
+    FILE *f = fopen(path, "r");
+    char line[1024];
+    int start = n;
+
+    if(!f){
+        perror(path);
+        return -1;
+    }
+    while(fgets(line, sizeof(line), f) && n < MAX_ROWS){
+        double col[MAX_COLUMNS];
+        char *p = line, *end;
+        int k = 0;
+
+        while(k < MAX_COLUMNS){
+            while(*p == ' ' || *p == '\t' || *p == ',') p++;
+            col[k] = strtod(p, &end);
+            if(end == p) break;
+            k++;
+            p = end;
+        }
+        if(k != 3 || col[0] < 0 || col[0] >= (1 << (CALIB_INPUT_BITS + CALIB_FRAC_BITS))){
+            continue; // header, other logger lines or a broken line
+        }
+        rows[n].counts = col[0];
+        rows[n].temp = col[1];
+        rows[n].reference = reference;
+        n++;
+    }
+    fclose(f);
+    return n - start;
+}
+
+//------------------weights()---------------------------
+//Interpolation weights of the table points for one reading, as Calib_Apply()
+static void weights(double counts, double w[CALIB_POINTS]){
+    double x = counts/((double)CALIB_SEGMENT*(1 << CALIB_FRAC_BITS));
+    int i = (int)floor(x);
+
+    memset(w, 0, sizeof(double)*CALIB_POINTS);
+    if(i > CALIB_POINTS - 2) i = CALIB_POINTS - 2;
+    w[i] = 1 - (x - i);
+    w[i + 1] = x - i;
+}
+
+//------------------solve()---------------------------
+//Solve a*x = b by Gaussian elimination with partial pivoting, a and b are
+//destroyed
+//Output: 1 if solved, 0 if singular
+static int solve(double a[MAX_UNKNOWNS][MAX_UNKNOWNS], double b[MAX_UNKNOWNS], double x[MAX_UNKNOWNS], int m){
+    int i, j, k, pivot;
+    double t;
+
+    for(k = 0; k < m; k++){
+        pivot = k;
+        for(i = k + 1; i < m; i++){
+            if(fabs(a[i][k]) > fabs(a[pivot][k])) pivot = i;
+        }
+        if(fabs(a[pivot][k]) < 1e-300) return 0;
+        for(j = 0; j < m; j++){
+            t = a[k][j]; a[k][j] = a[pivot][j]; a[pivot][j] = t;
+        }
+        t = b[k]; b[k] = b[pivot]; b[pivot] = t;
+        for(i = k + 1; i < m; i++){
+            t = a[i][k]/a[k][k];
+            for(j = k; j < m; j++) a[i][j] -= t*a[k][j];
+            b[i] -= t*b[k];
+        }
+    }
+    for(k = m - 1; k >= 0; k--){
+        t = b[k];
+        for(j = k + 1; j < m; j++) t -= a[k][j]*x[j];
+        x[k] = t/a[k][k];
+    }
+    return 1;
+}
+
+int main(int argc, char **argv){
+    static double a[MAX_UNKNOWNS][MAX_UNKNOWNS], b[MAX_UNKNOWNS], x[MAX_UNKNOWNS];
+    double w[CALIB_POINTS + 2], point[CALIB_POINTS], span = 0, offset = 0;
+    double tref = 0, tmin = 1e9, tmax = -1e9, smooth = 0.01, penalty, e;
+    double sum[2] = {0, 0}, worst[2] = {0, 0};
+    int userTref = 0, temp = 1, n = 0, logs = 0, m, i, j, k, got;
+    Calib_Table table;
+
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-tref") == 0 && i + 1 < argc){
+            tref = atof(argv[++i]);
+            userTref = 1;
+        }else if(strcmp(argv[i], "-smooth") == 0 && i + 1 < argc){
+            smooth = atof(argv[++i]);
+        }else if(strcmp(argv[i], "-notemp") == 0){
+            temp = 0;
+        }else if(argv[i][0] != '-' && i + 1 < argc){
+            got = readLog(argv[i], atof(argv[i + 1]), n);
+            if(got < 0) return 1;
+            fprintf(stderr, "%s: %d readings at %g lb\n", argv[i], got, atof(argv[i + 1]));
+            n += got;
+            logs++;
+            i++;
+        }else{
+            fprintf(stderr, "usage: %s log.txt lb [log.txt lb]... [-tref C] [-smooth w] [-notemp]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(logs < 2 || n == 0){
+        fprintf(stderr, "need the logs of two loads at least\n");
+        return 1;
+    }
+
+    for(k = 0; k < n; k++){
+        if(rows[k].temp < tmin) tmin = rows[k].temp;
+        if(rows[k].temp > tmax) tmax = rows[k].temp;
+        if(!userTref) tref += rows[k].temp/n;
+    }
+    if(tmax - tmin < MIN_TEMP_SPAN){
+        temp = 0;
+    }
+    m = temp ? CALIB_POINTS + 2 : CALIB_POINTS;
+
+    // Normal equations of the readings
+    for(k = 0; k < n; k++){
+        weights(rows[k].counts, w);
+        w[CALIB_POINTS] = (rows[k].temp - tref)*rows[k].reference;
+        w[CALIB_POINTS + 1] = rows[k].temp - tref;
+        for(i = 0; i < m; i++){
+            for(j = 0; j < m; j++) a[i][j] += w[i]*w[j];
+            b[i] += w[i]*rows[k].reference;
+        }
+    }
+    // Second difference penalty, weighted by the readings so it stays small
+    penalty = smooth*smooth*n;
+    for(k = 1; k < CALIB_POINTS - 1; k++){
+        static const double d[3] = {1, -2, 1};
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++) a[k - 1 + i][k - 1 + j] += penalty*d[i]*d[j];
+        }
+    }
+    if(!solve(a, b, x, m)){
+        fprintf(stderr, "the logs do not fix the table, add loads\n");
+        return 1;
+    }
+    for(i = 0; i < CALIB_POINTS; i++) point[i] = x[i];
+    if(temp){
+        span = x[CALIB_POINTS];
+        offset = x[CALIB_POINTS + 1];
+    }
+
+    for(i = 0; i < CALIB_POINTS; i++){
+        printf("set cal_p%d %.4f\n", i, point[i]);
+    }
+    printf("set cal_span %.7f\n", span);
+    printf("set cal_offset %.5f\n", offset);
+    printf("set cal_tref %.2f\n", tref);
+
+    // Check through the firmware table
+    Calib_Set(&table, point, FC_LOAD_PER_COUNT, span, offset, tref, CHIP_GAIN, CHIP_OFFSET, 0);
+    for(k = 0; k < n; k++){
+        uint32_t tempCounts = (uint32_t)floor((rows[k].temp - CHIP_OFFSET)/CHIP_GAIN + 0.5);
+        double load[2];
+
+        load[0] = rows[k].counts*(FC_LOAD_PER_COUNT/(1 << CALIB_FRAC_BITS));
+        load[1] = Calib_Apply(&table, (uint32_t)rows[k].counts, tempCounts)*(FC_LOAD_PER_COUNT/(1 << CALIB_FRAC_BITS));
+        for(i = 0; i < 2; i++){
+            e = load[i] - rows[k].reference;
+            sum[i] += e*e;
+            if(fabs(e) > fabs(worst[i])) worst[i] = e;
+        }
+    }
+    fprintf(stderr, "%d readings, chip %.1f to %.1f C, reference %.2f C%s\n", n, tmin, tmax, tref,
+            temp ? "" : ", no temperature terms");
+    fprintf(stderr, "nominal:    RMS error %.3f lb, largest %.3f lb\n", sqrt(sum[0]/n), worst[0]);
+    fprintf(stderr, "calibrated: RMS error %.3f lb, largest %.3f lb\n", sqrt(sum[1]/n), worst[1]);
+    return 0;
+}
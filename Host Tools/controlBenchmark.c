@@ -0,0 +1,232 @@
+// controlBenchmark.c
+// Runs on a host PC
+// Measures the cost per controller tick of the double, float32 and fixed point
+// versions of the PID and adaptive force laws in forceControl.c, and how far
+// the float32 and fixed point outputs are from the original double code.
+// Every variant is fed the same synthetic load cell trace (step + swing + noise
+// around the 45 lb rest load seen in the captures).
+//
+// Build:
+//   gcc -O2 -std=gnu99 -o controlBenchmark controlBenchmark.c "../Board Support Package/BSP/forceControl.c" -lm
+// Run:
+//   ./controlBenchmark [ticks] [repeats]
+//
+// Note: the cycles/tick and ns/tick columns are desktop numbers and say nothing
+// about the cost on the TM4C123. A desktop CPU has a double precision FPU and
+// 64 bit integer multiplies; the M4F runs double in the software library and
+// the Q formats in several 32 bit multiplies. Measure the target cost with
+// SLUG_PROFILE (profile.h) on the controller interrupt. The accuracy columns
+// hold on any machine.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "../Board Support Package/BSP/forceControl.h"
+
+// Same values as slug.c
+#define CONTROLLER_FREQ     2000
+#define GOAL_FORCE          60.0
+#define KBAR                0.04
+#define KI                  0.008
+#define KD                  0.0
+#define MIN_STEADY_ERROR    0.0
+#define MAX_STEADY_ERROR    100.0
+#define GAMMA_X             0.0002
+#define GAMMA_R             0.002
+
+typedef enum { LAW_PID, LAW_MRAC } law_t;
+
+typedef struct {
+    const char *name;
+    law_t law;
+    int numeric;
+} variant_t;
+
+static const variant_t variants[] = {
+    {"PID  double ", LAW_PID, FC_NUMERIC_DOUBLE},
+    {"PID  float32", LAW_PID, FC_NUMERIC_FLOAT},
+    {"PID  fixed  ", LAW_PID, FC_NUMERIC_FIXED},
+    {"MRAC double ", LAW_MRAC, FC_NUMERIC_DOUBLE},
+    {"MRAC float32", LAW_MRAC, FC_NUMERIC_FLOAT},
+    {"MRAC fixed  ", LAW_MRAC, FC_NUMERIC_FIXED},
+};
+#define NUM_VARIANTS (sizeof(variants)/sizeof(variants[0]))
+
+volatile uint32_t sink; // keeps the compiler from removing the loops
+
+//------------------clampCmd()---------------------------
+//Output as seen by the motor, limited to +/-100 percent
+static double clampCmd(double out){
+    if(out > FC_MAX_DUTY) return FC_MAX_DUTY;
+    if(out < -FC_MAX_DUTY) return -FC_MAX_DUTY;
+    return out;
+}
+
+//------------------nowNs()---------------------------
+//Monotonic time in nanoseconds
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+//------------------nowCycles()---------------------------
+//CPU time stamp counter, 0 when not available
+static uint64_t nowCycles(void){
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+//------------------makeTrace()---------------------------
+//Synthetic load cell trace in pound (Q16.16) of whole ADC counts: rest load,
+//a step towards the goal, a slow leg swing and white noise of a few counts
+static void makeTrace(int32_t *load, uint32_t n){
+    uint32_t i, lcg = 12345;
+    double rest = 45.0/FC_LOAD_PER_COUNT;
+    double goal = GOAL_FORCE/FC_LOAD_PER_COUNT;
+    for(i = 0; i < n; i++){
+        double t = (double)i/CONTROLLER_FREQ;
+        double v = rest + (goal - rest)*(1.0 - exp(-t*2.0));
+        v += 40.0*sin(2.0*M_PI*0.5*t);
+        lcg = lcg*1664525u + 1013904223u;
+        v += (double)(lcg >> 29) - 3.5;
+        if(v < 0) v = 0;
+        if(v > 4095) v = 4095;
+        load[i] = FC_LOAD_Q16((uint32_t)v);
+    }
+}
+
+//------------------runVariant()---------------------------
+//Run one variant over the trace, store the limited output and signed duty per tick
+static void runVariant(const variant_t *v, const int32_t *load, uint32_t n, double *out, int32_t *duty){
+    FC_PID_F64 pid64; FC_PID_F32 pid32; FC_PID_Q pidq;
+    FC_MRAC_F64 mrac64; FC_MRAC_F32 mrac32; FC_MRAC_Q mracq;
+    uint32_t i, acc = 0;
+
+    FC_PIDInit_F64(&pid64, KBAR, KI, KD, MIN_STEADY_ERROR, MAX_STEADY_ERROR);
+    FC_PIDInit_F32(&pid32, KBAR, KI, KD, MIN_STEADY_ERROR, MAX_STEADY_ERROR);
+    FC_PIDInit_Q(&pidq, KBAR, KI, KD, MIN_STEADY_ERROR, MAX_STEADY_ERROR);
+    FC_PIDSetGoal_F64(&pid64, GOAL_FORCE);
+    FC_PIDSetGoal_F32(&pid32, GOAL_FORCE);
+    FC_PIDSetGoal_Q(&pidq, GOAL_FORCE);
+    FC_MRACInit_F64(&mrac64, GAMMA_X, GAMMA_R, CONTROLLER_FREQ);
+    FC_MRACInit_F32(&mrac32, GAMMA_X, GAMMA_R, CONTROLLER_FREQ);
+    FC_MRACInit_Q(&mracq, GAMMA_X, GAMMA_R, CONTROLLER_FREQ);
+    FC_MRACSetGoal_F64(&mrac64, GOAL_FORCE);
+    FC_MRACSetGoal_F32(&mrac32, GOAL_FORCE);
+    FC_MRACSetGoal_Q(&mracq, GOAL_FORCE);
+
+    for(i = 0; i < n; i++){
+        switch(v->law*3 + v->numeric){
+        case LAW_PID*3 + FC_NUMERIC_DOUBLE:
+            FC_PIDStep_F64(&pid64, load[i]);
+            if(out){ out[i] = clampCmd(pid64.out); duty[i] = (int32_t)pid64.duty*(pid64.direction ? 1 : -1); }
+            acc += pid64.duty;
+            break;
+        case LAW_PID*3 + FC_NUMERIC_FLOAT:
+            FC_PIDStep_F32(&pid32, load[i]);
+            if(out){ out[i] = clampCmd(pid32.out); duty[i] = (int32_t)pid32.duty*(pid32.direction ? 1 : -1); }
+            acc += pid32.duty;
+            break;
+        case LAW_PID*3 + FC_NUMERIC_FIXED:
+            FC_PIDStep_Q(&pidq, load[i]);
+            if(out){ out[i] = clampCmd((double)pidq.out/FC_Q16_ONE); duty[i] = (int32_t)pidq.duty*(pidq.direction ? 1 : -1); }
+            acc += pidq.duty;
+            break;
+        case LAW_MRAC*3 + FC_NUMERIC_DOUBLE:
+            FC_MRACStep_F64(&mrac64, load[i]);
+            if(out){ out[i] = clampCmd(mrac64.out); duty[i] = (int32_t)mrac64.duty*(mrac64.direction ? 1 : -1); }
+            acc += mrac64.duty;
+            break;
+        case LAW_MRAC*3 + FC_NUMERIC_FLOAT:
+            FC_MRACStep_F32(&mrac32, load[i]);
+            if(out){ out[i] = clampCmd(mrac32.out); duty[i] = (int32_t)mrac32.duty*(mrac32.direction ? 1 : -1); }
+            acc += mrac32.duty;
+            break;
+        default:
+            FC_MRACStep_Q(&mracq, load[i]);
+            if(out){ out[i] = clampCmd((double)mracq.out/FC_Q16_ONE); duty[i] = (int32_t)mracq.duty*(mracq.direction ? 1 : -1); }
+            acc += mracq.duty;
+            break;
+        }
+    }
+    sink += acc;
+}
+
+int main(int argc, char **argv){
+    uint32_t n = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : 200000;
+    uint32_t repeats = (argc > 2) ? (uint32_t)strtoul(argv[2], 0, 0) : 20;
+    int32_t *load;
+    int32_t *duty[NUM_VARIANTS];
+    double *out[NUM_VARIANTS];
+    uint32_t v, r, i;
+
+    if(n == 0 || repeats == 0){
+        fprintf(stderr, "usage: %s [ticks] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    load = malloc(n*sizeof(*load));
+    if(!load){
+        return 1;
+    }
+    makeTrace(load, n);
+
+    printf("controller ticks: %u x %u repeats, %u Hz, goal %.1f lb\n", n, repeats, CONTROLLER_FREQ, GOAL_FORCE);
+    printf("%-14s %12s %12s %14s %14s\n", "variant", "cycles/tick", "ns/tick", "max|cmd-dbl|", "duty mismatch");
+
+    for(v = 0; v < NUM_VARIANTS; v++){
+        uint64_t bestCycles = UINT64_MAX, bestNs = UINT64_MAX;
+        double maxDiff = 0;
+        uint32_t mismatch = 0;
+
+        out[v] = malloc(n*sizeof(double));
+        duty[v] = malloc(n*sizeof(int32_t));
+        if(!out[v] || !duty[v]){
+            return 1;
+        }
+
+        // Reference run for the accuracy columns, then the timed runs
+        runVariant(&variants[v], load, n, out[v], duty[v]);
+        for(r = 0; r < repeats; r++){
+            uint64_t c0 = nowCycles(), t0 = nowNs();
+            runVariant(&variants[v], load, n, 0, 0);
+            uint64_t c1 = nowCycles(), t1 = nowNs();
+            if(c1 - c0 < bestCycles) bestCycles = c1 - c0;
+            if(t1 - t0 < bestNs) bestNs = t1 - t0;
+        }
+
+        // Compare with the double variant of the same law
+        if(variants[v].numeric != FC_NUMERIC_DOUBLE){
+            uint32_t ref = (variants[v].law == LAW_PID) ? 0 : 3;
+            for(i = 0; i < n; i++){
+                double d = fabs(out[v][i] - out[ref][i]);
+                if(d > maxDiff) maxDiff = d;
+                if(duty[v][i] != duty[ref][i]) mismatch++;
+            }
+        }
+
+#ifdef HAVE_RDTSC
+        printf("%-14s %12.1f %12.2f %14.4f %14u\n", variants[v].name,
+               (double)bestCycles/n, (double)bestNs/n, maxDiff, mismatch);
+#else
+        printf("%-14s %12s %12.2f %14.4f %14u\n", variants[v].name,
+               "n/a", (double)bestNs/n, maxDiff, mismatch);
+#endif
+    }
+    printf("max|cmd-dbl|: largest difference to the double law of the output limited to +/-100%%\n");
+    printf("duty mismatch: ticks where the integer duty or direction sent to the motor differs\n");
+    printf("cycles/tick, ns/tick: this host only, not the TM4C123\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+// encoderCheck.c
+// Runs on a host PC
+// Runs the encoder estimator of encoder.c against synthetic quadrature
+// streams. A motion profile gives the true position in counts, the QEI is
+// modelled edge by edge at SIM_FREQ: the count is the floor of the true
+// position (wrapping after TOP), the velocity timer latches the edges of each
+// period, its periods are offset from the controller ticks. At every tick the
+// estimate is compared to the true velocity and position, next to the plain
+// count difference per tick (what a controller would do without the
+// estimator) and to edge counting alone.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -I"../Board Support Package/BSP" -o encoderCheck encoderCheck.c "../Board Support Package/BSP/encoder.c" -lm
+// Run:
+//   ./encoderCheck [controller frequency Hz]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "encoder.h"
+
+#define SIM_FREQ        400000      // Hz, edge resolution of the model
+#define TOP             3999        // QEI maximum position, 1000 line encoder
+#define SECONDS         4.0
+#define TIMER_OFFSET    0.37        // velocity period end, fraction of a tick after the tick
+
+typedef struct {
+    const char *name;
+    double (*position)(double t);   // counts
+    double (*velocity)(double t);   // counts/s
+} Profile;
+
+static double slowPos(double t){ return 1000 + 25.0*t; }
+static double slowVel(double t){ (void)t; return 25.0; }
+static double fastPos(double t){ return 20000.0*t; }
+static double fastVel(double t){ (void)t; return 20000.0; }
+static double sinePos(double t){ return 1000 + 400.0*sin(2*M_PI*0.5*t); }
+static double sineVel(double t){ return 400.0*2*M_PI*0.5*cos(2*M_PI*0.5*t); }
+// Decelerates from 2000 counts/s to rest at t = 2 s, then holds
+static double stopPos(double t){ return (t < 2) ? 1000 + 2000*t - 500*t*t : 3000; }
+static double stopVel(double t){ return (t < 2) ? 2000 - 1000*t : 0; }
+static double reversePos(double t){ return 1000 + 40.0*t*(t - 2); }
+static double reverseVel(double t){ return 40.0*(2*t - 2); }
+
+static const Profile profiles[] = {
+    {"slow 25/s",        slowPos,    slowVel},
+    {"fast 20000/s",     fastPos,    fastVel},
+    {"sine 400 0.5Hz",   sinePos,    sineVel},
+    {"stop",             stopPos,    stopVel},
+    {"slow reversal",    reversePos, reverseVel},
+};
+
+typedef struct {
+    double sum2, max;
+    uint32_t n;
+} Error;
+
+static void addError(Error *e, double x){
+    x = fabs(x);
+    e->sum2 += x*x;
+    if(x > e->max) e->max = x;
+    e->n++;
+}
+
+static double rms(const Error *e){
+    return e->n ? sqrt(e->sum2/e->n) : 0;
+}
+
+//------------------wrap()---------------------------
+//QEI count of a true position
+static uint32_t wrap(double x){
+    int64_t c = (int64_t)floor(x);
+    int64_t range = TOP + 1;
+    return (uint32_t)(((c % range) + range) % range);
+}
+
+//------------------run()---------------------------
+//One profile at one controller rate
+static void run(const Profile *p, uint32_t freq){
+    Encoder_Estimator e;
+    uint32_t stepsPerTick = SIM_FREQ/freq;
+    uint32_t offset = (uint32_t)(TIMER_OFFSET*stepsPerTick);
+    uint64_t k, steps = (uint64_t)(SECONDS*SIM_FREQ);
+    int64_t count, lastCount, tickCount;
+    uint32_t edges = 0, latched = 0;
+    int32_t direction = 1;
+    Error est = {0}, diff = {0}, edge = {0}, pos = {0}, posFloor = {0};
+    double t, v, origin;
+
+    count = (int64_t)floor(p->position(0));
+    lastCount = tickCount = count;
+    origin = (double)wrap(p->position(0)) - (double)count; // estimator position minus true position
+    Encoder_Init(&e, wrap(p->position(0)), TOP, freq, freq);
+
+    for(k = 1; k <= steps; k++){
+        t = (double)k/SIM_FREQ;
+        count = (int64_t)floor(p->position(t));
+        if(count != lastCount){
+            direction = (count > lastCount) ? 1 : -1;
+            edges += (uint32_t)llabs(count - lastCount);
+            lastCount = count;
+        }
+        if((k % stepsPerTick) == offset){
+            latched = edges; // velocity timer period ends
+            edges = 0;
+        }
+        if((k % stepsPerTick) == 0){
+            Encoder_Update(&e, wrap(p->position(t)), latched, direction);
+            if(t < 0.5){
+                tickCount = count;
+                continue; // let the estimator start
+            }
+            v = p->velocity(t);
+            addError(&est, e.velocity/(double)(1 << ENCODER_FRAC_BITS) - v);
+            addError(&diff, (double)(count - tickCount)*freq - v);
+            addError(&edge, direction*(double)latched*freq - v);
+            addError(&pos, e.position/(double)(1 << ENCODER_FRAC_BITS) - origin - p->position(t));
+            addError(&posFloor, (double)count - p->position(t));
+            tickCount = count;
+        }
+    }
+    printf("%-16s %11.2f %11.2f %11.2f %11.2f %11.2f %11.2f %9.3f %9.3f\n", p->name,
+           rms(&est), est.max, rms(&diff), diff.max, rms(&edge), edge.max, rms(&posFloor), rms(&pos));
+}
+
+int main(int argc, char **argv){
+    uint32_t freq = (argc > 1) ? (uint32_t)atoi(argv[1]) : 2000;
+    unsigned i;
+
+    if(freq < 100 || freq > SIM_FREQ/10){
+        fprintf(stderr, "usage: %s [controller frequency 100 to %u Hz]\n", argv[0], SIM_FREQ/10);
+        return 1;
+    }
+    printf("controller %u Hz, QEI top %u, velocity errors in counts/s (RMS and max), position RMS in counts\n",
+           freq, TOP);
+    printf("%-16s %11s %11s %11s %11s %11s %11s %9s %9s\n", "profile", "est rms", "est max",
+           "diff rms", "diff max", "edges rms", "edges max", "count", "estimate");
+    for(i = 0; i < sizeof(profiles)/sizeof(profiles[0]); i++){
+        run(&profiles[i], freq);
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+// gaitTable.c
+// Runs on a host PC
+// Compiles a gait profile into a Gait_Table for the firmware (gait.h). The
+// profile is a CSV of one cycle, "phase, value" rows with the phase from 0
+// to 1, or, with -period, a logger capture ("sample, value, ...") that is
+// folded over its cycle period and averaged. The profile is resampled to
+// 2^bits points around the cycle, optionally smoothed to its first harmonics,
+// scaled to the table units (lb*2^16 for force, counts*2^8 for position) and
+// written as C source on stdout. The table is then played through gait.c
+// over one cycle and the error against the resampled profile is reported on
+// stderr.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -I"../Board Support Package/BSP" -o gaitTable gaitTable.c "../Board Support Package/BSP/gait.c" -lm
+// Run:
+//   ./gaitTable profile.csv name [-position] [-bits n] [-scale s]
+//               [-period samples] [-start sample] [-column n] [-harmonics n] > name.c
+// Example, the swing cycle of Data Collection/feedforward controller
+// (swingCycle.pdf), 300 logger samples per cycle, load cell ADC counts to lb:
+//   ./gaitTable "../Data Collection/feedforward controller/capture3.txt" gaitSwing
+//               -period 300 -start 301 -scale 0.020147 -harmonics 8 > "../Board Support Package/BSP/gaitSwing.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "gait.h"
+
+#define MAX_ROWS        200000
+#define MAX_COLUMNS     16
+#define CHECK_FREQ      2000    // Hz, player rate for the check
+#define CHECK_CADENCE   1000    // mHz
+
+typedef struct {
+    double phase, value;
+} Point;
+
+static Point points[MAX_ROWS];
+static double profile[1 << GAIT_MAX_BITS];
+static int32_t value[1 << GAIT_MAX_BITS];
+static int32_t slope[1 << GAIT_MAX_BITS];
+
+//------------------byPhase()---------------------------
+static int byPhase(const void *a, const void *b){
+    double d = ((const Point *)a)->phase - ((const Point *)b)->phase;
+    return (d > 0) - (d < 0);
+}
+
+//------------------readCSV()---------------------------
+//Read the profile. Phase rows, or capture rows folded over period samples
+//Output: Points read, -1 on error
+static int readCSV(const char *path, double period, double start, int column){
+    FILE *f = fopen(path, "r");
+    char line[1024];
+    int n = 0;
+
+    if(!f){
+        perror(path);
+        return -1;
+    }
+    while(fgets(line, sizeof(line), f) && n < MAX_ROWS){
+        double col[MAX_COLUMNS];
+        char *p = line, *end;
+        int k = 0;
+
+        while(k < MAX_COLUMNS){
+            while(*p == ' ' || *p == '\t' || *p == ',') p++;
+            col[k] = strtod(p, &end);
+            if(end == p) break;
+            k++;
+            p = end;
+        }
+        if(k < 2 || k < column){
+            continue; // header or blank line
+        }
+        if(period > 0){
+            if(col[0] < start) continue;
+            points[n].phase = fmod(col[0] - start, period)/period;
+            points[n].value = col[column - 1];
+        }else{
+            points[n].phase = col[0] - floor(col[0]);
+            points[n].value = col[1];
+        }
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+//------------------resample()---------------------------
+//Profile at size points around the cycle. Phase rows are interpolated,
+//folded captures are averaged per point
+static void resample(int n, int size, int folded){
+    int i, j;
+
+    if(folded){
+        static double sum[1 << GAIT_MAX_BITS];
+        static int count[1 << GAIT_MAX_BITS];
+
+        for(i = 0; i < size; i++){
+            sum[i] = 0;
+            count[i] = 0;
+        }
+        for(j = 0; j < n; j++){
+            // Nearest point, so point i averages the phases around i/size
+            i = (int)floor(points[j].phase*size + 0.5) % size;
+            sum[i] += points[j].value;
+            count[i]++;
+        }
+        for(i = 0; i < size; i++){
+            if(count[i]) profile[i] = sum[i]/count[i];
+        }
+        // Points no sample fell on, interpolated around the cycle
+        for(i = 0; i < size; i++){
+            int back = 1, ahead = 1;
+            if(count[i]) continue;
+            while(back < size && !count[(i - back + size) % size]) back++;
+            while(ahead < size && !count[(i + ahead) % size]) ahead++;
+            profile[i] = profile[(i - back + size) % size] + (double)back/(back + ahead)*
+                         (profile[(i + ahead) % size] - profile[(i - back + size) % size]);
+        }
+        return;
+    }
+
+    qsort(points, n, sizeof(Point), byPhase);
+    for(i = 0; i < size; i++){
+        double ph = (double)i/size;
+        Point lo, hi;
+        // Last point at or before ph and first after it, around the cycle
+        for(j = 0; j < n && points[j].phase <= ph; j++);
+        lo = (j > 0) ? points[j - 1] : (Point){points[n - 1].phase - 1, points[n - 1].value};
+        hi = (j < n) ? points[j] : (Point){points[0].phase + 1, points[0].value};
+        profile[i] = (hi.phase > lo.phase) ?
+            lo.value + (ph - lo.phase)*(hi.value - lo.value)/(hi.phase - lo.phase) : lo.value;
+    }
+}
+
+//------------------smooth()---------------------------
+//Keep the mean and the first harmonics of the profile
+static void smooth(int size, int harmonics){
+    static double out[1 << GAIT_MAX_BITS];
+    int i, k, j;
+
+    for(i = 0; i < size; i++){
+        out[i] = 0;
+    }
+    for(k = 0; k <= harmonics && k <= size/2; k++){
+        double re = 0, im = 0;
+        for(j = 0; j < size; j++){
+            re += profile[j]*cos(2*M_PI*k*j/size);
+            im += profile[j]*sin(2*M_PI*k*j/size);
+        }
+        re *= (k == 0 || 2*k == size) ? 1.0/size : 2.0/size;
+        im *= (k == 0 || 2*k == size) ? 1.0/size : 2.0/size;
+        for(i = 0; i < size; i++){
+            out[i] += re*cos(2*M_PI*k*i/size) + im*sin(2*M_PI*k*i/size);
+        }
+    }
+    memcpy(profile, out, size*sizeof(double));
+}
+
+//------------------printArray()---------------------------
+static void printArray(const char *name, const char *suffix, const int32_t *a, int size){
+    int i;
+    printf("static const int32_t %s%s[%d] = {\n", name, suffix, size);
+    for(i = 0; i < size; i++){
+        printf("%s%d,%s", (i % 8) ? " " : "    ", a[i], (i % 8 == 7 || i == size - 1) ? "\n" : "");
+    }
+    printf("};\n\n");
+}
+
+int main(int argc, char **argv){
+    const char *path, *name;
+    Gait_Kind kind = GAIT_FORCE;
+    int bits = 8, column = 2, harmonics = -1;
+    double scale = 1, period = 0, start = 0, one, err, maxErr = 0, sumErr = 0, rateErr = 0;
+    int32_t lo, hi;
+    int n, size, i, a;
+    Gait_Table table;
+    Gait_Player player;
+    uint32_t k, ticks;
+
+    if(argc < 3){
+        fprintf(stderr, "usage: %s profile.csv name [-position] [-bits n] [-scale s] [-period samples] [-start sample] [-column n] [-harmonics n]\n", argv[0]);
+        return 1;
+    }
+    path = argv[1];
+    name = argv[2];
+    for(a = 3; a < argc; a++){
+        if(strcmp(argv[a], "-position") == 0){
+            kind = GAIT_POSITION;
+        }else if(strcmp(argv[a], "-bits") == 0 && a + 1 < argc){
+            bits = atoi(argv[++a]);
+        }else if(strcmp(argv[a], "-scale") == 0 && a + 1 < argc){
+            scale = atof(argv[++a]);
+        }else if(strcmp(argv[a], "-period") == 0 && a + 1 < argc){
+            period = atof(argv[++a]);
+        }else if(strcmp(argv[a], "-start") == 0 && a + 1 < argc){
+            start = atof(argv[++a]);
+        }else if(strcmp(argv[a], "-column") == 0 && a + 1 < argc){
+            column = atoi(argv[++a]);
+        }else if(strcmp(argv[a], "-harmonics") == 0 && a + 1 < argc){
+            harmonics = atoi(argv[++a]);
+        }else{
+            fprintf(stderr, "unknown option %s\n", argv[a]);
+            return 1;
+        }
+    }
+    if(bits < 1 || bits > GAIT_MAX_BITS || column < 2 || column > MAX_COLUMNS){
+        fprintf(stderr, "bits must be 1 to %d, column 2 to %d\n", GAIT_MAX_BITS, MAX_COLUMNS);
+        return 1;
+    }
+
+    n = readCSV(path, period, start, column);
+    if(n < 2){
+        fprintf(stderr, "%s: not enough rows\n", path);
+        return 1;
+    }
+    size = 1 << bits;
+    resample(n, size, period > 0);
+    if(harmonics >= 0){
+        smooth(size, harmonics);
+    }
+
+    // Table units
+    one = (kind == GAIT_FORCE) ? (1 << GAIT_FORCE_FRAC_BITS) : (1 << GAIT_POSITION_FRAC_BITS);
+    for(i = 0; i < size; i++){
+        profile[i] *= scale;
+        value[i] = (int32_t)floor(profile[i]*one + 0.5);
+    }
+    for(i = 0; i < size; i++){
+        slope[i] = value[(i + 1) % size] - value[i];
+    }
+
+    // Play it back over one cycle against the profile between its points
+    table = (Gait_Table){name, kind, (uint32_t)bits, value, slope};
+    Gait_Init(&player, &table, CHECK_FREQ);
+    Gait_SetCadence(&player, CHECK_CADENCE);
+    ticks = CHECK_FREQ*1000/CHECK_CADENCE;
+    for(k = 0; k < ticks; k++){
+        double x, want, wantRate;
+        int j;
+
+        Gait_Step(&player);
+        x = (double)player.phase/4294967296.0*size;
+        j = (int)x;
+        want = profile[j] + (x - j)*(profile[(j + 1) % size] - profile[j]);
+        wantRate = (profile[(j + 1) % size] - profile[j])*size*CHECK_CADENCE/1000.0;
+        err = fabs(player.value/one - want);
+        if(err > maxErr) maxErr = err;
+        sumErr += err*err;
+        err = fabs(player.rate/one - wantRate);
+        if(err > rateErr) rateErr = err;
+    }
+
+    printf("// %s.c\n", name);
+    printf("// Runs on TM4C123 with TIVA shield v2.0, also builds on a host PC\n");
+    printf("// Gait table generated by Host Tools/gaitTable from %s, do not edit.\n", path);
+    printf("// %s, %d points, scale %g", (kind == GAIT_FORCE) ? "Force in lb*2^16" : "Position in counts*2^8", size, scale);
+    if(period > 0) printf(", folded over %g samples from sample %g", period, start);
+    if(harmonics >= 0) printf(", %d harmonics", harmonics);
+    printf("\n\n#include \"gait.h\"\n\n");
+    printArray(name, "Value", value, size);
+    printArray(name, "Slope", slope, size);
+    printf("const Gait_Table %s = {\"%s\", %s, %d, %sValue, %sSlope};\n",
+           name, name, (kind == GAIT_FORCE) ? "GAIT_FORCE" : "GAIT_POSITION", bits, name, name);
+
+    lo = hi = value[0];
+    for(i = 1; i < size; i++){
+        if(value[i] < lo) lo = value[i];
+        if(value[i] > hi) hi = value[i];
+    }
+    fprintf(stderr, "%d rows, %d points, range %.3f to %.3f %s\n", n, size,
+            lo/one, hi/one, (kind == GAIT_FORCE) ? "lb" : "counts");
+    fprintf(stderr, "playback at %u mHz: max error %.5f, RMS %.5f, max rate error %.4f per s\n",
+            CHECK_CADENCE, maxErr, sqrt(sumErr/ticks), rateErr);
+    return 0;
+}
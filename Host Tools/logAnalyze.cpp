@@ -0,0 +1,622 @@
+// logAnalyze.cpp
+// Runs on a host PC
+// Step response analysis of the Data Collection captures, in place of the
+// MATLAB scripts (stepResponse_final.m, stepResp_lowSpeedLog.m, loadCell.m,
+// feedForward.m). Each file is read once, in fixed size blocks, and the load
+// goes through a running median and a first order low pass as it streams, so
+// a capture of any length is analyzed in the same few megabytes. Files are
+// analyzed in parallel, one per worker thread.
+//
+// Formats, detected from the first row or set with -format (see replay.c):
+//   clog     - sample, load lb, duty %             (PI control step resp/c_log.txt, c2.txt)
+//   c1       - load lb, PID output                 (PI control step resp/c1.txt)
+//   lowspeed - load lb, PID output, error lb       (PI control step resp/lowSpeedLog*.txt)
+//   capture  - sample, load ADC, duty %, direction (feedforward controller/capture*.txt)
+//   csv      - "sample", "load ADC"                (load cell/*.csv)
+//   column   - load lb                             (PI control step resp/c1_sec.txt)
+// The first four are written by the text loggers and decoded as replay.c
+// does, csv and column are plain decimals. Rows that do not parse are
+// skipped and counted.
+//
+// Step metrics, on the filtered load:
+//   initial  - mean of the first -baseline rows
+//   start    - first row more than -threshold away from the initial value
+//   final    - mean of the last -tail rows
+//   rise     - 10 % to 90 % of final - initial, up or down steps alike
+//   overshoot- largest excursion past the final value, % of the step
+//   settling - from the start to the last row outside -band % of the step
+//   error    - goal - final, with -goal or the goal of lowspeed rows
+// The final value is only known at the end of the file, so the first and the
+// last row at each level of a grid (-resolution apart) are kept instead of
+// the samples, and the crossings are read from the grid at the end.
+//
+// Build:
+//   g++ -O2 -std=c++11 -pthread -o logAnalyze logAnalyze.cpp
+// Run:
+//   ./logAnalyze file... [-format name] [-rate Hz] [-median n] [-cutoff Hz] [-goal value]
+//                [-threshold value] [-baseline n] [-tail n] [-band %] [-resolution value]
+//                [-j threads] [-csv out.csv]
+//   e.g. ./logAnalyze "../Data Collection/PI control step resp/"*.txt -csv steps.csv
+// -median 10 is the medfilt1(L,10) of stepResponse_final.m, causal here, so
+// every row is delayed by half the window and the times between rows are
+// not. -cutoff 0 turns the low pass off. Values are in the units of the
+// file, lb or ADC counts, -threshold and -resolution too, which default to
+// 2 lb and 0.01 lb or 1 count.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ANALYZE_MAX_FIELDS  8
+#define ANALYZE_LINE_SIZE   256
+#define ANALYZE_BLOCK_SIZE  (1 << 20)   // bytes read at a time
+#define ANALYZE_MEDIAN_MAX  255
+#define ANALYZE_CELLS       (1 << 17)   // levels of the crossing grid, centered on the initial value
+#define ANALYZE_RATE        100.0       // Hz, text logger rate of the captures
+#define ANALYZE_GOAL_STEP   0.5         // lb, lowspeed goals are rounded to this, as in replay.c
+#define ANALYZE_THRESHOLD   2.0         // lb, default step threshold
+#define ANALYZE_LB_PER_COUNT (3.3*25.0/4095.0)  // FC_LOAD_PER_COUNT of forceControl.h
+
+enum Format {
+    FORMAT_CLOG,
+    FORMAT_C1,
+    FORMAT_LOWSPEED,
+    FORMAT_CAPTURE,
+    FORMAT_CSV,
+    FORMAT_COLUMN,
+    NUM_FORMATS
+};
+
+static const char *const formatName[NUM_FORMATS] = {"clog", "c1", "lowspeed", "capture", "csv", "column"};
+static const int formatFields[NUM_FORMATS] = {3, 2, 3, 4, 2, 1};
+static const int loadField[NUM_FORMATS] = {1, 0, 0, 1, 1, 0};
+static const int dutyField[NUM_FORMATS] = {2, 1, 1, 2, -1, -1};    // -1, no duty
+static const bool plainDecimals[NUM_FORMATS] = {false, false, false, false, true, true};
+
+struct Options {
+    int format = -1;
+    double rate = ANALYZE_RATE;
+    unsigned median = 10;
+    double cutoff = 0;          // Hz, 0 is no low pass
+    double goal = NAN;
+    double threshold = 0;       // 0, ANALYZE_THRESHOLD in the units of the format
+    unsigned long baseline = 100;
+    unsigned long tail = 500;
+    double band = 2;            // % of the step
+    double resolution = 0;      // 0, by format: 0.01 lb or 1 ADC count
+};
+
+struct Result {
+    std::string path, error;
+    int format = -1;
+    unsigned long rows = 0, skipped = 0;
+    double loadMin = 0, loadMax = 0, loadMean = 0, loadStd = 0;
+    double dutyMean = 0, dutyMax = 0;   // of the duty magnitude
+    double goal = NAN;
+    bool step = false;
+    double start = 0, initial = 0, final = 0;
+    double rise = NAN, overshoot = 0, settling = NAN, ssError = NAN;
+    double seconds = 0;                 // host time
+    uint64_t bytes = 0;
+};
+
+//------------------parseField()---------------------------
+//One number of a row. Logger numbers are decoded as in replay.c, plain
+//ones with strtod(). Leading labels and quotes are skipped
+//Input: text, value out, 1 out if it has a fraction, plain decimals
+//Output: End of the number, 0 if there is none
+static const char *parseField(const char *s, double *value, int *hasFraction, bool plain){
+    long whole, fraction = 0;
+    bool negative;
+    char *end;
+
+    while(*s && *s != '-' && !std::isdigit((unsigned char)*s)){
+        if(*s == ','){
+            return 0;               // empty field
+        }
+        s++;
+    }
+    if(!*s){
+        return 0;
+    }
+    if(plain){
+        *value = std::strtod(s, &end);
+        *hasFraction = (std::memchr(s, '.', end - s) != 0);
+        return (end == s) ? 0 : end;
+    }
+    negative = (*s == '-');
+    whole = std::strtol(s, &end, 10);
+    if(end == s || (negative && end == s + 1)){
+        return 0;
+    }
+    s = end;
+    *hasFraction = (*s == '.');
+    if(*hasFraction){
+        s++;
+        while(*s == ' '){
+            s++;                    // "%2d" pads a fraction below 10
+        }
+        if(std::isdigit((unsigned char)*s)){
+            fraction = std::strtol(s, &end, 10);
+            s = end;
+        }
+    }
+    if(negative){
+        *value = (fraction/1000.0 >= -whole) ? -(fraction/1000.0 + whole) : whole - fraction/1000.0;
+    }else{
+        *value = whole + fraction/1000.0;
+    }
+    return s;
+}
+
+//------------------parseLine()---------------------------
+//Split a row into its numbers
+//Input: row, values out, fraction flags out, room for values, plain decimals
+//Output: Number of values, 0 for a row that does not parse
+static int parseLine(const char *line, double *values, int *hasFraction, int max, bool plain){
+    int n = 0;
+
+    while(*line && n < max){
+        line = parseField(line, &values[n], &hasFraction[n], plain);
+        if(!line){
+            return 0;
+        }
+        n++;
+        while(*line == ' ' || *line == '\t' || *line == '\r' || *line == '\n' || *line == '"'){
+            line++;
+        }
+        if(*line == ','){
+            line++;
+        }else if(*line){
+            return 0;
+        }
+    }
+    return *line ? 0 : n;
+}
+
+//------------------detectFormat()---------------------------
+//Format of a capture from one parsed row
+static int detectFormat(const char *line, int n, const int *hasFraction){
+    if(std::strchr(line, '"')){
+        return FORMAT_CSV;
+    }
+    if(std::strchr(line, ':') || n == 4){
+        return FORMAT_CAPTURE;
+    }
+    if(n == 3){
+        return hasFraction[0] ? FORMAT_LOWSPEED : FORMAT_CLOG;
+    }
+    if(n == 2){
+        return FORMAT_C1;
+    }
+    return (n == 1) ? FORMAT_COLUMN : -1;
+}
+
+// Median of the last n rows: the window in arrival order and sorted
+class RunningMedian {
+public:
+    explicit RunningMedian(unsigned n) : size(n), count(0), next(0) {}
+
+    double add(double x){
+        if(count == size){
+            double *old = std::lower_bound(sorted, sorted + count, ring[next]);
+            std::copy(old + 1, sorted + count, old);
+            count--;
+        }
+        double *at = std::upper_bound(sorted, sorted + count, x);
+        std::copy_backward(at, sorted + count, sorted + count + 1);
+        *at = x;
+        count++;
+        ring[next] = x;
+        next = (next + 1) % size;
+        return (count & 1) ? sorted[count/2] : (sorted[count/2 - 1] + sorted[count/2])/2;
+    }
+
+private:
+    unsigned size, count, next;
+    double ring[ANALYZE_MEDIAN_MAX];
+    double sorted[ANALYZE_MEDIAN_MAX];
+};
+
+// Rows of a file, read ANALYZE_BLOCK_SIZE bytes at a time
+class LineReader {
+public:
+    explicit LineReader(const std::string &path) : bytes(0), tooLong(0), in(std::fopen(path.c_str(), "rb")),
+        block(ANALYZE_BLOCK_SIZE + 1), begin(0), end(0) {
+        if(!in){
+            throw std::runtime_error(std::strerror(errno));
+        }
+    }
+    ~LineReader(){
+        std::fclose(in);
+    }
+
+    //------------------next()---------------------------
+    //Next row, without its end of line. Rows longer than ANALYZE_LINE_SIZE
+    //are dropped and counted
+    //Input: row out
+    //Output: false at the end of the file
+    bool next(const char **line){
+        for(;;){
+            char *nl = static_cast<char *>(std::memchr(&block[begin], '\n', end - begin));
+            if(!nl && (begin > 0 || end == block.size() - 1)){
+                if(begin == 0){                     // a row longer than the block
+                    end = 0;
+                    tooLong++;
+                    skipRest = true;
+                }else{
+                    std::memmove(&block[0], &block[begin], end - begin);
+                    end -= begin;
+                    begin = 0;
+                }
+                continue;
+            }
+            if(!nl){
+                size_t got = std::fread(&block[end], 1, block.size() - 1 - end, in);
+                bytes += got;
+                if(got > 0){
+                    end += got;
+                    continue;
+                }
+                if(end == begin){
+                    return false;
+                }
+                nl = &block[end];                   // last row without an end of line
+                end++;
+            }
+            *nl = 0;
+            char *row = &block[begin];
+            begin = nl - &block[0] + 1;
+            if(skipRest){
+                skipRest = false;                   // the end of a row longer than the block
+                continue;
+            }
+            if(nl - row > ANALYZE_LINE_SIZE){
+                tooLong++;
+                continue;
+            }
+            *line = row;
+            return true;
+        }
+    }
+
+    uint64_t bytes;
+    unsigned long tooLong;
+
+private:
+    std::FILE *in;
+    std::vector<char> block;
+    size_t begin, end;
+    bool skipRest = false;
+};
+
+//------------------reach()---------------------------
+//First row at or past a level, from the first row of each cell
+//Input: first rows (+1, 0 never), cell of the level, direction of the step
+//Output: Row +1, 0 if the level was never reached
+static uint64_t reach(const std::vector<uint64_t> &first, long cell, bool up){
+    uint64_t best = 0;
+
+    for(long c = cell; c >= 0 && c < ANALYZE_CELLS; c += up ? 1 : -1){
+        if(first[c] && (!best || first[c] < best)){
+            best = first[c];
+        }
+    }
+    return best;
+}
+
+//------------------lastOutside()---------------------------
+//Last row in the cells above hi or below lo
+//Input: last rows (+1, 0 never), cells of the band
+//Output: Row +1, 0 if the load never left the band
+static uint64_t lastOutside(const std::vector<uint64_t> &last, long lo, long hi){
+    uint64_t best = 0;
+
+    for(long c = 0; c < ANALYZE_CELLS; c++){
+        if((c < lo || c > hi) && last[c] > best){
+            best = last[c];
+        }
+    }
+    return best;
+}
+
+//------------------analyze()---------------------------
+//One pass over a file, see the file header
+//Input: options, result with its path, out
+static void analyze(const Options &opt, Result &r){
+    auto t0 = std::chrono::steady_clock::now();
+    LineReader reader(r.path);
+    RunningMedian median(opt.median);
+    std::vector<uint64_t> firstIn(ANALYZE_CELLS, 0), lastIn(ANALYZE_CELLS, 0);
+    std::vector<double> tail(opt.tail);
+    double values[ANALYZE_MAX_FIELDS];
+    int hasFraction[ANALYZE_MAX_FIELDS];
+    double alpha = (opt.cutoff > 0) ? 1 - std::exp(-2*M_PI*opt.cutoff/opt.rate) : 1;
+    double filtered = 0, baseSum = 0, tailSum = 0, sum = 0, sumSquares = 0, dutySum = 0;
+    double resolution = opt.resolution, threshold = opt.threshold, origin = 0, peakMax = 0, peakMin = 0, lastGoal = NAN;
+    uint64_t row = 0, start = 0;
+    const char *line;
+    int n;
+
+    r.format = opt.format;
+    while(reader.next(&line)){
+        bool plain = (r.format >= 0) && plainDecimals[r.format];
+        n = parseLine(line, values, hasFraction, ANALYZE_MAX_FIELDS, plain);
+        if(n == 0){
+            if(std::strspn(line, " \t\r") != std::strlen(line)){
+                r.skipped++;    // blank lines are not counted
+            }
+            continue;
+        }
+        if(r.format < 0){
+            r.format = detectFormat(line, n, hasFraction);
+            if(r.format < 0){
+                throw std::runtime_error("unknown format, " + std::to_string(n) + " values per row");
+            }
+            if(plainDecimals[r.format]){
+                n = parseLine(line, values, hasFraction, ANALYZE_MAX_FIELDS, true);
+            }
+        }
+        if(row == 0){
+            bool counts = (r.format == FORMAT_CAPTURE || r.format == FORMAT_CSV);
+            if(resolution <= 0){
+                resolution = counts ? 1 : 0.01;
+            }
+            if(threshold <= 0){
+                threshold = counts ? ANALYZE_THRESHOLD/ANALYZE_LB_PER_COUNT : ANALYZE_THRESHOLD;
+            }
+        }
+        if(n != formatFields[r.format]){
+            r.skipped++;
+            continue;
+        }
+
+        double load = values[loadField[r.format]];
+        if(dutyField[r.format] >= 0){
+            double duty = std::fabs(values[dutyField[r.format]]);
+            dutySum += duty;
+            r.dutyMax = std::max(r.dutyMax, duty);
+        }
+        if(r.format == FORMAT_LOWSPEED){
+            lastGoal = std::floor((values[0] + values[2])/ANALYZE_GOAL_STEP + 0.5)*ANALYZE_GOAL_STEP;
+        }
+        if(row == 0){
+            r.loadMin = r.loadMax = load;
+        }
+        r.loadMin = std::min(r.loadMin, load);
+        r.loadMax = std::max(r.loadMax, load);
+        sum += load;
+        sumSquares += load*load;
+
+        // Median then low pass
+        double m = median.add(load);
+        filtered = (row == 0) ? m : filtered + alpha*(m - filtered);
+
+        if(opt.tail > 0){
+            tailSum += filtered - ((row >= opt.tail) ? tail[row % opt.tail] : 0);
+            tail[row % opt.tail] = filtered;
+        }
+        if(row < opt.baseline){
+            baseSum += filtered;
+        }else if(!r.step){
+            if(row == opt.baseline){
+                r.initial = baseSum/opt.baseline;
+                origin = r.initial - (ANALYZE_CELLS/2)*resolution;
+            }
+            if(std::fabs(filtered - r.initial) > threshold){
+                r.step = true;
+                start = row;
+                peakMax = peakMin = filtered;
+            }
+        }
+        if(r.step){
+            long cell = std::lround((filtered - origin)/resolution);
+            cell = std::min(std::max(cell, 0L), (long)ANALYZE_CELLS - 1);
+            if(!firstIn[cell]){
+                firstIn[cell] = row + 1;
+            }
+            lastIn[cell] = row + 1;
+            peakMax = std::max(peakMax, filtered);
+            peakMin = std::min(peakMin, filtered);
+        }
+        row++;
+    }
+    r.rows = row;
+    r.skipped += reader.tooLong;
+    r.bytes = reader.bytes;
+    if(row == 0){
+        throw std::runtime_error("no rows");
+    }
+    r.loadMean = sum/row;
+    r.loadStd = std::sqrt(std::max(0.0, sumSquares/row - r.loadMean*r.loadMean));
+    r.dutyMean = dutySum/row;
+    r.goal = !std::isnan(opt.goal) ? opt.goal : lastGoal;
+
+    if(r.step){
+        unsigned long tailRows = std::min<uint64_t>(opt.tail, row - start);
+        if(tailRows == opt.tail){
+            r.final = tailSum/opt.tail;
+        }else{
+            r.final = filtered;     // the step ends too close to the end of the file
+        }
+        double step = r.final - r.initial;
+        bool up = step > 0;
+        auto cellOf = [&](double v){
+            return std::min(std::max(std::lround((v - origin)/resolution), 0L), (long)ANALYZE_CELLS - 1);
+        };
+        uint64_t t10 = reach(firstIn, cellOf(r.initial + 0.1*step), up);
+        uint64_t t90 = reach(firstIn, cellOf(r.initial + 0.9*step), up);
+        double band = std::fabs(step)*opt.band/100;
+        uint64_t out = lastOutside(lastIn, cellOf(r.final - band), cellOf(r.final + band));
+
+        r.start = start/opt.rate;
+        if(t10 && t90){
+            r.rise = (double)(t90 - t10)/opt.rate;
+        }
+        if(step != 0){
+            r.overshoot = std::max(0.0, 100*(up ? peakMax - r.final : r.final - peakMin)/std::fabs(step));
+        }
+        r.settling = out ? (out - start)/opt.rate : 0;
+        if(!std::isnan(r.goal)){
+            r.ssError = r.goal - r.final;
+        }
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//------------------print()---------------------------
+//Summary of one file on stdout
+static void print(const Options &opt, const Result &r){
+    if(!r.error.empty()){
+        std::printf("%s: %s\n", r.path.c_str(), r.error.c_str());
+        return;
+    }
+    std::printf("%s: %s format, %lu rows (%.1f s at %.0f Hz), %lu skipped\n", r.path.c_str(), formatName[r.format],
+                r.rows, r.rows/opt.rate, opt.rate, r.skipped);
+    std::printf("  load min %.3f mean %.3f max %.3f std %.3f", r.loadMin, r.loadMean, r.loadMax, r.loadStd);
+    if(dutyField[r.format] >= 0){
+        std::printf(", |duty| mean %.3f max %.3f", r.dutyMean, r.dutyMax);
+    }
+    std::printf("\n");
+    if(!r.step){
+        std::printf("  no step from %.3f\n", r.initial);
+        return;
+    }
+    std::printf("  step at %.2f s from %.3f to %.3f: rise %.2f s, overshoot %.1f %%, settling %.2f s",
+                r.start, r.initial, r.final, r.rise, r.overshoot, r.settling);
+    if(!std::isnan(r.ssError)){
+        std::printf(", error %.3f (goal %.2f)", r.ssError, r.goal);
+    }
+    std::printf("\n");
+}
+
+static int usage(const char *name){
+    std::cerr << "usage: " << name << " file... [-format clog|c1|lowspeed|capture|csv|column] [-rate Hz]\n"
+              << "       [-median n] [-cutoff Hz] [-goal value] [-threshold value] [-baseline n] [-tail n]\n"
+              << "       [-band %] [-resolution value] [-j threads] [-csv out.csv]\n";
+    return 2;
+}
+
+int main(int argc, char **argv){
+    Options opt;
+    std::vector<Result> results;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const char *csvPath = 0;
+
+    for(int a = 1; a < argc; a++){
+        std::string arg = argv[a];
+        bool value = a + 1 < argc;
+        if(arg == "-format" && value){
+            a++;
+            for(opt.format = 0; opt.format < NUM_FORMATS && std::strcmp(argv[a], formatName[opt.format]) != 0; opt.format++){
+            }
+            if(opt.format == NUM_FORMATS){
+                std::cerr << "unknown format " << argv[a] << "\n";
+                return 2;
+            }
+        }else if(arg == "-rate" && value){
+            opt.rate = std::atof(argv[++a]);
+        }else if(arg == "-median" && value){
+            opt.median = (unsigned)std::atoi(argv[++a]);
+        }else if(arg == "-cutoff" && value){
+            opt.cutoff = std::atof(argv[++a]);
+        }else if(arg == "-goal" && value){
+            opt.goal = std::atof(argv[++a]);
+        }else if(arg == "-threshold" && value){
+            opt.threshold = std::atof(argv[++a]);
+        }else if(arg == "-baseline" && value){
+            opt.baseline = std::strtoul(argv[++a], 0, 10);
+        }else if(arg == "-tail" && value){
+            opt.tail = std::strtoul(argv[++a], 0, 10);
+        }else if(arg == "-band" && value){
+            opt.band = std::atof(argv[++a]);
+        }else if(arg == "-resolution" && value){
+            opt.resolution = std::atof(argv[++a]);
+        }else if(arg == "-j" && value){
+            threads = (unsigned)std::atoi(argv[++a]);
+        }else if(arg == "-csv" && value){
+            csvPath = argv[++a];
+        }else if(arg[0] == '-'){
+            return usage(argv[0]);
+        }else{
+            results.emplace_back();
+            results.back().path = arg;
+        }
+    }
+    if(results.empty()){
+        return usage(argv[0]);
+    }
+    if(opt.rate <= 0 || opt.median < 1 || opt.median > ANALYZE_MEDIAN_MAX || opt.baseline < 1 || opt.tail < 1 ||
+       threads < 1){
+        std::cerr << "rate, baseline, tail and threads must be above 0, median 1 to " << ANALYZE_MEDIAN_MAX << "\n";
+        return 2;
+    }
+
+    // Workers take the next file until there are none left
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    auto t0 = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < std::min<size_t>(threads, results.size()); i++){
+        workers.emplace_back([&](){
+            for(size_t f = next++; f < results.size(); f = next++){
+                try{
+                    analyze(opt, results[f]);
+                }catch(const std::exception &e){
+                    results[f].error = e.what();
+                }
+            }
+        });
+    }
+    for(auto &w : workers){
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    int status = 0;
+    uint64_t bytes = 0;
+    for(const auto &r : results){
+        print(opt, r);
+        bytes += r.bytes;
+        status |= r.error.empty() ? 0 : 2;
+    }
+    std::fprintf(stderr, "%zu files, %.1f MB in %.3f s on %u threads, %.0f MB/s\n", results.size(), bytes/1e6,
+                 seconds, (unsigned)workers.size(), seconds > 0 ? bytes/1e6/seconds : 0.0);
+
+    if(csvPath){
+        std::FILE *csv = std::fopen(csvPath, "w");
+        if(!csv){
+            std::perror(csvPath);
+            return 2;
+        }
+        std::fprintf(csv, "file, format, rows, skipped, load min, load mean, load max, load std, duty mean, duty max, "
+                          "step s, initial, final, rise s, overshoot %%, settling s, goal, error\n");
+        for(const auto &r : results){
+            if(!r.error.empty()){
+                continue;
+            }
+            std::fprintf(csv, "\"%s\", %s, %lu, %lu, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f", r.path.c_str(),
+                         formatName[r.format], r.rows, r.skipped, r.loadMin, r.loadMean, r.loadMax, r.loadStd,
+                         r.dutyMean, r.dutyMax);
+            if(r.step){
+                std::fprintf(csv, ", %.2f, %.3f, %.3f, %.2f, %.1f, %.2f, %.2f, %.3f\n", r.start, r.initial, r.final,
+                             r.rise, r.overshoot, r.settling, r.goal, r.ssError);
+            }else{
+                std::fprintf(csv, ",,,,,,,,\n");
+            }
+        }
+        std::fclose(csv);
+    }
+    return status;
+}
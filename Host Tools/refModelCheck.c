@@ -0,0 +1,161 @@
+// refModelCheck.c
+// Runs on a host PC
+// Checks the recursive reference model of the adaptive law in forceControl.c
+// against its closed form, in all three numeric formats, over a long run.
+// The goal alternates between two forces every few seconds (as between test
+// sessions) while the load cell reads a constant value. For a goal step at
+// tick k0 from x0 the closed form is
+//   x_ref(k) = goal + (x0 - goal)*exp(-FC_MRAC_POLE*(k - k0)*dt)
+// Reported per format: largest |x_ref - closed form| over the whole run and
+// over the last hour, largest |theta| (must stay within FC_MRAC_THETA_MAX)
+// and the cost per tick in the first and last hour, which must be the same.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -o refModelCheck refModelCheck.c "../Board Support Package/BSP/forceControl.c" -lm
+// Run:
+//   ./refModelCheck [hours] [seconds per goal]
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "../Board Support Package/BSP/forceControl.h"
+
+// Same values as slug.c
+#define CONTROLLER_FREQ     2000
+#define GAMMA_X             0.0002
+#define GAMMA_R             0.002
+#define GOAL_LOW            45.0
+#define GOAL_HIGH           60.0
+#define LOAD_ADC            2234    // 45 lb rest load
+
+typedef struct {
+    double maxErr, maxErrLastHour;
+    double maxTheta;
+    double nsFirstHour, nsLastHour;
+} Result;
+
+//------------------nowNs()---------------------------
+//Monotonic time in nanoseconds
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+//------------------setGoal()---------------------------
+//Set the goal of one format
+static void setGoal(int numeric, void *mrac, double goal){
+    switch(numeric){
+    case FC_NUMERIC_DOUBLE: FC_MRACSetGoal_F64(mrac, goal); break;
+    case FC_NUMERIC_FLOAT:  FC_MRACSetGoal_F32(mrac, goal); break;
+    default:                FC_MRACSetGoal_Q(mrac, goal); break;
+    }
+}
+
+//------------------step()---------------------------
+//Run one tick of one format
+//Output: x_ref used in this tick and the larger |theta|, in double
+static double step(int numeric, void *mrac, double *theta){
+    double x_ref, tx, tr;
+    switch(numeric){
+    case FC_NUMERIC_DOUBLE: {
+        FC_MRAC_F64 *m = mrac;
+        FC_MRACStep_F64(m, FC_LOAD_Q16(LOAD_ADC));
+        x_ref = m->x - m->error; tx = m->theta_x; tr = m->theta_r;
+        break; }
+    case FC_NUMERIC_FLOAT: {
+        FC_MRAC_F32 *m = mrac;
+        FC_MRACStep_F32(m, FC_LOAD_Q16(LOAD_ADC));
+        x_ref = (double)m->x - (double)m->error; tx = m->theta_x; tr = m->theta_r;
+        break; }
+    default: {
+        FC_MRAC_Q *m = mrac;
+        FC_MRACStep_Q(m, FC_LOAD_Q16(LOAD_ADC));
+        x_ref = ((double)m->x - m->error)/FC_Q16_ONE;
+        tx = (double)m->theta_x/FC_Q16_ONE; tr = (double)m->theta_r/FC_Q16_ONE;
+        break; }
+    }
+    *theta = fmax(fabs(tx), fabs(tr));
+    return x_ref;
+}
+
+//------------------run()---------------------------
+//Run one format for the whole time
+static void run(int numeric, uint64_t ticks, uint32_t ticksPerGoal, Result *r){
+    FC_MRAC_F64 m64;
+    FC_MRAC_F32 m32;
+    FC_MRAC_Q mq;
+    void *mrac = (numeric == FC_NUMERIC_DOUBLE) ? (void *)&m64 : (numeric == FC_NUMERIC_FLOAT) ? (void *)&m32 : (void *)&mq;
+    uint64_t hour = 3600ull*CONTROLLER_FREQ, k, k0 = 0, t0 = 0;
+    double dt = 1.0/CONTROLLER_FREQ;
+    double goal = GOAL_HIGH, x0 = LOAD_ADC*FC_LOAD_PER_COUNT, x_ref, err, theta;
+
+    switch(numeric){
+    case FC_NUMERIC_DOUBLE: FC_MRACInit_F64(&m64, GAMMA_X, GAMMA_R, CONTROLLER_FREQ); break;
+    case FC_NUMERIC_FLOAT:  FC_MRACInit_F32(&m32, GAMMA_X, GAMMA_R, CONTROLLER_FREQ); break;
+    default:                FC_MRACInit_Q(&mq, GAMMA_X, GAMMA_R, CONTROLLER_FREQ); break;
+    }
+    setGoal(numeric, mrac, goal);
+    r->maxErr = r->maxErrLastHour = r->maxTheta = 0;
+    r->nsFirstHour = r->nsLastHour = 0;
+
+    for(k = 0; k < ticks; k++){
+        if(k == 0 || k == ticks - hour){
+            t0 = nowNs();
+        }
+        if(k > 0 && (k % ticksPerGoal) == 0){
+            // The closed form restarts from the model value at the switch
+            x0 = goal + (x0 - goal)*exp(-FC_MRAC_POLE*(k - k0)*dt);
+            goal = (goal == GOAL_HIGH) ? GOAL_LOW : GOAL_HIGH;
+            k0 = k;
+            setGoal(numeric, mrac, goal);
+        }
+
+        x_ref = step(numeric, mrac, &theta);
+        err = fabs(x_ref - (goal + (x0 - goal)*exp(-FC_MRAC_POLE*(k - k0)*dt)));
+
+        if(err > r->maxErr) r->maxErr = err;
+        if(k >= ticks - hour && err > r->maxErrLastHour) r->maxErrLastHour = err;
+        if(theta > r->maxTheta) r->maxTheta = theta;
+
+        // The closed form in the loop is timed too, it is the same every tick
+        if(k == hour - 1){
+            r->nsFirstHour = (double)(nowNs() - t0)/hour;
+        }
+        if(k == ticks - 1){
+            r->nsLastHour = (double)(nowNs() - t0)/hour;
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    double hours = (argc > 1) ? atof(argv[1]) : 4.0;
+    double secondsPerGoal = (argc > 2) ? atof(argv[2]) : 5.0;
+    static const char *names[3] = {"double ", "float32", "fixed  "};
+    uint64_t ticks;
+    uint32_t ticksPerGoal;
+    Result r;
+    int numeric;
+
+    if(hours < 1 || secondsPerGoal <= 0){
+        fprintf(stderr, "usage: %s [hours >= 1] [seconds per goal]\n", argv[0]);
+        return 1;
+    }
+    ticks = (uint64_t)(hours*3600.0*CONTROLLER_FREQ);
+    ticksPerGoal = (uint32_t)(secondsPerGoal*CONTROLLER_FREQ);
+
+    printf("%.1f h at %u Hz (%llu ticks), goal %.0f/%.0f lb every %.1f s\n", hours, CONTROLLER_FREQ,
+           (unsigned long long)ticks, GOAL_LOW, GOAL_HIGH, secondsPerGoal);
+    printf("%-8s %16s %16s %10s %14s %14s\n", "format", "max|err| lb", "last hour lb", "max|theta|",
+           "ns/tick 1st h", "ns/tick last h");
+    for(numeric = FC_NUMERIC_DOUBLE; numeric <= FC_NUMERIC_FIXED; numeric++){
+        run(numeric, ticks, ticksPerGoal, &r);
+        printf("%-8s %16.6f %16.6f %10.4f %14.2f %14.2f\n", names[numeric], r.maxErr, r.maxErrLastHour,
+               r.maxTheta, r.nsFirstHour, r.nsLastHour);
+    }
+    return 0;
+}
@@ -0,0 +1,407 @@
+// replay.c
+// Runs on a host PC
+// Replays a load cell capture of the Data Collection folder through the
+// controller of slug.c, built for the host, one row per controller tick:
+// the recorded load goes to Controller_SetLoad(), then PID_control() or
+// Adaptive_control() runs and its signed duty is compared with the duty
+// recorded on the board. Nothing depends on the wall clock, so the same
+// capture and options always give the same output and a change of the
+// control law shows up as a change of the comparison.
+//
+// Formats, detected from the first row or set with -format:
+//   clog     - sample, load lb, duty %             (PI control step resp/c_log.txt)
+//   c1       - load lb, PID output                 (PI control step resp/c1.txt)
+//   lowspeed - load lb, PID output, error lb       (PI control step resp/lowSpeedLog1.txt)
+//   capture  - sample, load ADC, duty %, direction (feedforward controller/capture*.txt,
+//              the "Sample: n, LoadCell: n, ..." rows too)
+// The text loggers print fractions as "%d.%2d" of the fraction times 1000,
+// so "62.50" is 62.050 lb, and a negative value as -I.F with F the sum of
+// the magnitude and I, times 1000 ("-14.28824" is -14.824). parseField()
+// undoes both. A lowspeed row also gives the goal (load + error, rounded to
+// REPLAY_GOAL_STEP), in the other formats it is -goal. clog records the duty without its direction,
+// it is compared with the magnitude of the replayed duty. Rows that do not
+// parse are skipped and counted.
+//
+// Output: with -csv, one row per tick (row, load lb, goal lb, recorded duty %,
+// replayed duty %, controller output). Comparison summary on stdout: bias and
+// RMS of replayed - recorded duty, largest difference and its row, sign
+// agreement and correlation. Host time per tick on stderr, kept out of
+// stdout so two runs can be diffed.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -DSLUG_HOST -I"../Board Support Package/BSP" -o replay replay.c "../Board Support Package/BSP/slug.c" "../Board Support Package/BSP/forceControl.c" "../Board Support Package/BSP/telemetry.c" "../Board Support Package/BSP/uartTx.c" "../Board Support Package/BSP/decimator.c" "../Board Support Package/BSP/encoder.c" "../Board Support Package/BSP/gait.c" "../Board Support Package/BSP/gaitSwing.c" "../Board Support Package/BSP/gainSchedule.c" "../Board Support Package/BSP/command.c" "../Board Support Package/BSP/profile.c" "../Board Support Package/BSP/monitor.c" "../Board Support Package/BSP/ident.c" "../Board Support Package/BSP/autotune.c" "../Board Support Package/BSP/kalman.c" "../Board Support Package/BSP/calib.c" "../Board Support Package/BSP/paramStore.c" "../Board Support Package/BSP/halHost.c" -lm
+// Run:
+//   ./replay capture.txt [-format name] [-controller pid|adaptive] [-goal lb] [-rate Hz]
+//            [-set name value]... [-csv out.csv] [-tolerance rms]
+//   e.g. ./replay "../Data Collection/PI control step resp/lowSpeedLog1.txt" -csv replay.csv
+// -rate is the controller frequency the law is initialized with, the rate of
+// the logger that wrote the capture (default 100 Hz). -set changes a named
+// parameter (slugCmd list) before the replay. With -tolerance the exit code
+// is 1 when the RMS difference is larger, for scripted regression checks.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+
+#include "slug.h"
+
+#define REPLAY_MAX_FIELDS   8
+#define REPLAY_LINE_SIZE    256
+#define REPLAY_RATE         100     // Hz, text logger rate of the captures
+#define REPLAY_GOAL         60.0    // lb, goal of the step response captures
+#define REPLAY_GOAL_STEP    0.5     // lb, lowspeed goals are rounded to this, the load and the
+                                    // error of a row come from different ticks
+
+typedef enum {
+    FORMAT_CLOG,
+    FORMAT_C1,
+    FORMAT_LOWSPEED,
+    FORMAT_CAPTURE,
+    NUM_FORMATS
+} Replay_Format;
+
+static const char *const formatName[NUM_FORMATS] = {"clog", "c1", "lowspeed", "capture"};
+static const int formatFields[NUM_FORMATS] = {3, 2, 3, 4};
+
+typedef struct {
+    double load;            // lb
+    uint32_t loadADC;
+    double goal;            // lb, 0 when the row has none
+    double duty;            // recorded signed duty %, limited to +-100
+} Replay_Row;
+
+typedef struct {
+    unsigned long rows, skipped;
+    double sum, sumSquares;             // replayed - recorded
+    double maxDiff;
+    unsigned long maxRow;
+    unsigned long signRows, signMatch;  // rows with both duties non zero
+    double sx, sy, sxx, syy, sxy;       // correlation
+} Replay_Stats;
+
+//------------------parseField()---------------------------
+//One number printed by the text loggers, see the file header. Leading
+//labels ("LoadCell:") and stray characters are skipped
+//Input: text, value out, 1 out if it has a fraction
+//Output: End of the number, 0 if there is none
+static const char *parseField(const char *s, double *value, int *hasFraction){
+    long whole, fraction = 0;
+    int negative;
+    char *end;
+
+    while(*s && *s != '-' && !isdigit((unsigned char)*s)){
+        if(*s == ','){
+            return 0;               // empty field
+        }
+        s++;
+    }
+    if(!*s){
+        return 0;
+    }
+    negative = (*s == '-');
+    whole = strtol(s, &end, 10);
+    if(end == s || (negative && end == s + 1)){
+        return 0;
+    }
+    s = end;
+    *hasFraction = (*s == '.');
+    if(*hasFraction){
+        s++;
+        while(*s == ' '){
+            s++;                    // "%2d" pads a fraction below 10
+        }
+        if(isdigit((unsigned char)*s)){
+            fraction = strtol(s, &end, 10);
+            s = end;
+        }
+    }
+    if(negative){
+        // F = (|x| + |I|)*1000, older rows without the offset are below |I|
+        *value = (fraction/1000.0 >= -whole) ? -(fraction/1000.0 + whole) : whole - fraction/1000.0;
+    }else{
+        *value = whole + fraction/1000.0;
+    }
+    return s;
+}
+
+//------------------parseLine()---------------------------
+//Split a row into its numbers
+//Input: row, values out, fraction flags out, room for values
+//Output: Number of values, 0 for a row that does not parse
+static int parseLine(const char *line, double *values, int *hasFraction, int max){
+    int n = 0;
+
+    while(*line && n < max){
+        line = parseField(line, &values[n], &hasFraction[n]);
+        if(!line){
+            return 0;
+        }
+        n++;
+        while(*line == ' ' || *line == '\t' || *line == '\r' || *line == '\n'){
+            line++;
+        }
+        if(*line == ','){
+            line++;
+        }else if(*line){
+            return 0;
+        }
+    }
+    return *line ? 0 : n;
+}
+
+//------------------detectFormat()---------------------------
+//Format of a capture from one parsed row
+static int detectFormat(const char *line, int n, const int *hasFraction){
+    if(strchr(line, ':') || n == 4){
+        return FORMAT_CAPTURE;
+    }
+    if(n == 3){
+        return hasFraction[0] ? FORMAT_LOWSPEED : FORMAT_CLOG;
+    }
+    if(n == 2){
+        return FORMAT_C1;
+    }
+    return -1;
+}
+
+//------------------limit()---------------------------
+//Limit a duty to +-100 %, as sendSignedDuty() in slug.c
+static double limit(double duty){
+    return (duty > 100) ? 100 : ((duty < -100) ? -100 : duty);
+}
+
+//------------------makeRow()---------------------------
+//Load, goal and recorded duty of a parsed row
+static void makeRow(Replay_Format format, const double *v, Replay_Row *row){
+    row->goal = 0;
+    switch(format){
+    case FORMAT_CLOG:
+        row->load = v[1];
+        row->duty = limit(v[2]);
+        break;
+    case FORMAT_C1:
+        row->load = v[0];
+        row->duty = limit(v[1]);
+        break;
+    case FORMAT_LOWSPEED:
+        row->load = v[0];
+        row->duty = limit(v[1]);
+        row->goal = v[0] + v[2];    // error = goal - load
+        break;
+    default:
+        row->loadADC = (v[1] > 0) ? (uint32_t)v[1] : 0;
+        row->load = row->loadADC*FC_LOAD_PER_COUNT;
+        row->duty = limit(v[3] ? v[2] : -v[2]);
+        return;
+    }
+    row->loadADC = (row->load > 0) ? (uint32_t)(row->load/FC_LOAD_PER_COUNT + 0.5) : 0;
+}
+
+//------------------compare()---------------------------
+//Add one tick to the comparison
+static void compare(Replay_Stats *st, double recorded, double replayed){
+    double diff = replayed - recorded;
+
+    st->rows++;
+    st->sum += diff;
+    st->sumSquares += diff*diff;
+    if(fabs(diff) > st->maxDiff){
+        st->maxDiff = fabs(diff);
+        st->maxRow = st->rows;
+    }
+    if(recorded != 0 && replayed != 0){
+        st->signRows++;
+        st->signMatch += ((recorded > 0) == (replayed > 0));
+    }
+    st->sx += recorded;
+    st->sy += replayed;
+    st->sxx += recorded*recorded;
+    st->syy += replayed*replayed;
+    st->sxy += recorded*replayed;
+}
+
+//------------------correlation()---------------------------
+//Correlation of the recorded and replayed duties, 0 if either is constant
+static double correlation(const Replay_Stats *st){
+    double n = st->rows;
+    double vx = n*st->sxx - st->sx*st->sx;
+    double vy = n*st->syy - st->sy*st->sy;
+
+    if(vx <= 0 || vy <= 0){
+        return 0;
+    }
+    return (n*st->sxy - st->sx*st->sy)/sqrt(vx*vy);
+}
+
+static int usage(const char *name){
+    fprintf(stderr, "usage: %s capture.txt [-format clog|c1|lowspeed|capture] [-controller pid|adaptive]\n"
+                    "       [-goal lb] [-rate Hz] [-set name value]... [-csv out.csv] [-tolerance rms]\n", name);
+    return 2;
+}
+
+int main(int argc, char **argv){
+    const char *path, *csvPath = 0;
+    int format = -1, adaptive = 0, userGoal = 0, n, a, id;
+    double goal = REPLAY_GOAL, tolerance = -1, lastGoal = -1, rms;
+    double values[REPLAY_MAX_FIELDS];
+    int hasFraction[REPLAY_MAX_FIELDS];
+    uint32_t rate = REPLAY_RATE;
+    char line[REPLAY_LINE_SIZE];
+    Replay_Row row;
+    Replay_Stats st;
+    FILE *in, *csv = 0;
+    struct timespec t0, t1;
+    double hostNs = 0, replayed;
+
+    if(argc < 2){
+        return usage(argv[0]);
+    }
+    path = argv[1];
+    memset(&st, 0, sizeof(st));
+
+    HAL_SimReset();
+    Clock_set_80MHz();
+    Motor_Init(20000);
+
+    for(a = 2; a < argc; a++){
+        if(strcmp(argv[a], "-format") == 0 && a + 1 < argc){
+            a++;
+            for(format = 0; format < NUM_FORMATS && strcmp(argv[a], formatName[format]) != 0; format++){
+            }
+            if(format == NUM_FORMATS){
+                fprintf(stderr, "unknown format %s\n", argv[a]);
+                return 2;
+            }
+        }else if(strcmp(argv[a], "-controller") == 0 && a + 1 < argc){
+            a++;
+            if(strcmp(argv[a], "adaptive") == 0){
+                adaptive = 1;
+            }else if(strcmp(argv[a], "pid") != 0){
+                fprintf(stderr, "unknown controller %s\n", argv[a]);
+                return 2;
+            }
+        }else if(strcmp(argv[a], "-goal") == 0 && a + 1 < argc){
+            goal = atof(argv[++a]);
+            userGoal = 1;
+        }else if(strcmp(argv[a], "-rate") == 0 && a + 1 < argc){
+            rate = (uint32_t)atoi(argv[++a]);
+        }else if(strcmp(argv[a], "-set") == 0 && a + 2 < argc){
+            a += 2; // after Controller_Init(), below
+        }else if(strcmp(argv[a], "-csv") == 0 && a + 1 < argc){
+            csvPath = argv[++a];
+        }else if(strcmp(argv[a], "-tolerance") == 0 && a + 1 < argc){
+            tolerance = atof(argv[++a]);
+        }else{
+            return usage(argv[0]);
+        }
+    }
+    if(rate == 0){
+        fprintf(stderr, "rate must be above 0\n");
+        return 2;
+    }
+
+    // Same gains as on the board, then the -set parameters
+    Controller_Init(rate);
+    for(a = 2; a < argc; a++){
+        if(strcmp(argv[a], "-set") == 0){
+            id = Param_Find(argv[a + 1]);
+            if(id < 0 || !Param_Set((uint32_t)id, atof(argv[a + 2]))){
+                fprintf(stderr, "cannot set %s to %s\n", argv[a + 1], argv[a + 2]);
+                return 2;
+            }
+            a += 2;
+        }else if(strcmp(argv[a], "-format") == 0 || strcmp(argv[a], "-controller") == 0 ||
+                 strcmp(argv[a], "-goal") == 0 || strcmp(argv[a], "-rate") == 0 ||
+                 strcmp(argv[a], "-csv") == 0 || strcmp(argv[a], "-tolerance") == 0){
+            a++;
+        }
+    }
+    setGoalForce(goal);
+
+    in = fopen(path, "r");
+    if(!in){
+        perror(path);
+        return 2;
+    }
+    if(csvPath){
+        csv = fopen(csvPath, "w");
+        if(!csv){
+            perror(csvPath);
+            return 2;
+        }
+        fprintf(csv, "row, load lb, goal lb, recorded duty %%, replayed duty %%, output\n");
+    }
+
+    while(fgets(line, sizeof(line), in)){
+        n = parseLine(line, values, hasFraction, REPLAY_MAX_FIELDS);
+        if(n == 0){
+            if(strspn(line, " \t\r\n") != strlen(line)){
+                st.skipped++;   // blank lines are not counted
+            }
+            continue;
+        }
+        if(format < 0){
+            format = detectFormat(line, n, hasFraction);
+            if(format < 0){
+                fprintf(stderr, "%s: unknown format, %d values per row\n", path, n);
+                return 2;
+            }
+        }
+        if(n != formatFields[format]){
+            st.skipped++;
+            continue;
+        }
+        makeRow((Replay_Format)format, values, &row);
+        if(row.goal != 0 && !userGoal){
+            row.goal = floor(row.goal/REPLAY_GOAL_STEP + 0.5)*REPLAY_GOAL_STEP;
+            if(row.goal != lastGoal){
+                lastGoal = row.goal;
+                setGoalForce(lastGoal);
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        Controller_SetLoad(row.loadADC);
+        if(adaptive){
+            Adaptive_control();
+        }else{
+            PID_control();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        hostNs += (t1.tv_sec - t0.tv_sec)*1e9 + (t1.tv_nsec - t0.tv_nsec);
+
+        replayed = getglobaldirection() ? (double)getglobalduty() : -(double)getglobalduty();
+        compare(&st, row.duty, (format == FORMAT_CLOG) ? fabs(replayed) : replayed);
+        if(csv){
+            fprintf(csv, "%lu, %.3f, %.2f, %.3f, %.0f, %.3f\n", st.rows, row.load, getGoalForce(),
+                    row.duty, replayed, adaptive ? getMRACoutput() : getPIDoutput());
+        }
+    }
+    fclose(in);
+    if(csv){
+        fclose(csv);
+    }
+    if(st.rows == 0){
+        fprintf(stderr, "%s: no rows\n", path);
+        return 2;
+    }
+
+    rms = sqrt(st.sumSquares/st.rows);
+    printf("%s: %s format, %lu ticks of %s at %u Hz, %lu rows skipped\n", path, formatName[format], st.rows,
+           adaptive ? "Adaptive_control" : "PID_control", rate, st.skipped);
+    printf("replayed - recorded duty: bias %.3f %%, RMS %.3f %%, largest %.3f %% at tick %lu\n",
+           st.sum/st.rows, rms, st.maxDiff, st.maxRow);
+    printf("sign agreement %.1f %% of %lu ticks, correlation %.3f\n",
+           st.signRows ? 100.0*st.signMatch/st.signRows : 0.0, st.signRows, correlation(&st));
+    fprintf(stderr, "host time %.1f ns per tick\n", hostNs/st.rows);
+
+    if(tolerance >= 0 && rms > tolerance){
+        fprintf(stderr, "RMS difference %.3f %% above the tolerance %.3f %%\n", rms, tolerance);
+        return 1;
+    }
+    return 0;
+}
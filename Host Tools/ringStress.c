@@ -0,0 +1,195 @@
+// ringStress.c
+// Runs on a host PC
+// Stress run of the single producer, single consumer ring of ring.h with a
+// producer thread and a consumer thread on different cores. Every item
+// carries its sequence number and a payload derived from it, so the
+// consumer detects lost, repeated, reordered and torn items. Rings of
+// several sizes are run, half of the items through Push/Pop and half
+// through the zero copy Claim/Publish and Peek/Release calls. The producer
+// pauses now and then so the ring also runs empty, not only full. A thread
+// that finds the ring full or empty yields, so the run also works on a
+// single core, where the threads are preempted at arbitrary points instead.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -pthread -I"../Board Support Package/BSP" -o ringStress ringStress.c
+// Run:
+//   ./ringStress [million items per ring]
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ring.h"
+
+#define PAYLOAD_WORDS   7       // item of 32 bytes, wider than one store
+
+typedef struct {
+    uint32_t seq;
+    uint32_t payload[PAYLOAD_WORDS];
+} Item;
+
+RING_DEFINE(Ring2, Item, 2)
+RING_DEFINE(Ring16, Item, 16)
+RING_DEFINE(Ring1024, Item, 1024)
+
+typedef struct {
+    const char *name;
+    void *ring;
+    void (*init)(void *ring);
+    int (*put)(void *ring, const Item *item, int zeroCopy);
+    int (*get)(void *ring, Item *item, int zeroCopy);
+    uint32_t items;
+    uint64_t fullSpins, emptySpins;
+    uint64_t errors;
+} Run;
+
+// Adapters, one set per ring type
+#define RING_ADAPTERS(Name)                                                     \
+static void Name##_init(void *r){ Name##_Init((Name *)r); }                     \
+static int Name##_put(void *r, const Item *item, int zeroCopy){                 \
+    Item *s;                                                                    \
+    if(!zeroCopy) return Name##_Push((Name *)r, item);                          \
+    s = Name##_Claim((Name *)r);                                                \
+    if(!s) return 0;                                                            \
+    *s = *item;                                                                 \
+    Name##_Publish((Name *)r);                                                  \
+    return 1;                                                                   \
+}                                                                               \
+static int Name##_get(void *r, Item *item, int zeroCopy){                       \
+    const Item *s;                                                              \
+    if(!zeroCopy) return Name##_Pop((Name *)r, item);                           \
+    s = Name##_Peek((Name *)r);                                                 \
+    if(!s) return 0;                                                            \
+    *item = *s;                                                                 \
+    Name##_Release((Name *)r);                                                  \
+    return 1;                                                                   \
+}
+
+RING_ADAPTERS(Ring2)
+RING_ADAPTERS(Ring16)
+RING_ADAPTERS(Ring1024)
+
+//------------------payload()---------------------------
+//Payload word i of item seq
+static uint32_t payload(uint32_t seq, int i){
+    uint32_t x = seq*2654435761u + (uint32_t)i*40503u;
+    return x ^ (x >> 15);
+}
+
+//------------------pin()---------------------------
+//Keep the calling thread on one core, if there are enough
+static void pin(int core){
+    cpu_set_t set;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cores < 3){
+        return;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+//------------------producer()---------------------------
+static void *producer(void *arg){
+    Run *run = arg;
+    Item item;
+    uint32_t seq;
+    int i;
+
+    pin(1);
+    for(seq = 0; seq < run->items; seq++){
+        item.seq = seq;
+        for(i = 0; i < PAYLOAD_WORDS; i++){
+            item.payload[i] = payload(seq, i);
+        }
+        while(!run->put(run->ring, &item, seq & 1)){
+            run->fullSpins++;
+            sched_yield(); // needed when both threads share one core
+        }
+        if((seq & 0xFFFF) == 0){
+            sched_yield(); // let the consumer empty the ring
+        }
+    }
+    return 0;
+}
+
+//------------------consumer()---------------------------
+static void *consumer(void *arg){
+    Run *run = arg;
+    Item item;
+    uint32_t expect;
+    int i;
+
+    pin(2);
+    for(expect = 0; expect < run->items; expect++){
+        while(!run->get(run->ring, &item, expect & 1)){
+            run->emptySpins++;
+            sched_yield();
+        }
+        if(item.seq != expect){
+            if(run->errors++ < 5){
+                fprintf(stderr, "%s: got item %u, expected %u\n", run->name, item.seq, expect);
+            }
+            expect = item.seq;
+            continue;
+        }
+        for(i = 0; i < PAYLOAD_WORDS; i++){
+            if(item.payload[i] != payload(item.seq, i)){
+                if(run->errors++ < 5){
+                    fprintf(stderr, "%s: item %u word %d torn\n", run->name, item.seq, i);
+                }
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv){
+    double millions = (argc > 1) ? atof(argv[1]) : 20.0;
+    static Ring2 r2;
+    static Ring16 r16;
+    static Ring1024 r1024;
+    Run runs[3] = { // items is set per run
+        {"size 2   ", &r2,    Ring2_init,    Ring2_put,    Ring2_get,    0, 0, 0, 0},
+        {"size 16  ", &r16,   Ring16_init,   Ring16_put,   Ring16_get,   0, 0, 0, 0},
+        {"size 1024", &r1024, Ring1024_init, Ring1024_put, Ring1024_get, 0, 0, 0, 0},
+    };
+    pthread_t p, c;
+    struct timespec t0, t1;
+    double seconds;
+    uint64_t total = 0;
+    int k;
+
+    if(millions <= 0 || millions > 4000){
+        fprintf(stderr, "usage: %s [million items per ring, up to 4000]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-10s %12s %10s %14s %14s %8s\n", "ring", "items", "Mitems/s", "full spins", "empty spins", "errors");
+    for(k = 0; k < 3; k++){
+        Run *run = &runs[k];
+        run->items = (uint32_t)(millions*1e6);
+        run->init(run->ring);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        pthread_create(&c, 0, consumer, run);
+        pthread_create(&p, 0, producer, run);
+        pthread_join(p, 0);
+        pthread_join(c, 0);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        seconds = (t1.tv_sec - t0.tv_sec) + 1e-9*(t1.tv_nsec - t0.tv_nsec);
+
+        printf("%-10s %12u %10.1f %14llu %14llu %8llu\n", run->name, run->items, run->items/seconds/1e6,
+               (unsigned long long)run->fullSpins, (unsigned long long)run->emptySpins,
+               (unsigned long long)run->errors);
+        total += run->errors;
+    }
+    printf("%s\n", total ? "FAILED" : "no item lost, repeated or torn");
+    return total ? 1 : 0;
+}
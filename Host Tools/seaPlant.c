@@ -0,0 +1,159 @@
+// seaPlant.c
+// Runs on a host PC
+// Discrete time series elastic actuator model, see seaPlant.h
+
+#include <math.h>
+#include <string.h>
+
+#include "seaPlant.h"
+
+#define SEA_ADC_MAX 4095
+
+//------------------expm3()---------------------------
+//Matrix exponential of a 3x3 matrix, scaling and squaring with a Taylor series
+static void expm3(double m[3][3], double e[3][3]){
+    double a[3][3], term[3][3], tmp[3][3], norm = 0;
+    int i, j, k, n, squarings = 0;
+
+    for(i = 0; i < 3; i++){
+        double row = 0;
+        for(j = 0; j < 3; j++){
+            row += fabs(m[i][j]);
+        }
+        if(row > norm) norm = row;
+    }
+    while(norm > 0.5){
+        norm /= 2;
+        squarings++;
+    }
+
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            a[i][j] = ldexp(m[i][j], -squarings);
+            e[i][j] = term[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+    for(n = 1; n <= 16; n++){
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                tmp[i][j] = 0;
+                for(k = 0; k < 3; k++){
+                    tmp[i][j] += term[i][k]*a[k][j];
+                }
+            }
+        }
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                term[i][j] = tmp[i][j]/n;
+                e[i][j] += term[i][j];
+            }
+        }
+    }
+    while(squarings--){
+        for(i = 0; i < 3; i++){
+            for(j = 0; j < 3; j++){
+                tmp[i][j] = 0;
+                for(k = 0; k < 3; k++){
+                    tmp[i][j] += e[i][k]*e[k][j];
+                }
+            }
+        }
+        memcpy(e, tmp, sizeof(tmp));
+    }
+}
+
+//------------------gaussian()---------------------------
+//Unit normal sample from a 32 bit LCG (Box-Muller), repeatable between runs
+static double gaussian(uint32_t *seed){
+    double u1, u2;
+    *seed = *seed*1664525u + 1013904223u;
+    u1 = ((*seed >> 8) + 1.0)/16777217.0;
+    *seed = *seed*1664525u + 1013904223u;
+    u2 = (*seed >> 8)/16777216.0;
+    return sqrt(-2.0*log(u1))*cos(2.0*M_PI*u2);
+}
+
+void SEA_DefaultParams(SEA_Params *params){
+    params->num = SEA_NUM;
+    params->den1 = SEA_DEN1;
+    params->den0 = SEA_DEN0;
+    params->dutyScale = SEA_DUTY_SCALE;
+    params->preloadLb = 45.0;
+    params->noiseCounts = 2.0;
+    params->loadPerCount = 3.3*25.0/4095.0; // same as adc2Vol() and Vol2Load()
+    params->linkInertia = 0;
+    params->linkDamping = 1.0;
+    params->linkRadius = 0.05;
+    params->countsPerRad = 4000.0/(2.0*M_PI);
+}
+
+void SEA_PlantInit(SEA_Plant *plant, const SEA_Params *params, double dt){
+    // Controllable canonical form, x0' = x1, x1' = -den0*x0 - den1*x1 + u
+    // Zero order hold: exp([A B; 0 0]*dt) = [Ad Bd; 0 1]
+    double m[3][3] = {
+        {0, 1, 0},
+        {-params->den0, -params->den1, 1},
+        {0, 0, 0},
+    };
+    double e[3][3];
+    int i, j;
+
+    for(i = 0; i < 3; i++){
+        for(j = 0; j < 3; j++){
+            m[i][j] *= dt;
+        }
+    }
+    expm3(m, e);
+
+    plant->params = *params;
+    plant->dt = dt;
+    for(i = 0; i < 2; i++){
+        for(j = 0; j < 2; j++){
+            plant->Ad[i][j] = e[i][j];
+        }
+        plant->Bd[i] = e[i][2];
+    }
+    plant->x[0] = plant->x[1] = 0;
+    plant->u = 0;
+    plant->angle = plant->rate = 0;
+    plant->seed = 12345;
+}
+
+void SEA_PlantStep(SEA_Plant *plant, double dutyPercent){
+    double x0 = plant->x[0], x1 = plant->x[1];
+    double u = plant->params.dutyScale*dutyPercent/100.0;
+
+    plant->u = u;
+    plant->x[0] = plant->Ad[0][0]*x0 + plant->Ad[0][1]*x1 + plant->Bd[0]*u;
+    plant->x[1] = plant->Ad[1][0]*x0 + plant->Ad[1][1]*x1 + plant->Bd[1]*u;
+
+    // Link, semi-implicit Euler
+    if(plant->params.linkInertia > 0){
+        plant->rate += plant->dt*(plant->params.linkRadius*SEA_PlantForce(plant)
+                       - plant->params.linkDamping*plant->rate)/plant->params.linkInertia;
+        plant->angle += plant->dt*plant->rate;
+    }
+}
+
+double SEA_PlantForce(const SEA_Plant *plant){
+    return plant->params.num*plant->x[0];
+}
+
+double SEA_PlantLoad(const SEA_Plant *plant){
+    return plant->params.preloadLb + SEA_PlantForce(plant)*SEA_N2LB;
+}
+
+double SEA_PlantCounts(const SEA_Plant *plant){
+    return plant->angle*plant->params.countsPerRad;
+}
+
+uint32_t SEA_PlantADC(SEA_Plant *plant){
+    double counts = SEA_PlantLoad(plant)/plant->params.loadPerCount;
+    if(plant->params.noiseCounts > 0){
+        counts += plant->params.noiseCounts*gaussian(&plant->seed);
+    }
+    counts = floor(counts + 0.5);
+    if(counts < 0) return 0;
+    if(counts > SEA_ADC_MAX) return SEA_ADC_MAX;
+    return (uint32_t)counts;
+}
@@ -0,0 +1,97 @@
+// seaPlant.h
+// Runs on a host PC
+// Discrete time model of the series elastic actuator on the test stand, from
+// the transfer function identified in Data Collection/PI control step resp/SEA_analysis.m
+//     F(s)/u(s) = 11358.64/(s^2 + 3.823s + 50.126) * 100/225
+// F is the spring force in N and u is the signed PWM duty as a fraction
+// (duty percent/100, negative when the direction pin is low), so a full duty
+// step settles at about 100 N as in the open loop step plot of SEA_analysis.m.
+// The model is discretised with a zero order hold on u, which is how the PWM
+// behaves between two controller ticks.
+// The load cell reading is preload + F converted to pound and to 12 bit ADC
+// counts with the same 25 lb/V and 3.3V/4095 scaling as slug.c, plus optional
+// white noise.
+// Optionally the spring drives a leg link, J*a'' = r*F - b*a', read by the
+// incremental encoder. The link motion does not feed back into F, the force
+// model stays the one identified with the link held; this is close while the
+// link moves slowly against the force loop. With linkInertia 0 the link is
+// held, as in the identification.
+
+#ifndef SEAPLANT_H_
+#define SEAPLANT_H_
+
+#include <stdint.h>
+
+#define SEA_NUM             11358.64    // numerator
+#define SEA_DEN1            3.823       // s coefficient
+#define SEA_DEN0            50.126      // constant coefficient
+#define SEA_DUTY_SCALE      (100.0/225.0)
+#define SEA_N2LB            0.2248089431
+
+typedef struct {
+    double num, den1, den0;     // transfer function
+    double dutyScale;           // input scaling, 100/225
+    double preloadLb;           // load cell reading at zero spring force
+    double noiseCounts;         // standard deviation of the ADC noise, counts
+    double loadPerCount;        // pound per ADC count
+    double linkInertia;         // kg m^2, 0 for a held link
+    double linkDamping;         // N m s/rad
+    double linkRadius;          // m, spring force to link torque
+    double countsPerRad;        // encoder counts per link radian
+} SEA_Params;
+
+typedef struct {
+    SEA_Params params;
+    double dt;
+    double Ad[2][2], Bd[2];     // x[k+1] = Ad*x[k] + Bd*u[k]
+    double x[2];                // x[0] = F/num, x[1] = dx[0]/dt
+    double u;                   // last input
+    double angle, rate;         // link, rad and rad/s
+    uint32_t seed;              // noise generator state
+} SEA_Plant;
+
+//------------------SEA_DefaultParams()---------------------------
+//Fill the parameters with the identified model and the slug.c load cell scaling,
+//45 lb preload and 2 counts of noise. The link is held (linkInertia 0), its
+//other parameters are those of a leg on a 1000 line encoder
+//Input: parameters
+//Output: None
+void SEA_DefaultParams(SEA_Params *params);
+
+//------------------SEA_PlantInit()---------------------------
+//Discretise the model and reset the state to zero spring force
+//Input: plant, parameters, sample time in seconds
+//Output: None
+void SEA_PlantInit(SEA_Plant *plant, const SEA_Params *params, double dt);
+
+//------------------SEA_PlantStep()---------------------------
+//Advance the model by one sample time
+//Input: plant, signed duty cycle in percent (-100 to 100)
+//Output: None
+void SEA_PlantStep(SEA_Plant *plant, double dutyPercent);
+
+//------------------SEA_PlantForce()---------------------------
+//Get spring force
+//Input: plant
+//Output: Force in N
+double SEA_PlantForce(const SEA_Plant *plant);
+
+//------------------SEA_PlantLoad()---------------------------
+//Get load seen by the load cell without noise
+//Input: plant
+//Output: Load in pound
+double SEA_PlantLoad(const SEA_Plant *plant);
+
+//------------------SEA_PlantCounts()---------------------------
+//Get link position
+//Input: plant
+//Output: Encoder counts from the start, not wrapped
+double SEA_PlantCounts(const SEA_Plant *plant);
+
+//------------------SEA_PlantADC()---------------------------
+//Sample the load cell, with noise, limited to 0-4095
+//Input: plant
+//Output: ADC counts
+uint32_t SEA_PlantADC(SEA_Plant *plant);
+
+#endif /* SEAPLANT_H_ */
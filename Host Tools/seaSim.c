@@ -0,0 +1,675 @@
+// seaSim.c
+// Runs on a host PC
+// Closed loop simulation of the force controller in slug.c against the series
+// elastic actuator model of seaPlant.c. The firmware runs unmodified on the
+// simulated peripherals of halHost.c:
+//   motorSendCommand() -> PWM pulse width and direction pin -> plant input
+//   plant output -> load cell ADC counts -> LoadCellIntHandler()
+// The plant is stepped at PLANT_FREQ, the firmware timers (load cell trigger,
+// controller, logger) fire in between as they would on the board.
+//
+// Modes:
+//   step  - one step response from the preload to the goal, CSV on stdout
+//           (time s, load lb, signed duty %). -realtime paces the run to the wall clock,
+//           -controller selects the strategy (default adaptive) and -switch
+//           changes it during the run with Controller_Select() to compare
+//           controllers in one session. -overload masks the interrupts for
+//           OVERLOAD_MASK of every OVERLOAD_PERIOD from the given time, as a
+//           handler that hogs the core would, so the controller ticks are
+//           lost and the deadline monitor of slug.c trips and ramps the motor
+//           down; its counts are printed on stderr. -set changes a named
+//           parameter (slugCmd list) before the run, e.g. the excitation of
+//           -controller ident for Host Tools/sysIdent. With -switch to tune
+//           the relay result and the gains it gave are printed on stderr.
+//   sweep - grid of adaptation gains gamma_x x gamma_r (the law run by
+//           ControllerIntHandler), one step response each, run as fast as
+//           possible. CSV of step metrics on stdout, run rate on stderr.
+//   position - joint position step of the cascade strategy, the plant drives
+//           the link model of seaPlant.c and the simulated QEI, CSV on stdout
+//           (time s, goal counts, position counts, velocity counts/s, load lb,
+//           signed duty %). -rates sets the velocity and position loop
+//           dividers (Cascade_SetRates()).
+//   gait  - plays the gaitSwing force table (gait.h) as the goal of a force
+//           strategy with Trajectory_Start(), the cadence changes to the
+//           second one half way through, CSV on stdout (time s, goal lb,
+//           load lb, signed duty %), RMS tracking error of each half on stderr.
+//   filter - plays the gait table like gait and compares the load the
+//           controller reads with the plant load, CSV on stdout (time s,
+//           plant load lb, reading lb, Kalman estimate lb): for the reading,
+//           its mean over the last FILTER_MEAN ticks and a Kalman filter
+//           (kalman.h) designed from the kalman_q, kalman_qo and kalman_r
+//           parameters and fed the reading and the duty of the last tick
+//           like slug.c, the lag that fits the plant load best and the RMS
+//           error left at that lag, after FILTER_SKIP. -noise sets the ADC
+//           noise of every sample (seaPlant.h, 2 counts by default).
+//
+// Build:
+//   gcc -O2 -std=gnu99 -DSLUG_HOST -I"../Board Support Package/BSP" -o seaSim seaSim.c seaPlant.c "../Board Support Package/BSP/slug.c" "../Board Support Package/BSP/forceControl.c" "../Board Support Package/BSP/telemetry.c" "../Board Support Package/BSP/uartTx.c" "../Board Support Package/BSP/decimator.c" "../Board Support Package/BSP/encoder.c" "../Board Support Package/BSP/gait.c" "../Board Support Package/BSP/gaitSwing.c" "../Board Support Package/BSP/gainSchedule.c" "../Board Support Package/BSP/command.c" "../Board Support Package/BSP/profile.c" "../Board Support Package/BSP/monitor.c" "../Board Support Package/BSP/ident.c" "../Board Support Package/BSP/autotune.c" "../Board Support Package/BSP/kalman.c" "../Board Support Package/BSP/calib.c" "../Board Support Package/BSP/paramStore.c" "../Board Support Package/BSP/halHost.c" -lm
+// Run:
+//   ./seaSim step [seconds] [goal lb] [-realtime] [-controller name] [-switch time_s name] [-overload time_s]
+//                [-set name value]...
+//   ./seaSim sweep gxMin gxMax gxSteps grMin grMax grSteps [seconds] [goal lb]
+//   ./seaSim position [seconds] [step counts] [-rates velocityDiv positionDiv]
+//   ./seaSim gait [seconds] [cadence mHz] [second cadence mHz] [-controller name]
+//   ./seaSim filter [seconds] [cadence mHz] [-controller name] [-noise counts] [-set name value]...
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slug.h"
+#include "decimator.h"
+#include "seaPlant.h"
+
+#define PLANT_FREQ          10000   // Hz
+#define LOG_FREQ            1000    // Hz, step mode output
+#define SETTLE_BAND         0.02    // settling band, fraction of the step
+#define OVERLOAD_PERIOD     0.01    // s, step mode -overload
+#define OVERLOAD_MASK       0.0012  // s, interrupts masked in each period
+
+// Same rates as Adaptive_ForceControl.c, the 100 Hz text logger is used
+// since its output is discarded here
+#define LOGGER_FREQ         100
+#define BAUD_RATE           115200
+#define PWM_FREQ            20000
+#define HW_AVERAGING        8
+#define ADC_SAMPLE_FREQ     32000
+#define CONTROLLER_FREQ     2000
+#define QEI_TOP             3999    // 1000 line encoder
+#define LINK_INERTIA        0.02    // kg m^2, position mode
+#define FILTER_MEAN         8       // ticks, filter mode mean of the reading
+#define FILTER_SKIP         1.0     // s, filter mode start up not compared
+#define FILTER_MAX_LAG      0.02    // s, filter mode lag searched
+
+// Adaptation gains in slug.c, loaded by Controller_Init()
+extern double gamma_x;
+extern double gamma_r;
+
+typedef struct {
+    double riseTime;        // 10 to 90 percent, s (-1 if not reached)
+    double overshoot;       // percent of the step
+    double settlingTime;    // last time outside the band, s
+    double iae;             // integral of |goal - load|, lb s
+    double finalError;      // goal - load at the end, lb
+} StepMetrics;
+
+static SEA_Plant plant;
+static char uartBuffer[4096];
+
+typedef struct {
+    Controller_Id initial;
+    double switchTime;      // s, negative for no switch
+    Controller_Id switchTo;
+    double overloadTime;    // s, negative for no overload
+} ControllerPlan;
+
+static const ControllerPlan adaptiveOnly = {CONTROLLER_ADAPTIVE, -1, CONTROLLER_ADAPTIVE, -1};
+
+//------------------plantADC()---------------------------
+//ADC source for the load cell channel
+static uint32_t plantADC(void *context){
+    return SEA_PlantADC((SEA_Plant *)context);
+}
+
+//------------------motorDuty()---------------------------
+//Signed duty in percent from the simulated PWM output and direction pin
+static double motorDuty(void){
+    uint32_t period, width;
+    bool enabled;
+    double duty;
+
+    HAL_SimGetPWM(&period, &width, &enabled);
+    if(!enabled || period == 0){
+        return 0;
+    }
+    duty = 100.0*width/period;
+    return HAL_SimGetPin(HAL_PIN_MOTOR_DIR) ? duty : -duty;
+}
+
+//------------------nowNs()---------------------------
+//Monotonic time in nanoseconds
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+//------------------runStep()---------------------------
+//Boot the firmware against a fresh plant and run one step response
+static void runStep(double goal, double seconds, const SEA_Params *params,
+                    FILE *log, int realtime, const ControllerPlan *plan, StepMetrics *metrics){
+    uint32_t stepCycles, logEvery, k, steps, switchStep, overloadStep, masked = 0;
+    double start, span, t, load, peak;
+    uint64_t wallStart = nowNs();
+
+    HAL_SimReset();
+    SEA_PlantInit(&plant, params, 1.0/PLANT_FREQ);
+    HAL_SimSetADCSource(HAL_ADC_LOADCELL, plantADC, &plant);
+
+    // Same sequence as Adaptive_ForceControl.c
+    Clock_set_80MHz();
+    Logger_Init(LOGGER_FREQ, BAUD_RATE);
+    Motor_Init(PWM_FREQ);
+    LoadCell_initBlock(HW_AVERAGING, ADC_SAMPLE_FREQ);
+    setGoalForce(goal);
+    Controller_Init(CONTROLLER_FREQ);
+    Controller_Select(plan->initial);
+    ControllerEnable();
+    EnableInterrupts();
+
+    stepCycles = Clock_get_frequency()/PLANT_FREQ;
+    logEvery = PLANT_FREQ/LOG_FREQ;
+    steps = (uint32_t)(seconds*PLANT_FREQ);
+    switchStep = (plan->switchTime >= 0) ? (uint32_t)(plan->switchTime*PLANT_FREQ) : 0;
+    overloadStep = (plan->overloadTime >= 0) ? (uint32_t)(plan->overloadTime*PLANT_FREQ) + 1 : 0;
+
+    start = SEA_PlantLoad(&plant);
+    span = goal - start;
+    peak = start;
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->riseTime = -1;
+    {
+        double t10 = -1;
+        for(k = 1; k <= steps; k++){
+            if(k == switchStep){
+                Controller_Select(plan->switchTo);
+            }
+            if(overloadStep && k >= overloadStep){
+                uint32_t phase = (k - overloadStep) % (uint32_t)(OVERLOAD_PERIOD*PLANT_FREQ);
+                if(phase == 0){
+                    masked = HAL_EnterCritical();
+                }else if(phase == (uint32_t)(OVERLOAD_MASK*PLANT_FREQ)){
+                    HAL_ExitCritical(masked);
+                }
+            }
+            HAL_SimRun(stepCycles);
+            SEA_PlantStep(&plant, motorDuty());
+            while(HAL_SimUARTRead(uartBuffer, sizeof(uartBuffer)) > 0){
+                // logger output is not used here
+            }
+            Tune_Background(); // background loop of the board
+
+            t = (double)k/PLANT_FREQ;
+            load = SEA_PlantLoad(&plant);
+            if((load - peak)*span > 0) peak = load;
+            if(t10 < 0 && (load - start)*span >= 0.1*span*span) t10 = t;
+            if(metrics->riseTime < 0 && (load - start)*span >= 0.9*span*span) metrics->riseTime = t - t10;
+            if(fabs(goal - load) > SETTLE_BAND*fabs(span)) metrics->settlingTime = t;
+            metrics->iae += fabs(goal - load)/PLANT_FREQ;
+
+            if(log && (k % logEvery) == 0){
+                fprintf(log, "%.4f, %.3f, %.2f\n", t, load, motorDuty());
+            }
+            if(realtime && (k % logEvery) == 0){
+                uint64_t due = wallStart + (uint64_t)(t*1e9);
+                uint64_t now = nowNs();
+                if(due > now){
+                    struct timespec ts = {(time_t)((due - now)/1000000000ull), (long)((due - now)%1000000000ull)};
+                    nanosleep(&ts, 0);
+                }
+            }
+        }
+    }
+    if(overloadStep){
+        HAL_ExitCritical(masked); // in case the run ended in a masked period
+    }
+    metrics->overshoot = (span != 0) ? 100.0*(peak - goal)/span : 0;
+    if(metrics->overshoot < 0) metrics->overshoot = 0;
+    metrics->finalError = goal - SEA_PlantLoad(&plant);
+}
+
+//------------------qeiCount()---------------------------
+//QEI position register for a link position
+static uint32_t qeiCount(double counts){
+    int64_t c = (int64_t)floor(counts);
+    int64_t range = QEI_TOP + 1;
+    return (uint32_t)(((c % range) + range) % range);
+}
+
+//------------------runPosition()---------------------------
+//Boot the firmware against a fresh plant with a free link and run one
+//position step of the cascade strategy from where the link starts
+static void runPosition(double goal, double seconds, const SEA_Params *params, FILE *log,
+                        uint32_t velocityDiv, uint32_t positionDiv, StepMetrics *metrics){
+    uint32_t stepCycles, logEvery, k, steps;
+    double t, position, peak = 0;
+    double t10 = -1;
+
+    HAL_SimReset();
+    SEA_PlantInit(&plant, params, 1.0/PLANT_FREQ);
+    HAL_SimSetADCSource(HAL_ADC_LOADCELL, plantADC, &plant);
+    HAL_SimSetQEIPosition(qeiCount(0));
+
+    Clock_set_80MHz();
+    Logger_Init(LOGGER_FREQ, BAUD_RATE);
+    Motor_Init(PWM_FREQ);
+    LoadCell_initBlock(HW_AVERAGING, ADC_SAMPLE_FREQ);
+    IncEncoder_Init(QEI_TOP, 0);
+    setGoalForce(SEA_PlantLoad(&plant));
+    Controller_Init(CONTROLLER_FREQ);
+    ControllerEnable();
+    EnableInterrupts();
+    HAL_SimRun(Clock_get_frequency()/100); // let the sensors start
+    Controller_Select(CONTROLLER_CASCADE);
+    if(!Cascade_SetRates(velocityDiv, positionDiv)){
+        fprintf(stderr, "rates must be at least 1\n");
+        return;
+    }
+    Cascade_SetGoal((int32_t)(goal*256), 0);
+
+    stepCycles = Clock_get_frequency()/PLANT_FREQ;
+    logEvery = PLANT_FREQ/LOG_FREQ;
+    steps = (uint32_t)(seconds*PLANT_FREQ);
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->riseTime = -1;
+    for(k = 1; k <= steps; k++){
+        HAL_SimRun(stepCycles);
+        SEA_PlantStep(&plant, motorDuty());
+        HAL_SimSetQEIPosition(qeiCount(SEA_PlantCounts(&plant)));
+        while(HAL_SimUARTRead(uartBuffer, sizeof(uartBuffer)) > 0){
+            // logger output is not used here
+        }
+
+        t = (double)k/PLANT_FREQ;
+        position = SEA_PlantCounts(&plant);
+        if(position*goal > peak*goal) peak = position;
+        if(t10 < 0 && position*goal >= 0.1*goal*goal) t10 = t;
+        if(metrics->riseTime < 0 && position*goal >= 0.9*goal*goal) metrics->riseTime = t - t10;
+        if(fabs(goal - position) > SETTLE_BAND*fabs(goal)) metrics->settlingTime = t;
+        metrics->iae += fabs(goal - position)/PLANT_FREQ;
+
+        if(log && (k % logEvery) == 0){
+            fprintf(log, "%.4f, %.0f, %.2f, %.1f, %.3f, %.2f\n", t, goal, position,
+                    plant.rate*params->countsPerRad, SEA_PlantLoad(&plant), motorDuty());
+        }
+    }
+    metrics->overshoot = (goal != 0) ? 100.0*(peak - goal)/goal : 0;
+    if(metrics->overshoot < 0) metrics->overshoot = 0;
+    metrics->finalError = goal - SEA_PlantCounts(&plant);
+}
+
+//------------------runGait()---------------------------
+//Boot the firmware against a fresh plant and play a gait table from its first
+//point, changing the cadence half way. RMS tracking error of each half.
+static void runGait(const Gait_Table *table, double seconds, uint32_t cadence, uint32_t cadence2,
+                    const SEA_Params *params, FILE *log, Controller_Id id, double rms[2]){
+    uint32_t stepCycles, logEvery, k, steps, n[2] = {0, 0};
+    double t, goal, load, sum[2] = {0, 0};
+    int half;
+
+    HAL_SimReset();
+    SEA_PlantInit(&plant, params, 1.0/PLANT_FREQ);
+    HAL_SimSetADCSource(HAL_ADC_LOADCELL, plantADC, &plant);
+
+    Clock_set_80MHz();
+    Logger_Init(LOGGER_FREQ, BAUD_RATE);
+    Motor_Init(PWM_FREQ);
+    LoadCell_initBlock(HW_AVERAGING, ADC_SAMPLE_FREQ);
+    setGoalForce((double)table->value[0]/(1 << GAIT_FORCE_FRAC_BITS));
+    Controller_Init(CONTROLLER_FREQ);
+    Controller_Select(id);
+    ControllerEnable();
+    EnableInterrupts();
+    HAL_SimRun(Clock_get_frequency()); // settle on the first point
+    Trajectory_Start(table, cadence);
+
+    stepCycles = Clock_get_frequency()/PLANT_FREQ;
+    logEvery = PLANT_FREQ/LOG_FREQ;
+    steps = (uint32_t)(seconds*PLANT_FREQ);
+    for(k = 1; k <= steps; k++){
+        if(k == steps/2){
+            Trajectory_SetCadence(cadence2);
+        }
+        HAL_SimRun(stepCycles);
+        SEA_PlantStep(&plant, motorDuty());
+        while(HAL_SimUARTRead(uartBuffer, sizeof(uartBuffer)) > 0){
+            // logger output is not used here
+        }
+
+        t = (double)k/PLANT_FREQ;
+        goal = (double)Trajectory_Get()->value/(1 << GAIT_FORCE_FRAC_BITS);
+        load = SEA_PlantLoad(&plant);
+        half = (k >= steps/2);
+        sum[half] += (goal - load)*(goal - load);
+        n[half]++;
+        if(log && (k % logEvery) == 0){
+            fprintf(log, "%.4f, %.3f, %.3f, %.2f\n", t, goal, load, motorDuty());
+        }
+    }
+    Trajectory_Stop();
+    rms[0] = n[0] ? sqrt(sum[0]/n[0]) : 0;
+    rms[1] = n[1] ? sqrt(sum[1]/n[1]) : 0;
+}
+
+//------------------lagFit()---------------------------
+//Lag of one load series against the plant load, the one of least RMS error
+//Input: series and the plant step of each of its n values, plant load per
+//       step, lag and RMS error out
+static void lagFit(const double *value, const uint32_t *at, uint32_t n, const double *truth,
+                   double *lag, double *rms){
+    uint32_t d, i, maxLag = (uint32_t)(FILTER_MAX_LAG*PLANT_FREQ), count;
+    double sum, e;
+
+    *lag = 0;
+    *rms = -1;
+    for(d = 0; d <= maxLag; d++){
+        sum = 0;
+        count = 0;
+        for(i = 0; i < n; i++){
+            if(at[i] >= d + (uint32_t)(FILTER_SKIP*PLANT_FREQ)){
+                e = value[i] - truth[at[i] - d];
+                sum += e*e;
+                count++;
+            }
+        }
+        if(count && (*rms < 0 || sqrt(sum/count) < *rms)){
+            *rms = sqrt(sum/count);
+            *lag = (double)d/PLANT_FREQ;
+        }
+    }
+}
+
+//------------------paramValue()---------------------------
+//Value of a firmware parameter by name, 0 when it does not exist
+static double paramValue(const char *name){
+    double value = 0;
+    int id = Param_Find(name);
+
+    if(id >= 0){
+        Param_Get((uint32_t)id, &value);
+    }
+    return value;
+}
+
+//------------------runFilter()---------------------------
+//Boot the firmware against a fresh plant, play a gait table and compare the
+//load read at every controller tick with the plant load. The firmware only
+//steps its filter with kalman set to 1, so the comparison runs its own
+static int runFilter(const Gait_Table *table, double seconds, uint32_t cadence,
+                     const SEA_Params *params, FILE *log, Controller_Id id){
+    static const char *names[3] = {"reading", "mean", "Kalman"};
+    uint32_t stepCycles, logEvery, k, steps, n = 0, ticks, lastTick, i, j;
+    uint32_t *at;
+    double *truth, *value[3], sum, lag, rms, duty = 0;
+    Kalman_Filter filter;
+
+    steps = (uint32_t)(seconds*PLANT_FREQ);
+    ticks = (uint32_t)(seconds*CONTROLLER_FREQ) + 1;
+    truth = malloc(sizeof(double)*(steps + 1));
+    at = malloc(sizeof(uint32_t)*ticks);
+    for(j = 0; j < 3; j++){
+        value[j] = malloc(sizeof(double)*ticks);
+    }
+    if(!truth || !at || !value[0] || !value[1] || !value[2]){
+        fprintf(stderr, "out of memory\n");
+        return 0;
+    }
+    if(!Kalman_Design(&filter.model, 1.0/CONTROLLER_FREQ, paramValue("kalman_q"),
+                      paramValue("kalman_qo"), paramValue("kalman_r"))){
+        fprintf(stderr, "Kalman design failed\n");
+        return 0;
+    }
+    Kalman_Reset(&filter);
+
+    HAL_SimReset();
+    SEA_PlantInit(&plant, params, 1.0/PLANT_FREQ);
+    HAL_SimSetADCSource(HAL_ADC_LOADCELL, plantADC, &plant);
+
+    Clock_set_80MHz();
+    Logger_Init(LOGGER_FREQ, BAUD_RATE);
+    Motor_Init(PWM_FREQ);
+    LoadCell_initBlock(HW_AVERAGING, ADC_SAMPLE_FREQ);
+    setGoalForce((double)table->value[0]/(1 << GAIT_FORCE_FRAC_BITS));
+    Controller_Init(CONTROLLER_FREQ);
+    Controller_Select(id);
+    ControllerEnable();
+    EnableInterrupts();
+    Trajectory_Start(table, cadence);
+
+    stepCycles = Clock_get_frequency()/PLANT_FREQ;
+    logEvery = PLANT_FREQ/LOG_FREQ;
+    lastTick = getGlobalControllerTicks();
+    truth[0] = SEA_PlantLoad(&plant);
+    for(k = 1; k <= steps; k++){
+        HAL_SimRun(stepCycles);
+        SEA_PlantStep(&plant, motorDuty());
+        while(HAL_SimUARTRead(uartBuffer, sizeof(uartBuffer)) > 0){
+            // logger output is not used here
+        }
+        truth[k] = SEA_PlantLoad(&plant);
+
+        if(getGlobalControllerTicks() != lastTick && n < ticks){
+            lastTick = getGlobalControllerTicks();
+            at[n] = k;
+            value[0][n] = Controller_Sensors()->raw[SENSOR_LOADCELL]*FC_LOAD_PER_COUNT;
+            for(i = 0, sum = 0; i < FILTER_MEAN && i <= n; i++){
+                sum += value[0][n - i];
+            }
+            value[1][n] = sum/i;
+            value[2][n] = Kalman_Step(&filter, (float)Controller_Sensors()->loadFine*
+                                      (float)(FC_LOAD_PER_COUNT/(1 << DECIMATOR_FRAC_BITS)), (float)duty);
+            duty = motorDuty();
+            n++;
+        }
+        if(log && (k % logEvery) == 0 && n){
+            fprintf(log, "%.4f, %.3f, %.3f, %.3f\n", (double)k/PLANT_FREQ, truth[k], value[0][n - 1], value[2][n - 1]);
+        }
+    }
+    Trajectory_Stop();
+
+    for(j = 0; j < 3; j++){
+        lagFit(value[j], at, n, truth, &lag, &rms);
+        fprintf(stderr, "%s: lag %.2f ms, RMS error %.4f lb\n", names[j], lag*1000, rms);
+        free(value[j]);
+    }
+    free(truth);
+    free(at);
+    return 1;
+}
+
+//------------------controllerId()---------------------------
+//Controller from its strategy name, case insensitive
+static int controllerId(const char *name, Controller_Id *id){
+    int i;
+    for(i = 0; i < NUM_CONTROLLERS; i++){
+        if(strcasecmp(name, Controller_Get((Controller_Id)i)->name) == 0){
+            *id = (Controller_Id)i;
+            return 1;
+        }
+    }
+    fprintf(stderr, "unknown controller %s\n", name);
+    return 0;
+}
+
+//------------------grid()---------------------------
+//Value i of n linearly spaced values from min to max
+static double grid(double min, double max, int n, int i){
+    return (n > 1) ? min + (max - min)*i/(n - 1) : min;
+}
+
+int main(int argc, char **argv){
+    SEA_Params params;
+    StepMetrics m;
+
+    SEA_DefaultParams(&params);
+
+    if(argc > 1 && strcmp(argv[1], "step") == 0){
+        double seconds = (argc > 2) ? atof(argv[2]) : 3.0;
+        double goal = (argc > 3) ? atof(argv[3]) : 60.0;
+        int realtime = 0;
+        ControllerPlan plan = adaptiveOnly;
+        const Controller_Cost *cost;
+        const Monitor_State *monitor;
+        const Autotune_State *tune;
+        Autotune_Gains gains;
+        int a, i;
+
+        for(a = 4; a < argc; a++){
+            if(strcmp(argv[a], "-realtime") == 0){
+                realtime = 1;
+            }else if(strcmp(argv[a], "-controller") == 0 && a + 1 < argc){
+                if(!controllerId(argv[++a], &plan.initial)) return 1;
+            }else if(strcmp(argv[a], "-switch") == 0 && a + 2 < argc){
+                plan.switchTime = atof(argv[++a]);
+                if(!controllerId(argv[++a], &plan.switchTo)) return 1;
+            }else if(strcmp(argv[a], "-overload") == 0 && a + 1 < argc){
+                plan.overloadTime = atof(argv[++a]);
+            }else if(strcmp(argv[a], "-set") == 0 && a + 2 < argc){
+                // The parameters stay in their globals, Controller_Init() of the run loads them
+                int id = Param_Find(argv[a + 1]);
+                if(id < 0 || !Param_Set((uint32_t)id, atof(argv[a + 2]))){
+                    fprintf(stderr, "cannot set %s to %s\n", argv[a + 1], argv[a + 2]);
+                    return 1;
+                }
+                a += 2;
+            }else{
+                fprintf(stderr, "unknown option %s\n", argv[a]);
+                return 1;
+            }
+        }
+
+        printf("time, load, duty\n");
+        runStep(goal, seconds, &params, stdout, realtime, &plan, &m);
+        fprintf(stderr, "gamma_x %g gamma_r %g: rise %.3f s, overshoot %.1f %%, settling %.3f s, IAE %.3f lb s, final error %.3f lb\n",
+                gamma_x, gamma_r, m.riseTime, m.overshoot, m.settlingTime, m.iae, m.finalError);
+        for(i = 0; i < NUM_CONTROLLERS; i++){
+            cost = Controller_GetCost((Controller_Id)i);
+            if(cost->count){
+                fprintf(stderr, "%s: %u ticks\n", Controller_Get((Controller_Id)i)->name, cost->count);
+            }
+        }
+        if(Controller_GetCost(CONTROLLER_TUNE)->count){
+            tune = Tune_Get(&gains);
+            fprintf(stderr, "tune: status %d, Ku %.3f %%/lb, Tu %.3f s, a %.3f lb, kp %.3f ki %.3f kd %.4f\n",
+                    (int)tune->status, tune->ku, tune->tu, tune->oscillation, gains.kp, gains.ki, gains.kd);
+        }
+        monitor = Controller_GetMonitor();
+        fprintf(stderr, "monitor: %u ticks, %u overruns, jitter %d to %d cycles, %s\n",
+                monitor->ticks, monitor->overruns, (monitor->ticks > 1) ? monitor->jitterMin : 0,
+                (monitor->ticks > 1) ? monitor->jitterMax : 0, monitor->tripped ? "tripped, safe stop" : "not tripped");
+        return 0;
+    }
+
+    if(argc > 7 && strcmp(argv[1], "sweep") == 0){
+        double gxMin = atof(argv[2]), gxMax = atof(argv[3]);
+        int gxSteps = atoi(argv[4]);
+        double grMin = atof(argv[5]), grMax = atof(argv[6]);
+        int grSteps = atoi(argv[7]);
+        double seconds = (argc > 8) ? atof(argv[8]) : 3.0;
+        double goal = (argc > 9) ? atof(argv[9]) : 60.0;
+        uint64_t t0 = nowNs();
+        double wall;
+        int i, j;
+
+        if(gxSteps < 1 || grSteps < 1){
+            fprintf(stderr, "steps must be at least 1\n");
+            return 1;
+        }
+
+        printf("gamma_x, gamma_r, rise_s, overshoot_pct, settling_s, iae_lbs, final_error_lb\n");
+        for(i = 0; i < gxSteps; i++){
+            for(j = 0; j < grSteps; j++){
+                gamma_x = grid(gxMin, gxMax, gxSteps, i);
+                gamma_r = grid(grMin, grMax, grSteps, j);
+                runStep(goal, seconds, &params, 0, 0, &adaptiveOnly, &m);
+                printf("%g, %g, %.4f, %.2f, %.4f, %.4f, %.4f\n",
+                       gamma_x, gamma_r, m.riseTime, m.overshoot, m.settlingTime, m.iae, m.finalError);
+            }
+        }
+        wall = (nowNs() - t0)*1e-9;
+        fprintf(stderr, "%d step responses, %.1f s simulated in %.2f s wall (%.0fx real time)\n",
+                gxSteps*grSteps, gxSteps*grSteps*seconds, wall, gxSteps*grSteps*seconds/wall);
+        return 0;
+    }
+
+    if(argc > 1 && strcmp(argv[1], "position") == 0){
+        double seconds = (argc > 2) ? atof(argv[2]) : 6.0;
+        double goal = (argc > 3) ? atof(argv[3]) : 500.0;
+        uint32_t velocityDiv = 4, positionDiv = 20;
+        int a;
+
+        for(a = 4; a < argc; a++){
+            if(strcmp(argv[a], "-rates") == 0 && a + 2 < argc){
+                velocityDiv = (uint32_t)atoi(argv[++a]);
+                positionDiv = (uint32_t)atoi(argv[++a]);
+            }else{
+                fprintf(stderr, "unknown option %s\n", argv[a]);
+                return 1;
+            }
+        }
+
+        params.linkInertia = LINK_INERTIA;
+        printf("time, goal, position, velocity, load, duty\n");
+        runPosition(goal, seconds, &params, stdout, velocityDiv, positionDiv, &m);
+        fprintf(stderr, "rates %u/%u: rise %.3f s, overshoot %.1f %%, settling %.3f s, IAE %.1f counts s, final error %.1f counts\n",
+                velocityDiv, positionDiv, m.riseTime, m.overshoot, m.settlingTime, m.iae, m.finalError);
+        return 0;
+    }
+
+    if(argc > 1 && strcmp(argv[1], "gait") == 0){
+        double seconds = (argc > 2) ? atof(argv[2]) : 10.0;
+        uint32_t cadence = (argc > 3) ? (uint32_t)atoi(argv[3]) : 500;
+        uint32_t cadence2 = (argc > 4) ? (uint32_t)atoi(argv[4]) : 1000;
+        Controller_Id id = CONTROLLER_ADAPTIVE;
+        double rms[2];
+        int a;
+
+        for(a = 5; a < argc; a++){
+            if(strcmp(argv[a], "-controller") == 0 && a + 1 < argc){
+                if(!controllerId(argv[++a], &id)) return 1;
+            }else{
+                fprintf(stderr, "unknown option %s\n", argv[a]);
+                return 1;
+            }
+        }
+
+        printf("time, goal, load, duty\n");
+        runGait(&gaitSwing, seconds, cadence, cadence2, &params, stdout, id, rms);
+        fprintf(stderr, "%s on %s: RMS error %.3f lb at %u mHz, %.3f lb at %u mHz, %u cycles\n",
+                gaitSwing.name, Controller_Get(id)->name, rms[0], cadence, rms[1], cadence2,
+                Trajectory_Get()->cycles);
+        return 0;
+    }
+
+    if(argc > 1 && strcmp(argv[1], "filter") == 0){
+        double seconds = (argc > 2) ? atof(argv[2]) : 10.0;
+        uint32_t cadence = (argc > 3) ? (uint32_t)atoi(argv[3]) : 1000;
+        Controller_Id id = CONTROLLER_ADAPTIVE;
+        int a;
+
+        for(a = 4; a < argc; a++){
+            if(strcmp(argv[a], "-controller") == 0 && a + 1 < argc){
+                if(!controllerId(argv[++a], &id)) return 1;
+            }else if(strcmp(argv[a], "-noise") == 0 && a + 1 < argc){
+                params.noiseCounts = atof(argv[++a]);
+            }else if(strcmp(argv[a], "-set") == 0 && a + 2 < argc){
+                int p = Param_Find(argv[a + 1]);
+                if(p < 0 || !Param_Set((uint32_t)p, atof(argv[a + 2]))){
+                    fprintf(stderr, "cannot set %s to %s\n", argv[a + 1], argv[a + 2]);
+                    return 1;
+                }
+                a += 2;
+            }else{
+                fprintf(stderr, "unknown option %s\n", argv[a]);
+                return 1;
+            }
+        }
+
+        printf("time, plant, reading, kalman\n");
+        if(!runFilter(&gaitSwing, seconds, cadence, &params, stdout, id)){
+            return 1;
+        }
+        fprintf(stderr, "%s on %s at %u mHz, mean of %d ticks\n", gaitSwing.name, Controller_Get(id)->name,
+                cadence, FILTER_MEAN);
+        return 0;
+    }
+
+    fprintf(stderr, "usage: %s step [seconds] [goal lb] [-realtime] [-controller name] [-switch time_s name] [-overload time_s] [-set name value]...\n", argv[0]);
+    fprintf(stderr, "       %s sweep gxMin gxMax gxSteps grMin grMax grSteps [seconds] [goal lb]\n", argv[0]);
+    fprintf(stderr, "       %s position [seconds] [step counts] [-rates velocityDiv positionDiv]\n", argv[0]);
+    fprintf(stderr, "       %s gait [seconds] [cadence mHz] [second cadence mHz] [-controller name]\n", argv[0]);
+    fprintf(stderr, "       %s filter [seconds] [cadence mHz] [-controller name] [-noise counts] [-set name value]...\n", argv[0]);
+    return 1;
+}
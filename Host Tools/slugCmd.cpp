@@ -0,0 +1,288 @@
+// slugCmd.cpp
+// Runs on a host PC
+// Command line client of the UART0 command protocol (slugLink.h): read and
+// write the named parameters of slug.c, set or stream the force goal, start
+// and stop the controller and the logger, select the controller strategy,
+// read the deadline monitor of the controller tick, the interrupt handler
+// profiles of a board built with SLUG_PROFILE 1 and the thread loads of the
+// TI-RTOS build, read and upload the gain schedule of the scheduled PID as
+// CSV (goal lb, error lb, kp, ki, kd, one row per entry, goal by goal), and
+// save the parameters and the gain schedule to the EEPROM of the board
+// (store save), where it loads them from at reset.
+// Every command waits for the board to acknowledge it, except the goal
+// stream, which sends one goal per row of a CSV file (time s, goal lb) at
+// its time without waiting.
+//
+// Build:
+//   g++ -O2 -std=c++11 -o slugCmd slugCmd.cpp slugLink.cpp
+// Run:
+//   ./slugCmd device [-baud n] command...
+//     ping | list | get name | set name value | goal lb | stream file.csv
+//     start | stop | logger on|off | select controller | monitor | profile [reset] | load
+//     store [save|load|defaults|erase] | schedule [file.csv]
+//   e.g. ./slugCmd /dev/ttyACM0 set gamma_x 0.0003
+//        ./slugCmd /dev/ttyACM0 schedule > s.csv; edit s.csv; ./slugCmd /dev/ttyACM0 schedule s.csv
+//        ./slugPty /tmp/slug & ./slugCmd /tmp/slug -baud 0 list
+// The controller is a Controller_Id or one of the names below.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "slugLink.h"
+
+// Same order as Controller_Id in slug.h
+static const char *const controllers[] = {"pid", "adaptive", "swing", "cascade", "scheduled", "ident", "tune"};
+
+// Same order as Profile_Id in profile.h
+static const char *const handlers[NUM_PROFILES] = {"Controller", "LoadCell", "Sensors", "Logger", "UART"};
+
+// Same order as Command_StoreAction in command.h
+static const char *const storeActions[] = {"info", "save", "load", "defaults", "erase"};
+
+// Same order as Tier_Id in RTOS/ForceControl_RTOS/main.c
+static const char *const tiers[] = {"CPU", "Hwi", "Control", "Telemetry", "Command"};
+
+static int usage(const char *name){
+    std::cerr << "usage: " << name << " device [-baud n] command...\n"
+              << "  ping | list | get name | set name value | goal lb | stream file.csv\n"
+              << "  start | stop | logger on|off | select controller | monitor | profile [reset] | load\n"
+              << "  store [save|load|defaults|erase] | schedule [file.csv]\n";
+    return 1;
+}
+
+//------------------controllerId()---------------------------
+//Controller from its number or name
+static unsigned controllerId(const std::string &arg){
+    for(unsigned i = 0; i < sizeof(controllers)/sizeof(controllers[0]); i++){
+        if(arg == controllers[i]){
+            return i;
+        }
+    }
+    char *end;
+    unsigned long id = std::strtoul(arg.c_str(), &end, 0);
+    if(*end || arg.empty()){
+        throw SlugError("unknown controller " + arg);
+    }
+    return (unsigned)id;
+}
+
+//------------------stream()---------------------------
+//Send the goal of each row at its time, without acknowledge, then ping so
+//the last goal is known to have arrived
+static void stream(SlugLink &link, const std::string &path){
+    std::ifstream in(path);
+    std::string line;
+    unsigned long sent = 0;
+
+    if(!in){
+        throw SlugError(path + ": cannot open");
+    }
+    auto start = std::chrono::steady_clock::now();
+    while(std::getline(in, line)){
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream row(line);
+        double t, lb;
+        if(!(row >> t >> lb)){
+            continue; // header or blank line
+        }
+        std::this_thread::sleep_until(start + std::chrono::microseconds((long long)(t*1e6)));
+        link.goal((float)lb, false);
+        sent++;
+    }
+    link.ping();
+    std::cout << sent << " goals sent\n";
+}
+
+//------------------monitor()---------------------------
+//Print the deadline monitor of the controller tick, in clock cycles
+static void monitor(SlugLink &link){
+    SlugLink::Monitor m = link.monitor();
+    std::cout << "ticks " << m.ticks << ", overruns " << m.overruns << ", bucket " << m.bucket
+              << (m.tripped ? ", tripped" : "") << "\n"
+              << "jitter " << m.jitterMin << " to " << m.jitterMax << ", longest tick " << m.execMax << "\n"
+              << "jitter bins of " << (1 << MONITOR_BIN_SHIFT) << " cycles from "
+              << -(MONITOR_BINS/2 << MONITOR_BIN_SHIFT) << ":";
+    for(uint32_t n : m.histogram){
+        std::cout << " " << n;
+    }
+    std::cout << "\n";
+}
+
+//------------------profile()---------------------------
+//Print the profile of every handler, in clock cycles
+static void profile(SlugLink &link){
+    std::cout << "handler, count, min, mean, max, period, latency max, missed, latency bins\n";
+    for(unsigned id = 0; id < NUM_PROFILES; id++){
+        SlugLink::Profile p = link.profile(id);
+        std::cout << handlers[id] << ", " << p.count << ", " << p.min << ", " << p.mean << ", " << p.max
+                  << ", " << p.period << ", " << p.latencyMax << ", " << p.missed << ",";
+        for(uint32_t n : p.histogram){
+            std::cout << " " << n;
+        }
+        std::cout << "\n";
+    }
+}
+
+//------------------load()---------------------------
+//Print the load and latency of every thread tier over the last second
+static void load(SlugLink &link){
+    std::cout << "tier, load %, runs, latency max, latency mean\n";
+    for(unsigned tier = 0; tier < sizeof(tiers)/sizeof(tiers[0]); tier++){
+        SlugLink::Load l = link.load(tier);
+        std::cout << tiers[tier] << ", " << l.load/100 << "." << (l.load/10)%10 << l.load%10 << ", " << l.count
+                  << ", " << l.latencyMax << ", " << l.latencyMean << "\n";
+    }
+}
+
+//------------------store()---------------------------
+//Run an action on the parameter store and print its state
+static void store(SlugLink &link, const std::string &action){
+    for(unsigned i = 0; i < sizeof(storeActions)/sizeof(storeActions[0]); i++){
+        if(action == storeActions[i]){
+            SlugLink::Store s = link.store(i);
+            std::cout << SlugLink::storeName(s.status) << ", " << s.loaded << " loaded or saved, "
+                      << s.skipped << " skipped, " << s.saves << " saves"
+                      << (s.schedule ? ", gain schedule" : "") << "\n";
+            return;
+        }
+    }
+    throw SlugError("unknown store action " + action);
+}
+
+//------------------schedule()---------------------------
+//Print the gain schedule of the board as CSV
+static void schedule(SlugLink &link){
+    GainSchedule_Table t = link.schedule();
+
+    std::cout << "goal, error, kp, ki, kd\n";
+    for(uint32_t i = 0; i < t.goals; i++){
+        for(uint32_t j = 0; j < t.errors; j++){
+            std::cout << t.goal[i] << ", " << t.error[j] << ", " << t.gains[i][j].kp << ", "
+                      << t.gains[i][j].ki << ", " << t.gains[i][j].kd << "\n";
+        }
+    }
+}
+
+//------------------uploadSchedule()---------------------------
+//Upload a gain schedule from CSV in the format schedule() prints: the goal
+//and error breakpoints are taken in the order they first appear, every pair
+//needs one row
+static void uploadSchedule(SlugLink &link, const std::string &path){
+    std::ifstream in(path);
+    std::string line;
+    GainSchedule_Table t;
+    unsigned rows = 0;
+
+    if(!in){
+        throw SlugError(path + ": cannot open");
+    }
+    std::memset(&t, 0, sizeof(t));
+    while(std::getline(in, line)){
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream row(line);
+        float goal, error;
+        GainSchedule_Gains g;
+        uint32_t i, j;
+        if(!(row >> goal >> error >> g.kp >> g.ki >> g.kd)){
+            continue; // header or blank line
+        }
+        for(i = 0; i < t.goals && t.goal[i] != goal; i++){
+        }
+        for(j = 0; j < t.errors && t.error[j] != error; j++){
+        }
+        if(i == GAIN_SCHEDULE_MAX_GOALS || j == GAIN_SCHEDULE_MAX_ERRORS){
+            throw SlugError(path + ": too many breakpoints");
+        }
+        if(i == t.goals){
+            t.goal[t.goals++] = goal;
+        }
+        if(j == t.errors){
+            t.error[t.errors++] = error;
+        }
+        t.gains[i][j] = g;
+        rows++;
+    }
+    if(rows == 0 || rows != t.goals*t.errors){
+        throw SlugError(path + ": needs one row for every goal and error pair");
+    }
+    link.setSchedule(t);
+    std::cout << t.goals << " goals x " << t.errors << " errors set\n";
+}
+
+int main(int argc, char **argv){
+    unsigned baud = 460800;
+    int a = 2;
+
+    if(argc < 3){
+        return usage(argv[0]);
+    }
+    if(std::strcmp(argv[a], "-baud") == 0 && a + 2 < argc){
+        baud = (unsigned)std::atoi(argv[a + 1]);
+        a += 2;
+    }
+    std::string cmd = argv[a++];
+    int args = argc - a;
+
+    try{
+        SlugLink link(argv[1], baud);
+
+        if(cmd == "ping" && args == 0){
+            std::cout << "protocol version " << link.ping() << "\n";
+        }else if(cmd == "list" && args == 0){
+            for(const std::string &name : link.params()){
+                std::cout << name << " " << link.get(name) << "\n";
+            }
+        }else if(cmd == "get" && args == 1){
+            std::cout << link.get(argv[a]) << "\n";
+        }else if(cmd == "set" && args == 2){
+            std::cout << link.set(argv[a], (float)std::atof(argv[a + 1])) << "\n";
+        }else if(cmd == "goal" && args == 1){
+            link.goal((float)std::atof(argv[a]));
+        }else if(cmd == "stream" && args == 1){
+            stream(link, argv[a]);
+        }else if(cmd == "start" && args == 0){
+            link.start();
+        }else if(cmd == "stop" && args == 0){
+            link.stop();
+        }else if(cmd == "logger" && args == 1 && (std::strcmp(argv[a], "on") == 0 || std::strcmp(argv[a], "off") == 0)){
+            link.logger(std::strcmp(argv[a], "on") == 0);
+        }else if(cmd == "select" && args == 1){
+            link.select(controllerId(argv[a]));
+        }else if(cmd == "monitor" && args == 0){
+            monitor(link);
+        }else if(cmd == "profile" && args == 0){
+            profile(link);
+        }else if(cmd == "profile" && args == 1 && std::strcmp(argv[a], "reset") == 0){
+            link.profileReset();
+        }else if(cmd == "load" && args == 0){
+            load(link);
+        }else if(cmd == "store" && args <= 1){
+            store(link, args ? argv[a] : "info");
+        }else if(cmd == "schedule" && args == 0){
+            schedule(link);
+        }else if(cmd == "schedule" && args == 1){
+            uploadSchedule(link, argv[a]);
+        }else{
+            return usage(argv[0]);
+        }
+        if(link.resent()){
+            std::cerr << link.resent() << " requests sent again";
+            if(link.busy()){
+                std::cerr << ", " << link.busy() << " of them on a busy board";
+            }
+            std::cerr << "\n";
+        }
+    }catch(const SlugError &e){
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
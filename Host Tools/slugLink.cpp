@@ -0,0 +1,511 @@
+// slugLink.cpp
+// Runs on a host PC
+// Client of the UART0 command protocol, see slugLink.h.
+
+#include "slugLink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+//------------------speed()---------------------------
+//termios speed of a baud rate, B0 if there is none
+speed_t speed(unsigned baud){
+    switch(baud){
+    case 9600:    return B9600;
+    case 19200:   return B19200;
+    case 38400:   return B38400;
+    case 57600:   return B57600;
+    case 115200:  return B115200;
+    case 230400:  return B230400;
+#ifdef B460800
+    case 460800:  return B460800;
+#endif
+#ifdef B921600
+    case 921600:  return B921600;
+#endif
+#ifdef B1500000
+    case 1500000: return B1500000;
+#endif
+    }
+    return B0;
+}
+
+unsigned long long nowMs(){
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+SlugLink::SlugLink(const std::string &device, unsigned baud)
+    : fd_(-1), seq_(0), timeout_(200), retries_(3), resent_(0), busy_(0), skipped_(0), rxPos_(0){
+    struct termios tio;
+
+    fd_ = ::open(device.c_str(), O_RDWR | O_NOCTTY);
+    if(fd_ < 0){
+        throw SlugError(device + ": " + std::strerror(errno));
+    }
+    if(tcgetattr(fd_, &tio) == 0){
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        if(baud){
+            speed_t s = speed(baud);
+            if(s == B0){
+                ::close(fd_);
+                throw SlugError("unsupported baud rate " + std::to_string(baud));
+            }
+            cfsetispeed(&tio, s);
+            cfsetospeed(&tio, s);
+        }
+        tcsetattr(fd_, TCSANOW, &tio);
+        tcflush(fd_, TCIFLUSH); // telemetry queued before we came
+    }
+}
+
+SlugLink::~SlugLink(){
+    if(fd_ >= 0){
+        ::close(fd_);
+    }
+}
+
+void SlugLink::setTimeout(unsigned milliseconds, unsigned retries){
+    timeout_ = milliseconds;
+    retries_ = retries;
+}
+
+//------------------crc16()---------------------------
+//CRC-16/CCITT-FALSE, written out again here so the client checks the board
+uint16_t SlugLink::crc16(const uint8_t *data, size_t length){
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 0; i < length; i++){
+        crc ^= (uint16_t)data[i] << 8;
+        for(int bit = 0; bit < 8; bit++){
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void SlugLink::putFloat(std::vector<uint8_t> &buffer, float value){
+    uint32_t u;
+    std::memcpy(&u, &value, 4);
+    for(int i = 0; i < 4; i++){
+        buffer.push_back((uint8_t)(u >> (8*i)));
+    }
+}
+
+uint32_t SlugLink::getUint32(const uint8_t *buffer){
+    return buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+float SlugLink::getFloat(const uint8_t *buffer){
+    uint32_t u = getUint32(buffer);
+    float value;
+    std::memcpy(&value, &u, 4);
+    return value;
+}
+
+const char *SlugLink::statusName(Command_Status status){
+    switch(status){
+    case COMMAND_OK:           return "ok";
+    case COMMAND_UNKNOWN:      return "unknown command";
+    case COMMAND_BAD_LENGTH:   return "bad length";
+    case COMMAND_BAD_ID:       return "unknown parameter or controller";
+    case COMMAND_OUT_OF_RANGE: return "value out of range";
+    case COMMAND_BUSY:         return "board busy";
+    }
+    return "unknown status";
+}
+
+const char *SlugLink::storeName(ParamStore_Status status){
+    switch(status){
+    case PARAMSTORE_NONE:        return "nothing done";
+    case PARAMSTORE_LOADED:      return "loaded";
+    case PARAMSTORE_SAVED:       return "saved";
+    case PARAMSTORE_DEFAULTS:    return "build values set";
+    case PARAMSTORE_ERASED:      return "erased";
+    case PARAMSTORE_BLANK:       return "no store, build values kept";
+    case PARAMSTORE_BAD_VERSION: return "store of another layout, build values kept";
+    case PARAMSTORE_BAD_CRC:     return "store damaged, build values kept";
+    case PARAMSTORE_FAILED:      return "EEPROM failed";
+    }
+    return "unknown store status";
+}
+
+//------------------write()---------------------------
+//Frame and send one request
+void SlugLink::write(uint8_t seq, uint8_t code, const std::vector<uint8_t> &payload){
+    std::vector<uint8_t> frame;
+    uint16_t crc;
+
+    if(payload.size() > COMMAND_MAX_PAYLOAD){
+        throw SlugError("payload too long");
+    }
+    frame.push_back(COMMAND_SYNC & 0xFF);
+    frame.push_back(COMMAND_SYNC >> 8);
+    frame.push_back(seq);
+    frame.push_back(code);
+    frame.push_back((uint8_t)payload.size());
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    crc = crc16(&frame[2], frame.size() - 2);
+    frame.push_back((uint8_t)crc);
+    frame.push_back((uint8_t)(crc >> 8));
+
+    size_t done = 0;
+    while(done < frame.size()){
+        ssize_t n = ::write(fd_, &frame[done], frame.size() - done);
+        if(n < 0){
+            if(errno == EINTR || errno == EAGAIN) continue;
+            throw SlugError(std::string("write: ") + std::strerror(errno));
+        }
+        done += (size_t)n;
+    }
+}
+
+//------------------readByte()---------------------------
+//Next received byte, -1 when nothing came within the time
+int SlugLink::readByte(unsigned milliseconds){
+    if(rxPos_ == rx_.size()){
+        struct pollfd p = {fd_, POLLIN, 0};
+        uint8_t buffer[4096];
+        ssize_t n;
+
+        rx_.clear();
+        rxPos_ = 0;
+        if(poll(&p, 1, (int)milliseconds) <= 0){
+            return -1;
+        }
+        n = ::read(fd_, buffer, sizeof(buffer));
+        if(n <= 0){
+            return -1;
+        }
+        rx_.assign(buffer, buffer + n);
+    }
+    return rx_[rxPos_++];
+}
+
+//------------------readReply()---------------------------
+//Wait for the reply to request seq, skipping telemetry, other replies and
+//frames with a bad CRC
+bool SlugLink::readReply(uint8_t seq, Reply &reply, unsigned milliseconds){
+    unsigned long long deadline = nowMs() + milliseconds;
+    int last = -1;
+
+    for(;;){
+        unsigned long long now = nowMs();
+        if(now >= deadline){
+            return false;
+        }
+        unsigned left = (unsigned)(deadline - now);
+        int b = readByte(left);
+        if(b < 0){
+            return false;
+        }
+        if(!(last == (COMMAND_REPLY_SYNC & 0xFF) && b == (COMMAND_REPLY_SYNC >> 8))){
+            if(last >= 0) skipped_++;
+            last = b;
+            continue;
+        }
+        last = -1;
+
+        // Header, payload and CRC
+        uint8_t frame[COMMAND_REPLY_SIZE(COMMAND_MAX_PAYLOAD)];
+        size_t size = 6, i;
+        bool complete = true;
+        for(i = 2; i < size; i++){
+            int c = readByte(left);
+            if(c < 0){ complete = false; break; }
+            frame[i] = (uint8_t)c;
+            if(i == 5){
+                if(frame[5] > COMMAND_MAX_PAYLOAD){ complete = false; break; }
+                size = COMMAND_REPLY_SIZE(frame[5]);
+            }
+        }
+        if(!complete){
+            skipped_ += i;
+            continue;
+        }
+        uint16_t crc = frame[size - 2] | (uint16_t)(frame[size - 1] << 8);
+        if(crc16(&frame[2], size - 4) != crc){
+            skipped_ += size;
+            continue;
+        }
+        if(frame[2] != seq){
+            continue; // late reply to a request already given up on
+        }
+        reply.seq = frame[2];
+        reply.code = frame[3];
+        reply.status = (Command_Status)frame[4];
+        reply.payload.assign(frame + 6, frame + 6 + frame[5]);
+        return true;
+    }
+}
+
+SlugLink::Reply SlugLink::request(Command_Code code, const std::vector<uint8_t> &payload){
+    Reply reply;
+    uint8_t seq = seq_++;
+
+    for(unsigned attempt = 0; attempt <= retries_; attempt++){
+        if(attempt){
+            resent_++;
+        }
+        write(seq, (uint8_t)code, payload);
+        if(readReply(seq, reply, timeout_)){
+            if(reply.status == COMMAND_BUSY && attempt < retries_){
+                // not run on the board, the transmitter drains meanwhile
+                busy_++;
+                usleep(BUSY_PAUSE_MS*1000);
+                continue;
+            }
+            if(reply.status != COMMAND_OK){
+                throw SlugError(statusName(reply.status));
+            }
+            return reply;
+        }
+    }
+    throw SlugError("no reply from the board");
+}
+
+void SlugLink::send(Command_Code code, const std::vector<uint8_t> &payload){
+    write(seq_++, (uint8_t)(code | COMMAND_NO_REPLY), payload);
+}
+
+unsigned SlugLink::ping(){
+    Reply r = request(COMMAND_PING);
+    if(r.payload.size() < 1){
+        throw SlugError("short reply");
+    }
+    return r.payload[0];
+}
+
+const std::vector<std::string> &SlugLink::params(){
+    if(names_.empty()){
+        Reply r = request(COMMAND_PARAM_COUNT);
+        if(r.payload.size() < 1){
+            throw SlugError("short reply");
+        }
+        for(unsigned id = 0; id < r.payload[0]; id++){
+            Reply n = request(COMMAND_PARAM_NAME, std::vector<uint8_t>(1, (uint8_t)id));
+            if(n.payload.size() < 1){
+                throw SlugError("short reply");
+            }
+            names_.push_back(std::string(n.payload.begin() + 1, n.payload.end()));
+        }
+    }
+    return names_;
+}
+
+unsigned SlugLink::paramId(const std::string &name){
+    const std::vector<std::string> &names = params();
+    for(size_t i = 0; i < names.size(); i++){
+        if(names[i] == name){
+            return (unsigned)i;
+        }
+    }
+    throw SlugError("unknown parameter " + name);
+}
+
+float SlugLink::get(const std::string &name){
+    Reply r = request(COMMAND_GET, std::vector<uint8_t>(1, (uint8_t)paramId(name)));
+    if(r.payload.size() < 5){
+        throw SlugError("short reply");
+    }
+    return getFloat(&r.payload[1]);
+}
+
+float SlugLink::set(const std::string &name, float value){
+    std::vector<uint8_t> payload(1, (uint8_t)paramId(name));
+    putFloat(payload, value);
+    Reply r = request(COMMAND_SET, payload);
+    if(r.payload.size() < 5){
+        throw SlugError("short reply");
+    }
+    return getFloat(&r.payload[1]);
+}
+
+void SlugLink::goal(float lb, bool acknowledge){
+    std::vector<uint8_t> payload;
+    putFloat(payload, lb);
+    if(acknowledge){
+        request(COMMAND_GOAL, payload);
+    }else{
+        send(COMMAND_GOAL, payload);
+    }
+}
+
+void SlugLink::start(){
+    request(COMMAND_START);
+}
+
+void SlugLink::stop(){
+    request(COMMAND_STOP);
+}
+
+void SlugLink::logger(bool on){
+    request(COMMAND_LOGGER, std::vector<uint8_t>(1, on ? 1 : 0));
+}
+
+void SlugLink::select(unsigned controller){
+    request(COMMAND_SELECT, std::vector<uint8_t>(1, (uint8_t)controller));
+}
+
+SlugLink::Profile SlugLink::profile(unsigned handler){
+    Profile p;
+    std::vector<uint8_t> payload(2);
+    Reply r;
+
+    payload[0] = (uint8_t)handler;
+    payload[1] = 0;
+    r = request(COMMAND_PROFILE, payload);
+    if(r.payload.size() < 30){
+        throw SlugError("short reply");
+    }
+    p.count = getUint32(&r.payload[2]);
+    p.min = getUint32(&r.payload[6]);
+    p.mean = getUint32(&r.payload[10]);
+    p.max = getUint32(&r.payload[14]);
+    p.period = getUint32(&r.payload[18]);
+    p.latencyMax = getUint32(&r.payload[22]);
+    p.missed = getUint32(&r.payload[26]);
+    for(unsigned page = 1; p.histogram.size() < PROFILE_BINS; page++){
+        payload[1] = (uint8_t)page;
+        r = request(COMMAND_PROFILE, payload);
+        if(r.payload.size() < 6){
+            throw SlugError("short reply");
+        }
+        for(size_t i = 2; i + 4 <= r.payload.size(); i += 4){
+            p.histogram.push_back(getUint32(&r.payload[i]));
+        }
+    }
+    return p;
+}
+
+void SlugLink::profileReset(){
+    request(COMMAND_PROFILE_RESET);
+}
+
+SlugLink::Monitor SlugLink::monitor(){
+    Monitor m;
+    std::vector<uint8_t> payload(1, 0);
+    Reply r = request(COMMAND_MONITOR, payload);
+
+    if(r.payload.size() < 29){
+        throw SlugError("short reply");
+    }
+    m.ticks = getUint32(&r.payload[1]);
+    m.overruns = getUint32(&r.payload[5]);
+    m.bucket = getUint32(&r.payload[9]);
+    m.tripped = getUint32(&r.payload[13]) != 0;
+    m.jitterMin = (int32_t)getUint32(&r.payload[17]);
+    m.jitterMax = (int32_t)getUint32(&r.payload[21]);
+    m.execMax = getUint32(&r.payload[25]);
+    for(unsigned page = 1; m.histogram.size() < MONITOR_BINS; page++){
+        payload[0] = (uint8_t)page;
+        r = request(COMMAND_MONITOR, payload);
+        if(r.payload.size() < 5){
+            throw SlugError("short reply");
+        }
+        for(size_t i = 1; i + 4 <= r.payload.size(); i += 4){
+            m.histogram.push_back(getUint32(&r.payload[i]));
+        }
+    }
+    return m;
+}
+
+SlugLink::Load SlugLink::load(unsigned tier){
+    Load l;
+    Reply r = request(COMMAND_LOAD, std::vector<uint8_t>(1, (uint8_t)tier));
+
+    if(r.payload.size() < 17){
+        throw SlugError("short reply");
+    }
+    l.load = getUint32(&r.payload[1]);
+    l.count = getUint32(&r.payload[5]);
+    l.latencyMax = getUint32(&r.payload[9]);
+    l.latencyMean = getUint32(&r.payload[13]);
+    return l;
+}
+
+SlugLink::Store SlugLink::store(unsigned action){
+    Store s;
+    Reply r = request(COMMAND_STORE, std::vector<uint8_t>(1, (uint8_t)action));
+
+    if(r.payload.size() < 8){
+        throw SlugError("short reply");
+    }
+    s.status = (ParamStore_Status)r.payload[1];
+    s.loaded = r.payload[2];
+    s.skipped = r.payload[3];
+    s.saves = getUint32(&r.payload[4]);
+    s.schedule = r.payload.size() > 8 && r.payload[8] != 0;
+    return s;
+}
+
+GainSchedule_Table SlugLink::schedule(){
+    GainSchedule_Table t;
+    std::vector<uint8_t> payload(1, COMMAND_SCHEDULE_INFO);
+    Reply r = request(COMMAND_SCHEDULE, payload);
+
+    if(r.payload.size() < 3){
+        throw SlugError("short reply");
+    }
+    std::memset(&t, 0, sizeof(t));
+    t.goals = std::min<uint32_t>(r.payload[1], GAIN_SCHEDULE_MAX_GOALS);
+    t.errors = std::min<uint32_t>(r.payload[2], GAIN_SCHEDULE_MAX_ERRORS);
+    payload.assign(3, 0);
+    payload[0] = COMMAND_SCHEDULE_GET;
+    for(uint32_t i = 0; i < t.goals; i++){
+        for(uint32_t j = 0; j < t.errors; j++){
+            payload[1] = (uint8_t)i;
+            payload[2] = (uint8_t)j;
+            r = request(COMMAND_SCHEDULE, payload);
+            if(r.payload.size() < 23){
+                throw SlugError("short reply");
+            }
+            t.goal[i] = getFloat(&r.payload[3]);
+            t.error[j] = getFloat(&r.payload[7]);
+            t.gains[i][j].kp = getFloat(&r.payload[11]);
+            t.gains[i][j].ki = getFloat(&r.payload[15]);
+            t.gains[i][j].kd = getFloat(&r.payload[19]);
+        }
+    }
+    return t;
+}
+
+void SlugLink::setSchedule(const GainSchedule_Table &table){
+    std::vector<uint8_t> payload;
+
+    if(table.goals < 1 || table.goals > GAIN_SCHEDULE_MAX_GOALS ||
+       table.errors < 1 || table.errors > GAIN_SCHEDULE_MAX_ERRORS){
+        throw SlugError("gain schedule size out of range");
+    }
+    payload.push_back(COMMAND_SCHEDULE_BEGIN);
+    payload.push_back((uint8_t)table.goals);
+    payload.push_back((uint8_t)table.errors);
+    request(COMMAND_SCHEDULE, payload);
+    for(uint32_t i = 0; i < table.goals; i++){
+        for(uint32_t j = 0; j < table.errors; j++){
+            payload.clear();
+            payload.push_back(COMMAND_SCHEDULE_PUT);
+            payload.push_back((uint8_t)i);
+            payload.push_back((uint8_t)j);
+            putFloat(payload, table.goal[i]);
+            putFloat(payload, table.error[j]);
+            putFloat(payload, table.gains[i][j].kp);
+            putFloat(payload, table.gains[i][j].ki);
+            putFloat(payload, table.gains[i][j].kd);
+            request(COMMAND_SCHEDULE, payload);
+        }
+    }
+    request(COMMAND_SCHEDULE, std::vector<uint8_t>(1, COMMAND_SCHEDULE_COMMIT));
+}
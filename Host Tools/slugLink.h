@@ -0,0 +1,160 @@
+// slugLink.h
+// Runs on a host PC
+// Client of the UART0 command protocol of the board (Board Support
+// Package/BSP/command.h): get and set named parameters, stream the force
+// goal, start and stop the controller and the logger. Works on the serial
+// port of the board or on the pseudo terminal of Host Tools/slugPty.
+// Replies are found by their sync word and checked with their CRC, so the
+// telemetry records sent between them are skipped. A request without a reply
+// within the timeout is sent again, one the board answers with COMMAND_BUSY
+// after a pause of BUSY_PAUSE_MS; failures throw SlugError.
+//
+// Build: compile slugLink.cpp with the program, C++11, e.g. Host Tools/slugCmd.cpp
+
+#ifndef SLUGLINK_H_
+#define SLUGLINK_H_
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Board Support Package/BSP/command.h"
+#include "../Board Support Package/BSP/profile.h"
+#include "../Board Support Package/BSP/monitor.h"
+#include "../Board Support Package/BSP/paramStore.h"
+#include "../Board Support Package/BSP/gainSchedule.h"
+
+class SlugError : public std::runtime_error {
+public:
+    explicit SlugError(const std::string &what) : std::runtime_error(what) {}
+};
+
+class SlugLink {
+public:
+    struct Reply {
+        uint8_t seq;
+        uint8_t code;
+        Command_Status status;
+        std::vector<uint8_t> payload;
+    };
+
+    // Interrupt handler profile, in clock cycles (profile.h)
+    struct Profile {
+        uint32_t count;
+        uint32_t min, mean, max;
+        uint32_t period;
+        uint32_t latencyMax;
+        uint32_t missed;
+        std::vector<uint32_t> histogram;
+    };
+
+    // Deadline monitor of the controller tick, in clock cycles (monitor.h)
+    struct Monitor {
+        uint32_t ticks;
+        uint32_t overruns;
+        uint32_t bucket;
+        bool tripped;
+        int32_t jitterMin, jitterMax;
+        uint32_t execMax;
+        std::vector<uint32_t> histogram;
+    };
+
+    // Parameter store in the EEPROM after an action (paramStore.h)
+    struct Store {
+        ParamStore_Status status;
+        unsigned loaded;        // records loaded or saved
+        unsigned skipped;       // records not loaded
+        uint32_t saves;
+        bool schedule;          // gain schedule loaded, saved or set back too
+    };
+
+    // Load of a thread tier of the TI-RTOS build (RTOS/ForceControl_RTOS)
+    struct Load {
+        uint32_t load;          // 0.01 % of the CPU
+        uint32_t count;         // runs in the last window
+        uint32_t latencyMax, latencyMean;   // clock cycles
+    };
+
+    // Open and configure the serial device (raw 8N1), baud 0 leaves the
+    // speed as it is (pseudo terminals)
+    explicit SlugLink(const std::string &device, unsigned baud = 460800);
+    ~SlugLink();
+    SlugLink(const SlugLink &) = delete;
+    SlugLink &operator=(const SlugLink &) = delete;
+
+    void setTimeout(unsigned milliseconds, unsigned retries);
+
+    // Protocol version of the board
+    unsigned ping();
+
+    // Parameter names in board order, read once and cached
+    const std::vector<std::string> &params();
+    // Parameter number, throws for an unknown name
+    unsigned paramId(const std::string &name);
+    float get(const std::string &name);
+    // Returns the value the board set
+    float set(const std::string &name, float value);
+
+    // Force goal in lb. Without acknowledge nothing is read back, for streams
+    void goal(float lb, bool acknowledge = true);
+    void start();
+    void stop();
+    void logger(bool on);
+    // Controller_Id of slug.h
+    void select(unsigned controller);
+    // Profile of a handler (Profile_Id), the board must be built with
+    // SLUG_PROFILE 1
+    Profile profile(unsigned handler);
+    void profileReset();
+    Monitor monitor();
+    // Load of a tier, the board must run TI-RTOS
+    Load load(unsigned tier);
+    // Run a Command_StoreAction on the parameter store
+    Store store(unsigned action);
+    // Gain schedule of the scheduled PID (gainSchedule.h), one request per
+    // entry
+    GainSchedule_Table schedule();
+    // Upload a gain schedule, the board uses it once GainSchedule_Check()
+    // accepts it and saves it with store save
+    void setSchedule(const GainSchedule_Table &table);
+
+    // One request, sent again until a reply with a good CRC comes and again
+    // while the board is busy. A status other than COMMAND_OK throws
+    Reply request(Command_Code code, const std::vector<uint8_t> &payload = std::vector<uint8_t>());
+    // One request that asks for no reply
+    void send(Command_Code code, const std::vector<uint8_t> &payload);
+
+    // Requests sent again after a timeout or a COMMAND_BUSY reply, and bytes
+    // skipped looking for replies
+    unsigned long resent() const { return resent_; }
+    unsigned long busy() const { return busy_; }
+    unsigned long skipped() const { return skipped_; }
+
+    static uint16_t crc16(const uint8_t *data, size_t length);
+    static void putFloat(std::vector<uint8_t> &buffer, float value);
+    static float getFloat(const uint8_t *buffer);
+    static uint32_t getUint32(const uint8_t *buffer);
+    static const char *statusName(Command_Status status);
+    static const char *storeName(ParamStore_Status status);
+
+private:
+    void write(uint8_t seq, uint8_t code, const std::vector<uint8_t> &payload);
+    bool readReply(uint8_t seq, Reply &reply, unsigned milliseconds);
+    int readByte(unsigned milliseconds);
+
+    static const unsigned BUSY_PAUSE_MS = 20;   // transmitter drains, 115200 baud
+
+    int fd_;
+    uint8_t seq_;
+    unsigned timeout_;
+    unsigned retries_;
+    unsigned long resent_;
+    unsigned long busy_;
+    unsigned long skipped_;
+    std::vector<std::string> names_;
+    std::vector<uint8_t> rx_;
+    size_t rxPos_;
+};
+
+#endif /* SLUGLINK_H_ */
@@ -0,0 +1,223 @@
+// slugPty.c
+// Runs on a host PC
+// Stand-in for the board behind a pseudo terminal, to try Host Tools/slugCmd
+// and other UART0 clients without the test stand. The unmodified slug.c runs
+// on the simulated peripherals of halHost.c against the series elastic
+// actuator model of seaPlant.c, paced to the wall clock. The start up
+// sequence and background loop are those of Adaptive_ForceControl.c (binary
+// telemetry, Logger_Drain(), SerialMonitor_Receive() and Tune_Background()). Bytes written to
+// the pseudo terminal reach the UART0 receive interrupt, everything the
+// firmware transmits is written back; what the client does not read in time
+// is dropped, as a serial port would.
+// The slave device name is printed on stderr and, when a link path is given,
+// a symbolic link to it is made there. Runs until interrupted.
+// With -eeprom the EEPROM is kept in a file: the parameters saved with
+// slugCmd store save are loaded at the next start, as on the board.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -DSLUG_HOST -I"../Board Support Package/BSP" -o slugPty slugPty.c seaPlant.c "../Board Support Package/BSP/slug.c" "../Board Support Package/BSP/forceControl.c" "../Board Support Package/BSP/telemetry.c" "../Board Support Package/BSP/uartTx.c" "../Board Support Package/BSP/decimator.c" "../Board Support Package/BSP/encoder.c" "../Board Support Package/BSP/gait.c" "../Board Support Package/BSP/gaitSwing.c" "../Board Support Package/BSP/gainSchedule.c" "../Board Support Package/BSP/command.c" "../Board Support Package/BSP/profile.c" "../Board Support Package/BSP/monitor.c" "../Board Support Package/BSP/ident.c" "../Board Support Package/BSP/autotune.c" "../Board Support Package/BSP/kalman.c" "../Board Support Package/BSP/calib.c" "../Board Support Package/BSP/paramStore.c" "../Board Support Package/BSP/halHost.c" -lm
+// Run:
+//   ./slugPty [link path] [-fast] [-eeprom file]
+//   e.g. ./slugPty /tmp/slug & ./slugCmd /tmp/slug get Kbar
+// -fast runs as fast as possible instead of in real time.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slug.h"
+#include "telemetry.h"
+#include "command.h"
+#include "paramStore.h"
+#include "seaPlant.h"
+
+#define PLANT_FREQ          10000   // Hz
+#define PASS_FREQ           1000    // Hz, background loop passes
+
+#define GOAL                45.0    // lb, the preload, so the motor starts at rest
+
+static SEA_Plant plant;
+static volatile sig_atomic_t running = 1;
+
+//------------------plantADC()---------------------------
+//ADC source for the load cell channel
+static uint32_t plantADC(void *context){
+    return SEA_PlantADC((SEA_Plant *)context);
+}
+
+//------------------motorDuty()---------------------------
+//Signed duty in percent from the simulated PWM output and direction pin
+static double motorDuty(void){
+    uint32_t period, width;
+    bool enabled;
+    double duty;
+
+    HAL_SimGetPWM(&period, &width, &enabled);
+    if(!enabled || period == 0){
+        return 0;
+    }
+    duty = 100.0*width/period;
+    return HAL_SimGetPin(HAL_PIN_MOTOR_DIR) ? duty : -duty;
+}
+
+//------------------nowNs()---------------------------
+//Monotonic time in nanoseconds
+static uint64_t nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void stop(int sig){
+    (void)sig;
+    running = 0;
+}
+
+//------------------openPty()---------------------------
+//Open a pseudo terminal in raw mode, non blocking on the master side
+//Output: Master descriptor, -1 on error. The slave stays open in *slave so
+//        the master does not fail while no client is connected
+static int openPty(int *slave, char *name, size_t size){
+    struct termios tio;
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if(master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+       ptsname_r(master, name, size) != 0){
+        perror("pseudo terminal");
+        return -1;
+    }
+    *slave = open(name, O_RDWR | O_NOCTTY);
+    if(*slave < 0){
+        perror(name);
+        return -1;
+    }
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+//------------------storeStatus()---------------------------
+//Name of a parameter store result
+static const char *storeStatus(ParamStore_Status status){
+    static const char *const names[] = {"none", "loaded", "saved", "defaults", "erased",
+                                        "blank, build values", "other layout version, build values",
+                                        "bad CRC, build values", "failed"};
+    return ((unsigned)status < sizeof(names)/sizeof(names[0])) ? names[status] : "?";
+}
+
+int main(int argc, char **argv){
+    const char *link = 0, *eeprom = 0;
+    int fast = 0, master, slave, a;
+    char name[128], buffer[4096];
+    SEA_Params params;
+    Param_Boot boot;
+    uint32_t stepCycles, k;
+    uint64_t wallStart, passes = 0, dropped = 0;
+    ssize_t n;
+    size_t got;
+
+    for(a = 1; a < argc; a++){
+        if(strcmp(argv[a], "-fast") == 0){
+            fast = 1;
+        }else if(strcmp(argv[a], "-eeprom") == 0 && a + 1 < argc){
+            eeprom = argv[++a];
+        }else if(argv[a][0] != '-' && !link){
+            link = argv[a];
+        }else{
+            fprintf(stderr, "usage: %s [link path] [-fast] [-eeprom file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    master = openPty(&slave, name, sizeof(name));
+    if(master < 0){
+        return 1;
+    }
+    if(link){
+        unlink(link);
+        if(symlink(name, link) != 0){
+            perror(link);
+            return 1;
+        }
+    }
+    fprintf(stderr, "board on %s%s%s\n", name, link ? " linked from " : "", link ? link : "");
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    SEA_DefaultParams(&params);
+    HAL_SimReset();
+    SEA_PlantInit(&plant, &params, 1.0/PLANT_FREQ);
+    HAL_SimSetADCSource(HAL_ADC_LOADCELL, plantADC, &plant);
+    HAL_SimSetEEPROMFile(eeprom);
+
+    // Same sequence as Adaptive_ForceControl.c
+    Clock_set_80MHz();
+    ParamStore_Load();
+    fprintf(stderr, "parameter store: %s, %u loaded, %u skipped\n", storeStatus(ParamStore_Get()->status),
+            (unsigned)ParamStore_Get()->loaded, (unsigned)ParamStore_Get()->skipped);
+    Param_GetBoot(&boot);
+    Logger_InitTelemetry(TELEMETRY_BAUD_RATE);
+    Motor_Init(boot.pwmFreq);
+    LoadCell_initBlock(boot.adcAveraging, boot.adcFreq);
+    setGoalForce(GOAL);
+    Controller_Init(boot.controllerFreq);
+    ControllerEnable();
+    EnableInterrupts();
+
+    stepCycles = Clock_get_frequency()/PLANT_FREQ;
+    wallStart = nowNs();
+    while(running){
+        // Host to board
+        while((n = read(master, buffer, sizeof(buffer))) > 0){
+            HAL_SimUARTWrite(buffer, (size_t)n);
+        }
+
+        // 1 ms of board time, plant in step with the firmware
+        for(k = 0; k < PLANT_FREQ/PASS_FREQ; k++){
+            HAL_SimRun(stepCycles);
+            SEA_PlantStep(&plant, motorDuty());
+        }
+
+        // Background loop of Adaptive_ForceControl.c
+        Logger_Drain();
+        SerialMonitor_Receive();
+        Tune_Background();
+
+        // Board to host
+        while((got = HAL_SimUARTRead(buffer, sizeof(buffer))) > 0){
+            n = write(master, buffer, got);
+            if(n < (ssize_t)got){
+                dropped += got - ((n > 0) ? (size_t)n : 0);
+            }
+        }
+
+        passes++;
+        if(!fast){
+            uint64_t due = wallStart + passes*(1000000000ull/PASS_FREQ);
+            uint64_t now = nowNs();
+            if(due > now){
+                struct timespec ts = {0, (long)(due - now)};
+                nanosleep(&ts, 0);
+            }
+        }
+    }
+
+    fprintf(stderr, "%.3f s simulated, load %.2f lb, %u bad requests, %llu bytes not read by the client\n",
+            (double)HAL_SimCycles()/Clock_get_frequency(), SEA_PlantLoad(&plant),
+            Command_Errors(), (unsigned long long)dropped);
+    if(link){
+        unlink(link);
+    }
+    close(slave);
+    close(master);
+    return 0;
+}
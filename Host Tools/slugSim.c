@@ -0,0 +1,95 @@
+// slugSim.c
+// Runs on a host PC
+// Runs the unmodified slug.c board support package on the simulated peripherals
+// of halHost.c. The start up sequence is the one of Adaptive_ForceControl.c
+// (PWM 20 kHz, load cell uDMA blocks at 32 kHz, controller at 2 kHz). The load
+// cell ADC reads a constant value. Without a capture file the 100 Hz text
+// logger is used and its output goes to stdout, with a capture file the binary
+// telemetry stream is written there (decode with telemetryDecode), -raw adds
+// the raw load cell blocks. The last sensor snapshot is printed at the end.
+// There is no plant model here, see seaSim for closed loop runs.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -DSLUG_HOST -I"../Board Support Package/BSP" -o slugSim slugSim.c "../Board Support Package/BSP/slug.c" "../Board Support Package/BSP/forceControl.c" "../Board Support Package/BSP/telemetry.c" "../Board Support Package/BSP/uartTx.c" "../Board Support Package/BSP/decimator.c" "../Board Support Package/BSP/encoder.c" "../Board Support Package/BSP/gait.c" "../Board Support Package/BSP/gaitSwing.c" "../Board Support Package/BSP/gainSchedule.c" "../Board Support Package/BSP/command.c" "../Board Support Package/BSP/profile.c" "../Board Support Package/BSP/monitor.c" "../Board Support Package/BSP/ident.c" "../Board Support Package/BSP/autotune.c" "../Board Support Package/BSP/kalman.c" "../Board Support Package/BSP/calib.c" "../Board Support Package/BSP/paramStore.c" "../Board Support Package/BSP/halHost.c" -lm
+// Run:
+//   ./slugSim [seconds] [load cell ADC counts] [goal force lb] [capture file] [-raw]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slug.h"
+#include "telemetry.h"
+
+int main(int argc, char **argv){
+    double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+    uint32_t loadADC = (argc > 2) ? (uint32_t)strtoul(argv[2], 0, 0) : 2234; // 45 lb rest load
+    double goal = (argc > 3) ? atof(argv[3]) : 5.0;
+    uint32_t period, width;
+    bool enabled;
+    Sensors_Snapshot sensors;
+    int i;
+    FILE *capture = (argc > 4) ? fopen(argv[4], "wb") : 0;
+    int raw = (argc > 5) && strcmp(argv[5], "-raw") == 0;
+    char buffer[4096];
+    size_t n;
+
+    if(argc > 4 && !capture){
+        perror(argv[4]);
+        return 1;
+    }
+
+    HAL_SimReset();
+    HAL_SimSetADCValue(HAL_ADC_LOADCELL, loadADC);
+    HAL_SimUARTEcho(!capture);
+
+    // Same sequence as Adaptive_ForceControl.c
+    Clock_set_80MHz();
+    if(capture){
+        Logger_InitTelemetry(raw ? TELEMETRY_RAW_BAUD_RATE : TELEMETRY_BAUD_RATE);
+        Logger_EnableRawCapture(raw);
+    }else{
+        Logger_Init(100, 115200);
+    }
+    Motor_Init(20000);
+    LoadCell_initBlock(8, 32000);
+    setGoalForce(goal);
+    Controller_Init(2000);
+    ControllerEnable();
+    EnableInterrupts();
+    RGBled_Init(0, 0, 1);
+
+    // Background loop, 1 ms of virtual time per pass
+    while(HAL_SimCycles() < (uint64_t)(seconds*Clock_get_frequency())){
+        delayMS(1);
+        if(capture){
+            Logger_Drain();
+        }
+        Tune_Background();
+        while((n = HAL_SimUARTRead(buffer, sizeof(buffer))) > 0){
+            if(capture){
+                fwrite(buffer, 1, n, capture);
+            } // else already echoed to stdout
+        }
+    }
+    fflush(stdout);
+    if(capture){
+        fclose(capture);
+        fprintf(stderr, "%u telemetry records dropped, %u raw blocks dropped\n",
+                Telemetry_Dropped(), Telemetry_BlocksDropped());
+    }
+
+    HAL_SimGetPWM(&period, &width, &enabled);
+    fprintf(stderr, "%.3f s simulated, %u controller ticks, PWM %u/%u %s, direction %d\n",
+            (double)HAL_SimCycles()/Clock_get_frequency(), getGlobalControllerTicks(),
+            width, period, enabled ? "on" : "off", HAL_SimGetPin(HAL_PIN_MOTOR_DIR));
+
+    Sensors_Read(&sensors);
+    fprintf(stderr, "sensor snapshot %u at tick %u:", sensors.count, sensors.tick);
+    for(i = 0; i < NUM_SENSORS; i++){
+        fprintf(stderr, " %s %u (%.2f %s)", Sensors_Channel((Sensor_Id)i)->name, sensors.raw[i],
+                sensors.value[i], Sensors_Channel((Sensor_Id)i)->units);
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
@@ -0,0 +1,495 @@
+// sysIdent.cpp
+// Runs on a host PC
+// Frequency response of the actuator from an identification run, duty in
+// percent to load in lb, and a low order transfer function fitted to it.
+// The run is CONTROLLER_IDENT of slug.c (ident.h), a chirp or a PRBS of
+// duty sent open loop, recorded as a CSV with a header row:
+//   telemetryDecode - seq, tick, time_s, adc, load_lb, duty_pct, ...
+//   seaSim step     - time, load, duty
+// The input is the first column named "duty...", the output the first one
+// named "load...", the sample rate comes from the "time..." column or -rate.
+//
+// Welch estimate: the rows stream through a window of -nfft samples, every
+// half window the segment has its mean removed, gets a Hann window and goes
+// through the FFT; the auto and cross spectra are averaged over segments, so
+// a run of any length needs the memory of one segment. Then
+//   H(f) = Suy/Suu            (H1, unbiased for noise on the output)
+//   coherence = |Suy|^2/(Suu Syy)
+// Fit: H(s) = (b[m] s^m + ... + b[0])/(s^n + a[n-1] s^(n-1) + ... + a[0]),
+// -order n and -zeros m, on the bins from -fmin to -fmax with at least
+// -coherence. Levy's linear least squares, iterated (Sanathanan-Koerner) so
+// the error is that of H itself, relative to |H| so every decade counts the
+// same. -delay removes a known dead time (logger and controller tick) from
+// the measured phase before the fit. The frequency axis is scaled to the
+// band for the solve.
+//
+// Build:
+//   g++ -O2 -std=c++11 -o sysIdent sysIdent.cpp
+// Run:
+//   ./sysIdent run.csv [-rate Hz] [-nfft n] [-order n] [-zeros m] [-fmin Hz] [-fmax Hz]
+//              [-coherence c] [-delay s] [-csv bode.csv]
+//   e.g. ./seaSim step 60 45 -controller ident > chirp.csv && ./sysIdent chirp.csv -fmax 20 -csv bode.csv
+//        ./slugCmd /dev/ttyACM0 select ident && ./telemetryDecode /dev/ttyACM0 2000 > run.csv
+// The Bode CSV has one row per bin: f Hz, measured gain dB and phase deg,
+// coherence, model gain dB and phase deg.
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define IDENT_NFFT          8192
+#define IDENT_MAX_ORDER     4
+#define IDENT_ITERATIONS    20      // Sanathanan-Koerner
+#define IDENT_COHERENCE     0.9
+
+typedef std::complex<double> Complex;
+
+struct Options {
+    double rate = 0;            // Hz, 0 from the time column
+    size_t nfft = IDENT_NFFT;
+    int order = 2, zeros = 0;
+    double fmin = 0, fmax = 0;  // Hz, 0 for the whole range
+    double coherence = IDENT_COHERENCE;
+    double delay = 0;           // s
+};
+
+struct Model {
+    std::vector<double> b, a;   // increasing powers of s, a[n] = 1
+};
+
+//------------------fft()---------------------------
+//In place radix 2 FFT
+//Input: data, its size a power of 2
+static void fft(std::vector<Complex> &x){
+    size_t n = x.size();
+
+    for(size_t i = 1, j = 0; i < n; i++){
+        size_t bit = n >> 1;
+        for(; j & bit; bit >>= 1){
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j){
+            std::swap(x[i], x[j]);
+        }
+    }
+    for(size_t len = 2; len <= n; len <<= 1){
+        Complex w = std::polar(1.0, -2*M_PI/len);
+        for(size_t i = 0; i < n; i += len){
+            Complex wk = 1;
+            for(size_t k = 0; k < len/2; k++){
+                Complex t = wk*x[i + k + len/2];
+                x[i + k + len/2] = x[i + k] - t;
+                x[i + k] += t;
+                wk *= w;
+            }
+        }
+    }
+}
+
+// Averaged auto and cross spectra of Welch's method
+class Welch {
+public:
+    explicit Welch(size_t nfft) : n(nfft), u(nfft), y(nfft), window(nfft), suu(nfft/2 + 1), syy(nfft/2 + 1),
+        suy(nfft/2 + 1), fill(0), segments(0) {
+        for(size_t i = 0; i < n; i++){
+            window[i] = 0.5 - 0.5*std::cos(2*M_PI*i/n);
+        }
+    }
+
+    //------------------add()---------------------------
+    //One row, a segment is taken every half window once the first is full
+    void add(double input, double output){
+        u[fill] = input;
+        y[fill] = output;
+        if(++fill == n){
+            segment();
+            std::copy(u.begin() + n/2, u.end(), u.begin());
+            std::copy(y.begin() + n/2, y.end(), y.begin());
+            fill = n/2;
+        }
+    }
+
+    size_t n;
+    std::vector<double> u, y, window, suu, syy;
+    std::vector<Complex> suy;
+    size_t fill, segments;
+
+private:
+    //------------------segment()---------------------------
+    //Spectra of the window, mean removed, added to the sums
+    void segment(){
+        std::vector<Complex> U(n), Y(n);
+        double mu = 0, my = 0;
+
+        for(size_t i = 0; i < n; i++){
+            mu += u[i];
+            my += y[i];
+        }
+        mu /= n;
+        my /= n;
+        for(size_t i = 0; i < n; i++){
+            U[i] = (u[i] - mu)*window[i];
+            Y[i] = (y[i] - my)*window[i];
+        }
+        fft(U);
+        fft(Y);
+        for(size_t k = 0; k <= n/2; k++){
+            suu[k] += std::norm(U[k]);
+            syy[k] += std::norm(Y[k]);
+            suy[k] += std::conj(U[k])*Y[k];
+        }
+        segments++;
+    }
+};
+
+//------------------polyval()---------------------------
+//Polynomial in increasing powers at s
+static Complex polyval(const std::vector<double> &p, Complex s){
+    Complex v = 0;
+    for(size_t i = p.size(); i-- > 0;){
+        v = v*s + p[i];
+    }
+    return v;
+}
+
+//------------------solve()---------------------------
+//Solve A x = b in place, Gaussian elimination with partial pivoting
+//Input: matrix, right hand side
+//Output: false if singular
+static bool solve(std::vector<std::vector<double>> &A, std::vector<double> &b){
+    size_t n = b.size();
+
+    for(size_t c = 0; c < n; c++){
+        size_t p = c;
+        for(size_t r = c + 1; r < n; r++){
+            if(std::fabs(A[r][c]) > std::fabs(A[p][c])){
+                p = r;
+            }
+        }
+        if(A[p][c] == 0){
+            return false;
+        }
+        std::swap(A[p], A[c]);
+        std::swap(b[p], b[c]);
+        for(size_t r = c + 1; r < n; r++){
+            double f = A[r][c]/A[c][c];
+            for(size_t k = c; k < n; k++){
+                A[r][k] -= f*A[c][k];
+            }
+            b[r] -= f*b[c];
+        }
+    }
+    for(size_t c = n; c-- > 0;){
+        for(size_t k = c + 1; k < n; k++){
+            b[c] -= A[c][k]*b[k];
+        }
+        b[c] /= A[c][c];
+    }
+    return true;
+}
+
+//------------------fit()---------------------------
+//Fit the model to the measured response, see the file header
+//Input: angular frequencies, responses, weights, orders
+//Output: Model in s
+static Model fit(const std::vector<double> &w, const std::vector<Complex> &h, const std::vector<double> &weight,
+                 int order, int zeros){
+    size_t unknowns = zeros + 1 + order;
+    double w0 = *std::max_element(w.begin(), w.end());
+    std::vector<double> alpha(order + 1, 0.0);
+    Model scaled;
+
+    alpha[order] = 1;
+    for(int it = 0; it < IDENT_ITERATIONS; it++){
+        std::vector<std::vector<double>> A(unknowns, std::vector<double>(unknowns, 0.0));
+        std::vector<double> rhs(unknowns, 0.0);
+
+        for(size_t k = 0; k < w.size(); k++){
+            Complex p(0, w[k]/w0);
+            double sk = weight[k]/std::norm(polyval(alpha, p)*h[k]);
+            // B(p) - H sum(alpha_i p^i) = H p^n, real and imaginary rows
+            std::vector<Complex> row(unknowns);
+            Complex pi = 1;
+            for(int i = 0; i <= std::max(zeros, order - 1); i++){
+                if(i <= zeros){
+                    row[i] = pi;
+                }
+                if(i < order){
+                    row[zeros + 1 + i] = -h[k]*pi;
+                }
+                pi *= p;
+            }
+            Complex target = h[k]*std::pow(p, order);
+            for(size_t r = 0; r < unknowns; r++){
+                for(size_t c = 0; c < unknowns; c++){
+                    A[r][c] += sk*(row[r].real()*row[c].real() + row[r].imag()*row[c].imag());
+                }
+                rhs[r] += sk*(row[r].real()*target.real() + row[r].imag()*target.imag());
+            }
+        }
+        if(!solve(A, rhs)){
+            throw std::runtime_error("singular fit, fewer bins than unknowns");
+        }
+        scaled.b.assign(rhs.begin(), rhs.begin() + zeros + 1);
+        for(int i = 0; i < order; i++){
+            alpha[i] = rhs[zeros + 1 + i];
+        }
+    }
+    scaled.a = alpha;
+
+    // Back from p = s/w0: multiply both by w0^n
+    Model m;
+    for(int i = 0; i <= zeros; i++){
+        m.b.push_back(scaled.b[i]*std::pow(w0, order - i));
+    }
+    for(int i = 0; i <= order; i++){
+        m.a.push_back(scaled.a[i]*std::pow(w0, order - i));
+    }
+    return m;
+}
+
+//------------------roots()---------------------------
+//Roots of a monic polynomial, Durand-Kerner
+static std::vector<Complex> roots(const std::vector<double> &a){
+    int n = (int)a.size() - 1;
+    std::vector<Complex> z(n);
+
+    for(int i = 0; i < n; i++){
+        z[i] = std::pow(Complex(0.4, 0.9), i);
+    }
+    for(int it = 0; it < 500; it++){
+        for(int i = 0; i < n; i++){
+            Complex d = 1;
+            for(int j = 0; j < n; j++){
+                if(j != i){
+                    d *= z[i] - z[j];
+                }
+            }
+            z[i] -= polyval(a, z[i])/d;
+        }
+    }
+    return z;
+}
+
+//------------------printPoly()---------------------------
+//Polynomial in s, highest power first
+static std::string printPoly(const std::vector<double> &p){
+    std::ostringstream out;
+    for(size_t i = p.size(); i-- > 0;){
+        if(i + 1 < p.size()){
+            out << (p[i] < 0 ? " - " : " + ");
+        }else if(p[i] < 0){
+            out << "-";
+        }
+        if(i == 0 || std::fabs(p[i]) != 1){
+            out << std::fabs(p[i]);
+            if(i > 0) out << " ";
+        }
+        if(i > 1) out << "s^" << i;
+        else if(i == 1) out << "s";
+    }
+    return out.str();
+}
+
+//------------------column()---------------------------
+//First header column whose name starts with a prefix
+static int column(const std::vector<std::string> &names, const char *prefix){
+    for(size_t i = 0; i < names.size(); i++){
+        if(names[i].compare(0, std::strlen(prefix), prefix) == 0){
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int usage(const char *name){
+    std::cerr << "usage: " << name << " run.csv [-rate Hz] [-nfft n] [-order n] [-zeros m] [-fmin Hz] [-fmax Hz]\n"
+              << "       [-coherence c] [-delay s] [-csv bode.csv]\n";
+    return 2;
+}
+
+int main(int argc, char **argv){
+    Options opt;
+    const char *csvPath = 0;
+
+    if(argc < 2){
+        return usage(argv[0]);
+    }
+    for(int a = 2; a < argc; a++){
+        std::string arg = argv[a];
+        if(a + 1 >= argc){
+            return usage(argv[0]);
+        }
+        if(arg == "-rate") opt.rate = std::atof(argv[++a]);
+        else if(arg == "-nfft") opt.nfft = std::strtoul(argv[++a], 0, 10);
+        else if(arg == "-order") opt.order = std::atoi(argv[++a]);
+        else if(arg == "-zeros") opt.zeros = std::atoi(argv[++a]);
+        else if(arg == "-fmin") opt.fmin = std::atof(argv[++a]);
+        else if(arg == "-fmax") opt.fmax = std::atof(argv[++a]);
+        else if(arg == "-coherence") opt.coherence = std::atof(argv[++a]);
+        else if(arg == "-delay") opt.delay = std::atof(argv[++a]);
+        else if(arg == "-csv") csvPath = argv[++a];
+        else return usage(argv[0]);
+    }
+    if(opt.nfft < 16 || (opt.nfft & (opt.nfft - 1)) || opt.order < 1 || opt.order > IDENT_MAX_ORDER ||
+       opt.zeros < 0 || opt.zeros >= opt.order){
+        std::cerr << "nfft must be a power of 2, order 1 to " << IDENT_MAX_ORDER << ", zeros below the order\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1]);
+    std::string line;
+    if(!in || !std::getline(in, line)){
+        std::cerr << argv[1] << ": cannot read\n";
+        return 2;
+    }
+
+    // Header
+    std::vector<std::string> names;
+    {
+        std::istringstream header(line);
+        std::string name;
+        while(std::getline(header, name, ',')){
+            name.erase(0, name.find_first_not_of(" \t"));
+            names.push_back(name);
+        }
+    }
+    int uCol = column(names, "duty"), yCol = column(names, "load"), tCol = column(names, "time");
+    if(uCol < 0 || yCol < 0){
+        std::cerr << argv[1] << ": no duty or load column in the header\n";
+        return 2;
+    }
+    if(tCol < 0 && opt.rate <= 0){
+        std::cerr << argv[1] << ": no time column, give -rate\n";
+        return 2;
+    }
+
+    // Stream the rows through the spectra
+    Welch welch(opt.nfft);
+    unsigned long rows = 0, skipped = 0;
+    double t0 = 0, t1 = 0;
+    std::vector<double> v(names.size());
+    while(std::getline(in, line)){
+        const char *s = line.c_str();
+        char *end;
+        size_t n = 0;
+        for(; n < v.size(); n++){
+            v[n] = std::strtod(s, &end);
+            if(end == s){
+                break;
+            }
+            s = end;
+            while(*s == ' ' || *s == ',' || *s == '\r'){
+                s++;
+            }
+        }
+        if(n < v.size()){
+            skipped++;
+            continue;
+        }
+        if(tCol >= 0){
+            if(rows == 0) t0 = v[tCol];
+            t1 = v[tCol];
+        }
+        welch.add(v[uCol], v[yCol]);
+        rows++;
+    }
+    if(opt.rate <= 0){
+        opt.rate = (t1 > t0) ? (rows - 1)/(t1 - t0) : 0;
+    }
+    if(welch.segments == 0 || opt.rate <= 0){
+        std::cerr << argv[1] << ": " << rows << " rows, fewer than -nfft " << opt.nfft << "\n";
+        return 2;
+    }
+
+    // Response and the bins to fit
+    size_t bins = opt.nfft/2 + 1;
+    double df = opt.rate/opt.nfft;
+    double fmax = (opt.fmax > 0) ? opt.fmax : opt.rate/2;
+    std::vector<Complex> H(bins);
+    std::vector<double> coh(bins), fw, fweight;
+    std::vector<Complex> fh;
+    for(size_t k = 1; k < bins; k++){
+        double f = k*df;
+        H[k] = (welch.suu[k] > 0) ? welch.suy[k]/welch.suu[k] : 0;
+        H[k] *= std::polar(1.0, 2*M_PI*f*opt.delay);
+        coh[k] = (welch.suu[k] > 0 && welch.syy[k] > 0) ? std::norm(welch.suy[k])/(welch.suu[k]*welch.syy[k]) : 0;
+        if(f >= opt.fmin && f <= fmax && coh[k] >= opt.coherence && std::abs(H[k]) > 0){
+            fw.push_back(2*M_PI*f);
+            fh.push_back(H[k]);
+            fweight.push_back(coh[k]);
+        }
+    }
+    std::printf("%s: %lu rows at %.1f Hz, %lu skipped, %zu segments of %zu (%.3f Hz bins)\n", argv[1], rows,
+                opt.rate, skipped, welch.segments, opt.nfft, df);
+    if(fw.size() < (size_t)(opt.order + opt.zeros + 1)){
+        std::printf("%zu bins with coherence >= %.2f, too few to fit order %d\n", fw.size(), opt.coherence,
+                    opt.order);
+        return 1;
+    }
+    std::printf("fit from %.3f to %.3f Hz, %zu bins with coherence >= %.2f\n", fw.front()/(2*M_PI),
+                fw.back()/(2*M_PI), fw.size(), opt.coherence);
+
+    Model m;
+    try{
+        m = fit(fw, fh, fweight, opt.order, opt.zeros);
+    }catch(const std::exception &e){
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::printf("H(s) = (%s)/(%s)", printPoly(m.b).c_str(), printPoly(m.a).c_str());
+    if(opt.delay > 0){
+        std::printf(" e^(-%gs)", opt.delay);
+    }
+    std::printf("\nDC gain %.4f lb/%%\n", m.b[0]/m.a[0]);
+    for(const Complex &p : roots(m.a)){
+        if(p.imag() < -1e-9){
+            continue;           // printed with its conjugate
+        }
+        if(p.imag() > 1e-9){
+            double wn = std::abs(p);
+            std::printf("poles %.4f +- %.4fj: wn %.3f rad/s (%.3f Hz), zeta %.3f\n", p.real(), p.imag(), wn,
+                        wn/(2*M_PI), -p.real()/wn);
+        }else{
+            std::printf("pole %.4f: %.3f Hz\n", p.real(), -p.real()/(2*M_PI));
+        }
+    }
+
+    // Fit error over the fitted bins
+    double gainSum = 0, phaseSum = 0;
+    for(size_t k = 0; k < fw.size(); k++){
+        Complex model = polyval(m.b, Complex(0, fw[k]))/polyval(m.a, Complex(0, fw[k]));
+        double dg = 20*std::log10(std::abs(fh[k])/std::abs(model));
+        double dp = std::arg(fh[k]/model)*180/M_PI;
+        gainSum += dg*dg;
+        phaseSum += dp*dp;
+    }
+    std::printf("fit error RMS %.3f dB, %.2f deg\n", std::sqrt(gainSum/fw.size()), std::sqrt(phaseSum/fw.size()));
+
+    if(csvPath){
+        std::FILE *csv = std::fopen(csvPath, "w");
+        if(!csv){
+            std::perror(csvPath);
+            return 2;
+        }
+        std::fprintf(csv, "f_hz, gain_db, phase_deg, coherence, model_gain_db, model_phase_deg\n");
+        for(size_t k = 1; k < bins; k++){
+            double w = 2*M_PI*k*df;
+            Complex model = polyval(m.b, Complex(0, w))/polyval(m.a, Complex(0, w));
+            std::fprintf(csv, "%.4f, %.3f, %.2f, %.4f, %.3f, %.2f\n", k*df, 20*std::log10(std::abs(H[k]) + 1e-30),
+                         std::arg(H[k])*180/M_PI, coh[k], 20*std::log10(std::abs(model)), std::arg(model)*180/M_PI);
+        }
+        std::fclose(csv);
+    }
+    return 0;
+}
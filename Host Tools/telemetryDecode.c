@@ -0,0 +1,165 @@
+// telemetryDecode.c
+// Runs on a host PC
+// Decodes the binary telemetry stream of telemetry.c (Logger_InitTelemetry)
+// into CSV. The stream is read from a file (a raw serial capture) or stdin,
+// records are found by their sync word and checked with their CRC, so the
+// capture may start in the middle of a record. Gaps in the sequence number
+// (records dropped on the board) and CRC failures are counted on stderr.
+// Raw load cell blocks (Logger_EnableRawCapture) go to a second CSV file when
+// one is given, one line per sample, and are skipped otherwise.
+//
+// Build:
+//   gcc -O2 -std=gnu99 -o telemetryDecode telemetryDecode.c
+// Run:
+//   ./telemetryDecode [capture.bin] [controller frequency Hz] [raw.csv] > log.csv
+//   e.g. stty -F /dev/ttyACM0 460800 raw && ./telemetryDecode /dev/ttyACM0 > log.csv
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../Board Support Package/BSP/telemetry.h"
+
+#define LOAD_PER_COUNT (3.3*25.0/4095.0) // pound per ADC count, as in slug.c
+
+//------------------crc16()---------------------------
+//CRC-16/CCITT-FALSE, written out again here so the decoder checks the encoder
+static uint16_t crc16(const uint8_t *data, uint32_t length){
+    uint16_t crc = 0xFFFF;
+    uint32_t i;
+    int bit;
+    for(i = 0; i < length; i++){
+        crc ^= (uint16_t)data[i] << 8;
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+//------------------decode()---------------------------
+//Print one checked record as a CSV line and count sequence gaps
+static void decode(const uint8_t *frame, double freq, int *lastSeq, uint64_t *gaps){
+    uint8_t seq = frame[2];
+    int8_t duty = (int8_t)frame[3];
+    uint32_t tick = frame[4] | (frame[5] << 8) | (frame[6] << 16) | ((uint32_t)frame[7] << 24);
+    uint16_t adc = frame[8] | (frame[9] << 8);
+    int16_t error = (int16_t)(frame[10] | (frame[11] << 8));
+    int16_t out = (int16_t)(frame[12] | (frame[13] << 8));
+
+    if(*lastSeq >= 0){
+        *gaps += (uint8_t)(seq - *lastSeq - 1);
+    }
+    *lastSeq = seq;
+
+    printf("%u, %u, %.4f, %u, %.3f, %d, %.2f, %.2f\n", seq, tick, tick/freq, adc,
+           adc*LOAD_PER_COUNT, duty, error/100.0, out/100.0);
+}
+
+//------------------decodeBlock()---------------------------
+//Print one checked raw block, one CSV line per sample, and count lost blocks
+static void decodeBlock(const uint8_t *frame, FILE *raw, int64_t *lastBlock, uint64_t *lost){
+    uint32_t block = frame[4] | (frame[5] << 8) | (frame[6] << 16) | ((uint32_t)frame[7] << 24);
+    int i;
+
+    if(*lastBlock >= 0){
+        *lost += (uint32_t)(block - (uint32_t)*lastBlock - 1);
+    }
+    *lastBlock = block;
+
+    if(raw){
+        for(i = 0; i < frame[3]; i++){
+            fprintf(raw, "%u, %d, %u\n", block, i, frame[8 + 2*i] | (frame[9 + 2*i] << 8));
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    FILE *in = stdin;
+    double freq = (argc > 2) ? atof(argv[2]) : 2000.0;
+    FILE *raw = 0;
+    uint8_t frame[TELEMETRY_BLOCK_SIZE];
+    uint32_t have = 0, size;
+    uint64_t records = 0, crcErrors = 0, skipped = 0, gaps = 0;
+    uint64_t blocks = 0, blocksLost = 0;
+    int64_t lastBlock = -1;
+    int lastSeq = -1;
+    int isBlock;
+    int c;
+
+    if(argc > 1 && strcmp(argv[1], "-") != 0){
+        in = fopen(argv[1], "rb");
+        if(!in){
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    if(freq <= 0){
+        freq = 2000.0;
+    }
+    if(argc > 3){
+        raw = fopen(argv[3], "w");
+        if(!raw){
+            perror(argv[3]);
+            return 1;
+        }
+        fprintf(raw, "block, sample, adc\n");
+    }
+
+    printf("seq, tick, time_s, adc, load_lb, duty_pct, error_lb, out_pct\n");
+    while((c = fgetc(in)) != EOF){
+        frame[have++] = (uint8_t)c;
+
+        while(have > 0){
+            // Hunt for either sync word, then wait for a full record or block
+            isBlock = (have > 1 && frame[1] == (TELEMETRY_BLOCK_SYNC >> 8));
+            if(frame[0] != (TELEMETRY_SYNC & 0xFF) ||
+               (have > 1 && frame[1] != (TELEMETRY_SYNC >> 8) && !isBlock)){
+                memmove(frame, &frame[1], --have);
+                skipped++;
+                continue;
+            }
+            if(have < 2){
+                break;
+            }
+            size = isBlock ? TELEMETRY_BLOCK_SIZE : TELEMETRY_RECORD_SIZE;
+            if(isBlock && have > 3 && frame[3] != TELEMETRY_BLOCK_SAMPLES){
+                size = 0; // not a block, no length to trust
+            }
+            if(size && have < size){
+                break;
+            }
+            if(!size || crc16(&frame[2], size - 4) != (uint16_t)(frame[size - 2] | (frame[size - 1] << 8))){
+                // Not a record, restart the hunt one byte later
+                memmove(frame, &frame[1], --have);
+                crcErrors++;
+                skipped++;
+                continue;
+            }
+            if(isBlock){
+                decodeBlock(frame, raw, &lastBlock, &blocksLost);
+                blocks++;
+            }else{
+                decode(frame, freq, &lastSeq, &gaps);
+                records++;
+            }
+            have = 0;
+        }
+    }
+
+    fprintf(stderr, "%llu records, %llu missing by sequence number, %llu CRC errors, %llu bytes skipped\n",
+            (unsigned long long)records, (unsigned long long)gaps,
+            (unsigned long long)crcErrors, (unsigned long long)skipped);
+    if(blocks){
+        fprintf(stderr, "%llu raw blocks, %llu missing by block counter\n",
+                (unsigned long long)blocks, (unsigned long long)blocksLost);
+    }
+    if(raw){
+        fclose(raw);
+    }
+    if(in != stdin){
+        fclose(in);
+    }
+    return 0;
+}
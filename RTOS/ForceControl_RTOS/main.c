@@ -0,0 +1,275 @@
+// main.c
+// Runs on TM4C123 with TIVA shield v2.0 under TI-RTOS
+// Adaptive force control (BSP/Adaptive_ForceControl.c) split into TI-RTOS
+// threads by deadline. forceControl_rtos.cfg creates the Swi, the Tasks and
+// the semaphores, halTiva.c creates the Hwis:
+//   Hwi  ADC0 SS1   0x20  LoadCellBlockIntHandler, load cell blocks by uDMA
+//   Hwi  Timer1     0x40  tickHwi, clears the timer and posts controlSwi
+//   Hwi  UART0      0xA0  UARTIntHandler, command framing and uDMA transmit
+//   Swi  controlSwi 15    ControllerIntHandler, the control law
+//   Task telemetry  3     Logger_Drain and Tune_Background after every
+//                         controller tick
+//   Task command    2     SerialMonitor_Receive when bytes arrived
+//   Task diagnostics 1    load and latency of every tier, once a second
+// Every Swi runs before any Task, so a slow telemetry or command thread can
+// delay the other one but never the control law. Both write UART0 through
+// uartTx.c, they take txLock around it.
+//
+// Each tier measures its latency from the event that readies it to the
+// moment it runs, in clock cycles: the Timer1 Hwi from the timer rollover,
+// the control Swi from its post, the Tasks from the first semaphore post they
+// have not served yet. The diagnostics task reads the loads of the Load
+// module (Load.windowInMs) and logs them (System Analyzer); the host reads
+// them with the LOAD command (Host Tools/slugCmd load).
+//
+// Project: the BSP sources are linked from Board Support Package/BSP, without
+// the bare-metal mains, halHost.c and the startup file (BIOS owns the vector
+// table). SLUG_RTOS is pre-defined.
+
+//----------------------------------------
+// BIOS header files
+//----------------------------------------
+#include <xdc/std.h>                        //mandatory - have to include first, for BIOS types
+#include <ti/sysbios/BIOS.h>                //mandatory - if you call APIs like BIOS_start()
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Swi.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/utils/Load.h>
+#include <xdc/runtime/Log.h>                //needed for any Log_info() call
+#include <xdc/cfg/global.h>                 //header file for statically defined objects/handles
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "slug.h"
+#include "telemetry.h"
+#include "command.h"
+#include "paramStore.h"
+
+#define DIAGNOSTICS_PERIOD  1000            // Clock ticks of 1 ms, same as Load.windowInMs
+
+// Tiers of the LOAD command
+typedef enum {
+    TIER_CPU,                               // everything but the idle loop, no latency
+    TIER_HWI,                               // all Hwis, latency of the Timer1 Hwi
+    TIER_CONTROL,                           // controlSwi
+    TIER_TELEMETRY,                         // telemetryTask
+    TIER_COMMAND,                           // commandTask
+    NUM_TIERS
+} Tier_Id;
+
+typedef struct {
+    uint32_t load;                          // 0.01 % of the CPU
+    uint32_t count;                         // runs
+    uint32_t latencyMax;                    // cycles
+    uint64_t latencyTotal;
+} Tier_Stats;
+
+static Tier_Stats tierWindow[NUM_TIERS];    // being measured
+static Tier_Stats tierStats[NUM_TIERS];     // last full window, LOAD command
+static uint32_t tierPosted[NUM_TIERS];      // cycle count of the first post not served
+static volatile uint32_t tierPending[NUM_TIERS];
+static uint32_t tickPeriod;                 // Timer1 cycles
+
+double ref_input = 5;
+
+//------------------tierRun()---------------------------
+//Count one run of a tier and its latency
+static void tierRun(Tier_Id tier, uint32_t latency){
+    Tier_Stats *t = &tierWindow[tier];
+
+    t->count++;
+    t->latencyTotal += latency;
+    if(latency > t->latencyMax){
+        t->latencyMax = latency;
+    }
+}
+
+//------------------tierPost()---------------------------
+//Stamp the post of a semaphore, once until the task runs
+static void tierPost(Tier_Id tier){
+    if(!tierPending[tier]){
+        tierPosted[tier] = HAL_CycleCount();
+        tierPending[tier] = 1;
+    }
+}
+
+//------------------tierWake()---------------------------
+//Count the run of a task woken by tierPost()
+static void tierWake(Tier_Id tier){
+    uint32_t state = HAL_EnterCritical();
+
+    if(tierPending[tier]){
+        tierPending[tier] = 0;
+        tierRun(tier, HAL_CycleCount() - tierPosted[tier]);
+    }
+    HAL_ExitCritical(state);
+}
+
+//------------------loadOf()---------------------------
+//Load of a thread in 0.01 %, 0 before the first Load window
+static uint32_t loadOf(Load_Stat *stat){
+    return stat->totalTime ? (uint32_t)((uint64_t)stat->threadTime*10000/stat->totalTime) : 0;
+}
+
+//------------------tickHwi()---------------------------
+//Timer1 Hwi, post the control law. Timer1 counts down from tickPeriod - 1
+//Input: None
+//Output: None
+void tickHwi(void){
+    uint32_t latency = tickPeriod - 1 - HAL_TimerValueGet(HAL_TIMER1);
+
+    HAL_TimerIntClear(HAL_TIMER1);
+    tierRun(TIER_HWI, latency);
+    tierPosted[TIER_CONTROL] = HAL_CycleCount();
+    Swi_post(controlSwi);
+}
+
+//------------------controlSwiFxn()---------------------------
+//Control Swi, one controller tick, then wake the telemetry task
+//Input: None
+//Output: None
+void controlSwiFxn(UArg arg0, UArg arg1){
+    tierRun(TIER_CONTROL, HAL_CycleCount() - tierPosted[TIER_CONTROL]);
+    ControllerIntHandler();
+    tierPost(TIER_TELEMETRY);
+    Semaphore_post(telemetrySem);
+}
+
+//------------------commandNotify()---------------------------
+//Wake the command task, called from the UART Hwi
+//Input: None
+//Output: None
+static void commandNotify(void){
+    tierPost(TIER_COMMAND);
+    Semaphore_post(commandSem);
+}
+
+//------------------commandLoad()---------------------------
+//Reply payload of the LOAD command, the commands slug.c does not know
+//Input: request, reply payload out, reply length out
+//Output: Status
+static Command_Status commandLoad(const Command_Request *r, uint8_t *out, uint32_t *length){
+    Tier_Stats copy;
+    uint32_t state;
+
+    if((r->code & ~COMMAND_NO_REPLY) != COMMAND_LOAD) return COMMAND_UNKNOWN;
+    if(r->length != 1) return COMMAND_BAD_LENGTH;
+    if(r->payload[0] >= NUM_TIERS) return COMMAND_BAD_ID;
+    state = HAL_EnterCritical(); // one consistent set
+    copy = tierStats[r->payload[0]];
+    HAL_ExitCritical(state);
+
+    out[0] = r->payload[0];
+    Command_PutUint32(&out[1], copy.load);
+    Command_PutUint32(&out[5], copy.count);
+    Command_PutUint32(&out[9], copy.latencyMax);
+    Command_PutUint32(&out[13], copy.count ? (uint32_t)(copy.latencyTotal/copy.count) : 0);
+    *length = 17;
+    return COMMAND_OK;
+}
+
+//------------------telemetryTaskFxn()---------------------------
+//Send the records queued by the control law
+//Input: None
+//Output: None
+void telemetryTaskFxn(UArg arg0, UArg arg1){
+    while(1){
+        Semaphore_pend(telemetrySem, BIOS_WAIT_FOREVER);
+        tierWake(TIER_TELEMETRY);
+        Semaphore_pend(txLock, BIOS_WAIT_FOREVER);
+        Logger_Drain();
+        Semaphore_post(txLock);
+        Tune_Background();
+    }
+}
+
+//------------------commandTaskFxn()---------------------------
+//Run the commands from the host (Host Tools/slugCmd)
+//Input: None
+//Output: None
+void commandTaskFxn(UArg arg0, UArg arg1){
+    while(1){
+        Semaphore_pend(commandSem, BIOS_WAIT_FOREVER);
+        tierWake(TIER_COMMAND);
+        Semaphore_pend(txLock, BIOS_WAIT_FOREVER);
+        SerialMonitor_Receive();
+        Semaphore_post(txLock);
+    }
+}
+
+//------------------diagnosticsTaskFxn()---------------------------
+//Close the measurement window of every tier once a second
+//Input: None
+//Output: None
+void diagnosticsTaskFxn(UArg arg0, UArg arg1){
+    Load_Stat stat;
+    uint32_t load[NUM_TIERS];
+    uint32_t state, i;
+
+    while(1){
+        Task_sleep(DIAGNOSTICS_PERIOD);
+
+        load[TIER_CPU] = Load_getTaskLoad(Task_getIdleTask(), &stat) ? 10000 - loadOf(&stat) : 0;
+        load[TIER_HWI] = Load_getGlobalHwiLoad(&stat) ? loadOf(&stat) : 0;
+        load[TIER_CONTROL] = Load_getGlobalSwiLoad(&stat) ? loadOf(&stat) : 0;
+        load[TIER_TELEMETRY] = Load_getTaskLoad(telemetryTask, &stat) ? loadOf(&stat) : 0;
+        load[TIER_COMMAND] = Load_getTaskLoad(commandTask, &stat) ? loadOf(&stat) : 0;
+
+        state = HAL_EnterCritical();
+        for(i = 0; i < NUM_TIERS; i++){
+            tierStats[i] = tierWindow[i];
+            tierStats[i].load = load[i];
+            tierWindow[i].count = 0;
+            tierWindow[i].latencyMax = 0;
+            tierWindow[i].latencyTotal = 0;
+        }
+        HAL_ExitCritical(state);
+
+        Log_info5("load cpu %d, hwi %d, control %d, telemetry %d, command %d (0.01 %%)",
+                  load[TIER_CPU], load[TIER_HWI], load[TIER_CONTROL], load[TIER_TELEMETRY], load[TIER_COMMAND]);
+        Log_info4("latency max hwi %d, control %d, telemetry %d, command %d (cycles)",
+                  tierStats[TIER_HWI].latencyMax, tierStats[TIER_CONTROL].latencyMax,
+                  tierStats[TIER_TELEMETRY].latencyMax, tierStats[TIER_COMMAND].latencyMax);
+    }
+}
+
+//---------------------------------------------------------------------------
+// main()
+//---------------------------------------------------------------------------
+int main(void){
+    Param_Boot boot;
+
+    // Initialize clock at 80 MHZ frequency
+    Clock_set_80MHz();
+
+    // Parameters saved on this stand, the build values where there are none
+    ParamStore_Load();
+    Param_GetBoot(&boot);
+
+    // Binary telemetry, every controller tick (decode with Host Tools/telemetryDecode)
+    Logger_InitTelemetry(TELEMETRY_BAUD_RATE);
+    SerialMonitor_SetNotify(commandNotify);
+    SerialMonitor_SetExtension(commandLoad);
+
+    // Initialize motor, 20KHz by default
+    Motor_Init(boot.pwmFreq);
+
+    // Load cell in uDMA blocks of 16 samples at 32 KHz, decimated to one
+    // value every 0.5 ms by default
+    LoadCell_initBlock(boot.adcAveraging, boot.adcFreq);
+
+    // Controller at 2kHz by default, Timer1 posts controlSwi
+    setGoalForce(ref_input);
+    tickPeriod = HAL_ClockGet()/boot.controllerFreq;
+    Controller_InitTick(boot.controllerFreq, tickHwi);
+    ControllerEnable();
+
+    // For debugging
+    RGBled_Init(0, 0, 1); //Blue
+
+    // Interrupts are enabled by BIOS
+    BIOS_start();
+    return 0;
+}